@@ -0,0 +1,225 @@
+#ifndef UI_BENCHMARKUTILS_H
+#define UI_BENCHMARKUTILS_H
+
+#include <itkImage.h>
+#include <itkMesh.h>
+#include <itkTriangleCell.h>
+#include <vnl/algo/vnl_svd.h>
+#include <vnl/vnl_matrix.h>
+
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// Helpers shared by the benchmark and test executables
+namespace benchmark
+{
+using MeshType = itk::Mesh<float, 3>;
+
+inline void
+addTriangle(MeshType * mesh, MeshType::CellIdentifier cellId, unsigned a, unsigned b, unsigned c)
+{
+  using TriangleType = itk::TriangleCell<MeshType::CellType>;
+
+  MeshType::CellAutoPointer cell;
+  cell.TakeOwnership(new TriangleType);
+  cell->SetPointId(0, a);
+  cell->SetPointId(1, b);
+  cell->SetPointId(2, c);
+  mesh->SetCell(cellId, cell);
+}
+
+// Closed torus with (at least) the given number of vertices and twice as many triangles
+inline MeshType::Pointer
+makeTorusMesh(unsigned numberOfVertices)
+{
+  const double   pi = std::acos(-1.0);
+  const unsigned rings = std::max(3u, static_cast<unsigned>(std::sqrt(static_cast<double>(numberOfVertices))));
+  const unsigned segments = std::max(3u, (numberOfVertices + rings - 1) / rings);
+
+  auto mesh = MeshType::New();
+  for (unsigned i = 0; i < rings; ++i)
+  {
+    const double u = 2 * pi * i / rings;
+    for (unsigned j = 0; j < segments; ++j)
+    {
+      const double        v = 2 * pi * j / segments;
+      MeshType::PointType p;
+      p[0] = (100 + 30 * std::cos(v)) * std::cos(u);
+      p[1] = (100 + 30 * std::cos(v)) * std::sin(u);
+      p[2] = 30 * std::sin(v);
+      mesh->SetPoint(i * segments + j, p);
+    }
+  }
+
+  MeshType::CellIdentifier cellId = 0;
+  for (unsigned i = 0; i < rings; ++i)
+  {
+    for (unsigned j = 0; j < segments; ++j)
+    {
+      const unsigned a = i * segments + j;
+      const unsigned b = i * segments + (j + 1) % segments;
+      const unsigned c = ((i + 1) % rings) * segments + j;
+      const unsigned d = ((i + 1) % rings) * segments + (j + 1) % segments;
+      addTriangle(mesh, cellId++, a, b, d);
+      addTriangle(mesh, cellId++, a, d, c);
+    }
+  }
+  return mesh;
+}
+
+// Median wall clock time of f in milliseconds
+template <typename F>
+double
+medianMilliseconds(unsigned repetitions, F && f)
+{
+  std::vector<double> times;
+  for (unsigned i = 0; i < std::max(1u, repetitions); ++i)
+  {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+  }
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2];
+}
+
+// Cube image of edge * edge * edge voxels filled with a gradient
+inline itk::Image<short, 3>::Pointer
+makeImage(unsigned edge)
+{
+  using ImageType = itk::Image<short, 3>;
+
+  ImageType::SizeType size;
+  size.Fill(edge);
+  auto image = ImageType::New();
+  image->SetRegions(ImageType::RegionType(size));
+  image->Allocate();
+
+  short * buffer = image->GetBufferPointer();
+  for (std::size_t i = 0; i < image->GetPixelContainer()->Size(); ++i)
+  {
+    buffer[i] = static_cast<short>(i % 4096);
+  }
+  return image;
+}
+
+// Smooth columns of unit length, similar to the modes of a shape model. Orthogonality does not matter here.
+inline vnl_matrix<float>
+makeBasis(std::size_t numberOfRows, unsigned numberOfComponents)
+{
+  vnl_matrix<float> basis(numberOfRows, numberOfComponents);
+  for (unsigned i = 0; i < numberOfComponents; ++i)
+  {
+    for (std::size_t j = 0; j < numberOfRows; ++j)
+    {
+      basis(j, i) = std::sin((i + 1) * 3.14159 * (j + 0.5) / numberOfRows) * std::sqrt(2.0 / numberOfRows);
+    }
+  }
+  return basis;
+}
+
+// Smooth orthonormal columns, for the encodings whose error depends on the scale of the columns
+inline vnl_matrix<float>
+makeOrthonormalBasis(std::size_t numberOfRows, unsigned numberOfComponents)
+{
+  return vnl_svd<float>(makeBasis(numberOfRows, numberOfComponents)).U().extract(numberOfRows, numberOfComponents);
+}
+
+// Random covariances, a fifth of them isotropic and a fifth of rank one to cover repeated eigenvalues
+inline std::vector<vnl_matrix<double>>
+makeCovariances(std::size_t numberOfLandmarks)
+{
+  std::mt19937                     generator(42);
+  std::normal_distribution<double> normal;
+
+  std::vector<vnl_matrix<double>> covariances;
+  for (std::size_t l = 0; l < numberOfLandmarks; ++l)
+  {
+    vnl_matrix<double> b(3, 3);
+    for (unsigned i = 0; i < 9; ++i)
+    {
+      b.data_block()[i] = normal(generator);
+    }
+    switch (l % 5)
+    {
+      case 0:
+        covariances.push_back(vnl_matrix<double>(3, 3).set_identity() * (1 + l % 7));
+        break;
+      case 1:
+        covariances.push_back(outer_product(b.get_column(0), b.get_column(0)));
+        break;
+      default:
+        covariances.push_back(b * b.transpose() * std::pow(10.0, double(l % 9) - 4));
+    }
+  }
+  return covariances;
+}
+
+// Wall clock time of each call of f in milliseconds, sorted
+template <typename F>
+std::vector<double>
+sampleMilliseconds(unsigned repetitions, F && f)
+{
+  std::vector<double> times;
+  for (unsigned i = 0; i < std::max(1u, repetitions); ++i)
+  {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+  }
+  std::sort(times.begin(), times.end());
+  return times;
+}
+
+// Nearest-rank percentile (0 < q <= 100) of sorted samples
+inline double
+percentile(const std::vector<double> & sortedSamples, double q)
+{
+  std::size_t rank = static_cast<std::size_t>(std::ceil(q / 100 * sortedSamples.size()));
+  return sortedSamples[std::min(sortedSamples.size(), std::max<std::size_t>(rank, 1)) - 1];
+}
+
+struct Latency
+{
+  double medianMs{ 0 };
+  double meanMs{ 0 };
+  double maxMs{ 0 };
+};
+
+// Latency of n calls of f(i), i = 0 ... n - 1
+template <typename F>
+Latency
+measureLatency(unsigned n, F && f)
+{
+  unsigned                  i = 0;
+  const std::vector<double> times = sampleMilliseconds(n, [&f, &i] { f(i++); });
+
+  Latency latency;
+  latency.medianMs = percentile(times, 50);
+  latency.meanMs = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+  latency.maxMs = times.back();
+  return latency;
+}
+
+// Number of bytes the object occupies on the wire with the binary protocol
+template <typename T>
+uint32_t
+serializeToMemory(const T & thriftObject)
+{
+  auto                                    buffer = std::make_shared<apache::thrift::transport::TMemoryBuffer>();
+  apache::thrift::protocol::TBinaryProtocol protocol(buffer);
+  return thriftObject.write(&protocol);
+}
+} // namespace benchmark
+
+#endif // UI_BENCHMARKUTILS_H
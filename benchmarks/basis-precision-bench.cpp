@@ -0,0 +1,78 @@
+// Compares the encodings of the PCA basis (Float64, Float32, Float16, quantized Int16): bytes on the wire and time
+// to encode and decode. tests/basis-precision-test checks their error against the bound announced in
+// PackedKLBasis.columnErrors.
+//
+// usage: basis-precision-bench [--model model.h5] [numberOfVertices numberOfComponents]
+
+#include "BenchmarkUtils.h"
+#include "ThriftConversions.h"
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+int
+main(int argc, char ** argv)
+{
+  using namespace StatismoUI;
+
+  std::string           modelFile;
+  std::vector<unsigned> sizes;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--model" && i + 1 < argc)
+    {
+      modelFile = argv[++i];
+    }
+    else
+    {
+      sizes.push_back(std::stoul(arg));
+    }
+  }
+
+  vnl_matrix<float> basis;
+  vnl_vector<float> variances;
+  if (!modelFile.empty())
+  {
+    auto representer = itk::StandardMeshRepresenter<float, 3>::New();
+    auto model = itk::StatismoIO<benchmark::MeshType>::LoadStatisticalModel(representer, modelFile.c_str());
+    basis = model->GetOrthonormalPCABasisMatrix();
+    variances = model->GetPCAVarianceVector();
+  }
+  else
+  {
+    const unsigned numberOfVertices = sizes.size() > 0 ? sizes[0] : 20000;
+    const unsigned numberOfComponents = sizes.size() > 1 ? sizes[1] : 50;
+    basis = benchmark::makeOrthonormalBasis(3 * std::size_t(numberOfVertices), numberOfComponents);
+    variances.set_size(numberOfComponents);
+    for (unsigned i = 0; i < numberOfComponents; ++i)
+    {
+      variances[i] = 1000.0f / (i + 1);
+    }
+  }
+
+  std::cout << basis.rows() / 3 << " vertices, " << basis.cols() << " components" << std::endl;
+  std::cout << std::left << std::setw(10) << "encoding" << std::right << std::setw(14) << "bytes" << std::setw(12)
+            << "encode ms" << std::setw(12) << "decode ms" << std::endl;
+
+  for (ScalarType type : { ScalarType::Float64, ScalarType::Float32, ScalarType::Float16, ScalarType::Int16 })
+  {
+    ui::PackedKLBasis packed;
+    double            encodeMs = benchmark::medianMilliseconds(
+      3, [&]() { packed = conversions::klBasisToPackedThrift(basis, variances, type); });
+    double decodeMs =
+      benchmark::medianMilliseconds(3, [&]() { conversions::klBasisFromPackedThrift(packed, basis.rows()); });
+
+    const char * names[] = { "float64", "float32", "float16", "int16" };
+    const char * name = names[type == ScalarType::Float64   ? 0
+                              : type == ScalarType::Float32 ? 1
+                              : type == ScalarType::Float16 ? 2
+                                                            : 3];
+    std::cout << std::left << std::setw(10) << name << std::right << std::setw(14) << packed.eigenvectors.size()
+              << std::setw(12) << std::fixed << std::setprecision(2) << encodeMs << std::setw(12) << decodeMs
+              << std::endl;
+  }
+
+  return 0;
+}
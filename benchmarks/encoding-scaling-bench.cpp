@@ -0,0 +1,149 @@
+// Encode cost per vertex of the mesh and model converters for an increasing number of worker threads.
+// Without a model file, the basis encodings are timed on a synthetic basis of numberOfComponents columns.
+//
+// usage: encoding-scaling-bench [--repetitions n] [--threads n,...] [--model model.h5]
+//                               [numberOfVertices [numberOfComponents]]
+
+#include "BenchmarkUtils.h"
+#include "ParallelFor.h"
+#include "ThriftConversions.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+using MeshType = itk::Mesh<float, 3>;
+
+std::vector<unsigned>
+parseList(const std::string & arg)
+{
+  std::vector<unsigned> values;
+  std::istringstream    stream(arg);
+  std::string           value;
+  while (std::getline(stream, value, ','))
+  {
+    values.push_back(std::stoul(value));
+  }
+  return values;
+}
+
+template <typename EncodeFunction>
+void
+report(const std::string &           label,
+       const std::vector<unsigned> & threadCounts,
+       unsigned                      repetitions,
+       std::size_t                   numberOfVertices,
+       EncodeFunction &&             encode)
+{
+  std::cout << std::left << std::setw(44) << label << std::right;
+  for (unsigned threads : threadCounts)
+  {
+    StatismoUI::setNumberOfWorkerThreads(threads);
+    encode(); // warm up
+    double ms = benchmark::medianMilliseconds(repetitions, encode);
+    std::cout << std::setw(12) << std::fixed << std::setprecision(2) << ms * 1e6 / numberOfVertices;
+  }
+  std::cout << std::endl;
+  StatismoUI::setNumberOfWorkerThreads(0);
+}
+} // namespace
+
+int
+main(int argc, char ** argv)
+{
+  using namespace StatismoUI;
+
+  unsigned              repetitions = 10;
+  std::string           modelFile;
+  std::vector<unsigned> threadCounts;
+  std::vector<unsigned> sizes;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--repetitions" && i + 1 < argc)
+    {
+      repetitions = std::stoul(argv[++i]);
+    }
+    else if (arg == "--threads" && i + 1 < argc)
+    {
+      threadCounts = parseList(argv[++i]);
+    }
+    else if (arg == "--model" && i + 1 < argc)
+    {
+      modelFile = argv[++i];
+    }
+    else
+    {
+      sizes.push_back(std::stoul(arg));
+    }
+  }
+
+  if (threadCounts.empty())
+  {
+    for (unsigned threads = 1; threads < getNumberOfWorkerThreads(); threads *= 2)
+    {
+      threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(getNumberOfWorkerThreads());
+  }
+
+  MeshType::Pointer mesh = benchmark::makeTorusMesh(sizes.size() > 0 ? sizes[0] : 500000);
+  const unsigned    numberOfComponents = sizes.size() > 1 ? sizes[1] : 50;
+
+  itk::StatisticalModel<MeshType>::Pointer model;
+  if (!modelFile.empty())
+  {
+    auto representer = itk::StandardMeshRepresenter<float, 3>::New();
+    model = itk::StatismoIO<MeshType>::LoadStatisticalModel(representer, modelFile.c_str());
+  }
+
+  std::cout << mesh->GetNumberOfPoints() << " vertices, ns per vertex" << std::endl;
+  std::cout << std::left << std::setw(44) << "threads" << std::right;
+  for (unsigned threads : threadCounts)
+  {
+    std::cout << std::setw(12) << threads;
+  }
+  std::cout << std::endl;
+
+  report("meshToThriftMesh", threadCounts, repetitions, mesh->GetNumberOfPoints(), [&]() {
+    conversions::meshToThriftMesh(mesh);
+  });
+  report("meshToPackedThriftMesh", threadCounts, repetitions, mesh->GetNumberOfPoints(), [&]() {
+    conversions::meshToPackedThriftMesh(mesh, ScalarType::Float32);
+  });
+
+  vnl_matrix<float> basis(3 * mesh->GetNumberOfPoints(), numberOfComponents);
+  vnl_vector<float> variances(numberOfComponents);
+  for (unsigned i = 0; i < numberOfComponents; ++i)
+  {
+    for (unsigned j = 0; j < basis.rows(); ++j)
+    {
+      basis(j, i) = std::sin((i + 1) * 0.001f * j);
+    }
+    variances[i] = 1000.0f / (i + 1);
+  }
+
+  const std::string suffix = " (" + std::to_string(numberOfComponents) + " components)";
+  report("klBasisToPackedThrift float32" + suffix, threadCounts, repetitions, mesh->GetNumberOfPoints(), [&]() {
+    conversions::klBasisToPackedThrift(basis, variances, ScalarType::Float32);
+  });
+  report("klBasisToPackedThrift int16" + suffix, threadCounts, repetitions, mesh->GetNumberOfPoints(), [&]() {
+    conversions::klBasisToPackedThrift(basis, variances, ScalarType::Int16);
+  });
+
+  if (model)
+  {
+    const std::size_t numberOfVertices = model->GetRepresenter()->GetReference()->GetNumberOfPoints();
+    report("statisticalModelToThrift (model)", threadCounts, repetitions, numberOfVertices, [&]() {
+      conversions::statisticalModelToThrift(model);
+    });
+    report("statisticalModelToPackedThrift (model)", threadCounts, repetitions, numberOfVertices, [&]() {
+      conversions::statisticalModelToPackedThrift(model, ScalarType::Float32);
+    });
+  }
+
+  return 0;
+}
@@ -0,0 +1,144 @@
+// Computes shape model instances with ShapeModelEvaluator: one instance (GEMV), one posed instance and a batch of
+// random samples (GEMM), against a plain vnl matrix-vector product. Reports the time and the bandwidth reached.
+// tests/evaluator-test checks the instances against a double precision computation.
+//
+//   evaluator-bench [--vertices n] [--components n] [--samples n] [--threads n]
+
+#include "BenchmarkUtils.h"
+#include "ParallelFor.h"
+#include "ShapeModelEvaluator.h"
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+using MeshType = itk::Mesh<float, 3>;
+
+void
+printResult(const std::string & label, double ms, double bytes)
+{
+  std::cout << std::left << std::setw(32) << label << std::right << std::fixed << std::setprecision(3)
+            << std::setw(10) << ms << " ms" << std::setprecision(1) << std::setw(10) << bytes / ms / 1e6 << " GB/s"
+            << std::endl;
+}
+} // namespace
+
+int
+main(int argc, char ** argv)
+{
+  using namespace StatismoUI;
+
+  unsigned numberOfVertices = 10000;
+  unsigned numberOfComponents = 100;
+  unsigned numberOfSamples = 1000;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--vertices" && i + 1 < argc)
+    {
+      numberOfVertices = std::stoul(argv[++i]);
+    }
+    else if (arg == "--components" && i + 1 < argc)
+    {
+      numberOfComponents = std::stoul(argv[++i]);
+    }
+    else if (arg == "--samples" && i + 1 < argc)
+    {
+      numberOfSamples = std::stoul(argv[++i]);
+    }
+    else if (arg == "--threads" && i + 1 < argc)
+    {
+      setNumberOfWorkerThreads(std::stoul(argv[++i]));
+    }
+    else
+    {
+      std::cerr << "usage: evaluator-bench [--vertices n] [--components n] [--samples n] [--threads n]" << std::endl;
+      return 1;
+    }
+  }
+
+  auto                    reference = benchmark::makeTorusMesh(numberOfVertices);
+  const std::size_t       numberOfRows = 3 * std::size_t(reference->GetNumberOfPoints());
+  const vnl_matrix<float> basis = benchmark::makeBasis(numberOfRows, numberOfComponents);
+  vnl_vector<float>       variances(numberOfComponents);
+  vnl_vector<float>       meanDeformation(numberOfRows);
+  vnl_vector<float>       mean(numberOfRows);
+  for (unsigned i = 0; i < numberOfComponents; ++i)
+  {
+    variances[i] = 1000.0f / (i + 1);
+  }
+  for (std::size_t r = 0; r < numberOfRows; ++r)
+  {
+    meanDeformation[r] = std::sin(0.01 * r);
+    mean[r] = reference->GetPoint(r / 3)[r % 3] + meanDeformation[r];
+  }
+
+  ShapeModelEvaluator evaluator(reference, meanDeformation, basis, variances);
+  std::cout << evaluator.GetNumberOfPoints() << " vertices, " << evaluator.GetNumberOfComponents() << " components, "
+            << numberOfSamples << " samples, " << getNumberOfWorkerThreads() << " threads" << std::endl;
+
+  // coefficients are standard normal under the model
+  std::mt19937                    generator(42);
+  std::normal_distribution<float> normal;
+  vnl_matrix<float>               coefficients(numberOfSamples, numberOfComponents);
+  for (unsigned s = 0; s < numberOfSamples; ++s)
+  {
+    for (unsigned j = 0; j < numberOfComponents; ++j)
+    {
+      coefficients(s, j) = normal(generator);
+    }
+  }
+
+  const double       basisBytes = double(numberOfRows) * numberOfComponents * sizeof(float);
+  std::vector<float> points(numberOfRows);
+  vnl_vector<float>  alpha = coefficients.get_row(0);
+
+  // what a client does today without the evaluator: a vnl product with the scaled basis
+  vnl_matrix<float> scaledBasis = basis;
+  for (unsigned j = 0; j < numberOfComponents; ++j)
+  {
+    scaledBasis.scale_column(j, std::sqrt(variances[j]));
+  }
+  vnl_vector<float> vnlInstance;
+  printResult("vnl mean + basis * alpha",
+              benchmark::medianMilliseconds(20, [&] { vnlInstance = mean + scaledBasis * alpha; }),
+              basisBytes);
+  printResult("instance",
+              benchmark::medianMilliseconds(20, [&] { evaluator.evaluate(alpha, points.data()); }),
+              basisBytes);
+
+  // the posed instance is the instance moved by the rigid transform the view describes
+  auto rigid = itk::Euler3DTransform<float>::New();
+  rigid->SetRotation(0.1, -0.2, 0.3);
+  MeshType::PointType center;
+  center.Fill(5);
+  rigid->SetCenter(center);
+  itk::Euler3DTransform<float>::OutputVectorType translation;
+  translation.Fill(20);
+  rigid->SetTranslation(translation);
+  ShapeModelTransformationView smtv(0, PoseTransformation(*rigid), ShapeTransformation(vnl_vector<float>(alpha)));
+  std::vector<float> posed(numberOfRows);
+  printResult("posed instance",
+              benchmark::medianMilliseconds(20, [&] { evaluator.evaluate(smtv, posed.data()); }),
+              basisBytes);
+
+  // the batch writes numberOfSamples instances, which is what bounds it once the basis is read from cache
+  std::vector<float> batch(std::size_t(numberOfSamples) * numberOfRows);
+  const double       batchMs =
+    benchmark::medianMilliseconds(5, [&] { evaluator.evaluate(coefficients, batch.data()); });
+  printResult("batch", batchMs, double(batch.size()) * sizeof(float) + basisBytes);
+  const double loopMs = benchmark::medianMilliseconds(1, [&] {
+    for (unsigned s = 0; s < numberOfSamples; ++s)
+    {
+      evaluator.evaluate(coefficients.get_row(s), &batch[s * numberOfRows]);
+    }
+  });
+  printResult("batch, one instance at a time", loopMs, double(batch.size()) * sizeof(float));
+
+  return 0;
+}
@@ -0,0 +1,219 @@
+// Compares showing an image and a mesh straight from memory-mapped files with loading them first, end to end on an
+// in-process mock service. Each mode runs in its own process so that the peak resident memory it reports
+// (getrusage) is its own:
+//
+//   file-source-bench --write [--edge n] [--mesh-vertices n] [--dir d]   writes a NRRD image and a packed mesh
+//   file-source-bench --mode mapped|loaded [--port port] [--dir d]        shows them and reports time and memory
+//
+// mapped uses showImage and showTriangleMesh with the file paths, loaded reads the files into an itk::Image and an
+// itk::Mesh and sends them with showPackedImage and showPackedTriangleMesh.
+
+#include "BenchmarkUtils.h"
+#include "MockUIService.h"
+
+#include <sys/resource.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+using ImageType = itk::Image<short, 3>;
+using MeshType = benchmark::MeshType;
+
+// Peak resident memory of the process in MiB (ru_maxrss is in KiB on Linux)
+double
+peakResidentMiB()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024.0;
+}
+
+// Writes the gradient of benchmark::makeImage slice by slice, without holding the image
+void
+writeNrrd(const std::string & path, unsigned edge)
+{
+  std::ofstream file(path, std::ios::binary);
+  file << "NRRD0004\ntype: short\ndimension: 3\nsizes: " << edge << " " << edge << " " << edge
+       << "\nspace: left-posterior-superior\nspace directions: (1,0,0) (0,1,0) (0,0,1)\n"
+       << "space origin: (0,0,0)\nencoding: raw\nendian: little\n\n";
+
+  std::vector<short> slice(static_cast<std::size_t>(edge) * edge);
+  for (std::size_t z = 0; z < edge; ++z)
+  {
+    for (std::size_t i = 0; i < slice.size(); ++i)
+    {
+      slice[i] = static_cast<short>((z * slice.size() + i) % 4096);
+    }
+    file.write(reinterpret_cast<const char *>(slice.data()), slice.size() * sizeof(short));
+  }
+  if (!file)
+  {
+    throw std::runtime_error("cannot write " + path);
+  }
+}
+
+// Reads the image written by writeNrrd
+ImageType::Pointer
+readNrrd(const std::string & path)
+{
+  std::ifstream file(path, std::ios::binary);
+  std::string   line;
+  unsigned      edge = 0;
+  while (std::getline(file, line) && !line.empty())
+  {
+    if (line.compare(0, 7, "sizes: ") == 0)
+    {
+      edge = std::stoul(line.substr(7));
+    }
+  }
+
+  ImageType::SizeType size;
+  size.Fill(edge);
+  auto image = ImageType::New();
+  image->SetRegions(ImageType::RegionType(size));
+  image->Allocate();
+  file.read(reinterpret_cast<char *>(image->GetBufferPointer()),
+            image->GetPixelContainer()->Size() * sizeof(short));
+  if (!file)
+  {
+    throw std::runtime_error("cannot read " + path);
+  }
+  return image;
+}
+
+// Reads a packed mesh file into an itk::Mesh
+MeshType::Pointer
+readPackedMesh(const std::string & path)
+{
+  std::ifstream file(path, std::ios::binary);
+  char          magic[8];
+  std::uint32_t numberOfVertices = 0;
+  std::uint32_t numberOfTriangles = 0;
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char *>(&numberOfVertices), sizeof(numberOfVertices));
+  file.read(reinterpret_cast<char *>(&numberOfTriangles), sizeof(numberOfTriangles));
+
+  auto mesh = MeshType::New();
+  for (std::uint32_t v = 0; v < numberOfVertices; ++v)
+  {
+    float xyz[3];
+    file.read(reinterpret_cast<char *>(xyz), sizeof(xyz));
+    MeshType::PointType p;
+    p[0] = xyz[0];
+    p[1] = xyz[1];
+    p[2] = xyz[2];
+    mesh->SetPoint(v, p);
+  }
+  for (std::uint32_t t = 0; t < numberOfTriangles; ++t)
+  {
+    std::int32_t ids[3];
+    file.read(reinterpret_cast<char *>(ids), sizeof(ids));
+    benchmark::addTriangle(mesh, t, ids[0], ids[1], ids[2]);
+  }
+  if (!file)
+  {
+    throw std::runtime_error("cannot read " + path);
+  }
+  return mesh;
+}
+} // namespace
+
+int
+main(int argc, char ** argv)
+{
+  using namespace StatismoUI;
+
+  ConnectionOptions options;
+  options.port = 18002;
+  std::string mode;
+  std::string dir = ".";
+  unsigned    edge = 512;
+  unsigned    meshVertices = 2000000;
+  bool        write = false;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--port" && i + 1 < argc)
+    {
+      options.port = std::stoi(argv[++i]);
+    }
+    else if (arg == "--mode" && i + 1 < argc)
+    {
+      mode = argv[++i];
+    }
+    else if (arg == "--dir" && i + 1 < argc)
+    {
+      dir = argv[++i];
+    }
+    else if (arg == "--edge" && i + 1 < argc)
+    {
+      edge = std::stoul(argv[++i]);
+    }
+    else if (arg == "--mesh-vertices" && i + 1 < argc)
+    {
+      meshVertices = std::stoul(argv[++i]);
+    }
+    else if (arg == "--write")
+    {
+      write = true;
+    }
+    else
+    {
+      std::cerr << "usage: file-source-bench --write [--edge n] [--mesh-vertices n] [--dir d]" << std::endl
+                << "       file-source-bench --mode mapped|loaded [--port port] [--dir d]" << std::endl;
+      return 1;
+    }
+  }
+
+  const std::string imagePath = dir + "/file-source-bench.nrrd";
+  const std::string meshPath = dir + "/file-source-bench.mesh";
+  if (write)
+  {
+    writeNrrd(imagePath, edge);
+    writePackedMeshFile(meshPath, benchmark::makeTorusMesh(meshVertices).GetPointer());
+    std::cout << "wrote " << imagePath << " and " << meshPath << std::endl;
+    return 0;
+  }
+  if (mode != "mapped" && mode != "loaded")
+  {
+    std::cerr << "--mode must be mapped or loaded" << std::endl;
+    return 1;
+  }
+
+  MockUIServer           server(options);
+  StatismoUI::StatismoUI ui(options);
+  Group                  group = ui.createGroup("file-source-bench");
+  const double           baseline = peakResidentMiB();
+
+  auto report = [&](const std::string & label, auto && f) {
+    double ms = benchmark::medianMilliseconds(1, f);
+    std::cout << std::left << std::setw(28) << label << std::right << std::setw(12) << std::fixed
+              << std::setprecision(2) << ms << " ms" << std::setw(12) << std::setprecision(1)
+              << peakResidentMiB() - baseline << " MiB peak RSS over baseline" << std::endl;
+  };
+
+  if (mode == "mapped")
+  {
+    report("showImage (mapped)", [&]() { ui.showImage(group, imagePath, "image"); });
+    report("showTriangleMesh (mapped)", [&]() { ui.showTriangleMesh(group, meshPath, "mesh"); });
+  }
+  else
+  {
+    report("showPackedImage (loaded)", [&]() {
+      auto image = readNrrd(imagePath);
+      ui.showPackedImage(group, image.GetPointer(), "image");
+    });
+    report("showPackedTriangleMesh (loaded)", [&]() {
+      auto mesh = readPackedMesh(meshPath);
+      ui.showPackedTriangleMesh(group, mesh.GetPointer(), "mesh");
+    });
+  }
+  return 0;
+}
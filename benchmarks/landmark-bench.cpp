@@ -0,0 +1,89 @@
+// Compares the throughput of the batched landmark encoding with the decomposition of the covariances one by one,
+// then times showLandmark against showLandmarks end to end on an in-process mock service.
+// tests/landmark-encoding-test checks the encoding against vnl_svd.
+//
+// usage: landmark-bench [--port port] [--repetitions n] [numberOfLandmarks]
+
+#include "BenchmarkUtils.h"
+#include "MockUIService.h"
+#include "ParallelFor.h"
+#include "ThriftConversions.h"
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+using PointType = itk::Mesh<float, 3>::PointType;
+} // namespace
+
+int
+main(int argc, char ** argv)
+{
+  using namespace StatismoUI;
+
+  ConnectionOptions options;
+  unsigned          repetitions = 5;
+  std::size_t       numberOfLandmarks = 10000;
+  options.port = 18001;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--port" && i + 1 < argc)
+    {
+      options.port = std::stoi(argv[++i]);
+    }
+    else if (arg == "--repetitions" && i + 1 < argc)
+    {
+      repetitions = std::stoul(argv[++i]);
+    }
+    else
+    {
+      numberOfLandmarks = std::stoul(arg);
+    }
+  }
+
+  std::vector<PointType>          points(numberOfLandmarks);
+  std::vector<std::string>        names(numberOfLandmarks);
+  std::vector<vnl_matrix<double>> covariances = benchmark::makeCovariances(numberOfLandmarks);
+  for (std::size_t l = 0; l < numberOfLandmarks; ++l)
+  {
+    points[l].Fill(static_cast<float>(l));
+    names[l] = "landmark-" + std::to_string(l);
+  }
+
+  std::cout << numberOfLandmarks << " landmarks" << std::endl;
+
+  auto report = [&](const std::string & label, auto && f) {
+    double ms = benchmark::medianMilliseconds(repetitions, f);
+    std::cout << std::left << std::setw(36) << label << std::right << std::setw(12) << std::fixed
+              << std::setprecision(2) << ms << " ms" << std::setw(14) << std::setprecision(0)
+              << numberOfLandmarks / ms * 1000 << " landmarks/s" << std::endl;
+  };
+
+  report("vnl_svd one by one", [&]() {
+    for (const auto & cov : covariances)
+    {
+      vnl_svd<double> svd(cov);
+    }
+  });
+  setNumberOfWorkerThreads(1);
+  report("landmarksToThrift (1 thread)", [&]() { conversions::landmarksToThrift(points, covariances, names); });
+  setNumberOfWorkerThreads(0);
+  report("landmarksToThrift (" + std::to_string(getNumberOfWorkerThreads()) + " threads)",
+         [&]() { conversions::landmarksToThrift(points, covariances, names); });
+
+  MockUIServer           server(options);
+  StatismoUI::StatismoUI ui(options);
+  Group                  group = ui.createGroup("landmark-bench");
+  report("showLandmark one by one", [&]() {
+    for (std::size_t l = 0; l < numberOfLandmarks; ++l)
+    {
+      ui.showLandmark(group, points[l], covariances[l], names[l]);
+    }
+  });
+  report("showLandmarks", [&]() { ui.showLandmarks(group, points, covariances, names); });
+
+  return 0;
+}
@@ -0,0 +1,134 @@
+// Compares the struct-list (TriangleMesh, StatisticalShapeModel) and the packed
+// (PackedTriangleMesh, PackedStatisticalShapeModel) encodings: encode time,
+// serialization time and bytes on the wire. A double precision mesh is encoded
+// through the mesh adapter and, as clients had to before, copied to a float mesh first.
+//
+// usage: mesh-encoding-bench [--repetitions n] [--model model.h5] [numberOfVertices ...]
+
+#include "BenchmarkUtils.h"
+#include "ThriftConversions.h"
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+using MeshType = itk::Mesh<float, 3>;
+using DoubleMeshType = itk::Mesh<double, 3>;
+
+// Copies the points and the triangles of a mesh into a mesh of another type
+template <typename TOutputMesh, typename TInputMesh>
+typename TOutputMesh::Pointer
+copyMesh(const TInputMesh * input)
+{
+  auto output = TOutputMesh::New();
+  for (typename TInputMesh::PointIdentifier i = 0; i < input->GetNumberOfPoints(); ++i)
+  {
+    typename TOutputMesh::PointType point;
+    point.CastFrom(input->GetPoint(i));
+    output->SetPoint(i, point);
+  }
+  for (typename TInputMesh::CellIdentifier i = 0; i < input->GetNumberOfCells(); ++i)
+  {
+    auto                                  ids = input->GetCells()->GetElement(i)->PointIdsBegin();
+    typename TOutputMesh::CellAutoPointer cell;
+    cell.TakeOwnership(new itk::TriangleCell<typename TOutputMesh::CellType>);
+    cell->SetPointIds(ids);
+    output->SetCell(i, cell);
+  }
+  return output;
+}
+
+template <typename EncodeFunction>
+void
+report(const std::string & label, unsigned repetitions, EncodeFunction && encode)
+{
+  auto     encoded = encode();
+  uint32_t bytes = 0;
+  double   encodeMs = benchmark::medianMilliseconds(repetitions, [&]() { encoded = encode(); });
+  double   serializeMs =
+    benchmark::medianMilliseconds(repetitions, [&]() { bytes = benchmark::serializeToMemory(encoded); });
+
+  std::cout << std::left << std::setw(36) << label << std::right << std::setw(12) << std::fixed
+            << std::setprecision(2) << encodeMs << std::setw(14) << serializeMs << std::setw(16) << bytes << std::endl;
+}
+
+void
+printHeader()
+{
+  std::cout << std::left << std::setw(36) << "payload" << std::right << std::setw(12) << "encode ms" << std::setw(14)
+            << "serialize ms" << std::setw(16) << "bytes" << std::endl;
+}
+} // namespace
+
+int
+main(int argc, char ** argv)
+{
+  using namespace StatismoUI;
+
+  unsigned              repetitions = 5;
+  std::string           modelFile;
+  std::vector<unsigned> sizes;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--repetitions" && i + 1 < argc)
+    {
+      repetitions = std::stoul(argv[++i]);
+    }
+    else if (arg == "--model" && i + 1 < argc)
+    {
+      modelFile = argv[++i];
+    }
+    else
+    {
+      sizes.push_back(std::stoul(arg));
+    }
+  }
+  if (sizes.empty())
+  {
+    sizes = { 10000, 100000, 500000 };
+  }
+
+  printHeader();
+  for (unsigned n : sizes)
+  {
+    MeshType::Pointer mesh = benchmark::makeTorusMesh(n);
+    std::string       suffix = " (" + std::to_string(mesh->GetNumberOfPoints()) + " vertices)";
+
+    report("TriangleMesh" + suffix, repetitions, [&]() { return conversions::meshToThriftMesh(mesh); });
+    report("PackedTriangleMesh f32" + suffix, repetitions, [&]() {
+      return conversions::meshToPackedThriftMesh(mesh, ScalarType::Float32);
+    });
+    report("PackedTriangleMesh f64" + suffix, repetitions, [&]() {
+      return conversions::meshToPackedThriftMesh(mesh, ScalarType::Float64);
+    });
+
+    DoubleMeshType::Pointer doubleMesh = copyMesh<DoubleMeshType>(mesh.GetPointer());
+    report("Mesh<double> adapter f64" + suffix, repetitions, [&]() {
+      std::vector<std::int32_t> triangles;
+      return conversions::meshBuffersToPackedThrift(detail::meshBuffers(doubleMesh.GetPointer(), triangles));
+    });
+    report("Mesh<double> to float mesh f32" + suffix, repetitions, [&]() {
+      MeshType::Pointer floatMesh = copyMesh<MeshType>(doubleMesh.GetPointer());
+      return conversions::meshToPackedThriftMesh(floatMesh, ScalarType::Float32);
+    });
+  }
+
+  if (!modelFile.empty())
+  {
+    auto representer = itk::StandardMeshRepresenter<float, 3>::New();
+    auto model = itk::StatismoIO<MeshType>::LoadStatisticalModel(representer, modelFile.c_str());
+    std::string suffix = " (" + std::to_string(model->GetNumberOfPrincipalComponents()) + " components)";
+
+    report("StatisticalShapeModel" + suffix, repetitions, [&]() {
+      return conversions::statisticalModelToThrift(model);
+    });
+    report("PackedStatisticalShapeModel f32" + suffix, repetitions, [&]() {
+      return conversions::statisticalModelToPackedThrift(model, ScalarType::Float32);
+    });
+  }
+
+  return 0;
+}
@@ -0,0 +1,109 @@
+// Restarts an in-process mock service under a client with reconnect enabled: shows a scene, stops the service, keeps
+// calling while it is down and starts a new service on the same port. Reports the latency of the calls connected and
+// offline (they must not stall) and the time to restore the scene. tests/reconnect-test checks the restored scene.
+//
+//   reconnect-bench [--port port] [--mesh-vertices n] [--updates n]
+
+#include "BenchmarkUtils.h"
+#include "MockUIService.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+void
+printLatency(const std::string & label, const benchmark::Latency & latency)
+{
+  std::cout << std::left << std::setw(36) << label << std::right << std::fixed << std::setprecision(3)
+            << std::setw(10) << latency.meanMs << " ms mean" << std::setw(10) << latency.maxMs << " ms max"
+            << std::endl;
+}
+} // namespace
+
+int
+main(int argc, char ** argv)
+{
+  using namespace StatismoUI;
+
+  ConnectionOptions options;
+  options.port = 18003;
+  options.shared = false;
+  options.connectTimeoutMs = 1000;
+  options.reconnect.enabled = true;
+  options.reconnect.initialBackoffMs = 50;
+  options.reconnect.maxBackoffMs = 500;
+  unsigned meshVertices = 10000;
+  unsigned updates = 1000;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--port" && i + 1 < argc)
+    {
+      options.port = std::stoi(argv[++i]);
+    }
+    else if (arg == "--mesh-vertices" && i + 1 < argc)
+    {
+      meshVertices = std::stoul(argv[++i]);
+    }
+    else if (arg == "--updates" && i + 1 < argc)
+    {
+      updates = std::stoul(argv[++i]);
+    }
+    else
+    {
+      std::cerr << "usage: reconnect-bench [--port port] [--mesh-vertices n] [--updates n]" << std::endl;
+      return 1;
+    }
+  }
+
+  auto                   server = std::make_unique<MockUIServer>(options);
+  StatismoUI::StatismoUI ui(options);
+  auto                   mesh = benchmark::makeTorusMesh(meshVertices);
+
+  Group                         kept = ui.createGroup("kept");
+  Group                         removed = ui.createGroup("removed");
+  std::vector<TriangleMeshView> views;
+  views.push_back(ui.showPackedTriangleMesh(kept, mesh.GetPointer(), "mesh 1"));
+  views.push_back(ui.showPackedTriangleMesh(kept, mesh.GetPointer(), "mesh 2"));
+  ui.showPackedTriangleMesh(removed, mesh.GetPointer(), "mesh 3");
+
+  auto recolor = [&](unsigned i) {
+    TriangleMeshView & view = views[i % views.size()];
+    view.SetColor(Color(i % 256, 128, 255 - i % 256));
+    ui.updateTriangleMeshView(view);
+  };
+  printLatency("updateTriangleMeshView (connected)", benchmark::measureLatency(updates, recolor));
+
+  server->stop();
+  server.reset();
+
+  printLatency("updateTriangleMeshView (offline)", benchmark::measureLatency(updates, recolor));
+  views.push_back(ui.showPackedTriangleMesh(kept, mesh.GetPointer(), "mesh 4"));
+  ui.removeGroup(removed);
+
+  ConnectionStatus status = ui.getConnectionStatus();
+  std::cout << "offline: " << status.pendingOperations << " operations pending, " << status.droppedOperations
+            << " dropped" << std::endl;
+
+  auto start = std::chrono::steady_clock::now();
+  server = std::make_unique<MockUIServer>(options);
+  while (!ui.getConnectionStatus().connected && std::chrono::steady_clock::now() - start < std::chrono::seconds(30))
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  const double restoreMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  status = ui.getConnectionStatus();
+  std::cout << "reconnected and restored the scene in " << std::fixed << std::setprecision(1) << restoreMs << " ms ("
+            << status.reconnects << " reconnects, " << status.failedOperations << " failed operations)" << std::endl;
+
+  // the views returned before the restart still work
+  printLatency("updateTriangleMeshView (restored)", benchmark::measureLatency(updates, recolor));
+
+  return 0;
+}
@@ -0,0 +1,114 @@
+// Measures what recording a session costs the calling thread, on an in-process mock service: the latency of view
+// updates and mesh uploads without and with ConnectionOptions::recordPath, then the time to replay the log into a
+// second mock service. tests/record-replay-test checks the replayed scene.
+//
+//   record-bench [--port port] [--mesh-vertices n] [--updates n] [--log path]
+
+#include "BenchmarkUtils.h"
+#include "MockUIService.h"
+#include "SessionPlayer.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace
+{
+// Shows a mesh, recolors it the given number of times and shows it 10 more times; returns the latencies of both
+std::vector<benchmark::Latency>
+run(const StatismoUI::ConnectionOptions & options, const benchmark::MeshType * mesh, unsigned updates)
+{
+  StatismoUI::StatismoUI       ui(options);
+  StatismoUI::Group            group = ui.createGroup("record-bench");
+  StatismoUI::TriangleMeshView view = ui.showPackedTriangleMesh(group, mesh, "mesh");
+
+  std::vector<benchmark::Latency> results;
+  results.push_back(benchmark::measureLatency(updates, [&](unsigned i) {
+    view.SetColor(StatismoUI::Color(i % 256, 128, 255 - i % 256));
+    ui.updateTriangleMeshView(view);
+  }));
+  results.push_back(benchmark::measureLatency(10, [&](unsigned) { ui.showPackedTriangleMesh(group, mesh, "mesh"); }));
+  ui.removeTriangleMesh(view);
+  return results;
+}
+} // namespace
+
+int
+main(int argc, char ** argv)
+{
+  using namespace StatismoUI;
+
+  ConnectionOptions options;
+  options.port = 18004;
+  options.shared = false;
+  options.reconnect.enabled = true;
+  unsigned    meshVertices = 100000;
+  unsigned    updates = 10000;
+  std::string path = "record-bench.log";
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--port" && i + 1 < argc)
+    {
+      options.port = std::stoi(argv[++i]);
+    }
+    else if (arg == "--mesh-vertices" && i + 1 < argc)
+    {
+      meshVertices = std::stoul(argv[++i]);
+    }
+    else if (arg == "--updates" && i + 1 < argc)
+    {
+      updates = std::stoul(argv[++i]);
+    }
+    else if (arg == "--log" && i + 1 < argc)
+    {
+      path = argv[++i];
+    }
+    else
+    {
+      std::cerr << "usage: record-bench [--port port] [--mesh-vertices n] [--updates n] [--log path]" << std::endl;
+      return 1;
+    }
+  }
+
+  ConnectionOptions recordOptions = options;
+  recordOptions.port = options.port + 1;
+  recordOptions.recordPath = path;
+
+  auto                            mesh = benchmark::makeTorusMesh(meshVertices);
+  std::vector<benchmark::Latency> plain;
+  std::vector<benchmark::Latency> recording;
+  {
+    MockUIServer server(options);
+    MockUIServer recordedServer(recordOptions);
+    plain = run(options, mesh.GetPointer(), updates);
+    recording = run(recordOptions, mesh.GetPointer(), updates);
+  }
+
+  const char * labels[] = { "updateTriangleMeshView", "showPackedTriangleMesh" };
+  std::cout << std::left << std::setw(26) << "median / max ms" << std::right << std::setw(24) << "without recording"
+            << std::setw(24) << "recording" << std::endl;
+  for (std::size_t i = 0; i < plain.size(); ++i)
+  {
+    std::cout << std::left << std::setw(26) << labels[i] << std::right << std::fixed << std::setprecision(3)
+              << std::setw(12) << plain[i].medianMs << std::setw(12) << plain[i].maxMs << std::setw(12)
+              << recording[i].medianMs << std::setw(12) << recording[i].maxMs << std::endl;
+  }
+
+  MockUIServer  replayServer(options);
+  auto          start = std::chrono::steady_clock::now();
+  SessionPlayer player(path, options);
+  player.play(0, std::numeric_limits<std::uint64_t>::max(), 0);
+  const double replayMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "replayed " << player.GetLog().size() << " requests as fast as possible in " << std::setprecision(1)
+            << replayMs << " ms" << std::endl;
+
+  std::remove(path.c_str());
+  std::remove((path + ".index").c_str());
+  return 0;
+}
@@ -0,0 +1,319 @@
+// Times client calls end to end against an in-process mock ui-service on localhost: encoding, transfer and
+// decoding of the reply. Reports latency percentiles, throughput and bytes on the wire per call, then the per-RPC
+// breakdown of the client metrics. tests/metrics-test checks the bytes the client metrics count.
+//
+// usage: rpc-bench [--port port] [--compact] [--zlib | --compressed-frames [threshold]] [--repetitions n]
+//                  [--model model.h5] [--mesh-vertices n,...] [--image-edges n,...] [--model-ranks n,...]
+//                  [--cloud-points n,...]
+
+#include "BenchmarkUtils.h"
+#include "MockUIService.h"
+#include "SceneBatch.h"
+#include "ThriftConversions.h"
+
+#include <cctype>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string>
+
+namespace
+{
+using MeshType = itk::Mesh<float, 3>;
+
+std::vector<unsigned>
+parseList(const std::string & arg)
+{
+  std::vector<unsigned> values;
+  std::istringstream    stream(arg);
+  std::string           value;
+  while (std::getline(stream, value, ','))
+  {
+    values.push_back(std::stoul(value));
+  }
+  return values;
+}
+
+void
+printHeader()
+{
+  std::cout << std::left << std::setw(44) << "call" << std::right << std::setw(10) << "p50 ms" << std::setw(10)
+            << "p90 ms" << std::setw(10) << "p99 ms" << std::setw(10) << "max ms" << std::setw(12) << "calls/s"
+            << std::setw(10) << "MB/s" << std::setw(14) << "bytes/call" << std::endl;
+}
+
+template <typename CallFunction>
+void
+report(const std::string & label, StatismoUI::MockUIServer & server, unsigned repetitions, CallFunction && call)
+{
+  call(); // warm up
+
+  const std::uint64_t bytesBefore = server.GetBytesReceived() + server.GetBytesSent();
+  std::vector<double> times = benchmark::sampleMilliseconds(repetitions, call);
+  const std::uint64_t bytes = server.GetBytesReceived() + server.GetBytesSent() - bytesBefore;
+
+  const double totalSeconds = std::accumulate(times.begin(), times.end(), 0.0) / 1000;
+  std::cout << std::left << std::setw(44) << label << std::right << std::fixed << std::setprecision(3)
+            << std::setw(10) << benchmark::percentile(times, 50) << std::setw(10) << benchmark::percentile(times, 90)
+            << std::setw(10) << benchmark::percentile(times, 99) << std::setw(10) << times.back()
+            << std::setprecision(1) << std::setw(12) << times.size() / totalSeconds << std::setw(10)
+            << bytes / totalSeconds / 1e6 << std::setw(14) << bytes / times.size() << std::endl;
+}
+
+// Where the time of each RPC went, as measured by the client instrumentation (medians, in microseconds)
+void
+printMetrics(const std::vector<StatismoUI::RpcMetrics> & metrics)
+{
+  std::cout << std::endl
+            << std::left << std::setw(40) << "rpc" << std::right << std::setw(8) << "calls" << std::setw(12)
+            << "encode us" << std::setw(14) << "serialize us" << std::setw(14) << "roundtrip us" << std::setw(16)
+            << "bytes written" << std::setw(12) << "bytes read" << std::endl;
+  for (const auto & rpc : metrics)
+  {
+    std::cout << std::left << std::setw(40) << rpc.name << std::right << std::setw(8) << rpc.calls << std::fixed
+              << std::setprecision(1) << std::setw(12) << rpc.encodeNanoseconds.percentile(50) / 1e3 << std::setw(14)
+              << rpc.serializeNanoseconds.percentile(50) / 1e3 << std::setw(14)
+              << rpc.roundTripNanoseconds.percentile(50) / 1e3 << std::setprecision(0) << std::setw(16)
+              << rpc.bytesWritten.mean() << std::setw(12) << rpc.bytesRead.mean() << std::endl;
+  }
+}
+
+// Shape model view of the given rank, created directly in the service so that updates can be timed without a
+// model file
+StatismoUI::ShapeModelView
+makeShapeModelView(StatismoUI::MockUIService & service, const StatismoUI::Group & group, unsigned rank)
+{
+  ui::PackedStatisticalShapeModel model;
+  model.reference.numberOfVertices = 0;
+  model.reference.numberOfTriangles = 0;
+  model.reference.vertexType = ui::ScalarType::FLOAT32;
+  model.meanType = ui::ScalarType::FLOAT32;
+  model.klbasis.numberOfComponents = rank;
+  model.klbasis.scalarType = ui::ScalarType::FLOAT32;
+  model.klbasis.eigenvalues.assign(rank, 1.0);
+
+  ui::ShapeModelView view;
+  service.showPackedStatisticalShapeModel(
+    view, StatismoUI::conversions::groupToThriftGroup(group), model, "rank " + std::to_string(rank));
+  return StatismoUI::conversions::shapeModelViewFromThrift(view);
+}
+} // namespace
+
+int
+main(int argc, char ** argv)
+{
+  using namespace StatismoUI;
+
+  ConnectionOptions     options;
+  unsigned              repetitions = 20;
+  std::string           modelFile;
+  std::vector<unsigned> meshSizes = { 10000, 100000 };
+  std::vector<unsigned> imageEdges = { 64, 128 };
+  std::vector<unsigned> modelRanks = { 10, 50, 200 };
+  std::vector<unsigned> cloudSizes = { 100000, 1000000 };
+  options.port = 18000;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--compact")
+    {
+      options.protocol = Protocol::Compact;
+    }
+    else if (arg == "--zlib")
+    {
+      options.transport = Transport::Zlib;
+    }
+    else if (arg == "--compressed-frames")
+    {
+      options.transport = Transport::CompressedFrames;
+      if (i + 1 < argc && std::isdigit(argv[i + 1][0]))
+      {
+        options.compressionThreshold = std::stoul(argv[++i]);
+      }
+    }
+    else if (i + 1 >= argc)
+    {
+      std::cerr << "missing value for " << arg << std::endl;
+      return 1;
+    }
+    else if (arg == "--port")
+    {
+      options.port = std::stoi(argv[++i]);
+    }
+    else if (arg == "--repetitions")
+    {
+      repetitions = std::stoul(argv[++i]);
+    }
+    else if (arg == "--model")
+    {
+      modelFile = argv[++i];
+    }
+    else if (arg == "--mesh-vertices")
+    {
+      meshSizes = parseList(argv[++i]);
+    }
+    else if (arg == "--image-edges")
+    {
+      imageEdges = parseList(argv[++i]);
+    }
+    else if (arg == "--model-ranks")
+    {
+      modelRanks = parseList(argv[++i]);
+    }
+    else if (arg == "--cloud-points")
+    {
+      cloudSizes = parseList(argv[++i]);
+    }
+    else
+    {
+      std::cerr << "unknown argument " << arg << std::endl;
+      return 1;
+    }
+  }
+
+  MockUIServer server(options);
+  StatismoUI::StatismoUI ui(options);
+  Group                  group = ui.createGroup("rpc-bench");
+
+  printHeader();
+  for (unsigned n : meshSizes)
+  {
+    MeshType::Pointer mesh = benchmark::makeTorusMesh(n);
+    std::string       suffix = " (" + std::to_string(mesh->GetNumberOfPoints()) + " vertices)";
+
+    report("showTriangleMesh" + suffix, server, repetitions, [&]() { ui.showTriangleMesh(group, mesh, "mesh"); });
+    report("showPackedTriangleMesh" + suffix, server, repetitions, [&]() {
+      ui.showPackedTriangleMesh(group, mesh, "mesh");
+    });
+
+    TriangleMeshView meshView = ui.showPackedTriangleMesh(group, mesh, "mesh");
+    report("updateTriangleMeshVertices full" + suffix, server, repetitions, [&]() {
+      ui.updateTriangleMeshVertices(meshView, mesh, VertexUpdateMode::Full);
+    });
+    // a different 1% of the vertices moves before each update
+    unsigned step = 0;
+    report("updateTriangleMeshVertices delta 1%" + suffix, server, repetitions, [&]() {
+      for (unsigned i = step++ % 100; i < mesh->GetNumberOfPoints(); i += 100)
+      {
+        MeshType::PointType pt = mesh->GetPoint(i);
+        pt[2] += 0.1f;
+        mesh->SetPoint(i, pt);
+      }
+      ui.updateTriangleMeshVertices(meshView, mesh, VertexUpdateMode::Delta);
+    });
+  }
+
+  for (unsigned edge : imageEdges)
+  {
+    auto        image = benchmark::makeImage(edge);
+    std::string suffix = " (" + std::to_string(edge) + "^3)";
+
+    report("showImage" + suffix, server, repetitions, [&]() { ui.showImage(group, image, "image"); });
+    report("showPackedImage" + suffix, server, repetitions, [&]() {
+      ui.showPackedImage(group, image.GetPointer(), "image");
+    });
+    // time to the first view, then the full resolution on demand
+    report("showImagePyramid" + suffix, server, repetitions, [&]() {
+      ui.showImagePyramid(group, image.GetPointer(), "image");
+    });
+    ImageView imageView = ui.showImagePyramid(group, image.GetPointer(), "image");
+    report("showImageLevel 0" + suffix, server, repetitions, [&]() { ui.showImageLevel(imageView, 0); });
+  }
+
+  for (unsigned n : cloudSizes)
+  {
+    std::list<MeshType::PointType> points;
+    for (unsigned i = 0; i < n; ++i)
+    {
+      MeshType::PointType pt;
+      pt.Fill(static_cast<float>(i));
+      points.push_back(pt);
+    }
+    std::string suffix = " (" + std::to_string(n) + " points)";
+
+    report("showPointCloud" + suffix, server, repetitions, [&]() { ui.showPointCloud(group, points, "cloud"); });
+    report("streamPointCloud" + suffix, server, repetitions, [&]() {
+      ui.streamPointCloud(group, points.begin(), points.end(), "cloud");
+    });
+  }
+
+  // the same 100 landmarks, one call each and in a single scene batch
+  vnl_matrix<double>  cov(3, 3);
+  MeshType::PointType landmark;
+  cov.set_identity();
+  landmark.Fill(0);
+  report("showLandmark x100", server, repetitions, [&]() {
+    for (unsigned i = 0; i < 100; ++i)
+    {
+      ui.showLandmark(group, landmark, cov, "landmark");
+    }
+  });
+  report("applySceneBatch (100 landmarks)", server, repetitions, [&]() {
+    SceneBatch batch;
+    for (unsigned i = 0; i < 100; ++i)
+    {
+      batch.showLandmark(group, landmark, cov, "landmark");
+    }
+    ui.applySceneBatch(batch);
+  });
+
+  for (unsigned rank : modelRanks)
+  {
+    ShapeModelView view = makeShapeModelView(server.GetService(), group, rank);
+    std::string    suffix = " (rank " + std::to_string(rank) + ")";
+
+    report("updateShapeModelTransformationView" + suffix, server, repetitions, [&]() {
+      ui.updateShapeModelTransformationView(view);
+    });
+  }
+
+  if (!modelFile.empty())
+  {
+    for (unsigned rank : modelRanks)
+    {
+      auto representer = itk::StandardMeshRepresenter<float, 3>::New();
+      auto model = itk::StatismoIO<MeshType>::LoadStatisticalModel(representer, modelFile.c_str(), rank);
+      std::string suffix = " (rank " + std::to_string(model->GetNumberOfPrincipalComponents()) + ")";
+
+      report("showStatisticalShapeModel" + suffix, server, repetitions, [&]() {
+        ui.showStatisticalShapeModel(group, model, "model");
+      });
+      report("showPackedStatisticalShapeModel" + suffix, server, repetitions, [&]() {
+        ui.showPackedStatisticalShapeModel(group, model, "model");
+      });
+      report("showRegisteredStatisticalShapeModel" + suffix, server, repetitions, [&]() {
+        ui.showRegisteredStatisticalShapeModel(group, model, "model");
+      });
+      // time to the first view, the remaining components are still being appended by the following calls
+      report("showProgressiveStatisticalShapeModel" + suffix, server, repetitions, [&]() {
+        ui.showProgressiveStatisticalShapeModel(group, model, "model");
+      });
+      ui.waitForShapeModelUploads();
+    }
+  }
+
+  // the client counts the same bytes on its socket as the server on its own
+  const auto    metrics = ui.getMetrics();
+  std::uint64_t bytesWritten = 0;
+  std::uint64_t bytesRead = 0;
+  for (const auto & rpc : metrics)
+  {
+    bytesWritten += rpc.bytesWritten.sum;
+    bytesRead += rpc.bytesRead.sum;
+  }
+  printMetrics(metrics);
+  std::cout << "client metrics: " << bytesWritten << " bytes written, " << bytesRead << " bytes read (server: "
+            << server.GetBytesReceived() << " received, " << server.GetBytesSent() << " sent)" << std::endl
+            << std::endl;
+
+  // cost of the instrumentation on the smallest call
+  ConnectionOptions uninstrumented = options;
+  uninstrumented.collectMetrics = false;
+  StatismoUI::StatismoUI plain(uninstrumented);
+  printHeader();
+  report("createGroup", server, repetitions * 50, [&]() { ui.createGroup("group"); });
+  report("createGroup (without metrics)", server, repetitions * 50, [&]() { plain.createGroup("group"); });
+
+  return 0;
+}
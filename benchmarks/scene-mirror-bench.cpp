@@ -0,0 +1,133 @@
+// Replays the update loop of an interactive application on an in-process mock service: every frame, the properties
+// of all views are updated, but only those of one view changed. Compares the requests sent and the time per frame
+// without and with ConnectionOptions::skipUnchangedUpdates. tests/scene-mirror-test checks which requests are sent.
+//
+//   scene-mirror-bench [--port port] [--meshes n] [--images n] [--frames n]
+
+#include "BenchmarkUtils.h"
+#include "MockUIService.h"
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+struct Result
+{
+  double        msPerFrame{ 0 };
+  std::size_t   calls{ 0 };
+  std::uint64_t skipped{ 0 };
+};
+
+Result
+run(const StatismoUI::ConnectionOptions & options, unsigned meshes, unsigned images, unsigned frames)
+{
+  StatismoUI::MockUIServer server(options);
+  StatismoUI::StatismoUI   ui(options);
+  StatismoUI::Group        group = ui.createGroup("scene-mirror-bench");
+
+  auto                                      mesh = benchmark::makeTorusMesh(1000);
+  auto                                      image = benchmark::makeImage(16);
+  std::vector<StatismoUI::TriangleMeshView> meshViews;
+  std::vector<StatismoUI::ImageView>        imageViews;
+  for (unsigned i = 0; i < meshes; ++i)
+  {
+    meshViews.push_back(ui.showPackedTriangleMesh(group, mesh.GetPointer(), "mesh " + std::to_string(i)));
+  }
+  for (unsigned i = 0; i < images; ++i)
+  {
+    imageViews.push_back(ui.showPackedImage(group, image.GetPointer(), "image " + std::to_string(i)));
+  }
+
+  Result            result;
+  const std::size_t callsBefore = server.GetService().GetStatistics().numberOfCalls;
+  result.msPerFrame = benchmark::medianMilliseconds(frames, [&, frame = 0u]() mutable {
+    // one view changes per frame, alternately a mesh and an image
+    if (imageViews.empty() || (frame % 2 == 0 && !meshViews.empty()))
+    {
+      StatismoUI::TriangleMeshView & view = meshViews[frame / 2 % meshViews.size()];
+      view.SetOpacity(view.GetOpacity() == 1.0 ? 0.5 : 1.0);
+    }
+    else
+    {
+      StatismoUI::ImageView & view = imageViews[frame / 2 % imageViews.size()];
+      view.SetWindow(view.GetWindow() + 1);
+    }
+    ++frame;
+    for (const auto & view : meshViews)
+    {
+      ui.updateTriangleMeshView(view);
+    }
+    for (const auto & view : imageViews)
+    {
+      ui.updateImageView(view);
+    }
+  });
+  result.calls = server.GetService().GetStatistics().numberOfCalls - callsBefore;
+  result.skipped = ui.getNumberOfSkippedUpdates();
+  return result;
+}
+} // namespace
+
+int
+main(int argc, char ** argv)
+{
+  using namespace StatismoUI;
+
+  ConnectionOptions options;
+  options.port = 18006;
+  options.shared = false;
+  unsigned meshes = 50;
+  unsigned images = 10;
+  unsigned frames = 200;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--port" && i + 1 < argc)
+    {
+      options.port = std::stoi(argv[++i]);
+    }
+    else if (arg == "--meshes" && i + 1 < argc)
+    {
+      meshes = std::stoul(argv[++i]);
+    }
+    else if (arg == "--images" && i + 1 < argc)
+    {
+      images = std::stoul(argv[++i]);
+    }
+    else if (arg == "--frames" && i + 1 < argc)
+    {
+      frames = std::stoul(argv[++i]);
+    }
+    else
+    {
+      std::cerr << "usage: scene-mirror-bench [--port port] [--meshes n] [--images n] [--frames n]" << std::endl;
+      return 1;
+    }
+  }
+  // a frame always changes a view
+  if (meshes == 0 && images == 0)
+  {
+    images = 1;
+  }
+
+  options.skipUnchangedUpdates = false;
+  const Result all = run(options, meshes, images, frames);
+  options.skipUnchangedUpdates = true;
+  const Result changed = run(options, meshes, images, frames);
+
+  std::cout << meshes << " meshes, " << images << " images, " << frames << " frames" << std::endl;
+  std::cout << std::left << std::setw(28) << "" << std::right << std::setw(12) << "ms/frame" << std::setw(12)
+            << "requests" << std::setw(12) << "skipped" << std::endl;
+  for (const auto & row : { std::make_pair("all updates sent", all), std::make_pair("unchanged skipped", changed) })
+  {
+    std::cout << std::left << std::setw(28) << row.first << std::right << std::fixed << std::setprecision(3)
+              << std::setw(12) << row.second.msPerFrame << std::setw(12) << row.second.calls << std::setw(12)
+              << row.second.skipped << std::endl;
+  }
+
+  return 0;
+}
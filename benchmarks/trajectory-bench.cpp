@@ -0,0 +1,148 @@
+// Shows a fitting trajectory on an in-process mock service in two ways: live, with one
+// updateShapeModelTransformationView per frame, and as a ShapeTrajectory loaded with a single request and played by
+// the service. Reports the time and the bytes each takes. tests/trajectory-test checks the keyframes the service
+// shows when scrubbing and playing.
+//
+//   trajectory-bench [--port port] [--frames n] [--components n] [--fps n] [--half]
+
+#include "BenchmarkUtils.h"
+#include "MockUIService.h"
+#include "ShapeTrajectory.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+using namespace StatismoUI;
+
+// The view at frame f of a made up fitting: coefficients and pose converging from a random start
+ShapeModelTransformationView
+fittingFrame(const ShapeModelTransformationView & view, unsigned f, unsigned numberOfComponents)
+{
+  const double      progress = std::exp(-0.001 * f);
+  vnl_vector<float> coefficients(numberOfComponents);
+  for (unsigned j = 0; j < numberOfComponents; ++j)
+  {
+    coefficients[j] = progress * std::sin(1.0 + j + 0.01 * f) * 3.0 / (1 + j);
+  }
+
+  auto rigid = itk::Euler3DTransform<float>::New();
+  rigid->SetRotation(0.5 * progress, -0.2 * progress, 0.1 * progress);
+  itk::Euler3DTransform<float>::OutputVectorType translation;
+  translation.Fill(10 * progress);
+  rigid->SetTranslation(translation);
+
+  return ShapeModelTransformationView(
+    view.GetId(), PoseTransformation(*rigid), ShapeTransformation(std::move(coefficients)));
+}
+} // namespace
+
+int
+main(int argc, char ** argv)
+{
+  ConnectionOptions options;
+  options.port = 18007;
+  options.shared = false;
+  unsigned   numberOfFrames = 10000;
+  unsigned   numberOfComponents = 100;
+  double     fps = 100;
+  ScalarType scalarType = ScalarType::Float32;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--port" && i + 1 < argc)
+    {
+      options.port = std::stoi(argv[++i]);
+    }
+    else if (arg == "--frames" && i + 1 < argc)
+    {
+      numberOfFrames = std::max(3ul, std::stoul(argv[++i]));
+    }
+    else if (arg == "--components" && i + 1 < argc)
+    {
+      numberOfComponents = std::stoul(argv[++i]);
+    }
+    else if (arg == "--fps" && i + 1 < argc)
+    {
+      fps = std::stod(argv[++i]);
+    }
+    else if (arg == "--half")
+    {
+      scalarType = ScalarType::Float16;
+    }
+    else
+    {
+      std::cerr << "usage: trajectory-bench [--port port] [--frames n] [--components n] [--fps n] [--half]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  MockUIServer           server(options);
+  StatismoUI::StatismoUI ui(options);
+  Group                  group = ui.createGroup("trajectory-bench");
+
+  // a model of random modes: the service only checks the sizes
+  auto                      mesh = benchmark::makeTorusMesh(1000);
+  std::vector<std::int32_t> triangles;
+  const std::size_t         numberOfRows = 3 * std::size_t(mesh->GetNumberOfPoints());
+  vnl_matrix<float>         basis(numberOfRows, numberOfComponents);
+  vnl_vector<float>         variances(numberOfComponents, 1.0f);
+  basis.fill(0.01f);
+  ShapeModelView model = ui.showPackedStatisticalShapeModel(group,
+                                                            detail::meshBuffers(mesh.GetPointer(), triangles),
+                                                            vnl_vector<float>(numberOfRows, 0.0f),
+                                                            basis,
+                                                            variances,
+                                                            "model");
+  const ShapeModelTransformationView & view = model.GetShapeModelTransformationView();
+
+  std::vector<ShapeModelTransformationView> frames;
+  frames.reserve(numberOfFrames);
+  for (unsigned f = 0; f < numberOfFrames; ++f)
+  {
+    frames.push_back(fittingFrame(view, f, numberOfComponents));
+  }
+
+  // live: a blocking round trip per frame, as fast as the connection allows
+  std::uint64_t bytes = server.GetBytesReceived();
+  auto          start = std::chrono::steady_clock::now();
+  for (const auto & frame : frames)
+  {
+    ui.updateShapeModelTransformationView(frame);
+  }
+  const double liveMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  const double liveBytes = server.GetBytesReceived() - bytes;
+
+  // loaded: the keyframes are encoded and sent at once
+  ShapeTrajectory trajectory(scalarType);
+  trajectory.reserve(numberOfFrames);
+  bytes = server.GetBytesReceived();
+  start = std::chrono::steady_clock::now();
+  for (unsigned f = 0; f < numberOfFrames; ++f)
+  {
+    trajectory.addKeyframe(f / fps, frames[f]);
+  }
+  ui.loadShapeTrajectory(view, trajectory);
+  const double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  const double loadBytes = server.GetBytesReceived() - bytes;
+
+  std::cout << numberOfFrames << " frames of " << numberOfComponents << " coefficients and a pose" << std::endl;
+  std::cout << std::left << std::setw(36) << "" << std::right << std::setw(12) << "ms" << std::setw(12) << "requests"
+            << std::setw(12) << "MB" << std::endl;
+  std::cout << std::left << std::setw(36) << "updateShapeModelTransformationView" << std::right << std::fixed
+            << std::setprecision(1) << std::setw(12) << liveMs << std::setw(12) << numberOfFrames
+            << std::setprecision(2) << std::setw(12) << liveBytes / 1e6 << std::endl;
+  std::cout << std::left << std::setw(36) << "loadShapeTrajectory" << std::right << std::setprecision(1)
+            << std::setw(12) << loadMs << std::setw(12) << 1 << std::setprecision(2) << std::setw(12)
+            << loadBytes / 1e6 << std::endl;
+
+  return 0;
+}
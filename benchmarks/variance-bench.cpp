@@ -0,0 +1,133 @@
+// Computes the marginal variance of each point of a shape model with ShapeModelEvaluator, on one and on all threads,
+// against a 3 x 3 covariance per point formed with vnl, then colours the mesh of the model with them on an in-process
+// mock service. Reports the time of each. tests/variance-test checks the variances and the values the service holds.
+//
+//   variance-bench [--port port] [--vertices n] [--components n] [--threads n]
+
+#include "BenchmarkUtils.h"
+#include "MockUIService.h"
+#include "ParallelFor.h"
+#include "ShapeModelEvaluator.h"
+
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+// What a client does without the evaluator: the covariance of each point, U_i * diag(variances) * U_i^T, and its
+// trace
+std::vector<double>
+covarianceTraces(const vnl_matrix<float> & basis, const vnl_vector<float> & variances, float noiseVariance)
+{
+  std::vector<double> traces(basis.rows() / 3);
+  for (std::size_t i = 0; i < traces.size(); ++i)
+  {
+    vnl_matrix<double> rows(3, basis.cols());
+    vnl_matrix<double> scaledRows(3, basis.cols());
+    for (unsigned d = 0; d < 3; ++d)
+    {
+      for (unsigned j = 0; j < basis.cols(); ++j)
+      {
+        rows(d, j) = basis(3 * i + d, j);
+        scaledRows(d, j) = rows(d, j) * variances[j];
+      }
+    }
+    const vnl_matrix<double> covariance = scaledRows * rows.transpose();
+    traces[i] = covariance(0, 0) + covariance(1, 1) + covariance(2, 2) + 3.0 * noiseVariance;
+  }
+  return traces;
+}
+
+void
+printResult(const std::string & label, double ms)
+{
+  std::cout << std::left << std::setw(32) << label << std::right << std::fixed << std::setprecision(3)
+            << std::setw(10) << ms << " ms" << std::endl;
+}
+} // namespace
+
+int
+main(int argc, char ** argv)
+{
+  using namespace StatismoUI;
+
+  ConnectionOptions options;
+  options.port = 18008;
+  options.shared = false;
+  unsigned numberOfVertices = 100000;
+  unsigned numberOfComponents = 100;
+  unsigned numberOfThreads = 0;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--port" && i + 1 < argc)
+    {
+      options.port = std::stoi(argv[++i]);
+    }
+    else if (arg == "--vertices" && i + 1 < argc)
+    {
+      numberOfVertices = std::stoul(argv[++i]);
+    }
+    else if (arg == "--components" && i + 1 < argc)
+    {
+      numberOfComponents = std::stoul(argv[++i]);
+    }
+    else if (arg == "--threads" && i + 1 < argc)
+    {
+      numberOfThreads = std::stoul(argv[++i]);
+    }
+    else
+    {
+      std::cerr << "usage: variance-bench [--port port] [--vertices n] [--components n] [--threads n]" << std::endl;
+      return 1;
+    }
+  }
+
+  auto                    reference = benchmark::makeTorusMesh(numberOfVertices);
+  const std::size_t       numberOfRows = 3 * std::size_t(reference->GetNumberOfPoints());
+  const vnl_matrix<float> basis = benchmark::makeBasis(numberOfRows, numberOfComponents);
+  const float             noiseVariance = 0.1f;
+  vnl_vector<float>       variances(numberOfComponents);
+  for (unsigned i = 0; i < numberOfComponents; ++i)
+  {
+    variances[i] = 1000.0f / (i + 1);
+  }
+  const vnl_vector<float> meanDeformation(numberOfRows, 0.0f);
+
+  ShapeModelEvaluator evaluator(reference, meanDeformation, basis, variances, noiseVariance);
+
+  std::vector<double> exact;
+  printResult("vnl covariance per point",
+              benchmark::medianMilliseconds(3, [&] { exact = covarianceTraces(basis, variances, noiseVariance); }));
+
+  std::vector<float> marginalVariances(evaluator.GetNumberOfPoints());
+  setNumberOfWorkerThreads(1);
+  printResult("marginal variances, 1 thread", benchmark::medianMilliseconds(10, [&] {
+                evaluator.computeMarginalVariances(marginalVariances.data());
+              }));
+
+  setNumberOfWorkerThreads(numberOfThreads);
+  printResult("marginal variances, " + std::to_string(getNumberOfWorkerThreads()) + " threads",
+              benchmark::medianMilliseconds(10, [&] { evaluator.computeMarginalVariances(marginalVariances.data()); }));
+  std::cout << evaluator.GetNumberOfPoints() << " vertices, " << numberOfComponents << " components" << std::endl;
+
+  // the variances colour the mesh of the model
+  MockUIServer              server(options);
+  StatismoUI::StatismoUI    ui(options);
+  Group                     group = ui.createGroup("variance-bench");
+  std::vector<std::int32_t> triangles;
+  ShapeModelView            model = ui.showPackedStatisticalShapeModel(
+    group, detail::meshBuffers(reference.GetPointer(), triangles), meanDeformation, basis, variances, "model");
+  const std::uint64_t bytes = server.GetBytesReceived();
+  printResult("updateTriangleMeshScalars", benchmark::medianMilliseconds(10, [&] {
+                ui.updateTriangleMeshScalars(model.GetTriangleMeshView(), marginalVariances, "variance");
+              }));
+  std::cout << std::fixed << std::setprecision(2) << (server.GetBytesReceived() - bytes) / 10.0 / 1e6
+            << " MB per update" << std::endl;
+
+  return 0;
+}
@@ -26,6 +26,7 @@
 #  THRIFT_INCLUDE_DIR, where to find THRIFT headers
 #  THRIFT_CONTRIB_DIR, where contrib thrift files (e.g. fb303.thrift) are installed
 #  THRIFT_STATIC_LIB, THRIFT static library
+#  THRIFT_ZLIB_STATIC_LIB, THRIFT zlib transport static library (optional)
 #  THRIFT_FOUND, If false, do not try to use ant
 
 # prefer the thrift version supplied in THRIFT_HOME
@@ -59,6 +60,13 @@ find_library(THRIFT_STATIC_LIB NAMES
   PATH_SUFFIXES "lib/${CMAKE_LIBRARY_ARCHITECTURE}" "lib"
 )
 
+find_library(THRIFT_ZLIB_STATIC_LIB NAMES
+  ${CMAKE_STATIC_LIBRARY_PREFIX}thriftz${THRIFT_MSVC_STATIC_LIB_SUFFIX}${CMAKE_STATIC_LIBRARY_SUFFIX}
+  HINTS ${_thrift_roots}
+  NO_DEFAULT_PATH
+  PATH_SUFFIXES "lib/${CMAKE_LIBRARY_ARCHITECTURE}" "lib"
+)
+
 find_program(THRIFT_COMPILER thrift HINTS
   ${_thrift_roots}
   NO_DEFAULT_PATH
@@ -97,6 +105,7 @@ endif ()
 
 mark_as_advanced(
   THRIFT_STATIC_LIB
+  THRIFT_ZLIB_STATIC_LIB
   THRIFT_COMPILER
   THRIFT_INCLUDE_DIR
 )
@@ -0,0 +1,357 @@
+#include "ClientMetrics.h"
+
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace StatismoUI
+{
+
+namespace
+{
+// Encode time measured by ScopedEncodeTimers since this thread sent its last request
+thread_local std::uint64_t pendingEncodeNanoseconds = 0;
+
+std::uint64_t
+nanosecondsSince(std::chrono::steady_clock::time_point begin)
+{
+  return static_cast<std::uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+}
+
+unsigned
+bucketOf(std::uint64_t value)
+{
+  return value == 0 ? 0 : 64 - static_cast<unsigned>(__builtin_clzll(value));
+}
+
+void
+writeHistogram(std::ostream & out, const char * key, const Histogram & histogram)
+{
+  out << ",\"" << key << "\":{\"count\":" << histogram.count << ",\"mean\":" << histogram.mean()
+      << ",\"p50\":" << histogram.percentile(50) << ",\"p90\":" << histogram.percentile(90)
+      << ",\"p99\":" << histogram.percentile(99) << ",\"max\":" << histogram.max << '}';
+}
+
+// Names of the RPCs of the service need no escaping
+void
+writeMetrics(std::ostream & out, const std::vector<RpcMetrics> & metrics)
+{
+  const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count();
+  for (const auto & rpc : metrics)
+  {
+    out << "{\"time\":" << time << ",\"rpc\":\"" << rpc.name << "\",\"calls\":" << rpc.calls;
+    writeHistogram(out, "encodeNs", rpc.encodeNanoseconds);
+    writeHistogram(out, "serializeNs", rpc.serializeNanoseconds);
+    writeHistogram(out, "roundTripNs", rpc.roundTripNanoseconds);
+    writeHistogram(out, "bytesWritten", rpc.bytesWritten);
+    writeHistogram(out, "bytesRead", rpc.bytesRead);
+    out << "}\n";
+  }
+}
+} // namespace
+
+double
+Histogram::mean() const
+{
+  return count == 0 ? 0.0 : static_cast<double>(sum) / count;
+}
+
+std::uint64_t
+Histogram::percentile(double q) const
+{
+  std::uint64_t total = 0;
+  for (auto n : buckets)
+  {
+    total += n;
+  }
+  if (total == 0)
+  {
+    return 0;
+  }
+
+  const auto    rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(q / 100 * total)));
+  std::uint64_t seen = 0;
+  for (unsigned b = 0; b < buckets.size(); ++b)
+  {
+    seen += buckets[b];
+    if (seen >= rank)
+    {
+      const std::uint64_t upperBound = b == 0 ? 0 : b == 64 ? UINT64_MAX : (std::uint64_t(1) << b) - 1;
+      return std::min(upperBound, max);
+    }
+  }
+  return max;
+}
+
+void
+AtomicHistogram::record(std::uint64_t value)
+{
+  // single writer: plain read-modify-write sequences of relaxed atomics cannot lose updates
+  m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  m_sum.store(m_sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  if (value > m_max.load(std::memory_order_relaxed))
+  {
+    m_max.store(value, std::memory_order_relaxed);
+  }
+  auto & bucket = m_buckets[bucketOf(value)];
+  bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+Histogram
+AtomicHistogram::snapshot() const
+{
+  Histogram histogram;
+  histogram.count = m_count.load(std::memory_order_relaxed);
+  histogram.sum = m_sum.load(std::memory_order_relaxed);
+  histogram.max = m_max.load(std::memory_order_relaxed);
+  for (unsigned b = 0; b < m_buckets.size(); ++b)
+  {
+    histogram.buckets[b] = m_buckets[b].load(std::memory_order_relaxed);
+  }
+  return histogram;
+}
+
+void
+AtomicHistogram::reset()
+{
+  m_count.store(0, std::memory_order_relaxed);
+  m_sum.store(0, std::memory_order_relaxed);
+  m_max.store(0, std::memory_order_relaxed);
+  for (auto & bucket : m_buckets)
+  {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+ClientMetrics::ClientMetrics()
+  : m_transfer(std::make_shared<TransferCounters>())
+{}
+
+ClientMetrics::RpcCounters &
+ClientMetrics::countersOf(const std::string & name)
+{
+  auto it = m_index.find(name);
+  if (it != m_index.end())
+  {
+    return m_counters[it->second];
+  }
+
+  const std::size_t n = m_numberOfRpcs.load(std::memory_order_relaxed);
+  if (n == maxNumberOfRpcs)
+  {
+    return m_counters[n - 1];
+  }
+  // the name is complete before the readers can see it
+  m_names[n] = n + 1 == maxNumberOfRpcs ? "(other)" : name;
+  m_index.emplace(name, n);
+  m_numberOfRpcs.store(n + 1, std::memory_order_release);
+  return m_counters[n];
+}
+
+void
+ClientMetrics::requestBegin(const std::string & name, bool oneway)
+{
+  RpcCounters & counters = countersOf(name);
+  counters.calls.store(counters.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  counters.encodeNanoseconds.record(pendingEncodeNanoseconds);
+  pendingEncodeNanoseconds = 0;
+
+  // requests whose reply was never read, because the connection failed, are dropped eventually
+  if (m_calls.size() >= 1024)
+  {
+    m_calls.pop_front();
+  }
+  m_calls.push_back(Call{ &counters,
+                          std::chrono::steady_clock::now(),
+                          m_transfer->bytesWritten.load(std::memory_order_relaxed),
+                          m_transfer->bytesRead.load(std::memory_order_relaxed),
+                          oneway,
+                          false });
+}
+
+void
+ClientMetrics::requestEnd()
+{
+  if (!m_calls.empty())
+  {
+    m_calls.back().counters->serializeNanoseconds.record(nanosecondsSince(m_calls.back().begin));
+  }
+}
+
+void
+ClientMetrics::messageFlushed()
+{
+  if (m_calls.empty() || m_calls.back().flushed)
+  {
+    return;
+  }
+  Call & call = m_calls.back();
+  call.flushed = true;
+  call.counters->bytesWritten.record(m_transfer->bytesWritten.load(std::memory_order_relaxed) -
+                                     call.bytesWrittenAtBegin);
+  if (call.oneway)
+  {
+    call.counters->roundTripNanoseconds.record(nanosecondsSince(call.begin));
+    call.counters->bytesRead.record(0);
+    m_calls.pop_back();
+  }
+}
+
+void
+ClientMetrics::replyBegin()
+{
+  if (!m_calls.empty())
+  {
+    m_calls.front().bytesReadAtBegin = m_transfer->bytesRead.load(std::memory_order_relaxed);
+  }
+}
+
+void
+ClientMetrics::replyEnd()
+{
+  if (m_calls.empty())
+  {
+    return;
+  }
+  const Call & call = m_calls.front();
+  call.counters->roundTripNanoseconds.record(nanosecondsSince(call.begin));
+  call.counters->bytesRead.record(m_transfer->bytesRead.load(std::memory_order_relaxed) - call.bytesReadAtBegin);
+  m_calls.pop_front();
+}
+
+void
+ClientMetrics::abandonCalls()
+{
+  m_calls.clear();
+}
+
+std::vector<RpcMetrics>
+ClientMetrics::snapshot() const
+{
+  const std::size_t       n = m_numberOfRpcs.load(std::memory_order_acquire);
+  std::vector<RpcMetrics> metrics(n);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const RpcCounters & counters = m_counters[i];
+    metrics[i].name = m_names[i];
+    metrics[i].calls = counters.calls.load(std::memory_order_relaxed);
+    metrics[i].encodeNanoseconds = counters.encodeNanoseconds.snapshot();
+    metrics[i].serializeNanoseconds = counters.serializeNanoseconds.snapshot();
+    metrics[i].roundTripNanoseconds = counters.roundTripNanoseconds.snapshot();
+    metrics[i].bytesWritten = counters.bytesWritten.snapshot();
+    metrics[i].bytesRead = counters.bytesRead.snapshot();
+  }
+  return metrics;
+}
+
+void
+ClientMetrics::reset()
+{
+  const std::size_t n = m_numberOfRpcs.load(std::memory_order_acquire);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    RpcCounters & counters = m_counters[i];
+    counters.calls.store(0, std::memory_order_relaxed);
+    counters.encodeNanoseconds.reset();
+    counters.serializeNanoseconds.reset();
+    counters.roundTripNanoseconds.reset();
+    counters.bytesWritten.reset();
+    counters.bytesRead.reset();
+  }
+}
+
+ScopedEncodeTimer::~ScopedEncodeTimer()
+{
+  pendingEncodeNanoseconds += nanosecondsSince(m_begin);
+}
+
+uint32_t
+InstrumentedProtocol::writeMessageBegin_virt(const std::string &                         name,
+                                             const apache::thrift::protocol::TMessageType messageType,
+                                             const int32_t                               seqid)
+{
+  m_metrics->requestBegin(name, messageType == apache::thrift::protocol::T_ONEWAY);
+  return TProtocolDecorator::writeMessageBegin_virt(name, messageType, seqid);
+}
+
+uint32_t
+InstrumentedProtocol::writeMessageEnd_virt()
+{
+  uint32_t n = TProtocolDecorator::writeMessageEnd_virt();
+  m_metrics->requestEnd();
+  return n;
+}
+
+uint32_t
+InstrumentedProtocol::readMessageBegin_virt(std::string &                            name,
+                                            apache::thrift::protocol::TMessageType & messageType,
+                                            int32_t &                                seqid)
+{
+  // before the wrapped protocol reads the frame of the reply
+  m_metrics->replyBegin();
+  return TProtocolDecorator::readMessageBegin_virt(name, messageType, seqid);
+}
+
+uint32_t
+InstrumentedProtocol::readMessageEnd_virt()
+{
+  uint32_t n = TProtocolDecorator::readMessageEnd_virt();
+  m_metrics->replyEnd();
+  return n;
+}
+
+MetricsDump::MetricsDump(std::shared_ptr<ClientMetrics> metrics,
+                         const std::string &            path,
+                         std::chrono::milliseconds      period)
+  : m_metrics(std::move(metrics))
+  , m_path(path)
+  , m_period(period)
+{
+  if (period.count() <= 0)
+  {
+    throw std::invalid_argument("the period of the metrics dump must be positive");
+  }
+  if (!std::ofstream(m_path, std::ios::app))
+  {
+    throw std::runtime_error("cannot write " + m_path);
+  }
+  m_thread = std::thread(&MetricsDump::run, this);
+}
+
+MetricsDump::~MetricsDump()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+  }
+  m_condition.notify_one();
+  m_thread.join();
+}
+
+void
+MetricsDump::run()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true)
+  {
+    m_condition.wait_for(lock, m_period, [this] { return m_stopped; });
+    write();
+    if (m_stopped)
+    {
+      return;
+    }
+  }
+}
+
+void
+MetricsDump::write()
+{
+  // a dump that cannot be written must not disturb the client, the next one is tried anyway
+  std::ofstream out(m_path, std::ios::app);
+  writeMetrics(out, m_metrics->snapshot());
+}
+
+} // namespace StatismoUI
@@ -0,0 +1,215 @@
+#ifndef UI_CLIENTMETRICS_H
+#define UI_CLIENTMETRICS_H
+
+#include "CountingTransport.h"
+#include "StatismoUI.h"
+
+#include <thrift/protocol/TProtocolDecorator.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Per-RPC instrumentation of a connection.
+namespace StatismoUI
+{
+
+// Histogram with a single writer and any number of lock-free readers
+class AtomicHistogram
+{
+public:
+  void
+  record(std::uint64_t value);
+
+  Histogram
+  snapshot() const;
+
+  void
+  reset();
+
+private:
+  std::atomic<std::uint64_t>                 m_count{ 0 };
+  std::atomic<std::uint64_t>                 m_sum{ 0 };
+  std::atomic<std::uint64_t>                 m_max{ 0 };
+  std::array<std::atomic<std::uint64_t>, 65> m_buckets{};
+};
+
+// Metrics of the RPCs sent over one connection. The recording side is called by InstrumentedProtocol and the
+// CountingTransport below it, which the connection serializes; it takes no lock and only updates relaxed atomics.
+// Snapshots can be taken from any thread at any time.
+class ClientMetrics
+{
+public:
+  ClientMetrics();
+
+  ClientMetrics(const ClientMetrics &) = delete;
+  ClientMetrics &
+  operator=(const ClientMetrics &) = delete;
+
+  // Bytes on the socket, to be counted by a CountingTransport calling messageFlushed from its flush
+  const std::shared_ptr<TransferCounters> &
+  GetTransferCounters() const
+  {
+    return m_transfer;
+  }
+
+  // Recording side, see InstrumentedProtocol
+  void
+  requestBegin(const std::string & name, bool oneway);
+  void
+  requestEnd();
+  void
+  messageFlushed();
+  void
+  replyBegin();
+  void
+  replyEnd();
+
+  // Forgets the requests in flight, before the recording side moves to a new connection
+  void
+  abandonCalls();
+
+  std::vector<RpcMetrics>
+  snapshot() const;
+
+  // Counters of calls in flight may be partially reset
+  void
+  reset();
+
+private:
+  struct RpcCounters
+  {
+    std::atomic<std::uint64_t> calls{ 0 };
+    AtomicHistogram            encodeNanoseconds;
+    AtomicHistogram            serializeNanoseconds;
+    AtomicHistogram            roundTripNanoseconds;
+    AtomicHistogram            bytesWritten;
+    AtomicHistogram            bytesRead;
+  };
+
+  // A request whose reply has not been read yet. Replies come in request order.
+  struct Call
+  {
+    RpcCounters *                         counters;
+    std::chrono::steady_clock::time_point begin;
+    std::uint64_t                         bytesWrittenAtBegin;
+    std::uint64_t                         bytesReadAtBegin;
+    bool                                  oneway;
+    bool                                  flushed;
+  };
+
+  RpcCounters &
+  countersOf(const std::string & name);
+
+  // The service has far fewer RPCs, further names are counted in the last slot
+  static constexpr std::size_t maxNumberOfRpcs = 128;
+
+  std::shared_ptr<TransferCounters>        m_transfer;
+  std::array<std::string, maxNumberOfRpcs> m_names;
+  std::array<RpcCounters, maxNumberOfRpcs> m_counters;
+  // Names [0, m_numberOfRpcs) are published to the readers
+  std::atomic<std::size_t> m_numberOfRpcs{ 0 };
+
+  // Only touched by the recording side
+  std::unordered_map<std::string, std::size_t> m_index;
+  std::deque<Call>                             m_calls;
+};
+
+// Records the time spent in the scope as encode time of the next request this thread sends
+class ScopedEncodeTimer
+{
+public:
+  ScopedEncodeTimer()
+    : m_begin(std::chrono::steady_clock::now())
+  {}
+
+  ~ScopedEncodeTimer();
+
+  ScopedEncodeTimer(const ScopedEncodeTimer &) = delete;
+  ScopedEncodeTimer &
+  operator=(const ScopedEncodeTimer &) = delete;
+
+private:
+  std::chrono::steady_clock::time_point m_begin;
+};
+
+// Runs f, a conversion to thrift, and records its duration as encode time
+template <typename F>
+auto
+timedEncode(F && f)
+{
+  ScopedEncodeTimer timer;
+  return f();
+}
+
+// Protocol that reports the message boundaries of the wrapped protocol to a ClientMetrics
+class InstrumentedProtocol : public apache::thrift::protocol::TProtocolDecorator
+{
+public:
+  InstrumentedProtocol(std::shared_ptr<apache::thrift::protocol::TProtocol> protocol,
+                       std::shared_ptr<ClientMetrics>                       metrics)
+    : TProtocolDecorator(std::move(protocol))
+    , m_metrics(std::move(metrics))
+  {}
+
+  uint32_t
+  writeMessageBegin_virt(const std::string &                         name,
+                         const apache::thrift::protocol::TMessageType messageType,
+                         const int32_t                               seqid) override;
+
+  uint32_t
+  writeMessageEnd_virt() override;
+
+  uint32_t
+  readMessageBegin_virt(std::string &                            name,
+                        apache::thrift::protocol::TMessageType & messageType,
+                        int32_t &                                seqid) override;
+
+  uint32_t
+  readMessageEnd_virt() override;
+
+private:
+  std::shared_ptr<ClientMetrics> m_metrics;
+};
+
+// Appends snapshots of the metrics to a file from a background thread, as JSON lines
+class MetricsDump
+{
+public:
+  MetricsDump(std::shared_ptr<ClientMetrics> metrics, const std::string & path, std::chrono::milliseconds period);
+
+  // Writes a last snapshot
+  ~MetricsDump();
+
+  MetricsDump(const MetricsDump &) = delete;
+  MetricsDump &
+  operator=(const MetricsDump &) = delete;
+
+private:
+  void
+  run();
+
+  void
+  write();
+
+  std::shared_ptr<ClientMetrics> m_metrics;
+  std::string                    m_path;
+  std::chrono::milliseconds      m_period;
+  bool                           m_stopped{ false };
+  std::mutex                     m_mutex;
+  std::condition_variable        m_condition;
+  std::thread                    m_thread;
+};
+
+} // namespace StatismoUI
+
+#endif // UI_CLIENTMETRICS_H
@@ -0,0 +1,159 @@
+#include "CompressedFramedTransport.h"
+
+#include <thrift/transport/TTransportException.h>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+
+using apache::thrift::transport::TTransportException;
+
+namespace StatismoUI
+{
+
+namespace
+{
+const std::uint8_t  rawCodec = 0;
+const std::uint8_t  zlibCodec = 1;
+const std::uint32_t maxFrameSize = 1u << 30;
+
+void
+putUInt32(std::uint8_t * out, std::uint32_t value)
+{
+  out[0] = static_cast<std::uint8_t>(value >> 24);
+  out[1] = static_cast<std::uint8_t>(value >> 16);
+  out[2] = static_cast<std::uint8_t>(value >> 8);
+  out[3] = static_cast<std::uint8_t>(value);
+}
+
+std::uint32_t
+getUInt32(const std::uint8_t * in)
+{
+  return (std::uint32_t(in[0]) << 24) | (std::uint32_t(in[1]) << 16) | (std::uint32_t(in[2]) << 8) |
+         std::uint32_t(in[3]);
+}
+} // namespace
+
+CompressedFramedTransport::CompressedFramedTransport(std::shared_ptr<apache::thrift::transport::TTransport> transport,
+                                                     std::size_t                                             threshold,
+                                                     int                                                     level)
+  : m_transport(std::move(transport))
+  , m_threshold(threshold)
+  , m_level(level)
+{}
+
+uint32_t
+CompressedFramedTransport::read(uint8_t * buf, uint32_t len)
+{
+  if (m_readPosition == m_readBuffer.size())
+  {
+    readFrame();
+  }
+
+  uint32_t n = static_cast<uint32_t>(std::min<std::size_t>(len, m_readBuffer.size() - m_readPosition));
+  std::memcpy(buf, m_readBuffer.data() + m_readPosition, n);
+  m_readPosition += n;
+  return n;
+}
+
+void
+CompressedFramedTransport::flush()
+{
+  std::uint8_t        header[9];
+  std::size_t         headerSize = 5;
+  const std::string * payload = &m_writeBuffer;
+
+  header[4] = rawCodec;
+  if (m_writeBuffer.size() >= m_threshold)
+  {
+    uLongf compressedSize = compressBound(static_cast<uLong>(m_writeBuffer.size()));
+    m_compressed.resize(compressedSize);
+    int status = compress2(reinterpret_cast<Bytef *>(&m_compressed[0]),
+                           &compressedSize,
+                           reinterpret_cast<const Bytef *>(m_writeBuffer.data()),
+                           static_cast<uLong>(m_writeBuffer.size()),
+                           m_level);
+    if (status == Z_OK && compressedSize + 4 < m_writeBuffer.size())
+    {
+      m_compressed.resize(compressedSize);
+      header[4] = zlibCodec;
+      putUInt32(header + 5, static_cast<std::uint32_t>(m_writeBuffer.size()));
+      headerSize = 9;
+      payload = &m_compressed;
+    }
+  }
+
+  // The buffer is dropped whatever happens, a failed write must not leave half a message for the next flush
+  try
+  {
+    const std::size_t frameSize = headerSize - 4 + payload->size();
+    if (frameSize > maxFrameSize)
+    {
+      throw TTransportException(TTransportException::CORRUPTED_DATA, "message exceeds the maximum frame size");
+    }
+    putUInt32(header, static_cast<std::uint32_t>(frameSize));
+
+    m_transport->write(header, static_cast<uint32_t>(headerSize));
+    m_transport->write(reinterpret_cast<const uint8_t *>(payload->data()), static_cast<uint32_t>(payload->size()));
+    m_transport->flush();
+  }
+  catch (...)
+  {
+    m_writeBuffer.clear();
+    throw;
+  }
+  m_writeBuffer.clear();
+}
+
+void
+CompressedFramedTransport::readFrame()
+{
+  std::uint8_t header[5];
+  m_transport->readAll(header, sizeof(header));
+
+  const std::uint32_t frameSize = getUInt32(header);
+  if (frameSize < 1 || frameSize > maxFrameSize)
+  {
+    throw TTransportException(TTransportException::CORRUPTED_DATA, "invalid frame size");
+  }
+
+  m_readPosition = 0;
+  if (header[4] == rawCodec)
+  {
+    m_readBuffer.resize(frameSize - 1);
+    m_transport->readAll(reinterpret_cast<uint8_t *>(&m_readBuffer[0]), frameSize - 1);
+  }
+  else if (header[4] == zlibCodec && frameSize > 5)
+  {
+    m_compressed.resize(frameSize - 1);
+    m_transport->readAll(reinterpret_cast<uint8_t *>(&m_compressed[0]), frameSize - 1);
+
+    const std::uint32_t messageSize = getUInt32(reinterpret_cast<const std::uint8_t *>(m_compressed.data()));
+    if (messageSize > maxFrameSize)
+    {
+      throw TTransportException(TTransportException::CORRUPTED_DATA, "invalid message size");
+    }
+    m_readBuffer.resize(messageSize);
+    uLongf size = messageSize;
+    int    status = uncompress(reinterpret_cast<Bytef *>(&m_readBuffer[0]),
+                            &size,
+                            reinterpret_cast<const Bytef *>(m_compressed.data() + 4),
+                            static_cast<uLong>(m_compressed.size() - 4));
+    if (status != Z_OK || size != messageSize)
+    {
+      throw TTransportException(TTransportException::CORRUPTED_DATA, "corrupted compressed frame");
+    }
+  }
+  else
+  {
+    throw TTransportException(TTransportException::CORRUPTED_DATA, "unknown frame codec");
+  }
+
+  if (m_readBuffer.empty())
+  {
+    throw TTransportException(TTransportException::CORRUPTED_DATA, "empty frame");
+  }
+}
+
+} // namespace StatismoUI
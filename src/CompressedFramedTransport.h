@@ -0,0 +1,81 @@
+#ifndef UI_COMPRESSEDFRAMEDTRANSPORT_H
+#define UI_COMPRESSEDFRAMEDTRANSPORT_H
+
+#include <thrift/transport/TVirtualTransport.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace StatismoUI
+{
+// Framed transport that deflates large frames. Every message is sent as one frame:
+//   uint32 length (big endian) | uint8 codec | payload
+// codec 0: the payload is the message.
+// codec 1: the payload is a uint32 message length (big endian) followed by the zlib stream of the message.
+// Messages shorter than the threshold, or that do not shrink, are sent with codec 0.
+class CompressedFramedTransport : public apache::thrift::transport::TVirtualTransport<CompressedFramedTransport>
+{
+public:
+  CompressedFramedTransport(std::shared_ptr<apache::thrift::transport::TTransport> transport,
+                            std::size_t                                             threshold,
+                            int                                                     level);
+
+  bool
+  isOpen() const override
+  {
+    return m_transport->isOpen();
+  }
+
+  bool
+  peek() override
+  {
+    return m_readPosition < m_readBuffer.size() || m_transport->peek();
+  }
+
+  void
+  open() override
+  {
+    m_transport->open();
+  }
+
+  void
+  close() override
+  {
+    m_transport->close();
+  }
+
+  uint32_t
+  read(uint8_t * buf, uint32_t len);
+
+  void
+  write(const uint8_t * buf, uint32_t len)
+  {
+    m_writeBuffer.append(reinterpret_cast<const char *>(buf), len);
+  }
+
+  void
+  flush() override;
+
+  const std::string
+  getOrigin() const override
+  {
+    return m_transport->getOrigin();
+  }
+
+private:
+  void
+  readFrame();
+
+  std::shared_ptr<apache::thrift::transport::TTransport> m_transport;
+  std::size_t                                            m_threshold;
+  int                                                    m_level;
+  std::string                                            m_readBuffer;
+  std::size_t                                            m_readPosition{ 0 };
+  std::string                                            m_writeBuffer;
+  std::string                                            m_compressed;
+};
+
+} // namespace StatismoUI
+
+#endif // UI_COMPRESSEDFRAMEDTRANSPORT_H
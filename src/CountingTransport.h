@@ -0,0 +1,97 @@
+#ifndef UI_COUNTINGTRANSPORT_H
+#define UI_COUNTINGTRANSPORT_H
+
+#include <thrift/transport/TVirtualTransport.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace StatismoUI
+{
+// Bytes that went through one or several CountingTransports
+struct TransferCounters
+{
+  std::atomic<std::uint64_t> bytesRead{ 0 };
+  std::atomic<std::uint64_t> bytesWritten{ 0 };
+};
+
+// Pass-through transport that counts the bytes read from and written to the wrapped transport, and calls onFlush
+// after each flush, i.e. once per message written.
+class CountingTransport : public apache::thrift::transport::TVirtualTransport<CountingTransport>
+{
+public:
+  CountingTransport(std::shared_ptr<apache::thrift::transport::TTransport> transport,
+                    std::shared_ptr<TransferCounters>                       counters,
+                    std::function<void()>                                   onFlush = nullptr)
+    : m_transport(std::move(transport))
+    , m_counters(std::move(counters))
+    , m_onFlush(std::move(onFlush))
+  {}
+
+  bool
+  isOpen() const override
+  {
+    return m_transport->isOpen();
+  }
+
+  bool
+  peek() override
+  {
+    return m_transport->peek();
+  }
+
+  void
+  open() override
+  {
+    m_transport->open();
+  }
+
+  void
+  close() override
+  {
+    m_transport->close();
+  }
+
+  uint32_t
+  read(uint8_t * buf, uint32_t len)
+  {
+    uint32_t n = m_transport->read(buf, len);
+    m_counters->bytesRead += n;
+    return n;
+  }
+
+  void
+  write(const uint8_t * buf, uint32_t len)
+  {
+    m_transport->write(buf, len);
+    m_counters->bytesWritten += len;
+  }
+
+  void
+  flush() override
+  {
+    m_transport->flush();
+    if (m_onFlush)
+    {
+      m_onFlush();
+    }
+  }
+
+  const std::string
+  getOrigin() const override
+  {
+    return m_transport->getOrigin();
+  }
+
+private:
+  std::shared_ptr<apache::thrift::transport::TTransport> m_transport;
+  std::shared_ptr<TransferCounters>                      m_counters;
+  std::function<void()>                                  m_onFlush;
+};
+
+} // namespace StatismoUI
+
+#endif // UI_COUNTINGTRANSPORT_H
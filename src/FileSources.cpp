@@ -0,0 +1,375 @@
+#include "FileSources.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace StatismoUI
+{
+
+namespace
+{
+constexpr char        meshFileMagic[8] = { 'S', 'U', 'I', 'M', 'E', 'S', 'H', '1' };
+constexpr std::size_t meshFileHeaderSize = 16;
+
+bool
+endsWith(const std::string & s, const std::string & suffix)
+{
+  return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string
+trim(const std::string & s)
+{
+  const auto begin = s.find_first_not_of(" \t\r");
+  const auto end = s.find_last_not_of(" \t\r");
+  return begin == std::string::npos ? std::string() : s.substr(begin, end - begin + 1);
+}
+
+ScalarType
+nrrdPixelType(const std::string & type, const std::string & path)
+{
+  static const std::map<std::string, ScalarType> types = {
+    { "signed char", ScalarType::Int8 },       { "int8", ScalarType::Int8 },
+    { "int8_t", ScalarType::Int8 },            { "uchar", ScalarType::UInt8 },
+    { "unsigned char", ScalarType::UInt8 },    { "uint8", ScalarType::UInt8 },
+    { "uint8_t", ScalarType::UInt8 },          { "short", ScalarType::Int16 },
+    { "short int", ScalarType::Int16 },        { "signed short", ScalarType::Int16 },
+    { "signed short int", ScalarType::Int16 }, { "int16", ScalarType::Int16 },
+    { "int16_t", ScalarType::Int16 },          { "ushort", ScalarType::UInt16 },
+    { "unsigned short", ScalarType::UInt16 },  { "unsigned short int", ScalarType::UInt16 },
+    { "uint16", ScalarType::UInt16 },          { "uint16_t", ScalarType::UInt16 },
+    { "int", ScalarType::Int32 },              { "signed int", ScalarType::Int32 },
+    { "int32", ScalarType::Int32 },            { "int32_t", ScalarType::Int32 },
+    { "uint", ScalarType::UInt32 },            { "unsigned int", ScalarType::UInt32 },
+    { "uint32", ScalarType::UInt32 },          { "uint32_t", ScalarType::UInt32 },
+    { "float", ScalarType::Float32 },          { "double", ScalarType::Float64 }
+  };
+  auto it = types.find(type);
+  if (it == types.end())
+  {
+    throw std::runtime_error(path + ": unsupported NRRD type " + type);
+  }
+  return it->second;
+}
+
+// Parses "(x,y,z)"
+std::array<double, 3>
+nrrdVector(const std::string & value, const std::string & path)
+{
+  std::array<double, 3> v;
+  char                  open, comma1, comma2, close;
+  std::istringstream    stream(value);
+  if (!(stream >> open >> v[0] >> comma1 >> v[1] >> comma2 >> v[2] >> close) || open != '(' || comma1 != ',' ||
+      comma2 != ',' || close != ')')
+  {
+    throw std::runtime_error(path + ": cannot parse the NRRD vector " + value);
+  }
+  return v;
+}
+
+ImageFileHeader
+readNrrdHeader(const std::string & path)
+{
+  std::ifstream file(path, std::ios::binary);
+  std::string   line;
+  if (!file || !std::getline(file, line) || line.compare(0, 7, "NRRD000") != 0)
+  {
+    throw std::runtime_error(path + " is not a NRRD file");
+  }
+
+  // fields until the empty line that ends the header or the end of a detached header
+  std::map<std::string, std::string> fields;
+  while (std::getline(file, line) && !trim(line).empty())
+  {
+    const auto colon = line.find(": ");
+    if (line[0] == '#' || colon == std::string::npos)
+    {
+      continue;
+    }
+    fields[line.substr(0, colon)] = trim(line.substr(colon + 2));
+  }
+  auto field = [&](const std::string & key) {
+    auto it = fields.find(key);
+    if (it == fields.end())
+    {
+      throw std::runtime_error(path + ": the NRRD field " + key + " is missing");
+    }
+    return it->second;
+  };
+
+  if (field("dimension") != "3")
+  {
+    throw std::runtime_error(path + ": only 3D NRRD images are supported");
+  }
+  if (field("encoding") != "raw")
+  {
+    throw std::runtime_error(path + ": only raw NRRD encoding is supported");
+  }
+  if (fields.count("endian") && fields["endian"] != "little")
+  {
+    throw std::runtime_error(path + ": only little endian NRRD data is supported");
+  }
+  if (fields.count("line skip") && fields["line skip"] != "0")
+  {
+    throw std::runtime_error(path + ": NRRD line skip is not supported");
+  }
+
+  ImageFileHeader header;
+  header.pixelType = nrrdPixelType(field("type"), path);
+  std::istringstream sizes(field("sizes"));
+  for (auto & size : header.size)
+  {
+    sizes >> size;
+  }
+  if (!sizes)
+  {
+    throw std::runtime_error(path + ": cannot parse the NRRD sizes");
+  }
+
+  header.spacing = { 1, 1, 1 };
+  if (fields.count("space directions"))
+  {
+    std::istringstream directions(fields["space directions"]);
+    for (auto & spacing : header.spacing)
+    {
+      std::string direction;
+      directions >> direction;
+      const auto v = nrrdVector(direction, path);
+      spacing = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    }
+  }
+  else if (fields.count("spacings"))
+  {
+    std::istringstream spacings(fields["spacings"]);
+    for (auto & spacing : header.spacing)
+    {
+      spacings >> spacing;
+    }
+  }
+
+  header.origin = { 0, 0, 0 };
+  if (fields.count("space origin"))
+  {
+    header.origin = nrrdVector(fields["space origin"], path);
+    const std::string space = fields.count("space") ? fields["space"] : "";
+    if (space == "right-anterior-superior" || space == "RAS")
+    {
+      header.origin[0] = -header.origin[0];
+      header.origin[1] = -header.origin[1];
+    }
+  }
+
+  const std::string dataFile = fields.count("data file") ? fields["data file"] : fields["datafile"];
+  if (dataFile.empty())
+  {
+    header.dataPath = path;
+    header.dataOffset = static_cast<std::size_t>(file.tellg());
+  }
+  else
+  {
+    // relative to the directory of the header
+    const auto slash = path.find_last_of('/');
+    header.dataPath =
+      dataFile[0] == '/' || slash == std::string::npos ? dataFile : path.substr(0, slash + 1) + dataFile;
+    header.dataOffset = fields.count("byte skip") ? std::stoul(fields["byte skip"]) : 0;
+  }
+  return header;
+}
+
+template <typename T>
+T
+readLittleEndian(const char * header, std::size_t offset)
+{
+  T value;
+  std::memcpy(&value, header + offset, sizeof(T));
+  return value;
+}
+
+ImageFileHeader
+readNiftiHeader(const std::string & path)
+{
+  char          nifti[348];
+  std::ifstream file(path, std::ios::binary);
+  if (!file.read(nifti, sizeof(nifti)) || readLittleEndian<std::int32_t>(nifti, 0) != 348 ||
+      std::memcmp(nifti + 344, "n+1", 4) != 0)
+  {
+    throw std::runtime_error(path + " is not a little endian single-file NIfTI-1 image");
+  }
+
+  const auto dimension = readLittleEndian<std::int16_t>(nifti, 40);
+  for (int d = 4; d <= dimension && d < 8; ++d)
+  {
+    if (readLittleEndian<std::int16_t>(nifti, 40 + 2 * d) > 1)
+    {
+      throw std::runtime_error(path + ": only 3D NIfTI images are supported");
+    }
+  }
+  const float slope = readLittleEndian<float>(nifti, 112);
+  const float intercept = readLittleEndian<float>(nifti, 116);
+  if ((slope != 0 && slope != 1) || intercept != 0)
+  {
+    throw std::runtime_error(path + ": scaled NIfTI data is not supported");
+  }
+
+  ImageFileHeader header;
+  switch (readLittleEndian<std::int16_t>(nifti, 70))
+  {
+    case 2:
+      header.pixelType = ScalarType::UInt8;
+      break;
+    case 4:
+      header.pixelType = ScalarType::Int16;
+      break;
+    case 8:
+      header.pixelType = ScalarType::Int32;
+      break;
+    case 16:
+      header.pixelType = ScalarType::Float32;
+      break;
+    case 64:
+      header.pixelType = ScalarType::Float64;
+      break;
+    case 256:
+      header.pixelType = ScalarType::Int8;
+      break;
+    case 512:
+      header.pixelType = ScalarType::UInt16;
+      break;
+    case 768:
+      header.pixelType = ScalarType::UInt32;
+      break;
+    default:
+      throw std::runtime_error(path + ": unsupported NIfTI datatype");
+  }
+
+  for (unsigned i = 0; i < 3; ++i)
+  {
+    header.size[i] = dimension > static_cast<int>(i) ? readLittleEndian<std::int16_t>(nifti, 42 + 2 * i) : 1;
+    header.spacing[i] = std::abs(readLittleEndian<float>(nifti, 80 + 4 * i));
+    header.origin[i] = 0;
+  }
+
+  // qform, else sform; NIfTI is RAS, ITK is LPS
+  if (readLittleEndian<std::int16_t>(nifti, 252) > 0)
+  {
+    for (unsigned i = 0; i < 3; ++i)
+    {
+      header.origin[i] = readLittleEndian<float>(nifti, 268 + 4 * i);
+    }
+  }
+  else if (readLittleEndian<std::int16_t>(nifti, 254) > 0)
+  {
+    for (unsigned i = 0; i < 3; ++i)
+    {
+      header.origin[i] = readLittleEndian<float>(nifti, 280 + 16 * i + 12);
+    }
+  }
+  header.origin[0] = -header.origin[0];
+  header.origin[1] = -header.origin[1];
+
+  header.dataPath = path;
+  header.dataOffset = static_cast<std::size_t>(readLittleEndian<float>(nifti, 108));
+  return header;
+}
+} // namespace
+
+ImageFileHeader
+readImageFileHeader(const std::string & path)
+{
+  if (endsWith(path, ".nrrd") || endsWith(path, ".nhdr"))
+  {
+    return readNrrdHeader(path);
+  }
+  if (endsWith(path, ".nii"))
+  {
+    return readNiftiHeader(path);
+  }
+  throw std::runtime_error(path + ": only .nrrd, .nhdr and .nii images can be mapped");
+}
+
+MeshFileHeader
+readMeshFileHeader(const MappedFile & file, const std::string & path)
+{
+  if (file.size() < meshFileHeaderSize || std::memcmp(file.data(), meshFileMagic, sizeof(meshFileMagic)) != 0)
+  {
+    throw std::runtime_error(path + " is not a packed mesh file");
+  }
+
+  MeshFileHeader header;
+  header.numberOfVertices = readLittleEndian<std::uint32_t>(file.data(), 8);
+  header.numberOfTriangles = readLittleEndian<std::uint32_t>(file.data(), 12);
+  constexpr std::size_t maxCount = std::numeric_limits<std::int32_t>::max();
+  if (header.numberOfVertices > maxCount || header.numberOfTriangles > maxCount)
+  {
+    throw std::runtime_error(path + " has more vertices or triangles than ui-service accepts");
+  }
+  header.verticesOffset = meshFileHeaderSize;
+  header.topologyOffset = header.verticesOffset + 3 * sizeof(float) * header.numberOfVertices;
+  if (file.size() != header.topologyOffset + 3 * sizeof(std::int32_t) * header.numberOfTriangles)
+  {
+    throw std::runtime_error(path + " is truncated");
+  }
+  return header;
+}
+
+void
+checkMeshFileTriangles(const MappedFile & file, const MeshFileHeader & header, const std::string & path)
+{
+  const char * topology = file.data() + header.topologyOffset;
+  for (std::size_t i = 0; i < 3 * header.numberOfTriangles; ++i)
+  {
+    const auto id = readLittleEndian<std::int32_t>(topology, i * sizeof(std::int32_t));
+    if (id < 0 || static_cast<std::size_t>(id) >= header.numberOfVertices)
+    {
+      throw std::runtime_error(path + ": triangle " + std::to_string(i / 3) + " refers to vertex " +
+                               std::to_string(id) + ", the mesh has " + std::to_string(header.numberOfVertices));
+    }
+  }
+}
+
+void
+writePackedMeshFile(const std::string & path, const itk::Mesh<float, 3> * mesh)
+{
+  std::ofstream file(path, std::ios::binary);
+  if (!file)
+  {
+    throw std::runtime_error("cannot write " + path);
+  }
+
+  const std::uint32_t numberOfVertices = static_cast<std::uint32_t>(mesh->GetNumberOfPoints());
+  const std::uint32_t numberOfTriangles = static_cast<std::uint32_t>(mesh->GetNumberOfCells());
+  file.write(meshFileMagic, sizeof(meshFileMagic));
+  file.write(reinterpret_cast<const char *>(&numberOfVertices), sizeof(numberOfVertices));
+  file.write(reinterpret_cast<const char *>(&numberOfTriangles), sizeof(numberOfTriangles));
+
+  for (auto it = mesh->GetPoints()->Begin(); it != mesh->GetPoints()->End(); ++it)
+  {
+    const float xyz[] = { it.Value()[0], it.Value()[1], it.Value()[2] };
+    file.write(reinterpret_cast<const char *>(xyz), sizeof(xyz));
+  }
+  for (auto it = mesh->GetCells()->Begin(); it != mesh->GetCells()->End(); ++it)
+  {
+    if (it.Value()->GetNumberOfPoints() != 3)
+    {
+      throw std::invalid_argument("the mesh must consist of triangles");
+    }
+    std::int32_t ids[3];
+    std::copy(it.Value()->PointIdsBegin(), it.Value()->PointIdsEnd(), ids);
+    file.write(reinterpret_cast<const char *>(ids), sizeof(ids));
+  }
+
+  if (!file)
+  {
+    throw std::runtime_error("cannot write " + path);
+  }
+}
+
+} // namespace StatismoUI
@@ -0,0 +1,56 @@
+#ifndef UI_FILESOURCES_H
+#define UI_FILESOURCES_H
+
+#include "StatismoUI.h"
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+// Headers of the image and mesh files that StatismoUI sends straight from a memory mapping.
+namespace StatismoUI
+{
+class MappedFile;
+
+// Where the voxels of an image file are and how to interpret them. Origins are in LPS coordinates, as in ITK.
+struct ImageFileHeader
+{
+  std::array<std::size_t, 3> size;
+  std::array<double, 3>      origin;
+  std::array<double, 3>      spacing;
+  ScalarType                 pixelType;
+  // The voxels are stored x fastest, little endian, from dataOffset on in dataPath
+  std::string dataPath;
+  std::size_t dataOffset;
+};
+
+// Reads the header of a 3D NRRD (.nrrd, or .nhdr with a detached data file) with raw encoding or of an uncompressed
+// single-file NIfTI-1 (.nii). Throws std::runtime_error for other files.
+ImageFileHeader
+readImageFileHeader(const std::string & path);
+
+// Packed mesh files, little endian:
+//   char[8]  "SUIMESH1"
+//   uint32   numberOfVertices
+//   uint32   numberOfTriangles
+//   float32  x y z of each vertex
+//   int32    the three point ids of each triangle
+struct MeshFileHeader
+{
+  std::size_t numberOfVertices;
+  std::size_t numberOfTriangles;
+  std::size_t verticesOffset;
+  std::size_t topologyOffset;
+};
+
+// Throws std::runtime_error if the file is not a packed mesh file or if its counts do not fit the int32 of ui.thrift
+MeshFileHeader
+readMeshFileHeader(const MappedFile & file, const std::string & path);
+
+// Throws std::runtime_error if a triangle of the file refers to a vertex the mesh does not have
+void
+checkMeshFileTriangles(const MappedFile & file, const MeshFileHeader & header, const std::string & path);
+
+} // namespace StatismoUI
+
+#endif // UI_FILESOURCES_H
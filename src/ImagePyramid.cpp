@@ -0,0 +1,182 @@
+#include "ImagePyramid.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace StatismoUI
+{
+
+namespace
+{
+// Calls f with a value of the C++ type of the pixel type
+template <typename F>
+void
+dispatchPixelType(ScalarType pixelType, F && f)
+{
+  switch (pixelType)
+  {
+    case ScalarType::Float32:
+      return f(float());
+    case ScalarType::Float64:
+      return f(double());
+    case ScalarType::Int8:
+      return f(std::int8_t());
+    case ScalarType::UInt8:
+      return f(std::uint8_t());
+    case ScalarType::Int16:
+      return f(std::int16_t());
+    case ScalarType::UInt16:
+      return f(std::uint16_t());
+    case ScalarType::Int32:
+      return f(std::int32_t());
+    case ScalarType::UInt32:
+      return f(std::uint32_t());
+    case ScalarType::Float16:
+      break;
+  }
+  throw std::invalid_argument("images cannot be sent as Float16");
+}
+
+// Averages the (up to) 2 x 2 x 2 voxels of the fine level covered by each voxel of the coarse level.
+// Integer pixels are rounded to the nearest value.
+template <typename T>
+void
+downsample(const ImagePyramid::Level & fine, const ImagePyramid::Level & coarse, char * coarseData)
+{
+  const T *    src = reinterpret_cast<const T *>(fine.data);
+  T *          dst = reinterpret_cast<T *>(coarseData);
+  const auto & fs = fine.size;
+  const auto & cs = coarse.size;
+
+  const std::size_t minSlicesPerChunk = std::max<std::size_t>(1, 32768 / (cs[0] * cs[1]));
+  parallelFor(cs[2], minSlicesPerChunk, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t z = begin; z < end; ++z)
+    {
+      for (std::size_t y = 0; y < cs[1]; ++y)
+      {
+        for (std::size_t x = 0; x < cs[0]; ++x)
+        {
+          double   sum = 0;
+          unsigned count = 0;
+          for (std::size_t zz = 2 * z; zz < std::min(2 * z + 2, fs[2]); ++zz)
+          {
+            for (std::size_t yy = 2 * y; yy < std::min(2 * y + 2, fs[1]); ++yy)
+            {
+              for (std::size_t xx = 2 * x; xx < std::min(2 * x + 2, fs[0]); ++xx)
+              {
+                sum += src[(zz * fs[1] + yy) * fs[0] + xx];
+                ++count;
+              }
+            }
+          }
+
+          const double mean = sum / count;
+          if constexpr (std::is_integral_v<T>)
+          {
+            dst[(z * cs[1] + y) * cs[0] + x] = static_cast<T>(std::llround(mean));
+          }
+          else
+          {
+            dst[(z * cs[1] + y) * cs[0] + x] = static_cast<T>(mean);
+          }
+        }
+      }
+    }
+  });
+}
+} // namespace
+
+ImagePyramid::ImagePyramid(const itk::ImageBase<3> * image,
+                           ScalarType                pixelType,
+                           const void *              buffer,
+                           unsigned                  coarsestEdge,
+                           unsigned                  maxNumberOfLevels)
+  : m_image(image)
+  , m_pixelType(pixelType)
+  , m_pixelSize(0)
+{
+  if (image->GetBufferedRegion() != image->GetLargestPossibleRegion())
+  {
+    throw std::invalid_argument("image must be buffered over its largest possible region");
+  }
+  dispatchPixelType(pixelType, [this](auto pixel) { m_pixelSize = sizeof(pixel); });
+
+  Level level;
+  for (unsigned i = 0; i < 3; ++i)
+  {
+    level.size[i] = image->GetLargestPossibleRegion().GetSize(i);
+    level.origin[i] = image->GetOrigin()[i];
+    level.spacing[i] = image->GetSpacing()[i];
+  }
+  level.data = static_cast<const char *>(buffer);
+  m_levels.push_back(level);
+
+  auto largestEdge = [](const Level & l) { return *std::max_element(l.size.begin(), l.size.end()); };
+  while (largestEdge(m_levels.back()) > std::max(1u, coarsestEdge) &&
+         (maxNumberOfLevels == 0 || m_levels.size() < maxNumberOfLevels))
+  {
+    const Level & fine = m_levels.back();
+    Level         coarse;
+    for (unsigned i = 0; i < 3; ++i)
+    {
+      coarse.size[i] = (fine.size[i] + 1) / 2;
+      coarse.origin[i] = fine.origin[i] + 0.5 * fine.spacing[i];
+      coarse.spacing[i] = 2 * fine.spacing[i];
+    }
+
+    std::vector<char> data(coarse.size[0] * coarse.size[1] * coarse.size[2] * m_pixelSize);
+    dispatchPixelType(pixelType, [&](auto pixel) { downsample<decltype(pixel)>(fine, coarse, data.data()); });
+    coarse.data = data.data();
+    m_buffers.push_back(std::move(data));
+    m_levels.push_back(coarse);
+  }
+}
+
+const ImagePyramid::Level &
+ImagePyramid::GetLevel(unsigned level) const
+{
+  if (level >= m_levels.size())
+  {
+    throw std::invalid_argument("the image pyramid has " + std::to_string(m_levels.size()) + " levels");
+  }
+  return m_levels[level];
+}
+
+void
+ImagePyramid::checkRegion(unsigned level, const itk::ImageRegion<3> & region) const
+{
+  const Level & l = GetLevel(level);
+  for (unsigned i = 0; i < 3; ++i)
+  {
+    if (region.GetIndex(i) < 0 || region.GetIndex(i) + region.GetSize(i) > l.size[i])
+    {
+      throw std::invalid_argument("the region is outside of level " + std::to_string(level));
+    }
+  }
+}
+
+void
+ImagePyramid::copyRegion(unsigned level, const itk::ImageRegion<3> & region, char * dst) const
+{
+  checkRegion(level, region);
+
+  const Level &     l = m_levels[level];
+  const std::size_t rowBytes = region.GetSize(0) * m_pixelSize;
+  for (std::size_t z = 0; z < region.GetSize(2); ++z)
+  {
+    for (std::size_t y = 0; y < region.GetSize(1); ++y)
+    {
+      const std::size_t zz = region.GetIndex(2) + z;
+      const std::size_t yy = region.GetIndex(1) + y;
+      const char *      src = l.data + ((zz * l.size[1] + yy) * l.size[0] + region.GetIndex(0)) * m_pixelSize;
+      std::memcpy(dst, src, rowBytes);
+      dst += rowBytes;
+    }
+  }
+}
+
+} // namespace StatismoUI
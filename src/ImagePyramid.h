@@ -0,0 +1,72 @@
+#ifndef UI_IMAGEPYRAMID_H
+#define UI_IMAGEPYRAMID_H
+
+#include "StatismoUI.h"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace StatismoUI
+{
+// Multi-resolution copy of an image, for showImagePyramid. Level 0 is the image itself, each further level averages
+// blocks of 2 x 2 x 2 voxels of the previous one: its size is halved (rounded up) and its spacing doubled.
+class ImagePyramid
+{
+public:
+  struct Level
+  {
+    std::array<std::size_t, 3> size;
+    std::array<double, 3>      origin;
+    std::array<double, 3>      spacing;
+    const char *               data;
+  };
+
+  // Level 0 refers to the buffer of the image, which the pyramid keeps alive. Levels are added until the largest
+  // edge is at most coarsestEdge voxels or there are maxNumberOfLevels of them (if not 0).
+  ImagePyramid(const itk::ImageBase<3> * image,
+               ScalarType                pixelType,
+               const void *              buffer,
+               unsigned                  coarsestEdge,
+               unsigned                  maxNumberOfLevels);
+
+  unsigned
+  GetNumberOfLevels() const
+  {
+    return static_cast<unsigned>(m_levels.size());
+  }
+
+  // Throws std::invalid_argument for a level that does not exist
+  const Level &
+  GetLevel(unsigned level) const;
+
+  ScalarType
+  GetPixelType() const
+  {
+    return m_pixelType;
+  }
+
+  std::size_t
+  GetPixelSize() const
+  {
+    return m_pixelSize;
+  }
+
+  // Throws std::invalid_argument if the region is not inside the level
+  void
+  checkRegion(unsigned level, const itk::ImageRegion<3> & region) const;
+
+  // Copies the voxels of a region of a level (x fastest) to dst, which must hold the region
+  void
+  copyRegion(unsigned level, const itk::ImageRegion<3> & region, char * dst) const;
+
+private:
+  itk::ImageBase<3>::ConstPointer m_image;
+  ScalarType                      m_pixelType;
+  std::size_t                     m_pixelSize;
+  std::vector<Level>              m_levels;
+  std::vector<std::vector<char>>  m_buffers;
+};
+} // namespace StatismoUI
+
+#endif // UI_IMAGEPYRAMID_H
@@ -0,0 +1,71 @@
+#include "MappedFile.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace StatismoUI
+{
+
+MappedFile::MappedFile(const std::string & path)
+{
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+  }
+
+  struct stat status;
+  if (::fstat(fd, &status) != 0)
+  {
+    const int error = errno;
+    ::close(fd);
+    throw std::runtime_error("cannot read the size of " + path + ": " + std::strerror(error));
+  }
+  m_size = static_cast<std::size_t>(status.st_size);
+
+  // mmap fails for empty files, which are left unmapped
+  if (m_size > 0)
+  {
+    void * data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+      const int error = errno;
+      ::close(fd);
+      throw std::runtime_error("cannot map " + path + ": " + std::strerror(error));
+    }
+    ::madvise(data, m_size, MADV_SEQUENTIAL);
+    m_data = static_cast<const char *>(data);
+  }
+  // the mapping stays valid after the descriptor is closed
+  ::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+  if (m_data)
+  {
+    ::munmap(const_cast<char *>(m_data), m_size);
+  }
+}
+
+void
+MappedFile::release(std::size_t offset, std::size_t size) const
+{
+  // madvise works on whole pages, the partial pages at both ends are kept
+  const std::size_t pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  const std::size_t begin = (offset + pageSize - 1) / pageSize * pageSize;
+  const std::size_t end = std::min(offset + size, m_size) / pageSize * pageSize;
+  if (m_data && begin < end)
+  {
+    ::madvise(const_cast<char *>(m_data) + begin, end - begin, MADV_DONTNEED);
+  }
+}
+
+} // namespace StatismoUI
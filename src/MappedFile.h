@@ -0,0 +1,45 @@
+#ifndef UI_MAPPEDFILE_H
+#define UI_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace StatismoUI
+{
+// Read-only memory mapping of a whole file (POSIX mmap). Pages are loaded by the kernel as they are read and, being
+// backed by the file, can be dropped again without being written to swap.
+class MappedFile
+{
+public:
+  // Throws std::runtime_error if the file cannot be opened or mapped
+  explicit MappedFile(const std::string & path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &
+  operator=(const MappedFile &) = delete;
+
+  const char *
+  data() const
+  {
+    return m_data;
+  }
+
+  std::size_t
+  size() const
+  {
+    return m_size;
+  }
+
+  // Tells the kernel that the bytes [offset, offset + size) will not be read again, so that their pages no longer
+  // count towards the resident memory of the process
+  void
+  release(std::size_t offset, std::size_t size) const;
+
+private:
+  const char * m_data{ nullptr };
+  std::size_t  m_size{ 0 };
+};
+} // namespace StatismoUI
+
+#endif // UI_MAPPEDFILE_H
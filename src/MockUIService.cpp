@@ -0,0 +1,1176 @@
+#include "MockUIService.h"
+#include "CountingTransport.h"
+#include "ServerConnection.h"
+
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/protocol/TCompactProtocol.h>
+#include <thrift/server/TThreadedServer.h>
+#include <thrift/transport/TBufferTransports.h>
+#include <thrift/transport/TServerSocket.h>
+#include <thrift/transport/TSocket.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+using namespace apache::thrift;
+using namespace apache::thrift::protocol;
+using namespace apache::thrift::server;
+using namespace apache::thrift::transport;
+
+namespace StatismoUI
+{
+
+namespace
+{
+std::size_t
+scalarTypeSize(ui::ScalarType::type type)
+{
+  switch (type)
+  {
+    case ui::ScalarType::FLOAT32:
+    case ui::ScalarType::INT32:
+    case ui::ScalarType::UINT32:
+      return 4;
+    case ui::ScalarType::FLOAT64:
+      return 8;
+    case ui::ScalarType::INT8:
+    case ui::ScalarType::UINT8:
+      return 1;
+    case ui::ScalarType::INT16:
+    case ui::ScalarType::UINT16:
+    case ui::ScalarType::FLOAT16:
+      return 2;
+  }
+  throw std::invalid_argument("unknown scalar type");
+}
+
+// Counts the bytes on the wire below the transport stack selected by the options
+class CountingTransportFactory : public TTransportFactory
+{
+public:
+  CountingTransportFactory(const ConnectionOptions & options, std::shared_ptr<TransferCounters> counters)
+    : m_options(options)
+    , m_counters(std::move(counters))
+  {}
+
+  std::shared_ptr<TTransport>
+  getTransport(std::shared_ptr<TTransport> transport) override
+  {
+    return makeTransport(m_options, std::make_shared<CountingTransport>(transport, m_counters));
+  }
+
+private:
+  ConnectionOptions                 m_options;
+  std::shared_ptr<TransferCounters> m_counters;
+};
+
+std::string
+newSessionId()
+{
+  std::random_device                           device;
+  std::uniform_int_distribution<std::uint32_t> word;
+  std::ostringstream                           id;
+  id << std::hex << std::setfill('0');
+  for (int i = 0; i < 4; ++i)
+  {
+    id << std::setw(8) << word(device);
+  }
+  return id.str();
+}
+
+void
+checkSize(const std::string & data, std::size_t expected, const char * what)
+{
+  if (data.size() != expected)
+  {
+    throw std::invalid_argument(std::string(what) + " has " + std::to_string(data.size()) + " bytes, expected " +
+                                std::to_string(expected));
+  }
+}
+} // namespace
+
+MockUIService::MockUIService()
+  : m_sessionId(newSessionId())
+{}
+
+MockUIService::Statistics
+MockUIService::GetStatistics() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  Statistics stats;
+  stats.numberOfCalls = m_numberOfCalls;
+  stats.numberOfGroups = m_groups.size();
+  stats.numberOfImages = m_imageViews.size();
+  stats.numberOfShapeModels = m_shapeModelTransformationViews.size();
+  stats.numberOfTriangleMeshes = m_triangleMeshViews.size() - stats.numberOfShapeModels;
+  stats.numberOfRegisteredModels = m_registeredModels.size();
+  stats.numberOfPointClouds = m_numberOfPointClouds;
+  stats.numberOfPointCloudPoints = m_numberOfPointCloudPoints;
+  stats.numberOfLandmarks = m_numberOfLandmarks;
+  stats.numberOfTrajectories = m_trajectories.size();
+  for (const auto & trajectory : m_trajectories)
+  {
+    stats.numberOfTrajectoryKeyframes += trajectory.second.times.size();
+  }
+  stats.numberOfVertexScalarFields = m_vertexScalars.size();
+  return stats;
+}
+
+std::size_t
+MockUIService::GetTrajectoryKeyframe(int viewId) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto loaded = m_trajectories.find(viewId);
+  if (loaded == m_trajectories.end())
+  {
+    throw std::invalid_argument("shape model transformation " + std::to_string(viewId) + " has no trajectory");
+  }
+  const LoadedTrajectory &       trajectory = loaded->second;
+  const ui::TrajectoryPlayback & playback = trajectory.playback;
+
+  double time = playback.time;
+  if (playback.playing)
+  {
+    time += playback.speed *
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - trajectory.started).count();
+  }
+  const double duration = trajectory.times.back();
+  if (duration > 0)
+  {
+    switch (playback.mode)
+    {
+      case ui::PlaybackMode::LOOP:
+        time = std::fmod(time, duration);
+        break;
+      case ui::PlaybackMode::BOUNCE:
+        time = std::fmod(time, 2 * duration);
+        time = time <= duration ? time : 2 * duration - time;
+        break;
+      default:
+        time = std::min(time, duration);
+        break;
+    }
+  }
+  auto after = std::upper_bound(trajectory.times.begin(), trajectory.times.end(), time);
+  return after == trajectory.times.begin() ? 0 : after - trajectory.times.begin() - 1;
+}
+
+std::pair<std::vector<float>, std::string>
+MockUIService::GetTriangleMeshScalars(int viewId) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto scalars = m_vertexScalars.find(viewId);
+  if (scalars == m_vertexScalars.end())
+  {
+    throw std::invalid_argument("triangle mesh " + std::to_string(viewId) + " has no scalars");
+  }
+  const ui::PackedVertexScalars & packed = scalars->second;
+
+  std::vector<float> values(packed.numberOfVertices);
+  for (std::size_t i = 0; i < values.size(); ++i)
+  {
+    if (packed.scalarType == ui::ScalarType::FLOAT64)
+    {
+      double value;
+      std::memcpy(&value, packed.values.data() + i * sizeof(value), sizeof(value));
+      values[i] = static_cast<float>(value);
+    }
+    else
+    {
+      std::memcpy(&values[i], packed.values.data() + i * sizeof(float), sizeof(float));
+    }
+  }
+  return { std::move(values), packed.name };
+}
+
+void
+MockUIService::getSessionId(std::string & _return)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  _return = m_sessionId;
+}
+
+void
+MockUIService::createGroup(ui::Group & _return, const std::string & name)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  _return.id = m_nextId++;
+  _return.name = name;
+  m_groups[_return.id] = name;
+}
+
+void
+MockUIService::createTriangleMesh(ui::TriangleMeshView & _return,
+                                  const ui::Group &      g,
+                                  std::int32_t           numberOfVertices,
+                                  std::int32_t           numberOfTriangles,
+                                  const std::string &)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  checkGroup(g);
+  if (numberOfVertices < 0 || numberOfTriangles < 0)
+  {
+    throw std::invalid_argument("negative mesh size");
+  }
+  _return = newTriangleMeshView(g);
+  m_triangleMeshVertexCounts[_return.id] = static_cast<std::size_t>(numberOfVertices);
+  m_triangleMeshTriangleCounts[_return.id] = static_cast<std::size_t>(numberOfTriangles);
+}
+
+void
+MockUIService::writeTriangleMeshChunk(const ui::TriangleMeshView & tmv, const ui::PackedMeshChunk & chunk)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  auto triangleCount = m_triangleMeshTriangleCounts.find(tmv.id);
+  if (triangleCount == m_triangleMeshTriangleCounts.end())
+  {
+    throw std::invalid_argument("unknown mesh created with createTriangleMesh " + std::to_string(tmv.id));
+  }
+  const std::size_t numberOfVertices = m_triangleMeshVertexCounts.at(tmv.id);
+  const std::size_t numberOfTriangles = triangleCount->second;
+
+  const std::size_t elementBytes = 3 * sizeof(float);
+  if (chunk.firstVertex < 0 || chunk.vertices.size() % elementBytes != 0 ||
+      static_cast<std::size_t>(chunk.firstVertex) + chunk.vertices.size() / elementBytes > numberOfVertices)
+  {
+    throw std::invalid_argument("the vertices are outside of the mesh");
+  }
+  if (chunk.firstTriangle < 0 || chunk.topology.size() % elementBytes != 0 ||
+      static_cast<std::size_t>(chunk.firstTriangle) + chunk.topology.size() / elementBytes > numberOfTriangles)
+  {
+    throw std::invalid_argument("the triangles are outside of the mesh");
+  }
+  for (std::size_t offset = 0; offset < chunk.topology.size(); offset += sizeof(std::int32_t))
+  {
+    std::int32_t id;
+    std::memcpy(&id, chunk.topology.data() + offset, sizeof(id));
+    if (id < 0 || static_cast<std::size_t>(id) >= numberOfVertices)
+    {
+      throw std::invalid_argument("triangle refers to a vertex that does not exist");
+    }
+  }
+}
+
+void
+MockUIService::showPointCloud(const ui::Group & g, const ui::PointList &, const std::string &)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  checkGroup(g);
+  ++m_numberOfPointClouds;
+}
+
+void
+MockUIService::createPointCloud(ui::PointCloudView & _return,
+                                const ui::Group &    g,
+                                const std::string &,
+                                std::int64_t         expectedNumberOfPoints)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  checkGroup(g);
+  if (expectedNumberOfPoints < 0)
+  {
+    throw std::invalid_argument("negative number of points");
+  }
+  _return.id = addObject(g);
+  m_pointClouds[_return.id] = PointCloudProgress{ static_cast<std::size_t>(expectedNumberOfPoints), 0 };
+  ++m_numberOfPointClouds;
+}
+
+void
+MockUIService::appendPointCloudPoints(const ui::PointCloudView & pcv, const ui::PackedPointChunk & chunk)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  auto cloud = m_pointClouds.find(pcv.id);
+  if (cloud == m_pointClouds.end())
+  {
+    throw std::invalid_argument("unknown point cloud " + std::to_string(pcv.id));
+  }
+  if (chunk.numberOfPoints < 0)
+  {
+    throw std::invalid_argument("negative number of points");
+  }
+
+  const std::size_t numberOfPoints = static_cast<std::size_t>(chunk.numberOfPoints);
+  checkSize(chunk.points, 3 * numberOfPoints * scalarTypeSize(chunk.pointType), "points");
+
+  PointCloudProgress & progress = cloud->second;
+  progress.numberOfPoints += numberOfPoints;
+  if (progress.expectedNumberOfPoints > 0 && progress.numberOfPoints > progress.expectedNumberOfPoints)
+  {
+    throw std::invalid_argument("the point cloud was announced with " +
+                                std::to_string(progress.expectedNumberOfPoints) + " points");
+  }
+  m_numberOfPointCloudPoints += numberOfPoints;
+}
+
+void
+MockUIService::showTriangleMesh(ui::TriangleMeshView &   _return,
+                                const ui::Group &        g,
+                                const ui::TriangleMesh & m,
+                                const std::string &)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  checkGroup(g);
+  for (const auto & cell : m.topology)
+  {
+    const int n = static_cast<int>(m.vertices.size());
+    if (cell.id1 < 0 || cell.id1 >= n || cell.id2 < 0 || cell.id2 >= n || cell.id3 < 0 || cell.id3 >= n)
+    {
+      throw std::invalid_argument("triangle refers to a vertex that does not exist");
+    }
+  }
+  _return = newTriangleMeshView(g);
+  m_triangleMeshVertexCounts[_return.id] = m.vertices.size();
+}
+
+void
+MockUIService::showPackedTriangleMesh(ui::TriangleMeshView &         _return,
+                                      const ui::Group &              g,
+                                      const ui::PackedTriangleMesh & m,
+                                      const std::string &)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  checkGroup(g);
+  checkPackedMesh(m);
+  _return = newTriangleMeshView(g);
+  m_triangleMeshVertexCounts[_return.id] = m.numberOfVertices;
+}
+
+void
+MockUIService::showImage(ui::ImageView & _return, const ui::Group & g, const ui::Image & img, const std::string &)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  checkGroup(g);
+  const auto & size = img.domain.size;
+  if (img.data.size() != static_cast<std::size_t>(size.i) * size.j * size.k)
+  {
+    throw std::invalid_argument("image data does not match the image size");
+  }
+
+  _return.id = addObject(g);
+  _return.window = 256;
+  _return.level = 256;
+  _return.opacity = 1.0;
+  m_imageViews[_return.id] = _return;
+}
+
+void
+MockUIService::showPackedImage(ui::ImageView &         _return,
+                               const ui::Group &       g,
+                               const ui::PackedImage & img,
+                               const std::string &)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  checkGroup(g);
+  const auto & size = img.domain.size;
+  checkSize(img.data, static_cast<std::size_t>(size.i) * size.j * size.k * scalarTypeSize(img.pixelType), "image data");
+
+  _return.id = addObject(g);
+  _return.window = 256;
+  _return.level = 256;
+  _return.opacity = 1.0;
+  m_imageViews[_return.id] = _return;
+}
+
+void
+MockUIService::showImagePyramid(ui::ImageView &         _return,
+                                const ui::Group &       g,
+                                const ui::ImageDomain & domain,
+                                std::int32_t            numberOfLevels,
+                                const ui::PackedImage & coarsestLevel,
+                                const std::string &)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  checkGroup(g);
+  if (numberOfLevels < 1)
+  {
+    throw std::invalid_argument("an image pyramid has at least one level");
+  }
+
+  ImagePyramidSize pyramid;
+  pyramid.pixelType = coarsestLevel.pixelType;
+  pyramid.levelSizes.push_back({ static_cast<std::size_t>(domain.size.i),
+                                 static_cast<std::size_t>(domain.size.j),
+                                 static_cast<std::size_t>(domain.size.k) });
+  while (pyramid.levelSizes.size() < static_cast<std::size_t>(numberOfLevels))
+  {
+    const auto & fine = pyramid.levelSizes.back();
+    pyramid.levelSizes.push_back({ (fine[0] + 1) / 2, (fine[1] + 1) / 2, (fine[2] + 1) / 2 });
+  }
+
+  const auto & coarsest = pyramid.levelSizes.back();
+  const auto & size = coarsestLevel.domain.size;
+  if (static_cast<std::size_t>(size.i) != coarsest[0] || static_cast<std::size_t>(size.j) != coarsest[1] ||
+      static_cast<std::size_t>(size.k) != coarsest[2])
+  {
+    throw std::invalid_argument("the coarsest level does not match the size of the image");
+  }
+  checkSize(coarsestLevel.data,
+            coarsest[0] * coarsest[1] * coarsest[2] * scalarTypeSize(coarsestLevel.pixelType),
+            "image data");
+
+  _return.id = addObject(g);
+  _return.window = 256;
+  _return.level = 256;
+  _return.opacity = 1.0;
+  m_imageViews[_return.id] = _return;
+  m_imagePyramids[_return.id] = std::move(pyramid);
+}
+
+void
+MockUIService::createImage(ui::ImageView &         _return,
+                           const ui::Group &       g,
+                           const ui::ImageDomain & domain,
+                           ui::ScalarType::type    pixelType,
+                           const std::string &)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  checkGroup(g);
+  if (domain.size.i < 0 || domain.size.j < 0 || domain.size.k < 0)
+  {
+    throw std::invalid_argument("negative image size");
+  }
+  scalarTypeSize(pixelType);
+
+  // an image without a pyramid is written like the single level of one
+  ImagePyramidSize pyramid;
+  pyramid.pixelType = pixelType;
+  pyramid.levelSizes.push_back({ static_cast<std::size_t>(domain.size.i),
+                                 static_cast<std::size_t>(domain.size.j),
+                                 static_cast<std::size_t>(domain.size.k) });
+
+  _return.id = addObject(g);
+  _return.window = 256;
+  _return.level = 256;
+  _return.opacity = 1.0;
+  m_imageViews[_return.id] = _return;
+  m_imagePyramids[_return.id] = std::move(pyramid);
+}
+
+void
+MockUIService::updateImageRegion(const ui::ImageView & iv, const ui::PackedImageRegion & region)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  auto pyramid = m_imagePyramids.find(iv.id);
+  if (pyramid == m_imagePyramids.end())
+  {
+    throw std::invalid_argument("unknown image with updatable regions " + std::to_string(iv.id));
+  }
+  const auto & levelSizes = pyramid->second.levelSizes;
+  if (region.region.level < 0 || static_cast<std::size_t>(region.region.level) >= levelSizes.size())
+  {
+    throw std::invalid_argument("the image pyramid has " + std::to_string(levelSizes.size()) + " levels");
+  }
+  if (region.pixelType != pyramid->second.pixelType)
+  {
+    throw std::invalid_argument("the pixel type differs from the one of the image");
+  }
+
+  const auto &       levelSize = levelSizes[region.region.level];
+  const std::int32_t index[] = { region.region.index.i, region.region.index.j, region.region.index.k };
+  const std::int32_t size[] = { region.region.size.i, region.region.size.j, region.region.size.k };
+  for (unsigned d = 0; d < 3; ++d)
+  {
+    if (index[d] < 0 || size[d] < 0 || static_cast<std::size_t>(index[d]) + size[d] > levelSize[d])
+    {
+      throw std::invalid_argument("the region is outside of the level");
+    }
+  }
+  checkSize(region.data,
+            static_cast<std::size_t>(size[0]) * size[1] * size[2] * scalarTypeSize(region.pixelType),
+            "region data");
+}
+
+void
+MockUIService::showLandmark(const ui::Group & g, const ui::Landmark &, const std::string &)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  checkGroup(g);
+  ++m_numberOfLandmarks;
+}
+
+void
+MockUIService::showLandmarks(const ui::Group & g, const std::vector<ui::Landmark> & landmarks)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  checkGroup(g);
+  m_numberOfLandmarks += landmarks.size();
+}
+
+void
+MockUIService::showStatisticalShapeModel(ui::ShapeModelView &              _return,
+                                         const ui::Group &                 g,
+                                         const ui::StatisticalShapeModel & ssm,
+                                         const std::string &)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  checkGroup(g);
+  const std::size_t dimension = 3 * ssm.reference.vertices.size();
+  if (ssm.mean.size() != dimension || ssm.klbasis.eigenvectors.size() != ssm.klbasis.eigenvalues.size())
+  {
+    throw std::invalid_argument("model dimensions are inconsistent");
+  }
+  for (const auto & eigenvector : ssm.klbasis.eigenvectors)
+  {
+    if (eigenvector.size() != dimension)
+    {
+      throw std::invalid_argument("model dimensions are inconsistent");
+    }
+  }
+  _return = newShapeModelView(g, { dimension, ssm.klbasis.eigenvalues.size() });
+}
+
+void
+MockUIService::showPackedStatisticalShapeModel(ui::ShapeModelView &                    _return,
+                                               const ui::Group &                       g,
+                                               const ui::PackedStatisticalShapeModel & ssm,
+                                               const std::string &)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  checkGroup(g);
+  checkPackedModel(ssm);
+  _return = newShapeModelView(
+    g, { 3 * static_cast<std::size_t>(ssm.reference.numberOfVertices), ssm.klbasis.eigenvalues.size() });
+}
+
+void
+MockUIService::registerStatisticalShapeModel(const std::string & modelHash, const ui::PackedStatisticalShapeModel & ssm)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  checkPackedModel(ssm);
+  m_registeredModels[modelHash] = { 3 * static_cast<std::size_t>(ssm.reference.numberOfVertices),
+                                    ssm.klbasis.eigenvalues.size() };
+}
+
+void
+MockUIService::showRegisteredStatisticalShapeModel(ui::ShapeModelView & _return,
+                                                   const ui::Group &    g,
+                                                   const std::string &  modelHash,
+                                                   const std::string &)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  checkGroup(g);
+  auto model = m_registeredModels.find(modelHash);
+  if (model == m_registeredModels.end())
+  {
+    ui::UnknownModel e;
+    e.modelHash = modelHash;
+    throw e;
+  }
+  _return = newShapeModelView(g, model->second);
+}
+
+void
+MockUIService::appendShapeModelComponents(const ui::ShapeModelView & smv, const ui::PackedKLBasis & components)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  const int id = smv.shapeModelTransformationView.id;
+  auto      size = m_shapeModelSizes.find(id);
+  if (size == m_shapeModelSizes.end())
+  {
+    throw std::invalid_argument("unknown shape model transformation " + std::to_string(id));
+  }
+  checkPackedBasis(components, size->second.dimension);
+  size->second.numberOfComponents += components.eigenvalues.size();
+}
+
+void
+MockUIService::updateShapeModelTransformation(const ui::ShapeModelTransformationView & smtv)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  auto view = m_shapeModelTransformationViews.find(smtv.id);
+  if (view == m_shapeModelTransformationViews.end())
+  {
+    throw std::invalid_argument("unknown shape model transformation " + std::to_string(smtv.id));
+  }
+  view->second = smtv;
+}
+
+void
+MockUIService::loadShapeTrajectory(const ui::ShapeModelTransformationView & smtv,
+                                   const ui::PackedShapeTrajectory &        trajectory)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  auto size = m_shapeModelSizes.find(smtv.id);
+  if (size == m_shapeModelSizes.end())
+  {
+    throw std::invalid_argument("unknown shape model transformation " + std::to_string(smtv.id));
+  }
+  if (trajectory.numberOfFrames <= 0 || trajectory.numberOfCoefficients < 0)
+  {
+    throw std::invalid_argument("a trajectory needs keyframes");
+  }
+  if (static_cast<std::size_t>(trajectory.numberOfCoefficients) > size->second.numberOfComponents)
+  {
+    throw std::invalid_argument("the trajectory has more coefficients than the model has components");
+  }
+  if (trajectory.scalarType != ui::ScalarType::FLOAT32 && trajectory.scalarType != ui::ScalarType::FLOAT64 &&
+      trajectory.scalarType != ui::ScalarType::FLOAT16)
+  {
+    throw std::invalid_argument("coefficients must be FLOAT32, FLOAT64 or FLOAT16");
+  }
+  const std::size_t numberOfFrames = trajectory.numberOfFrames;
+  checkSize(trajectory.times, numberOfFrames * sizeof(double), "times");
+  checkSize(trajectory.coefficients,
+            numberOfFrames * trajectory.numberOfCoefficients * scalarTypeSize(trajectory.scalarType),
+            "coefficients");
+  if (trajectory.__isset.poses)
+  {
+    checkSize(trajectory.poses, numberOfFrames * 9 * sizeof(double), "poses");
+  }
+
+  LoadedTrajectory loaded;
+  loaded.times.resize(numberOfFrames);
+  std::memcpy(loaded.times.data(), trajectory.times.data(), trajectory.times.size());
+  // strictly increasing: no two keyframes at the same time
+  if (loaded.times.front() < 0 || !std::is_sorted(loaded.times.begin(), loaded.times.end(), std::less_equal<double>()))
+  {
+    throw std::invalid_argument("keyframe times must be increasing, from 0 on");
+  }
+  loaded.playback.playing = false;
+  loaded.playback.time = 0;
+  loaded.playback.speed = 1;
+  loaded.playback.mode = ui::PlaybackMode::ONCE;
+  loaded.started = std::chrono::steady_clock::now();
+  m_trajectories[smtv.id] = std::move(loaded);
+}
+
+void
+MockUIService::playShapeTrajectory(const ui::ShapeModelTransformationView & smtv,
+                                   const ui::TrajectoryPlayback &           playback)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  auto trajectory = m_trajectories.find(smtv.id);
+  if (trajectory == m_trajectories.end())
+  {
+    throw std::invalid_argument("shape model transformation " + std::to_string(smtv.id) + " has no trajectory");
+  }
+  if (!(playback.speed > 0) || !(playback.time >= 0))
+  {
+    throw std::invalid_argument("the playback needs a positive speed and a time from 0 on");
+  }
+  trajectory->second.playback = playback;
+  trajectory->second.started = std::chrono::steady_clock::now();
+}
+
+void
+MockUIService::updateShapeModelTransformations(const std::vector<ui::ShapeModelTransformationView> & smtvs)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  // oneway: there is nobody to report an error to, unknown views are ignored
+  for (const auto & smtv : smtvs)
+  {
+    auto view = m_shapeModelTransformationViews.find(smtv.id);
+    if (view != m_shapeModelTransformationViews.end())
+    {
+      view->second = smtv;
+    }
+  }
+}
+
+void
+MockUIService::updateTriangleMeshView(const ui::TriangleMeshView & tmv)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  auto view = m_triangleMeshViews.find(tmv.id);
+  if (view == m_triangleMeshViews.end())
+  {
+    throw std::invalid_argument("unknown triangle mesh " + std::to_string(tmv.id));
+  }
+  view->second = tmv;
+}
+
+void
+MockUIService::updateTriangleMeshVertices(const ui::TriangleMeshView & tmv, const ui::PackedVertexUpdate & update)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  auto vertexCount = m_triangleMeshVertexCounts.find(tmv.id);
+  if (vertexCount == m_triangleMeshVertexCounts.end())
+  {
+    throw std::invalid_argument("unknown triangle mesh " + std::to_string(tmv.id));
+  }
+
+  const std::size_t numberOfVertices = static_cast<std::size_t>(update.numberOfVertices);
+  checkSize(update.vertices, 3 * numberOfVertices * scalarTypeSize(update.vertexType), "vertices");
+  if (!update.__isset.indices)
+  {
+    if (numberOfVertices != vertexCount->second)
+    {
+      throw std::invalid_argument("the mesh has " + std::to_string(vertexCount->second) + " vertices");
+    }
+    return;
+  }
+
+  checkSize(update.indices, numberOfVertices * sizeof(std::int32_t), "indices");
+  for (std::size_t i = 0; i < numberOfVertices; ++i)
+  {
+    std::int32_t id;
+    std::memcpy(&id, update.indices.data() + i * sizeof(id), sizeof(id));
+    if (id < 0 || static_cast<std::size_t>(id) >= vertexCount->second)
+    {
+      throw std::invalid_argument("vertex " + std::to_string(id) + " does not exist");
+    }
+  }
+}
+
+void
+MockUIService::updateTriangleMeshScalars(const ui::TriangleMeshView & tmv, const ui::PackedVertexScalars & scalars)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  auto vertexCount = m_triangleMeshVertexCounts.find(tmv.id);
+  if (vertexCount == m_triangleMeshVertexCounts.end())
+  {
+    throw std::invalid_argument("unknown triangle mesh " + std::to_string(tmv.id));
+  }
+  if (scalars.scalarType != ui::ScalarType::FLOAT32 && scalars.scalarType != ui::ScalarType::FLOAT64)
+  {
+    throw std::invalid_argument("scalars must be FLOAT32 or FLOAT64");
+  }
+  if (scalars.numberOfVertices < 0 || static_cast<std::size_t>(scalars.numberOfVertices) != vertexCount->second)
+  {
+    throw std::invalid_argument("the mesh has " + std::to_string(vertexCount->second) + " vertices");
+  }
+  checkSize(scalars.values, vertexCount->second * scalarTypeSize(scalars.scalarType), "values");
+  m_vertexScalars[tmv.id] = scalars;
+}
+
+void
+MockUIService::updateImageView(const ui::ImageView & iv)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  auto view = m_imageViews.find(iv.id);
+  if (view == m_imageViews.end())
+  {
+    throw std::invalid_argument("unknown image " + std::to_string(iv.id));
+  }
+  view->second = iv;
+}
+
+void
+MockUIService::removeGroup(const ui::Group & g)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  checkGroup(g);
+  std::vector<int> ids;
+  for (const auto & object : m_objectGroups)
+  {
+    if (object.second == g.id)
+    {
+      ids.push_back(object.first);
+    }
+  }
+  for (int id : ids)
+  {
+    removeObject(id);
+  }
+  m_groups.erase(g.id);
+}
+
+void
+MockUIService::removeImage(const ui::ImageView & iv)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  removeObject(iv.id);
+}
+
+void
+MockUIService::removeTriangleMesh(const ui::TriangleMeshView & tmv)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  removeObject(tmv.id);
+}
+
+void
+MockUIService::removeShapeModelTransformation(const ui::ShapeModelTransformationView & smv)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  removeObject(smv.id);
+}
+
+void
+MockUIService::removeShapeModel(const ui::ShapeModelView & smv)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_numberOfCalls;
+
+  removeObject(smv.meshView.id);
+  removeObject(smv.shapeModelTransformationView.id);
+}
+
+void
+MockUIService::applySceneBatch(std::vector<ui::SceneOperationResult> & _return,
+                               const std::vector<ui::SceneOperation> & operations)
+{
+  _return.clear();
+  _return.reserve(operations.size());
+
+  // A group with id -(k + 1) is the one created by operation k of this batch
+  auto resolve = [&_return](const ui::Group & g) {
+    if (g.id >= 0)
+    {
+      return g;
+    }
+    const std::size_t index = -(g.id + 1);
+    if (index >= _return.size() || !_return[index].__isset.group)
+    {
+      throw std::invalid_argument("operation " + std::to_string(index) + " of the batch did not create a group");
+    }
+    return _return[index].group;
+  };
+
+  for (std::size_t i = 0; i < operations.size(); ++i)
+  {
+    const ui::SceneOperation & operation = operations[i];
+    ui::SceneOperationResult   result;
+    try
+    {
+      if (operation.__isset.createGroup)
+      {
+        createGroup(result.group, operation.createGroup);
+        result.__isset.group = true;
+      }
+      else if (operation.__isset.showPointCloud)
+      {
+        const auto & show = operation.showPointCloud;
+        showPointCloud(resolve(show.g), show.points, show.name);
+      }
+      else if (operation.__isset.showTriangleMesh)
+      {
+        const auto & show = operation.showTriangleMesh;
+        showPackedTriangleMesh(result.meshView, resolve(show.g), show.mesh, show.name);
+        result.__isset.meshView = true;
+      }
+      else if (operation.__isset.showImage)
+      {
+        const auto & show = operation.showImage;
+        showPackedImage(result.imageView, resolve(show.g), show.image, show.name);
+        result.__isset.imageView = true;
+      }
+      else if (operation.__isset.showLandmark)
+      {
+        const auto & show = operation.showLandmark;
+        showLandmark(resolve(show.g), show.landmark, show.name);
+      }
+      else if (operation.__isset.updateTriangleMeshView)
+      {
+        updateTriangleMeshView(operation.updateTriangleMeshView);
+      }
+      else if (operation.__isset.updateImageView)
+      {
+        updateImageView(operation.updateImageView);
+      }
+      else if (operation.__isset.updateShapeModelTransformation)
+      {
+        updateShapeModelTransformation(operation.updateShapeModelTransformation);
+      }
+      else if (operation.__isset.removeGroup)
+      {
+        removeGroup(resolve(operation.removeGroup));
+      }
+      else if (operation.__isset.removeTriangleMesh)
+      {
+        removeTriangleMesh(operation.removeTriangleMesh);
+      }
+      else if (operation.__isset.removeImage)
+      {
+        removeImage(operation.removeImage);
+      }
+      else
+      {
+        throw std::invalid_argument("empty operation");
+      }
+    }
+    catch (const std::exception & e)
+    {
+      ui::SceneBatchError error;
+      error.operationIndex = static_cast<std::int32_t>(i);
+      error.message = e.what();
+      error.__set_results(_return);
+      throw error;
+    }
+    _return.push_back(std::move(result));
+  }
+}
+
+int
+MockUIService::addObject(const ui::Group & g)
+{
+  const int id = m_nextId++;
+  m_objectGroups[id] = g.id;
+  return id;
+}
+
+void
+MockUIService::removeObject(int id)
+{
+  if (m_objectGroups.erase(id) == 0)
+  {
+    throw std::invalid_argument("unknown object " + std::to_string(id));
+  }
+  m_triangleMeshViews.erase(id);
+  m_triangleMeshVertexCounts.erase(id);
+  m_triangleMeshTriangleCounts.erase(id);
+  m_imageViews.erase(id);
+  m_shapeModelTransformationViews.erase(id);
+  m_shapeModelSizes.erase(id);
+  m_trajectories.erase(id);
+  m_vertexScalars.erase(id);
+  m_pointClouds.erase(id);
+  m_imagePyramids.erase(id);
+}
+
+void
+MockUIService::checkGroup(const ui::Group & g) const
+{
+  if (m_groups.count(g.id) == 0)
+  {
+    throw std::invalid_argument("unknown group " + std::to_string(g.id));
+  }
+}
+
+ui::TriangleMeshView
+MockUIService::newTriangleMeshView(const ui::Group & g)
+{
+  ui::TriangleMeshView view;
+  view.id = addObject(g);
+  view.color.r = 255;
+  view.color.g = 255;
+  view.color.b = 255;
+  view.lineWidth = 1;
+  view.opacity = 1.0;
+  m_triangleMeshViews[view.id] = view;
+  return view;
+}
+
+ui::ShapeModelView
+MockUIService::newShapeModelView(const ui::Group & g, const ModelSize & size)
+{
+  ui::ShapeModelView view;
+  view.meshView = newTriangleMeshView(g);
+  m_triangleMeshVertexCounts[view.meshView.id] = size.dimension / 3;
+
+  auto & smtv = view.shapeModelTransformationView;
+  smtv.id = addObject(g);
+  smtv.shapeTransformation.coefficients.assign(size.numberOfComponents, 0.0);
+  smtv.poseTransformation.rotation.center.x = 0;
+  smtv.poseTransformation.rotation.center.y = 0;
+  smtv.poseTransformation.rotation.center.z = 0;
+  smtv.poseTransformation.rotation.angleX = 0;
+  smtv.poseTransformation.rotation.angleY = 0;
+  smtv.poseTransformation.rotation.angleZ = 0;
+  smtv.poseTransformation.translation.x = 0;
+  smtv.poseTransformation.translation.y = 0;
+  smtv.poseTransformation.translation.z = 0;
+  m_shapeModelTransformationViews[smtv.id] = smtv;
+  m_shapeModelSizes[smtv.id] = size;
+  return view;
+}
+
+void
+MockUIService::checkPackedMesh(const ui::PackedTriangleMesh & m) const
+{
+  checkSize(m.vertices, 3 * static_cast<std::size_t>(m.numberOfVertices) * scalarTypeSize(m.vertexType), "vertices");
+  checkSize(m.topology, 3 * static_cast<std::size_t>(m.numberOfTriangles) * sizeof(std::int32_t), "topology");
+}
+
+void
+MockUIService::checkPackedBasis(const ui::PackedKLBasis & basis, std::size_t dimension) const
+{
+  checkSize(basis.eigenvectors,
+            dimension * basis.numberOfComponents * scalarTypeSize(basis.scalarType),
+            "eigenvectors");
+  if (basis.eigenvalues.size() != static_cast<std::size_t>(basis.numberOfComponents))
+  {
+    throw std::invalid_argument("number of eigenvalues does not match the number of components");
+  }
+  if (basis.scalarType == ui::ScalarType::INT16 &&
+      (basis.columnScales.size() != basis.eigenvalues.size() || basis.columnOffsets.size() != basis.eigenvalues.size()))
+  {
+    throw std::invalid_argument("quantized basis needs a scale and an offset per component");
+  }
+}
+
+void
+MockUIService::checkPackedModel(const ui::PackedStatisticalShapeModel & ssm) const
+{
+  checkPackedMesh(ssm.reference);
+
+  const std::size_t dimension = 3 * static_cast<std::size_t>(ssm.reference.numberOfVertices);
+  checkSize(ssm.mean, dimension * scalarTypeSize(ssm.meanType), "mean");
+  checkPackedBasis(ssm.klbasis, dimension);
+}
+
+MockUIServer::MockUIServer(const ConnectionOptions & options)
+  : m_service(std::make_shared<MockUIService>())
+  , m_counters(std::make_shared<TransferCounters>())
+  , m_port(options.port)
+{
+  // the server socket only learns its port once serve() listens, so ask the system for a free one beforehand
+  if (m_port == 0)
+  {
+    TServerSocket socket(0);
+    socket.listen();
+    m_port = socket.getPort();
+    socket.close();
+  }
+
+  std::shared_ptr<TProtocolFactory> protocolFactory;
+  if (options.protocol == Protocol::Compact)
+  {
+    protocolFactory = std::make_shared<TCompactProtocolFactory>();
+  }
+  else
+  {
+    protocolFactory = std::make_shared<TBinaryProtocolFactory>();
+  }
+
+  auto server = std::make_shared<TThreadedServer>(std::make_shared<ui::UIProcessor>(m_service),
+                                                  std::make_shared<TServerSocket>(m_port),
+                                                  std::make_shared<CountingTransportFactory>(options, m_counters),
+                                                  protocolFactory);
+  m_server = server;
+  m_thread = std::thread([this, server] {
+    try
+    {
+      server->serve();
+    }
+    catch (...)
+    {
+      m_error = std::current_exception();
+    }
+  });
+
+  // serve() gives no signal once it listens, so probe the port until it accepts a connection
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (true)
+  {
+    try
+    {
+      TSocket probe("localhost", m_port);
+      probe.open();
+      probe.close();
+      return;
+    }
+    catch (const TTransportException &)
+    {
+      if (std::chrono::steady_clock::now() > deadline)
+      {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  stop();
+  if (m_error)
+  {
+    std::rethrow_exception(m_error);
+  }
+  throw std::runtime_error("mock UI service did not start on port " + std::to_string(m_port));
+}
+
+std::uint64_t
+MockUIServer::GetBytesReceived() const
+{
+  return m_counters->bytesRead;
+}
+
+std::uint64_t
+MockUIServer::GetBytesSent() const
+{
+  return m_counters->bytesWritten;
+}
+
+MockUIServer::~MockUIServer()
+{
+  stop();
+}
+
+void
+MockUIServer::stop()
+{
+  if (m_thread.joinable())
+  {
+    m_server->stop();
+    m_thread.join();
+  }
+}
+
+} // namespace StatismoUI
@@ -0,0 +1,339 @@
+#ifndef UI_MOCKUISERVICE_H
+#define UI_MOCKUISERVICE_H
+
+#include "StatismoUI.h"
+#include "thrift/UI.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace apache
+{
+namespace thrift
+{
+namespace server
+{
+class TServer;
+} // namespace server
+} // namespace thrift
+} // namespace apache
+
+namespace StatismoUI
+{
+struct TransferCounters;
+
+// In-memory implementation of the UI service. It keeps track of the scene and checks the consistency of the
+// payloads, but renders nothing. It is a stand-in for ui-service in tests, benchmarks and tools.
+class MockUIService : public ui::UIIf
+{
+public:
+  struct Statistics
+  {
+    std::size_t numberOfCalls{ 0 };
+    std::size_t numberOfGroups{ 0 };
+    std::size_t numberOfTriangleMeshes{ 0 };
+    std::size_t numberOfImages{ 0 };
+    std::size_t numberOfShapeModels{ 0 };
+    std::size_t numberOfRegisteredModels{ 0 };
+    std::size_t numberOfPointClouds{ 0 };
+    // Points appended to streamed point clouds
+    std::size_t numberOfPointCloudPoints{ 0 };
+    std::size_t numberOfLandmarks{ 0 };
+    // Trajectories loaded on shape model transformations, and their keyframes
+    std::size_t numberOfTrajectories{ 0 };
+    std::size_t numberOfTrajectoryKeyframes{ 0 };
+    // Meshes coloured by a value per vertex
+    std::size_t numberOfVertexScalarFields{ 0 };
+  };
+
+  // Each instance is a new session, with a random id
+  MockUIService();
+
+  Statistics
+  GetStatistics() const;
+
+  // Index of the keyframe the trajectory of a shape model transformation view is at now, as it plays: the last
+  // keyframe at or before its playback time. Throws std::invalid_argument if the view has no trajectory.
+  std::size_t
+  GetTrajectoryKeyframe(int viewId) const;
+
+  // The values and the name of the colour map of a triangle mesh, as last sent with updateTriangleMeshScalars.
+  // Throws std::invalid_argument if the mesh has none.
+  std::pair<std::vector<float>, std::string>
+  GetTriangleMeshScalars(int viewId) const;
+
+  void
+  getSessionId(std::string & _return) override;
+
+  void
+  createGroup(ui::Group & _return, const std::string & name) override;
+
+  void
+  createTriangleMesh(ui::TriangleMeshView & _return,
+                     const ui::Group &      g,
+                     std::int32_t           numberOfVertices,
+                     std::int32_t           numberOfTriangles,
+                     const std::string &    name) override;
+
+  void
+  writeTriangleMeshChunk(const ui::TriangleMeshView & tmv, const ui::PackedMeshChunk & chunk) override;
+
+  void
+  showPointCloud(const ui::Group & g, const ui::PointList & p, const std::string & name) override;
+
+  void
+  createPointCloud(ui::PointCloudView & _return,
+                   const ui::Group &    g,
+                   const std::string &  name,
+                   std::int64_t         expectedNumberOfPoints) override;
+
+  void
+  appendPointCloudPoints(const ui::PointCloudView & pcv, const ui::PackedPointChunk & chunk) override;
+
+  void
+  showTriangleMesh(ui::TriangleMeshView &   _return,
+                   const ui::Group &        g,
+                   const ui::TriangleMesh & m,
+                   const std::string &      name) override;
+
+  void
+  showPackedTriangleMesh(ui::TriangleMeshView &         _return,
+                         const ui::Group &              g,
+                         const ui::PackedTriangleMesh & m,
+                         const std::string &            name) override;
+
+  void
+  showImage(ui::ImageView & _return, const ui::Group & g, const ui::Image & img, const std::string & name) override;
+
+  void
+  showPackedImage(ui::ImageView &         _return,
+                  const ui::Group &       g,
+                  const ui::PackedImage & img,
+                  const std::string &     name) override;
+
+  void
+  showImagePyramid(ui::ImageView &         _return,
+                   const ui::Group &       g,
+                   const ui::ImageDomain & domain,
+                   std::int32_t            numberOfLevels,
+                   const ui::PackedImage & coarsestLevel,
+                   const std::string &     name) override;
+
+  void
+  createImage(ui::ImageView &         _return,
+              const ui::Group &       g,
+              const ui::ImageDomain & domain,
+              ui::ScalarType::type    pixelType,
+              const std::string &     name) override;
+
+  void
+  updateImageRegion(const ui::ImageView & iv, const ui::PackedImageRegion & region) override;
+
+  void
+  showLandmark(const ui::Group & g, const ui::Landmark & landmark, const std::string & name) override;
+
+  void
+  showLandmarks(const ui::Group & g, const std::vector<ui::Landmark> & landmarks) override;
+
+  void
+  showStatisticalShapeModel(ui::ShapeModelView &              _return,
+                            const ui::Group &                 g,
+                            const ui::StatisticalShapeModel & ssm,
+                            const std::string &               name) override;
+
+  void
+  showPackedStatisticalShapeModel(ui::ShapeModelView &                    _return,
+                                  const ui::Group &                       g,
+                                  const ui::PackedStatisticalShapeModel & ssm,
+                                  const std::string &                     name) override;
+
+  void
+  registerStatisticalShapeModel(const std::string & modelHash, const ui::PackedStatisticalShapeModel & ssm) override;
+
+  void
+  showRegisteredStatisticalShapeModel(ui::ShapeModelView & _return,
+                                      const ui::Group &    g,
+                                      const std::string &  modelHash,
+                                      const std::string &  name) override;
+
+  void
+  appendShapeModelComponents(const ui::ShapeModelView & smv, const ui::PackedKLBasis & components) override;
+
+  void
+  updateShapeModelTransformation(const ui::ShapeModelTransformationView & smtv) override;
+
+  void
+  updateShapeModelTransformations(const std::vector<ui::ShapeModelTransformationView> & smtvs) override;
+
+  void
+  loadShapeTrajectory(const ui::ShapeModelTransformationView & smtv,
+                      const ui::PackedShapeTrajectory &        trajectory) override;
+
+  void
+  playShapeTrajectory(const ui::ShapeModelTransformationView & smtv,
+                      const ui::TrajectoryPlayback &           playback) override;
+
+  void
+  updateTriangleMeshView(const ui::TriangleMeshView & tmv) override;
+
+  void
+  updateTriangleMeshVertices(const ui::TriangleMeshView & tmv, const ui::PackedVertexUpdate & update) override;
+
+  void
+  updateTriangleMeshScalars(const ui::TriangleMeshView & tmv, const ui::PackedVertexScalars & scalars) override;
+
+  void
+  updateImageView(const ui::ImageView & iv) override;
+
+  void
+  removeGroup(const ui::Group & g) override;
+
+  void
+  removeImage(const ui::ImageView & iv) override;
+
+  void
+  removeTriangleMesh(const ui::TriangleMeshView & tmv) override;
+
+  void
+  removeShapeModelTransformation(const ui::ShapeModelTransformationView & smv) override;
+
+  void
+  removeShapeModel(const ui::ShapeModelView & smv) override;
+
+  // Applies the operations one by one through the calls above, each of them counts as a call
+  void
+  applySceneBatch(std::vector<ui::SceneOperationResult> & _return,
+                  const std::vector<ui::SceneOperation> & operations) override;
+
+private:
+  // Number of rows (3 * number of vertices) and columns of a model basis
+  struct ModelSize
+  {
+    std::size_t dimension;
+    std::size_t numberOfComponents;
+  };
+
+  // Points announced (0 if unknown) and received so far for a streamed point cloud
+  struct PointCloudProgress
+  {
+    std::size_t expectedNumberOfPoints;
+    std::size_t numberOfPoints;
+  };
+
+  // Sizes of the levels of an image pyramid, from the full resolution to the coarsest level
+  struct ImagePyramidSize
+  {
+    std::vector<std::array<std::size_t, 3>> levelSizes;
+    ui::ScalarType::type                    pixelType;
+  };
+
+  // Times of the keyframes of a trajectory and how it plays since started
+  struct LoadedTrajectory
+  {
+    std::vector<double>                   times;
+    ui::TrajectoryPlayback                playback;
+    std::chrono::steady_clock::time_point started;
+  };
+
+  // All private helpers expect m_mutex to be held
+  int
+  addObject(const ui::Group & g);
+
+  void
+  removeObject(int id);
+
+  void
+  checkGroup(const ui::Group & g) const;
+
+  ui::TriangleMeshView
+  newTriangleMeshView(const ui::Group & g);
+
+  ui::ShapeModelView
+  newShapeModelView(const ui::Group & g, const ModelSize & size);
+
+  void
+  checkPackedMesh(const ui::PackedTriangleMesh & m) const;
+
+  void
+  checkPackedBasis(const ui::PackedKLBasis & basis, std::size_t dimension) const;
+
+  void
+  checkPackedModel(const ui::PackedStatisticalShapeModel & ssm) const;
+
+  mutable std::mutex                              m_mutex;
+  const std::string                               m_sessionId;
+  int                                             m_nextId{ 1 };
+  std::size_t                                     m_numberOfCalls{ 0 };
+  std::size_t                                     m_numberOfPointClouds{ 0 };
+  std::size_t                                     m_numberOfPointCloudPoints{ 0 };
+  std::size_t                                     m_numberOfLandmarks{ 0 };
+  std::map<int, std::string>                      m_groups;
+  std::map<int, int>                              m_objectGroups;
+  std::map<int, ui::TriangleMeshView>             m_triangleMeshViews;
+  std::map<int, std::size_t>                      m_triangleMeshVertexCounts;
+  std::map<int, std::size_t>                      m_triangleMeshTriangleCounts;
+  std::map<int, ui::ImageView>                    m_imageViews;
+  std::map<int, ui::ShapeModelTransformationView> m_shapeModelTransformationViews;
+  std::map<int, ModelSize>                        m_shapeModelSizes;
+  std::map<int, PointCloudProgress>               m_pointClouds;
+  std::map<int, ImagePyramidSize>                 m_imagePyramids;
+  std::map<std::string, ModelSize>                m_registeredModels;
+  std::map<int, LoadedTrajectory>                 m_trajectories;
+  std::map<int, ui::PackedVertexScalars>          m_vertexScalars;
+};
+
+// Serves a MockUIService on localhost from a background thread, for as long as the object lives.
+// Port, protocol and transport are taken from the options, the host is ignored. Port 0 picks a free port, which
+// GetPort returns.
+class MockUIServer
+{
+public:
+  // Returns once the server accepts connections
+  explicit MockUIServer(const ConnectionOptions & options);
+  ~MockUIServer();
+
+  MockUIServer(const MockUIServer &) = delete;
+  MockUIServer &
+  operator=(const MockUIServer &) = delete;
+
+  MockUIService &
+  GetService()
+  {
+    return *m_service;
+  }
+
+  int
+  GetPort() const
+  {
+    return m_port;
+  }
+
+  // Bytes on the wire since the server started, frame headers included
+  std::uint64_t
+  GetBytesReceived() const;
+  std::uint64_t
+  GetBytesSent() const;
+
+  void
+  stop();
+
+private:
+  std::shared_ptr<MockUIService>                   m_service;
+  std::shared_ptr<TransferCounters>                m_counters;
+  int                                              m_port{ 0 };
+  std::shared_ptr<apache::thrift::server::TServer> m_server;
+  std::exception_ptr                               m_error;
+  std::thread                                      m_thread;
+};
+
+} // namespace StatismoUI
+
+#endif // UI_MOCKUISERVICE_H
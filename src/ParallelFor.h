@@ -0,0 +1,101 @@
+#ifndef UI_PARALLELFOR_H
+#define UI_PARALLELFOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Data parallel loops for the payload encoders.
+namespace StatismoUI
+{
+namespace detail
+{
+inline std::atomic<unsigned> &
+workerThreadsSetting()
+{
+  static std::atomic<unsigned> numberOfThreads{ 0 };
+  return numberOfThreads;
+}
+} // namespace detail
+
+// Number of threads parallelFor uses, the number of hardware threads unless set otherwise
+inline unsigned
+getNumberOfWorkerThreads()
+{
+  const unsigned numberOfThreads = detail::workerThreadsSetting();
+  return numberOfThreads > 0 ? numberOfThreads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// 0 restores the default
+inline void
+setNumberOfWorkerThreads(unsigned numberOfThreads)
+{
+  detail::workerThreadsSetting() = numberOfThreads;
+}
+
+// Splits [0, size) into contiguous ranges of at least minChunkSize elements and calls f(begin, end) for each of
+// them, one range per thread. The calling thread processes the last range. Threads are started on each call, work
+// that takes less than starting them, like a chunk of a stream, is better done on the calling thread. If f throws,
+// the first exception is rethrown once every range is done.
+template <typename F>
+void
+parallelFor(std::size_t size, std::size_t minChunkSize, F && f)
+{
+  const std::size_t maxNumberOfChunks = std::max<std::size_t>(1, size / std::max<std::size_t>(1, minChunkSize));
+  const std::size_t numberOfChunks = std::min<std::size_t>(getNumberOfWorkerThreads(), maxNumberOfChunks);
+  if (numberOfChunks <= 1)
+  {
+    f(std::size_t(0), size);
+    return;
+  }
+
+  const std::size_t               chunkSize = (size + numberOfChunks - 1) / numberOfChunks;
+  std::vector<std::thread>        threads;
+  std::vector<std::exception_ptr> errors(numberOfChunks - 1);
+  threads.reserve(numberOfChunks - 1);
+  {
+    // joins the threads started so far, also when starting one or the range of the calling thread throws
+    struct JoinGuard
+    {
+      std::vector<std::thread> & threads;
+      ~JoinGuard()
+      {
+        for (auto & thread : threads)
+        {
+          thread.join();
+        }
+      }
+    } guard{ threads };
+
+    for (std::size_t begin = 0; begin + chunkSize < size; begin += chunkSize)
+    {
+      std::exception_ptr & error = errors[threads.size()];
+      threads.emplace_back([&f, &error, begin, chunkSize] {
+        try
+        {
+          f(begin, begin + chunkSize);
+        }
+        catch (...)
+        {
+          error = std::current_exception();
+        }
+      });
+    }
+    f(threads.size() * chunkSize, size);
+  }
+
+  for (const auto & error : errors)
+  {
+    if (error)
+    {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+} // namespace StatismoUI
+
+#endif // UI_PARALLELFOR_H
@@ -0,0 +1,296 @@
+#include "RecordingUI.h"
+
+#include <thrift/protocol/TBinaryProtocol.h>
+
+namespace StatismoUI
+{
+
+RecordingUI::RecordingUI(ui::UIIf & ui, const std::string & path)
+  : m_ui(ui)
+  , m_buffer(std::make_shared<apache::thrift::transport::TMemoryBuffer>())
+  , m_encoder(std::make_shared<apache::thrift::protocol::TBinaryProtocol>(m_buffer))
+  , m_log(path)
+{}
+
+void
+RecordingUI::getSessionId(std::string & _return)
+{
+  // a query, not part of the session
+  m_ui.getSessionId(_return);
+}
+
+void
+RecordingUI::createGroup(ui::Group & _return, const std::string & name)
+{
+  record(&ui::UIClient::send_createGroup, name);
+  m_ui.createGroup(_return, name);
+}
+
+void
+RecordingUI::createTriangleMesh(ui::TriangleMeshView & _return,
+                                const ui::Group &      g,
+                                std::int32_t           numberOfVertices,
+                                std::int32_t           numberOfTriangles,
+                                const std::string &    name)
+{
+  record(&ui::UIClient::send_createTriangleMesh, g, numberOfVertices, numberOfTriangles, name);
+  m_ui.createTriangleMesh(_return, g, numberOfVertices, numberOfTriangles, name);
+}
+
+void
+RecordingUI::writeTriangleMeshChunk(const ui::TriangleMeshView & tmv, const ui::PackedMeshChunk & chunk)
+{
+  record(&ui::UIClient::send_writeTriangleMeshChunk, tmv, chunk);
+  m_ui.writeTriangleMeshChunk(tmv, chunk);
+}
+
+void
+RecordingUI::showPointCloud(const ui::Group & g, const ui::PointList & p, const std::string & name)
+{
+  record(&ui::UIClient::send_showPointCloud, g, p, name);
+  m_ui.showPointCloud(g, p, name);
+}
+
+void
+RecordingUI::createPointCloud(ui::PointCloudView & _return,
+                              const ui::Group &    g,
+                              const std::string &  name,
+                              std::int64_t         expectedNumberOfPoints)
+{
+  record(&ui::UIClient::send_createPointCloud, g, name, expectedNumberOfPoints);
+  m_ui.createPointCloud(_return, g, name, expectedNumberOfPoints);
+}
+
+void
+RecordingUI::appendPointCloudPoints(const ui::PointCloudView & pcv, const ui::PackedPointChunk & chunk)
+{
+  record(&ui::UIClient::send_appendPointCloudPoints, pcv, chunk);
+  m_ui.appendPointCloudPoints(pcv, chunk);
+}
+
+void
+RecordingUI::showTriangleMesh(ui::TriangleMeshView &   _return,
+                              const ui::Group &        g,
+                              const ui::TriangleMesh & m,
+                              const std::string &      name)
+{
+  record(&ui::UIClient::send_showTriangleMesh, g, m, name);
+  m_ui.showTriangleMesh(_return, g, m, name);
+}
+
+void
+RecordingUI::showPackedTriangleMesh(ui::TriangleMeshView &         _return,
+                                    const ui::Group &              g,
+                                    const ui::PackedTriangleMesh & m,
+                                    const std::string &            name)
+{
+  record(&ui::UIClient::send_showPackedTriangleMesh, g, m, name);
+  m_ui.showPackedTriangleMesh(_return, g, m, name);
+}
+
+void
+RecordingUI::showImage(ui::ImageView & _return, const ui::Group & g, const ui::Image & img, const std::string & name)
+{
+  record(&ui::UIClient::send_showImage, g, img, name);
+  m_ui.showImage(_return, g, img, name);
+}
+
+void
+RecordingUI::showPackedImage(ui::ImageView &         _return,
+                             const ui::Group &       g,
+                             const ui::PackedImage & img,
+                             const std::string &     name)
+{
+  record(&ui::UIClient::send_showPackedImage, g, img, name);
+  m_ui.showPackedImage(_return, g, img, name);
+}
+
+void
+RecordingUI::showLandmark(const ui::Group & g, const ui::Landmark & landmark, const std::string & name)
+{
+  record(&ui::UIClient::send_showLandmark, g, landmark, name);
+  m_ui.showLandmark(g, landmark, name);
+}
+
+void
+RecordingUI::showLandmarks(const ui::Group & g, const std::vector<ui::Landmark> & landmarks)
+{
+  record(&ui::UIClient::send_showLandmarks, g, landmarks);
+  m_ui.showLandmarks(g, landmarks);
+}
+
+void
+RecordingUI::showStatisticalShapeModel(ui::ShapeModelView &              _return,
+                                       const ui::Group &                 g,
+                                       const ui::StatisticalShapeModel & ssm,
+                                       const std::string &               name)
+{
+  record(&ui::UIClient::send_showStatisticalShapeModel, g, ssm, name);
+  m_ui.showStatisticalShapeModel(_return, g, ssm, name);
+}
+
+void
+RecordingUI::showPackedStatisticalShapeModel(ui::ShapeModelView &                    _return,
+                                             const ui::Group &                       g,
+                                             const ui::PackedStatisticalShapeModel & ssm,
+                                             const std::string &                     name)
+{
+  record(&ui::UIClient::send_showPackedStatisticalShapeModel, g, ssm, name);
+  m_ui.showPackedStatisticalShapeModel(_return, g, ssm, name);
+}
+
+void
+RecordingUI::registerStatisticalShapeModel(const std::string & modelHash, const ui::PackedStatisticalShapeModel & ssm)
+{
+  record(&ui::UIClient::send_registerStatisticalShapeModel, modelHash, ssm);
+  m_ui.registerStatisticalShapeModel(modelHash, ssm);
+}
+
+void
+RecordingUI::showRegisteredStatisticalShapeModel(ui::ShapeModelView & _return,
+                                                 const ui::Group &    g,
+                                                 const std::string &  modelHash,
+                                                 const std::string &  name)
+{
+  record(&ui::UIClient::send_showRegisteredStatisticalShapeModel, g, modelHash, name);
+  m_ui.showRegisteredStatisticalShapeModel(_return, g, modelHash, name);
+}
+
+void
+RecordingUI::appendShapeModelComponents(const ui::ShapeModelView & smv, const ui::PackedKLBasis & components)
+{
+  record(&ui::UIClient::send_appendShapeModelComponents, smv, components);
+  m_ui.appendShapeModelComponents(smv, components);
+}
+
+void
+RecordingUI::updateShapeModelTransformation(const ui::ShapeModelTransformationView & smtv)
+{
+  record(&ui::UIClient::send_updateShapeModelTransformation, smtv);
+  m_ui.updateShapeModelTransformation(smtv);
+}
+
+void
+RecordingUI::updateShapeModelTransformations(const std::vector<ui::ShapeModelTransformationView> & smtvs)
+{
+  record(&ui::UIClient::send_updateShapeModelTransformations, smtvs);
+  m_ui.updateShapeModelTransformations(smtvs);
+}
+
+void
+RecordingUI::loadShapeTrajectory(const ui::ShapeModelTransformationView & smtv,
+                                 const ui::PackedShapeTrajectory &        trajectory)
+{
+  record(&ui::UIClient::send_loadShapeTrajectory, smtv, trajectory);
+  m_ui.loadShapeTrajectory(smtv, trajectory);
+}
+
+void
+RecordingUI::playShapeTrajectory(const ui::ShapeModelTransformationView & smtv, const ui::TrajectoryPlayback & playback)
+{
+  record(&ui::UIClient::send_playShapeTrajectory, smtv, playback);
+  m_ui.playShapeTrajectory(smtv, playback);
+}
+
+void
+RecordingUI::updateTriangleMeshView(const ui::TriangleMeshView & tmv)
+{
+  record(&ui::UIClient::send_updateTriangleMeshView, tmv);
+  m_ui.updateTriangleMeshView(tmv);
+}
+
+void
+RecordingUI::updateTriangleMeshVertices(const ui::TriangleMeshView & tmv, const ui::PackedVertexUpdate & update)
+{
+  record(&ui::UIClient::send_updateTriangleMeshVertices, tmv, update);
+  m_ui.updateTriangleMeshVertices(tmv, update);
+}
+
+void
+RecordingUI::updateTriangleMeshScalars(const ui::TriangleMeshView & tmv, const ui::PackedVertexScalars & scalars)
+{
+  record(&ui::UIClient::send_updateTriangleMeshScalars, tmv, scalars);
+  m_ui.updateTriangleMeshScalars(tmv, scalars);
+}
+
+void
+RecordingUI::updateImageView(const ui::ImageView & iv)
+{
+  record(&ui::UIClient::send_updateImageView, iv);
+  m_ui.updateImageView(iv);
+}
+
+void
+RecordingUI::showImagePyramid(ui::ImageView &         _return,
+                              const ui::Group &       g,
+                              const ui::ImageDomain & domain,
+                              std::int32_t            numberOfLevels,
+                              const ui::PackedImage & coarsestLevel,
+                              const std::string &     name)
+{
+  record(&ui::UIClient::send_showImagePyramid, g, domain, numberOfLevels, coarsestLevel, name);
+  m_ui.showImagePyramid(_return, g, domain, numberOfLevels, coarsestLevel, name);
+}
+
+void
+RecordingUI::createImage(ui::ImageView &         _return,
+                         const ui::Group &       g,
+                         const ui::ImageDomain & domain,
+                         ui::ScalarType::type    pixelType,
+                         const std::string &     name)
+{
+  record(&ui::UIClient::send_createImage, g, domain, pixelType, name);
+  m_ui.createImage(_return, g, domain, pixelType, name);
+}
+
+void
+RecordingUI::updateImageRegion(const ui::ImageView & iv, const ui::PackedImageRegion & region)
+{
+  record(&ui::UIClient::send_updateImageRegion, iv, region);
+  m_ui.updateImageRegion(iv, region);
+}
+
+void
+RecordingUI::removeGroup(const ui::Group & g)
+{
+  record(&ui::UIClient::send_removeGroup, g);
+  m_ui.removeGroup(g);
+}
+
+void
+RecordingUI::removeImage(const ui::ImageView & iv)
+{
+  record(&ui::UIClient::send_removeImage, iv);
+  m_ui.removeImage(iv);
+}
+
+void
+RecordingUI::removeTriangleMesh(const ui::TriangleMeshView & tmv)
+{
+  record(&ui::UIClient::send_removeTriangleMesh, tmv);
+  m_ui.removeTriangleMesh(tmv);
+}
+
+void
+RecordingUI::removeShapeModelTransformation(const ui::ShapeModelTransformationView & smv)
+{
+  record(&ui::UIClient::send_removeShapeModelTransformation, smv);
+  m_ui.removeShapeModelTransformation(smv);
+}
+
+void
+RecordingUI::removeShapeModel(const ui::ShapeModelView & smv)
+{
+  record(&ui::UIClient::send_removeShapeModel, smv);
+  m_ui.removeShapeModel(smv);
+}
+
+void
+RecordingUI::applySceneBatch(std::vector<ui::SceneOperationResult> & _return,
+                             const std::vector<ui::SceneOperation> & operations)
+{
+  record(&ui::UIClient::send_applySceneBatch, operations);
+  m_ui.applySceneBatch(_return, operations);
+}
+
+} // namespace StatismoUI
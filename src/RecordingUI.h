@@ -0,0 +1,193 @@
+#ifndef UI_RECORDINGUI_H
+#define UI_RECORDINGUI_H
+
+#include "SessionLog.h"
+#include "thrift/UI.h"
+
+#include <thrift/transport/TBufferTransports.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Recording of the requests of a client.
+namespace StatismoUI
+{
+
+// ui::UIIf that appends every request to a session log before passing it on to ui. The requests are serialized by
+// the calling thread, written by the one of the log. Requests that fail are recorded too: the ids of a ResilientUI
+// only depend on the sequence of requests, so a replay through a ResilientUI gives every object the id it had.
+//
+// Calls must be serialized, like those of the wrapped ui.
+class RecordingUI : public ui::UIIf
+{
+public:
+  // Throws std::runtime_error if the log cannot be created
+  RecordingUI(ui::UIIf & ui, const std::string & path);
+
+  void
+  getSessionId(std::string & _return) override;
+
+  void
+  createGroup(ui::Group & _return, const std::string & name) override;
+
+  void
+  createTriangleMesh(ui::TriangleMeshView & _return,
+                     const ui::Group &      g,
+                     std::int32_t           numberOfVertices,
+                     std::int32_t           numberOfTriangles,
+                     const std::string &    name) override;
+
+  void
+  writeTriangleMeshChunk(const ui::TriangleMeshView & tmv, const ui::PackedMeshChunk & chunk) override;
+
+  void
+  showPointCloud(const ui::Group & g, const ui::PointList & p, const std::string & name) override;
+
+  void
+  createPointCloud(ui::PointCloudView & _return,
+                   const ui::Group &    g,
+                   const std::string &  name,
+                   std::int64_t         expectedNumberOfPoints) override;
+
+  void
+  appendPointCloudPoints(const ui::PointCloudView & pcv, const ui::PackedPointChunk & chunk) override;
+
+  void
+  showTriangleMesh(ui::TriangleMeshView &   _return,
+                   const ui::Group &        g,
+                   const ui::TriangleMesh & m,
+                   const std::string &      name) override;
+
+  void
+  showPackedTriangleMesh(ui::TriangleMeshView &         _return,
+                         const ui::Group &              g,
+                         const ui::PackedTriangleMesh & m,
+                         const std::string &            name) override;
+
+  void
+  showImage(ui::ImageView & _return, const ui::Group & g, const ui::Image & img, const std::string & name) override;
+
+  void
+  showPackedImage(ui::ImageView &         _return,
+                  const ui::Group &       g,
+                  const ui::PackedImage & img,
+                  const std::string &     name) override;
+
+  void
+  showLandmark(const ui::Group & g, const ui::Landmark & landmark, const std::string & name) override;
+
+  void
+  showLandmarks(const ui::Group & g, const std::vector<ui::Landmark> & landmarks) override;
+
+  void
+  showStatisticalShapeModel(ui::ShapeModelView &              _return,
+                            const ui::Group &                 g,
+                            const ui::StatisticalShapeModel & ssm,
+                            const std::string &               name) override;
+
+  void
+  showPackedStatisticalShapeModel(ui::ShapeModelView &                    _return,
+                                  const ui::Group &                       g,
+                                  const ui::PackedStatisticalShapeModel & ssm,
+                                  const std::string &                     name) override;
+
+  void
+  registerStatisticalShapeModel(const std::string & modelHash, const ui::PackedStatisticalShapeModel & ssm) override;
+
+  void
+  showRegisteredStatisticalShapeModel(ui::ShapeModelView & _return,
+                                      const ui::Group &    g,
+                                      const std::string &  modelHash,
+                                      const std::string &  name) override;
+
+  void
+  appendShapeModelComponents(const ui::ShapeModelView & smv, const ui::PackedKLBasis & components) override;
+
+  void
+  updateShapeModelTransformation(const ui::ShapeModelTransformationView & smtv) override;
+
+  void
+  updateShapeModelTransformations(const std::vector<ui::ShapeModelTransformationView> & smtvs) override;
+
+  void
+  loadShapeTrajectory(const ui::ShapeModelTransformationView & smtv,
+                      const ui::PackedShapeTrajectory &        trajectory) override;
+
+  void
+  playShapeTrajectory(const ui::ShapeModelTransformationView & smtv,
+                      const ui::TrajectoryPlayback &           playback) override;
+
+  void
+  updateTriangleMeshView(const ui::TriangleMeshView & tmv) override;
+
+  void
+  updateTriangleMeshVertices(const ui::TriangleMeshView & tmv, const ui::PackedVertexUpdate & update) override;
+
+  void
+  updateTriangleMeshScalars(const ui::TriangleMeshView & tmv, const ui::PackedVertexScalars & scalars) override;
+
+  void
+  updateImageView(const ui::ImageView & iv) override;
+
+  void
+  showImagePyramid(ui::ImageView &         _return,
+                   const ui::Group &       g,
+                   const ui::ImageDomain & domain,
+                   std::int32_t            numberOfLevels,
+                   const ui::PackedImage & coarsestLevel,
+                   const std::string &     name) override;
+
+  void
+  createImage(ui::ImageView &         _return,
+              const ui::Group &       g,
+              const ui::ImageDomain & domain,
+              ui::ScalarType::type    pixelType,
+              const std::string &     name) override;
+
+  void
+  updateImageRegion(const ui::ImageView & iv, const ui::PackedImageRegion & region) override;
+
+  void
+  removeGroup(const ui::Group & g) override;
+
+  void
+  removeImage(const ui::ImageView & iv) override;
+
+  void
+  removeTriangleMesh(const ui::TriangleMeshView & tmv) override;
+
+  void
+  removeShapeModelTransformation(const ui::ShapeModelTransformationView & smv) override;
+
+  void
+  removeShapeModel(const ui::ShapeModelView & smv) override;
+
+  void
+  applySceneBatch(std::vector<ui::SceneOperationResult> & _return,
+                  const std::vector<ui::SceneOperation> & operations) override;
+
+private:
+  // Serializes a request with a send_ method of the encoder and appends it to the log
+  template <typename... Parameters, typename... Arguments>
+  void
+  record(void (ui::UIClient::*send)(Parameters...), const Arguments &... arguments)
+  {
+    (m_encoder.*send)(arguments...);
+    std::uint8_t * message;
+    std::uint32_t  size;
+    m_buffer->getBuffer(&message, &size);
+    m_log.append(message, size);
+    m_buffer->resetBuffer();
+  }
+
+  ui::UIIf &                                                m_ui;
+  std::shared_ptr<apache::thrift::transport::TMemoryBuffer> m_buffer;
+  ui::UIClient                                              m_encoder;
+  SessionLogWriter                                          m_log;
+};
+
+} // namespace StatismoUI
+
+#endif // UI_RECORDINGUI_H
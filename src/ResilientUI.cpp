@@ -0,0 +1,1421 @@
+#include "ResilientUI.h"
+
+#include <thrift/TApplicationException.h>
+#include <thrift/transport/TTransportException.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace StatismoUI
+{
+
+namespace
+{
+using apache::thrift::TApplicationException;
+using apache::thrift::transport::TTransportException;
+
+// A known object that ui-service does not show in the current session, because its creation was dropped or failed
+class UnmappedObject : public std::invalid_argument
+{
+public:
+  explicit UnmappedObject(int id)
+    : std::invalid_argument("object " + std::to_string(id) + " is not shown by ui-service")
+  {}
+};
+
+// Payload of an operation, borrowed from the caller as long as the operation is only sent and copied once it is kept
+template <typename T>
+class Payload
+{
+public:
+  explicit Payload(const T & borrowed)
+    : m_value(&borrowed)
+  {}
+
+  const T &
+  get() const
+  {
+    return *m_value;
+  }
+
+  std::shared_ptr<const T>
+  share()
+  {
+    if (!m_copy)
+    {
+      m_copy = std::make_shared<const T>(*m_value);
+      m_value = m_copy.get();
+    }
+    return m_copy;
+  }
+
+private:
+  const T *                m_value;
+  std::shared_ptr<const T> m_copy;
+};
+
+template <typename T>
+std::shared_ptr<Payload<T>>
+borrow(const T & value)
+{
+  return std::make_shared<Payload<T>>(value);
+}
+
+// Views as ui-service creates them, returned for the operations journaled while disconnected
+ui::TriangleMeshView
+newTriangleMeshView(int id)
+{
+  ui::TriangleMeshView view;
+  view.id = id;
+  view.color.r = 255;
+  view.color.g = 255;
+  view.color.b = 255;
+  view.lineWidth = 1;
+  view.opacity = 1.0;
+  return view;
+}
+
+ui::ImageView
+newImageView(int id)
+{
+  ui::ImageView view;
+  view.id = id;
+  view.window = 256;
+  view.level = 256;
+  view.opacity = 1.0;
+  return view;
+}
+
+ui::ShapeModelView
+newShapeModelView(int meshId, int transformationId, std::size_t numberOfComponents)
+{
+  ui::ShapeModelView view;
+  view.meshView = newTriangleMeshView(meshId);
+
+  auto & smtv = view.shapeModelTransformationView;
+  smtv.id = transformationId;
+  smtv.shapeTransformation.coefficients.assign(numberOfComponents, 0.0);
+  smtv.poseTransformation.rotation.center.x = 0;
+  smtv.poseTransformation.rotation.center.y = 0;
+  smtv.poseTransformation.rotation.center.z = 0;
+  smtv.poseTransformation.rotation.angleX = 0;
+  smtv.poseTransformation.rotation.angleY = 0;
+  smtv.poseTransformation.rotation.angleZ = 0;
+  smtv.poseTransformation.translation.x = 0;
+  smtv.poseTransformation.translation.y = 0;
+  smtv.poseTransformation.translation.z = 0;
+  return view;
+}
+
+ui::ShapeModelView
+withIds(ui::ShapeModelView view, int meshId, int transformationId)
+{
+  view.meshView.id = meshId;
+  view.shapeModelTransformationView.id = transformationId;
+  return view;
+}
+
+// Connects and asks the service for its session, the id is empty for a service that predates sessions
+std::unique_ptr<ui::UIClient>
+connectClient(const ResilientUI::Connect & connect, std::string & sessionId)
+{
+  std::unique_ptr<ui::UIClient> client = connect();
+  try
+  {
+    client->getSessionId(sessionId);
+  }
+  catch (const TApplicationException &)
+  {
+    sessionId.clear();
+  }
+  return client;
+}
+
+void
+closeClient(ui::UIClient & client)
+{
+  try
+  {
+    client.getOutputProtocol()->getTransport()->close();
+  }
+  catch (...)
+  {
+    // the connection is already broken
+  }
+}
+} // namespace
+
+ResilientUI::ResilientUI(Connect connect, const ReconnectOptions & options, std::mutex & connectionMutex)
+  : m_connect(std::move(connect))
+  , m_options(options)
+  , m_connectionMutex(connectionMutex)
+{
+  if (options.initialBackoffMs <= 0 || options.maxBackoffMs < options.initialBackoffMs)
+  {
+    throw std::invalid_argument("the reconnect backoff must be positive and initialBackoffMs at most maxBackoffMs");
+  }
+
+  try
+  {
+    std::string sessionId;
+    auto        client = connectClient(m_connect, sessionId);
+    resume(std::move(client), sessionId);
+  }
+  catch (const std::exception &)
+  {
+    // the application starts offline, as if the connection had broken right away
+    m_reconnect = true;
+  }
+  m_thread = std::thread(&ResilientUI::reconnectLoop, this);
+}
+
+ResilientUI::~ResilientUI()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_threadMutex);
+    m_stopped = true;
+  }
+  m_condition.notify_one();
+  m_thread.join();
+
+  if (m_client)
+  {
+    closeClient(*m_client);
+  }
+}
+
+ConnectionStatus
+ResilientUI::GetStatus() const
+{
+  ConnectionStatus status;
+  status.connected = m_client != nullptr;
+  status.reconnects = m_reconnects;
+  status.pendingOperations = m_numberOfPending;
+  status.droppedOperations = m_droppedOperations;
+  status.failedOperations = m_failedOperations;
+  return status;
+}
+
+bool
+ResilientUI::TakeDropped(int viewId)
+{
+  return m_droppedViews.erase(viewId) != 0;
+}
+
+ResilientUI::OperationPointer
+ResilientUI::makeOperation(Operation::Kind kind, int object, const std::string & name, Send send) const
+{
+  auto operation = std::make_shared<Operation>();
+  operation->kind = kind;
+  operation->object = object;
+  operation->name = name;
+  operation->send = std::move(send);
+  operation->retain = [] {};
+  return operation;
+}
+
+int
+ResilientUI::objectOf(int id) const
+{
+  auto it = m_objects.find(id);
+  if (it == m_objects.end())
+  {
+    throw std::invalid_argument("unknown object " + std::to_string(id));
+  }
+  return it->second;
+}
+
+int
+ResilientUI::serverId(int id) const
+{
+  auto it = m_serverIds.find(id);
+  if (it == m_serverIds.end())
+  {
+    throw UnmappedObject(id);
+  }
+  return it->second;
+}
+
+ui::ShapeModelView
+ResilientUI::serverShapeModelView(ui::ShapeModelView smv) const
+{
+  smv.meshView.id = serverId(smv.meshView.id);
+  smv.shapeModelTransformationView.id = serverId(smv.shapeModelTransformationView.id);
+  return smv;
+}
+
+ResilientUI::OperationPointer
+ResilientUI::groupCreation(int id, const std::string & name)
+{
+  return makeOperation(Operation::Kind::Create, id, "createGroup", [this, id, name](ui::UIClient & client) {
+    ui::Group g;
+    client.createGroup(g, name);
+    m_serverIds[id] = g.id;
+  });
+}
+
+template <typename View, typename Data>
+ResilientUI::OperationPointer
+ResilientUI::viewCreation(const std::string &   rpcName,
+                          int                   id,
+                          const ui::Group &     g,
+                          const Data &          data,
+                          const std::string &   name,
+                          std::shared_ptr<View> result,
+                          void (ui::UIIf::*rpc)(View &, const ui::Group &, const Data &, const std::string &))
+{
+  auto payload = borrow(data);
+  auto operation = makeOperation(
+    Operation::Kind::Create, id, rpcName, [this, id, g, payload, name, result, rpc](ui::UIClient & client) {
+      (client.*rpc)(*result, serverView(g), payload->get(), name);
+      m_serverIds[id] = result->id;
+    });
+  operation->retain = [payload] { payload->share(); };
+  return operation;
+}
+
+template <typename Data>
+ResilientUI::OperationPointer
+ResilientUI::anonymousCreation(const std::string & rpcName,
+                               int                 id,
+                               const ui::Group &   g,
+                               const Data &        data,
+                               const std::string & name,
+                               void (ui::UIIf::*rpc)(const ui::Group &, const Data &, const std::string &))
+{
+  auto payload = borrow(data);
+  auto operation =
+    makeOperation(Operation::Kind::Create, id, rpcName, [this, g, payload, name, rpc](ui::UIClient & client) {
+      (client.*rpc)(serverView(g), payload->get(), name);
+    });
+  operation->retain = [payload] { payload->share(); };
+  return operation;
+}
+
+template <typename View>
+ResilientUI::OperationPointer
+ResilientUI::viewUpdate(const std::string & rpcName, const View & view, void (ui::UIIf::*rpc)(const View &))
+{
+  auto operation =
+    makeOperation(Operation::Kind::Update, objectOf(view.id), rpcName, [this, view, rpc](ui::UIClient & client) {
+      (client.*rpc)(serverView(view));
+    });
+  operation->view = view.id;
+  return operation;
+}
+
+template <typename View, typename Data>
+ResilientUI::OperationPointer
+ResilientUI::dataTransfer(Operation::Kind     kind,
+                          const std::string & rpcName,
+                          const View &        view,
+                          const Data &        data,
+                          void (ui::UIIf::*rpc)(const View &, const Data &))
+{
+  auto payload = borrow(data);
+  auto operation = makeOperation(kind, objectOf(view.id), rpcName, [this, view, payload, rpc](ui::UIClient & client) {
+    (client.*rpc)(serverView(view), payload->get());
+  });
+  operation->view = view.id;
+  operation->retain = [payload] { payload->share(); };
+  return operation;
+}
+
+template <typename View>
+ResilientUI::OperationPointer
+ResilientUI::removal(const std::string & rpcName, const View & view, void (ui::UIIf::*rpc)(const View &))
+{
+  objectOf(view.id);
+  return makeOperation(Operation::Kind::Remove, 0, rpcName, [this, view, rpc](ui::UIClient & client) {
+    // nothing to remove if the object never reached the service
+    if (m_serverIds.count(view.id) != 0)
+    {
+      (client.*rpc)(serverView(view));
+    }
+  });
+}
+
+void
+ResilientUI::submit(const OperationPointer & operation)
+{
+  if (m_client)
+  {
+    try
+    {
+      operation->send(*m_client);
+      remember(operation);
+      return;
+    }
+    catch (const TTransportException &)
+    {
+      disconnect();
+    }
+    catch (const UnmappedObject &)
+    {
+      drop(operation);
+      return;
+    }
+  }
+  if (enqueue(operation))
+  {
+    remember(operation);
+  }
+}
+
+void
+ResilientUI::addObject(int object, int group, const std::vector<int> & aliases)
+{
+  m_scene[object].group = group;
+  m_objects[object] = object;
+  for (int alias : aliases)
+  {
+    m_objects[alias] = object;
+  }
+}
+
+void
+ResilientUI::submitCreation(const OperationPointer & operation, int group, const std::vector<int> & aliases)
+{
+  addObject(operation->object, group, aliases);
+  try
+  {
+    submit(operation);
+  }
+  catch (...)
+  {
+    forget(operation->object);
+    throw;
+  }
+}
+
+bool
+ResilientUI::enqueue(const OperationPointer & operation)
+{
+  if (operation->kind == Operation::Kind::Update)
+  {
+    auto & pending = m_pendingUpdates[{ operation->object, operation->name }];
+    if (auto superseded = pending.lock())
+    {
+      superseded->superseded = true;
+      --m_numberOfPending;
+    }
+    pending = operation;
+  }
+  if (m_numberOfPending >= m_options.maxPendingOperations)
+  {
+    drop(operation);
+    return false;
+  }
+  operation->retain();
+  m_journal.push_back(operation);
+  ++m_numberOfPending;
+  return true;
+}
+
+void
+ResilientUI::drop(const OperationPointer & operation)
+{
+  ++m_droppedOperations;
+  if (operation->view != 0)
+  {
+    m_droppedViews.insert(operation->view);
+  }
+}
+
+void
+ResilientUI::remember(const OperationPointer & operation)
+{
+  auto object = m_scene.find(operation->object);
+  if (!m_options.restoreScene || object == m_scene.end())
+  {
+    return;
+  }
+
+  operation->retain();
+  SceneObject & scene = object->second;
+  switch (operation->kind)
+  {
+    case Operation::Kind::Create:
+      scene.creation = operation;
+      break;
+    case Operation::Kind::Append:
+      scene.appends.push_back(operation);
+      break;
+    case Operation::Kind::Update:
+      if (operation->resetsAppends)
+      {
+        scene.appends.erase(std::remove_if(scene.appends.begin(),
+                                           scene.appends.end(),
+                                           [&operation](const OperationPointer & append) {
+                                             return append->name == operation->name;
+                                           }),
+                            scene.appends.end());
+      }
+      scene.updates.erase(std::remove_if(scene.updates.begin(),
+                                         scene.updates.end(),
+                                         [&operation](const OperationPointer & update) {
+                                           return update->name == operation->name;
+                                         }),
+                          scene.updates.end());
+      scene.updates.push_back(operation);
+      break;
+    case Operation::Kind::Remove:
+    case Operation::Kind::Register:
+      break;
+  }
+}
+
+void
+ResilientUI::forget(int id)
+{
+  const int object = objectOf(id);
+  if (object != id)
+  {
+    // a part of a shape model, the model stays in the scene
+    m_objects.erase(id);
+    m_droppedViews.erase(id);
+    return;
+  }
+
+  auto removed = [this, object](int member) {
+    auto scene = m_scene.find(member);
+    return member == object || (scene != m_scene.end() && scene->second.group == object);
+  };
+  for (auto it = m_objects.begin(); it != m_objects.end();)
+  {
+    if (removed(it->second))
+    {
+      m_droppedViews.erase(it->first);
+      it = m_objects.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+  for (auto it = m_scene.begin(); it != m_scene.end();)
+  {
+    it = it->first == object || it->second.group == object ? m_scene.erase(it) : std::next(it);
+  }
+}
+
+void
+ResilientUI::disconnect()
+{
+  closeClient(*m_client);
+  m_client.reset();
+  {
+    std::lock_guard<std::mutex> lock(m_threadMutex);
+    m_reconnect = true;
+  }
+  m_condition.notify_one();
+}
+
+bool
+ResilientUI::sendJournal()
+{
+  while (!m_journal.empty())
+  {
+    const OperationPointer operation = m_journal.front();
+    if (!operation->superseded)
+    {
+      try
+      {
+        operation->send(*m_client);
+      }
+      catch (const TTransportException &)
+      {
+        // the operation stays first, it may reach the service twice
+        disconnect();
+        return false;
+      }
+      catch (const std::exception &)
+      {
+        ++m_failedOperations;
+        if (operation->view != 0)
+        {
+          m_droppedViews.insert(operation->view);
+        }
+      }
+      --m_numberOfPending;
+    }
+    m_journal.pop_front();
+  }
+  m_pendingUpdates.clear();
+  return true;
+}
+
+void
+ResilientUI::startSession()
+{
+  m_serverIds.clear();
+  if (!m_options.restoreScene)
+  {
+    // the journal is sent as is, its operations on objects of the previous session are dropped
+    return;
+  }
+
+  m_journal.clear();
+  m_pendingUpdates.clear();
+  for (const auto & entry : m_scene)
+  {
+    const SceneObject & object = entry.second;
+    if (!object.creation)
+    {
+      continue;
+    }
+    m_journal.push_back(object.creation);
+    m_journal.insert(m_journal.end(), object.appends.begin(), object.appends.end());
+    m_journal.insert(m_journal.end(), object.updates.begin(), object.updates.end());
+  }
+  for (const auto & operation : m_journal)
+  {
+    operation->superseded = false;
+  }
+  m_numberOfPending = m_journal.size();
+}
+
+bool
+ResilientUI::resume(std::unique_ptr<ui::UIClient> client, const std::string & sessionId)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_threadMutex);
+    m_reconnect = false;
+  }
+  m_client = std::move(client);
+  if (sessionId.empty() || sessionId != m_sessionId)
+  {
+    startSession();
+    // set before the journal is sent, a replay that is interrupted continues where it stopped
+    m_sessionId = sessionId;
+  }
+  return sendJournal();
+}
+
+void
+ResilientUI::reconnectLoop()
+{
+  const std::chrono::milliseconds initialBackoff(m_options.initialBackoffMs);
+  const std::chrono::milliseconds maxBackoff(m_options.maxBackoffMs);
+  std::chrono::milliseconds       backoff = initialBackoff;
+
+  std::unique_lock<std::mutex> lock(m_threadMutex);
+  while (true)
+  {
+    m_condition.wait(lock, [this] { return m_stopped || m_reconnect; });
+    if (m_stopped)
+    {
+      return;
+    }
+    lock.unlock();
+
+    bool resumed = false;
+    try
+    {
+      // the application keeps working while the service is unreachable, it only waits for the journal
+      std::string sessionId;
+      auto        client = connectClient(m_connect, sessionId);
+
+      std::lock_guard<std::mutex> connectionLock(m_connectionMutex);
+      ++m_reconnects;
+      resumed = resume(std::move(client), sessionId);
+    }
+    catch (const std::exception &)
+    {
+      // still unreachable
+    }
+
+    lock.lock();
+    if (resumed)
+    {
+      backoff = initialBackoff;
+    }
+    else
+    {
+      m_condition.wait_for(lock, backoff, [this] { return m_stopped; });
+      backoff = std::min(backoff * 2, maxBackoff);
+    }
+  }
+}
+
+void
+ResilientUI::getSessionId(std::string & _return)
+{
+  _return = m_sessionId;
+}
+
+void
+ResilientUI::createGroup(ui::Group & _return, const std::string & name)
+{
+  const int id = m_nextId++;
+  submitCreation(groupCreation(id, name), 0);
+  _return.id = id;
+  _return.name = name;
+}
+
+void
+ResilientUI::createTriangleMesh(ui::TriangleMeshView & _return,
+                                const ui::Group &      g,
+                                std::int32_t           numberOfVertices,
+                                std::int32_t           numberOfTriangles,
+                                const std::string &    name)
+{
+  const int group = objectOf(g.id);
+  const int id = m_nextId++;
+  auto      result = std::make_shared<ui::TriangleMeshView>(newTriangleMeshView(id));
+  submitCreation(makeOperation(Operation::Kind::Create,
+                               id,
+                               "createTriangleMesh",
+                               [this, id, g, numberOfVertices, numberOfTriangles, name, result](ui::UIClient & client) {
+                                 client.createTriangleMesh(
+                                   *result, serverView(g), numberOfVertices, numberOfTriangles, name);
+                                 m_serverIds[id] = result->id;
+                               }),
+                 group);
+  _return = *result;
+  _return.id = id;
+}
+
+void
+ResilientUI::writeTriangleMeshChunk(const ui::TriangleMeshView & tmv, const ui::PackedMeshChunk & chunk)
+{
+  submit(dataTransfer(
+    Operation::Kind::Append, "writeTriangleMeshChunk", tmv, chunk, &ui::UIIf::writeTriangleMeshChunk));
+}
+
+void
+ResilientUI::showPointCloud(const ui::Group & g, const ui::PointList & p, const std::string & name)
+{
+  const int group = objectOf(g.id);
+  submitCreation(anonymousCreation("showPointCloud", m_nextId++, g, p, name, &ui::UIIf::showPointCloud), group);
+}
+
+void
+ResilientUI::createPointCloud(ui::PointCloudView & _return,
+                              const ui::Group &    g,
+                              const std::string &  name,
+                              std::int64_t         expectedNumberOfPoints)
+{
+  const int group = objectOf(g.id);
+  const int id = m_nextId++;
+  auto      result = std::make_shared<ui::PointCloudView>();
+  result->id = id;
+  submitCreation(makeOperation(Operation::Kind::Create,
+                               id,
+                               "createPointCloud",
+                               [this, id, g, name, expectedNumberOfPoints, result](ui::UIClient & client) {
+                                 client.createPointCloud(*result, serverView(g), name, expectedNumberOfPoints);
+                                 m_serverIds[id] = result->id;
+                               }),
+                 group);
+  _return.id = id;
+}
+
+void
+ResilientUI::appendPointCloudPoints(const ui::PointCloudView & pcv, const ui::PackedPointChunk & chunk)
+{
+  submit(dataTransfer(
+    Operation::Kind::Append, "appendPointCloudPoints", pcv, chunk, &ui::UIIf::appendPointCloudPoints));
+}
+
+void
+ResilientUI::showTriangleMesh(ui::TriangleMeshView &   _return,
+                              const ui::Group &        g,
+                              const ui::TriangleMesh & m,
+                              const std::string &      name)
+{
+  const int group = objectOf(g.id);
+  const int id = m_nextId++;
+  auto      result = std::make_shared<ui::TriangleMeshView>(newTriangleMeshView(id));
+  submitCreation(viewCreation("showTriangleMesh", id, g, m, name, result, &ui::UIIf::showTriangleMesh), group);
+  _return = *result;
+  _return.id = id;
+}
+
+void
+ResilientUI::showPackedTriangleMesh(ui::TriangleMeshView &         _return,
+                                    const ui::Group &              g,
+                                    const ui::PackedTriangleMesh & m,
+                                    const std::string &            name)
+{
+  const int group = objectOf(g.id);
+  const int id = m_nextId++;
+  auto      result = std::make_shared<ui::TriangleMeshView>(newTriangleMeshView(id));
+  submitCreation(viewCreation("showPackedTriangleMesh", id, g, m, name, result, &ui::UIIf::showPackedTriangleMesh),
+                 group);
+  _return = *result;
+  _return.id = id;
+}
+
+void
+ResilientUI::showImage(ui::ImageView & _return, const ui::Group & g, const ui::Image & img, const std::string & name)
+{
+  const int group = objectOf(g.id);
+  const int id = m_nextId++;
+  auto      result = std::make_shared<ui::ImageView>(newImageView(id));
+  submitCreation(viewCreation("showImage", id, g, img, name, result, &ui::UIIf::showImage), group);
+  _return = *result;
+  _return.id = id;
+}
+
+void
+ResilientUI::showPackedImage(ui::ImageView &         _return,
+                             const ui::Group &       g,
+                             const ui::PackedImage & img,
+                             const std::string &     name)
+{
+  const int group = objectOf(g.id);
+  const int id = m_nextId++;
+  auto      result = std::make_shared<ui::ImageView>(newImageView(id));
+  submitCreation(viewCreation("showPackedImage", id, g, img, name, result, &ui::UIIf::showPackedImage), group);
+  _return = *result;
+  _return.id = id;
+}
+
+void
+ResilientUI::showLandmark(const ui::Group & g, const ui::Landmark & landmark, const std::string & name)
+{
+  const int group = objectOf(g.id);
+  submitCreation(anonymousCreation("showLandmark", m_nextId++, g, landmark, name, &ui::UIIf::showLandmark), group);
+}
+
+void
+ResilientUI::showLandmarks(const ui::Group & g, const std::vector<ui::Landmark> & landmarks)
+{
+  const int group = objectOf(g.id);
+  const int id = m_nextId++;
+  auto      payload = borrow(landmarks);
+  auto      operation =
+    makeOperation(Operation::Kind::Create, id, "showLandmarks", [this, g, payload](ui::UIClient & client) {
+      client.showLandmarks(serverView(g), payload->get());
+    });
+  operation->retain = [payload] { payload->share(); };
+  submitCreation(operation, group);
+}
+
+void
+ResilientUI::showStatisticalShapeModel(ui::ShapeModelView &              _return,
+                                       const ui::Group &                 g,
+                                       const ui::StatisticalShapeModel & ssm,
+                                       const std::string &               name)
+{
+  const int group = objectOf(g.id);
+  const int meshId = m_nextId++;
+  const int transformationId = m_nextId++;
+  auto      result = std::make_shared<ui::ShapeModelView>(
+    newShapeModelView(meshId, transformationId, ssm.klbasis.eigenvalues.size()));
+  auto payload = borrow(ssm);
+  auto operation = makeOperation(Operation::Kind::Create,
+                                 meshId,
+                                 "showStatisticalShapeModel",
+                                 [this, g, payload, name, result, meshId, transformationId](ui::UIClient & client) {
+                                   client.showStatisticalShapeModel(*result, serverView(g), payload->get(), name);
+                                   m_serverIds[meshId] = result->meshView.id;
+                                   m_serverIds[transformationId] = result->shapeModelTransformationView.id;
+                                 });
+  operation->retain = [payload] { payload->share(); };
+  submitCreation(operation, group, { transformationId });
+  _return = withIds(*result, meshId, transformationId);
+}
+
+void
+ResilientUI::showPackedStatisticalShapeModel(ui::ShapeModelView &                    _return,
+                                             const ui::Group &                       g,
+                                             const ui::PackedStatisticalShapeModel & ssm,
+                                             const std::string &                     name)
+{
+  const int group = objectOf(g.id);
+  const int meshId = m_nextId++;
+  const int transformationId = m_nextId++;
+  auto      result = std::make_shared<ui::ShapeModelView>(
+    newShapeModelView(meshId, transformationId, ssm.klbasis.eigenvalues.size()));
+  auto payload = borrow(ssm);
+  auto operation = makeOperation(Operation::Kind::Create,
+                                 meshId,
+                                 "showPackedStatisticalShapeModel",
+                                 [this, g, payload, name, result, meshId, transformationId](ui::UIClient & client) {
+                                   client.showPackedStatisticalShapeModel(*result, serverView(g), payload->get(), name);
+                                   m_serverIds[meshId] = result->meshView.id;
+                                   m_serverIds[transformationId] = result->shapeModelTransformationView.id;
+                                 });
+  operation->retain = [payload] { payload->share(); };
+  submitCreation(operation, group, { transformationId });
+  _return = withIds(*result, meshId, transformationId);
+}
+
+void
+ResilientUI::registerStatisticalShapeModel(const std::string & modelHash, const ui::PackedStatisticalShapeModel & ssm)
+{
+  auto payload = borrow(ssm);
+  auto operation = makeOperation(
+    Operation::Kind::Register, 0, "registerStatisticalShapeModel", [payload, modelHash](ui::UIClient & client) {
+      client.registerStatisticalShapeModel(modelHash, payload->get());
+    });
+  operation->retain = [payload] { payload->share(); };
+  submit(operation);
+
+  m_modelComponents[modelHash] = ssm.klbasis.numberOfComponents;
+  if (m_options.restoreScene)
+  {
+    m_models[modelHash] = payload->share();
+  }
+}
+
+void
+ResilientUI::showRegisteredStatisticalShapeModel(ui::ShapeModelView & _return,
+                                                 const ui::Group &    g,
+                                                 const std::string &  modelHash,
+                                                 const std::string &  name)
+{
+  const int group = objectOf(g.id);
+  // taken whether the model is known or not, the ids only depend on the sequence of calls
+  const int meshId = m_nextId++;
+  const int transformationId = m_nextId++;
+  auto      components = m_modelComponents.find(modelHash);
+  if (!m_client && components == m_modelComponents.end())
+  {
+    // as the service would, the application then registers the model
+    ui::UnknownModel unknown;
+    unknown.modelHash = modelHash;
+    throw unknown;
+  }
+
+  auto      result = std::make_shared<ui::ShapeModelView>(newShapeModelView(
+    meshId, transformationId, components == m_modelComponents.end() ? 0 : components->second));
+  auto operation = makeOperation(
+    Operation::Kind::Create,
+    meshId,
+    "showRegisteredStatisticalShapeModel",
+    [this, g, modelHash, name, result, meshId, transformationId](ui::UIClient & client) {
+      try
+      {
+        client.showRegisteredStatisticalShapeModel(*result, serverView(g), modelHash, name);
+      }
+      catch (const ui::UnknownModel &)
+      {
+        // a restarted service has lost its registry
+        auto model = m_models.find(modelHash);
+        if (model == m_models.end())
+        {
+          throw;
+        }
+        client.registerStatisticalShapeModel(modelHash, *model->second);
+        client.showRegisteredStatisticalShapeModel(*result, serverView(g), modelHash, name);
+      }
+      m_serverIds[meshId] = result->meshView.id;
+      m_serverIds[transformationId] = result->shapeModelTransformationView.id;
+    });
+  submitCreation(operation, group, { transformationId });
+  _return = withIds(*result, meshId, transformationId);
+}
+
+void
+ResilientUI::appendShapeModelComponents(const ui::ShapeModelView & smv, const ui::PackedKLBasis & components)
+{
+  auto payload = borrow(components);
+  auto operation = makeOperation(Operation::Kind::Append,
+                                 objectOf(smv.meshView.id),
+                                 "appendShapeModelComponents",
+                                 [this, smv, payload](ui::UIClient & client) {
+                                   client.appendShapeModelComponents(serverShapeModelView(smv), payload->get());
+                                 });
+  operation->retain = [payload] { payload->share(); };
+  submit(operation);
+}
+
+void
+ResilientUI::updateShapeModelTransformation(const ui::ShapeModelTransformationView & smtv)
+{
+  submit(viewUpdate("updateShapeModelTransformation", smtv, &ui::UIIf::updateShapeModelTransformation));
+}
+
+void
+ResilientUI::updateShapeModelTransformations(const std::vector<ui::ShapeModelTransformationView> & smtvs)
+{
+  // recorded view by view, so that each supersedes the earlier updates of its view
+  std::vector<OperationPointer> updates;
+  updates.reserve(smtvs.size());
+  for (const auto & smtv : smtvs)
+  {
+    updates.push_back(viewUpdate("updateShapeModelTransformation", smtv, &ui::UIIf::updateShapeModelTransformation));
+  }
+
+  if (m_client)
+  {
+    try
+    {
+      std::vector<ui::ShapeModelTransformationView> serverViews;
+      serverViews.reserve(smtvs.size());
+      for (const auto & smtv : smtvs)
+      {
+        serverViews.push_back(serverView(smtv));
+      }
+      m_client->updateShapeModelTransformations(serverViews);
+      for (const auto & update : updates)
+      {
+        remember(update);
+      }
+      return;
+    }
+    catch (const TTransportException &)
+    {
+      disconnect();
+    }
+    catch (const UnmappedObject &)
+    {
+      // sent one by one below, dropping the views that are not shown
+    }
+  }
+  for (const auto & update : updates)
+  {
+    submit(update);
+  }
+}
+
+void
+ResilientUI::loadShapeTrajectory(const ui::ShapeModelTransformationView & smtv,
+                                 const ui::PackedShapeTrajectory &        trajectory)
+{
+  submit(dataTransfer(
+    Operation::Kind::Update, "loadShapeTrajectory", smtv, trajectory, &ui::UIIf::loadShapeTrajectory));
+}
+
+void
+ResilientUI::playShapeTrajectory(const ui::ShapeModelTransformationView & smtv, const ui::TrajectoryPlayback & playback)
+{
+  submit(dataTransfer(
+    Operation::Kind::Update, "playShapeTrajectory", smtv, playback, &ui::UIIf::playShapeTrajectory));
+}
+
+void
+ResilientUI::updateTriangleMeshView(const ui::TriangleMeshView & tmv)
+{
+  submit(viewUpdate("updateTriangleMeshView", tmv, &ui::UIIf::updateTriangleMeshView));
+}
+
+void
+ResilientUI::updateTriangleMeshVertices(const ui::TriangleMeshView & tmv, const ui::PackedVertexUpdate & update)
+{
+  // deltas add up, an update of all the vertices replaces them
+  const bool full = !update.__isset.indices;
+  auto       operation = dataTransfer(full ? Operation::Kind::Update : Operation::Kind::Append,
+                                "updateTriangleMeshVertices",
+                                tmv,
+                                update,
+                                &ui::UIIf::updateTriangleMeshVertices);
+  operation->resetsAppends = full;
+  submit(operation);
+}
+
+void
+ResilientUI::updateTriangleMeshScalars(const ui::TriangleMeshView & tmv, const ui::PackedVertexScalars & scalars)
+{
+  submit(dataTransfer(
+    Operation::Kind::Update, "updateTriangleMeshScalars", tmv, scalars, &ui::UIIf::updateTriangleMeshScalars));
+}
+
+void
+ResilientUI::updateImageView(const ui::ImageView & iv)
+{
+  submit(viewUpdate("updateImageView", iv, &ui::UIIf::updateImageView));
+}
+
+void
+ResilientUI::showImagePyramid(ui::ImageView &         _return,
+                              const ui::Group &       g,
+                              const ui::ImageDomain & domain,
+                              std::int32_t            numberOfLevels,
+                              const ui::PackedImage & coarsestLevel,
+                              const std::string &     name)
+{
+  const int group = objectOf(g.id);
+  const int id = m_nextId++;
+  auto      result = std::make_shared<ui::ImageView>(newImageView(id));
+  auto      payload = borrow(coarsestLevel);
+  auto      operation =
+    makeOperation(Operation::Kind::Create,
+                  id,
+                  "showImagePyramid",
+                  [this, id, g, domain, numberOfLevels, payload, name, result](ui::UIClient & client) {
+                    client.showImagePyramid(*result, serverView(g), domain, numberOfLevels, payload->get(), name);
+                    m_serverIds[id] = result->id;
+                  });
+  operation->retain = [payload] { payload->share(); };
+  submitCreation(operation, group);
+  _return = *result;
+  _return.id = id;
+}
+
+void
+ResilientUI::createImage(ui::ImageView &         _return,
+                         const ui::Group &       g,
+                         const ui::ImageDomain & domain,
+                         ui::ScalarType::type    pixelType,
+                         const std::string &     name)
+{
+  const int group = objectOf(g.id);
+  const int id = m_nextId++;
+  auto      result = std::make_shared<ui::ImageView>(newImageView(id));
+  submitCreation(makeOperation(Operation::Kind::Create,
+                               id,
+                               "createImage",
+                               [this, id, g, domain, pixelType, name, result](ui::UIClient & client) {
+                                 client.createImage(*result, serverView(g), domain, pixelType, name);
+                                 m_serverIds[id] = result->id;
+                               }),
+                 group);
+  _return = *result;
+  _return.id = id;
+}
+
+void
+ResilientUI::updateImageRegion(const ui::ImageView & iv, const ui::PackedImageRegion & region)
+{
+  submit(dataTransfer(Operation::Kind::Append, "updateImageRegion", iv, region, &ui::UIIf::updateImageRegion));
+}
+
+void
+ResilientUI::removeGroup(const ui::Group & g)
+{
+  submit(removal("removeGroup", g, &ui::UIIf::removeGroup));
+  forget(g.id);
+}
+
+void
+ResilientUI::removeImage(const ui::ImageView & iv)
+{
+  submit(removal("removeImage", iv, &ui::UIIf::removeImage));
+  forget(iv.id);
+}
+
+void
+ResilientUI::removeTriangleMesh(const ui::TriangleMeshView & tmv)
+{
+  submit(removal("removeTriangleMesh", tmv, &ui::UIIf::removeTriangleMesh));
+  forget(tmv.id);
+}
+
+void
+ResilientUI::removeShapeModelTransformation(const ui::ShapeModelTransformationView & smv)
+{
+  submit(removal("removeShapeModelTransformation", smv, &ui::UIIf::removeShapeModelTransformation));
+  forget(smv.id);
+}
+
+void
+ResilientUI::removeShapeModel(const ui::ShapeModelView & smv)
+{
+  const int object = objectOf(smv.meshView.id);
+  submit(makeOperation(Operation::Kind::Remove, 0, "removeShapeModel", [this, smv](ui::UIClient & client) {
+    if (m_serverIds.count(smv.meshView.id) != 0)
+    {
+      client.removeShapeModel(serverShapeModelView(smv));
+    }
+  }));
+  forget(object);
+}
+
+void
+ResilientUI::applySceneBatch(std::vector<ui::SceneOperationResult> & _return,
+                             const std::vector<ui::SceneOperation> & operations)
+{
+  if (m_client)
+  {
+    try
+    {
+      // groups created by the batch keep their negative ids
+      auto translate = [this](auto & view) {
+        if (view.id >= 0)
+        {
+          objectOf(view.id);
+          view.id = serverId(view.id);
+        }
+      };
+
+      std::vector<ui::SceneOperation> serverOperations = operations;
+      for (auto & operation : serverOperations)
+      {
+        if (operation.__isset.showPointCloud)
+        {
+          translate(operation.showPointCloud.g);
+        }
+        else if (operation.__isset.showTriangleMesh)
+        {
+          translate(operation.showTriangleMesh.g);
+        }
+        else if (operation.__isset.showImage)
+        {
+          translate(operation.showImage.g);
+        }
+        else if (operation.__isset.showLandmark)
+        {
+          translate(operation.showLandmark.g);
+        }
+        else if (operation.__isset.updateTriangleMeshView)
+        {
+          translate(operation.updateTriangleMeshView);
+        }
+        else if (operation.__isset.updateImageView)
+        {
+          translate(operation.updateImageView);
+        }
+        else if (operation.__isset.updateShapeModelTransformation)
+        {
+          translate(operation.updateShapeModelTransformation);
+        }
+        else if (operation.__isset.removeGroup)
+        {
+          translate(operation.removeGroup);
+        }
+        else if (operation.__isset.removeTriangleMesh)
+        {
+          translate(operation.removeTriangleMesh);
+        }
+        else if (operation.__isset.removeImage)
+        {
+          translate(operation.removeImage);
+        }
+      }
+
+      std::vector<ui::SceneOperationResult> serverResults;
+      m_client->applySceneBatch(serverResults, serverOperations);
+      rememberBatch(operations, serverResults, _return);
+      return;
+    }
+    catch (ui::SceneBatchError & e)
+    {
+      // the operations before the failed one were applied: their objects are restored after a restart, their
+      // removals are not undone
+      const std::size_t                     applied = std::min<std::size_t>(e.operationIndex, operations.size());
+      const std::vector<ui::SceneOperation> prefix(operations.begin(), operations.begin() + applied);
+      std::vector<ui::SceneOperationResult> results;
+      rememberBatch(prefix, e.results, results);
+      e.__set_results(std::move(results));
+      throw;
+    }
+    catch (const TTransportException &)
+    {
+      disconnect();
+    }
+    catch (const UnmappedObject &)
+    {
+      // applied one by one below, dropping the operations on objects that are not shown
+    }
+  }
+  applyOneByOne(operations, _return);
+}
+
+void
+ResilientUI::rememberBatch(const std::vector<ui::SceneOperation> &       operations,
+                           const std::vector<ui::SceneOperationResult> & serverResults,
+                           std::vector<ui::SceneOperationResult> &       _return)
+{
+  _return.clear();
+  _return.reserve(operations.size());
+
+  auto resolve = [&_return](ui::Group g) {
+    if (g.id < 0)
+    {
+      g = _return[-(g.id + 1)].group;
+    }
+    return g;
+  };
+
+  static const ui::SceneOperationResult unknown;
+  for (std::size_t i = 0; i < operations.size(); ++i)
+  {
+    const ui::SceneOperation &       operation = operations[i];
+    const ui::SceneOperationResult & serverResult = i < serverResults.size() ? serverResults[i] : unknown;
+    ui::SceneOperationResult         result;
+    if (i >= serverResults.size() &&
+        (operation.__isset.createGroup || operation.__isset.showPointCloud || operation.__isset.showTriangleMesh ||
+         operation.__isset.showImage || operation.__isset.showLandmark))
+    {
+      // a failed batch of a service that does not report what it created: the object cannot be restored
+      ++m_droppedOperations;
+    }
+    else if (operation.__isset.createGroup)
+    {
+      const int id = m_nextId++;
+      addObject(id, 0);
+      m_serverIds[id] = serverResult.group.id;
+      remember(groupCreation(id, operation.createGroup));
+      result.group.id = id;
+      result.group.name = operation.createGroup;
+      result.__isset.group = true;
+    }
+    else if (operation.__isset.showPointCloud)
+    {
+      const auto &    show = operation.showPointCloud;
+      const ui::Group g = resolve(show.g);
+      const int       id = m_nextId++;
+      addObject(id, g.id);
+      remember(anonymousCreation("showPointCloud", id, g, show.points, show.name, &ui::UIIf::showPointCloud));
+    }
+    else if (operation.__isset.showTriangleMesh)
+    {
+      const auto &    show = operation.showTriangleMesh;
+      const ui::Group g = resolve(show.g);
+      const int       id = m_nextId++;
+      auto            view = std::make_shared<ui::TriangleMeshView>(serverResult.meshView);
+      addObject(id, g.id);
+      m_serverIds[id] = view->id;
+      remember(
+        viewCreation("showPackedTriangleMesh", id, g, show.mesh, show.name, view, &ui::UIIf::showPackedTriangleMesh));
+      result.meshView = *view;
+      result.meshView.id = id;
+      result.__isset.meshView = true;
+    }
+    else if (operation.__isset.showImage)
+    {
+      const auto &    show = operation.showImage;
+      const ui::Group g = resolve(show.g);
+      const int       id = m_nextId++;
+      auto            view = std::make_shared<ui::ImageView>(serverResult.imageView);
+      addObject(id, g.id);
+      m_serverIds[id] = view->id;
+      remember(viewCreation("showPackedImage", id, g, show.image, show.name, view, &ui::UIIf::showPackedImage));
+      result.imageView = *view;
+      result.imageView.id = id;
+      result.__isset.imageView = true;
+    }
+    else if (operation.__isset.showLandmark)
+    {
+      const auto &    show = operation.showLandmark;
+      const ui::Group g = resolve(show.g);
+      const int       id = m_nextId++;
+      addObject(id, g.id);
+      remember(anonymousCreation("showLandmark", id, g, show.landmark, show.name, &ui::UIIf::showLandmark));
+    }
+    else if (operation.__isset.updateTriangleMeshView)
+    {
+      remember(
+        viewUpdate("updateTriangleMeshView", operation.updateTriangleMeshView, &ui::UIIf::updateTriangleMeshView));
+    }
+    else if (operation.__isset.updateImageView)
+    {
+      remember(viewUpdate("updateImageView", operation.updateImageView, &ui::UIIf::updateImageView));
+    }
+    else if (operation.__isset.updateShapeModelTransformation)
+    {
+      remember(viewUpdate("updateShapeModelTransformation",
+                          operation.updateShapeModelTransformation,
+                          &ui::UIIf::updateShapeModelTransformation));
+    }
+    else if (operation.__isset.removeGroup)
+    {
+      // 0 for a group of the batch that was not reported
+      const int id = resolve(operation.removeGroup).id;
+      if (id != 0)
+      {
+        forget(id);
+      }
+    }
+    else if (operation.__isset.removeTriangleMesh)
+    {
+      forget(operation.removeTriangleMesh.id);
+    }
+    else if (operation.__isset.removeImage)
+    {
+      forget(operation.removeImage.id);
+    }
+    _return.push_back(std::move(result));
+  }
+}
+
+void
+ResilientUI::applyOneByOne(const std::vector<ui::SceneOperation> & operations,
+                           std::vector<ui::SceneOperationResult> & _return)
+{
+  _return.clear();
+  _return.reserve(operations.size());
+
+  // A group with id -(k + 1) is the one created by operation k of this batch
+  auto resolve = [&_return](const ui::Group & g) {
+    if (g.id >= 0)
+    {
+      return g;
+    }
+    const std::size_t index = -(g.id + 1);
+    if (index >= _return.size() || !_return[index].__isset.group)
+    {
+      throw std::invalid_argument("operation " + std::to_string(index) + " of the batch did not create a group");
+    }
+    return _return[index].group;
+  };
+
+  for (std::size_t i = 0; i < operations.size(); ++i)
+  {
+    const ui::SceneOperation & operation = operations[i];
+    ui::SceneOperationResult   result;
+    try
+    {
+      if (operation.__isset.createGroup)
+      {
+        createGroup(result.group, operation.createGroup);
+        result.__isset.group = true;
+      }
+      else if (operation.__isset.showPointCloud)
+      {
+        const auto & show = operation.showPointCloud;
+        showPointCloud(resolve(show.g), show.points, show.name);
+      }
+      else if (operation.__isset.showTriangleMesh)
+      {
+        const auto & show = operation.showTriangleMesh;
+        showPackedTriangleMesh(result.meshView, resolve(show.g), show.mesh, show.name);
+        result.__isset.meshView = true;
+      }
+      else if (operation.__isset.showImage)
+      {
+        const auto & show = operation.showImage;
+        showPackedImage(result.imageView, resolve(show.g), show.image, show.name);
+        result.__isset.imageView = true;
+      }
+      else if (operation.__isset.showLandmark)
+      {
+        const auto & show = operation.showLandmark;
+        showLandmark(resolve(show.g), show.landmark, show.name);
+      }
+      else if (operation.__isset.updateTriangleMeshView)
+      {
+        updateTriangleMeshView(operation.updateTriangleMeshView);
+      }
+      else if (operation.__isset.updateImageView)
+      {
+        updateImageView(operation.updateImageView);
+      }
+      else if (operation.__isset.updateShapeModelTransformation)
+      {
+        updateShapeModelTransformation(operation.updateShapeModelTransformation);
+      }
+      else if (operation.__isset.removeGroup)
+      {
+        removeGroup(resolve(operation.removeGroup));
+      }
+      else if (operation.__isset.removeTriangleMesh)
+      {
+        removeTriangleMesh(operation.removeTriangleMesh);
+      }
+      else if (operation.__isset.removeImage)
+      {
+        removeImage(operation.removeImage);
+      }
+      else
+      {
+        throw std::invalid_argument("empty operation");
+      }
+    }
+    catch (const std::exception & e)
+    {
+      ui::SceneBatchError error;
+      error.operationIndex = static_cast<std::int32_t>(i);
+      error.message = e.what();
+      error.__set_results(_return);
+      throw error;
+    }
+    _return.push_back(std::move(result));
+  }
+}
+
+} // namespace StatismoUI
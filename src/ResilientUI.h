@@ -0,0 +1,397 @@
+#ifndef UI_RESILIENTUI_H
+#define UI_RESILIENTUI_H
+
+#include "StatismoUI.h"
+#include "thrift/UI.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Reconnecting client of ui-service.
+namespace StatismoUI
+{
+
+// ui::UIIf that keeps working while ui-service is unreachable, see ReconnectOptions.
+//
+// Every object shown gets an id chosen here, which is mapped to the id of the service in the current session.
+// Operations are sent right away while connected. Otherwise they are journaled and sent by a background thread once
+// it has reconnected; updates of a view supersede its earlier pending updates. If the session id of the service
+// changed, the service was restarted and the journal is rebuilt from the scene: for each object that is still
+// shown, the operation that created it, the data appended to it since and its latest update of each kind.
+//
+// All calls, those of the background thread included, are made with connectionMutex locked.
+class ResilientUI : public ui::UIIf
+{
+public:
+  // Opens a new connection, throws if the service cannot be reached
+  using Connect = std::function<std::unique_ptr<ui::UIClient>()>;
+
+  // Tries to connect once before returning, then keeps trying in the background
+  ResilientUI(Connect connect, const ReconnectOptions & options, std::mutex & connectionMutex);
+  ~ResilientUI() override;
+
+  ResilientUI(const ResilientUI &) = delete;
+  ResilientUI &
+  operator=(const ResilientUI &) = delete;
+
+  ConnectionStatus
+  GetStatus() const;
+
+  // Whether an update or an append of the view was dropped, or failed while the journal was sent, since the last call
+  // for the view. The service may then not hold what the caller last sent for it.
+  bool
+  TakeDropped(int viewId);
+
+  void
+  getSessionId(std::string & _return) override;
+
+  void
+  createGroup(ui::Group & _return, const std::string & name) override;
+
+  void
+  createTriangleMesh(ui::TriangleMeshView & _return,
+                     const ui::Group &      g,
+                     std::int32_t           numberOfVertices,
+                     std::int32_t           numberOfTriangles,
+                     const std::string &    name) override;
+
+  void
+  writeTriangleMeshChunk(const ui::TriangleMeshView & tmv, const ui::PackedMeshChunk & chunk) override;
+
+  void
+  showPointCloud(const ui::Group & g, const ui::PointList & p, const std::string & name) override;
+
+  void
+  createPointCloud(ui::PointCloudView & _return,
+                   const ui::Group &    g,
+                   const std::string &  name,
+                   std::int64_t         expectedNumberOfPoints) override;
+
+  void
+  appendPointCloudPoints(const ui::PointCloudView & pcv, const ui::PackedPointChunk & chunk) override;
+
+  void
+  showTriangleMesh(ui::TriangleMeshView &   _return,
+                   const ui::Group &        g,
+                   const ui::TriangleMesh & m,
+                   const std::string &      name) override;
+
+  void
+  showPackedTriangleMesh(ui::TriangleMeshView &         _return,
+                         const ui::Group &              g,
+                         const ui::PackedTriangleMesh & m,
+                         const std::string &            name) override;
+
+  void
+  showImage(ui::ImageView & _return, const ui::Group & g, const ui::Image & img, const std::string & name) override;
+
+  void
+  showPackedImage(ui::ImageView &         _return,
+                  const ui::Group &       g,
+                  const ui::PackedImage & img,
+                  const std::string &     name) override;
+
+  void
+  showLandmark(const ui::Group & g, const ui::Landmark & landmark, const std::string & name) override;
+
+  void
+  showLandmarks(const ui::Group & g, const std::vector<ui::Landmark> & landmarks) override;
+
+  void
+  showStatisticalShapeModel(ui::ShapeModelView &              _return,
+                            const ui::Group &                 g,
+                            const ui::StatisticalShapeModel & ssm,
+                            const std::string &               name) override;
+
+  void
+  showPackedStatisticalShapeModel(ui::ShapeModelView &                    _return,
+                                  const ui::Group &                       g,
+                                  const ui::PackedStatisticalShapeModel & ssm,
+                                  const std::string &                     name) override;
+
+  void
+  registerStatisticalShapeModel(const std::string & modelHash, const ui::PackedStatisticalShapeModel & ssm) override;
+
+  void
+  showRegisteredStatisticalShapeModel(ui::ShapeModelView & _return,
+                                      const ui::Group &    g,
+                                      const std::string &  modelHash,
+                                      const std::string &  name) override;
+
+  void
+  appendShapeModelComponents(const ui::ShapeModelView & smv, const ui::PackedKLBasis & components) override;
+
+  void
+  updateShapeModelTransformation(const ui::ShapeModelTransformationView & smtv) override;
+
+  void
+  updateShapeModelTransformations(const std::vector<ui::ShapeModelTransformationView> & smtvs) override;
+
+  void
+  loadShapeTrajectory(const ui::ShapeModelTransformationView & smtv,
+                      const ui::PackedShapeTrajectory &        trajectory) override;
+
+  void
+  playShapeTrajectory(const ui::ShapeModelTransformationView & smtv,
+                      const ui::TrajectoryPlayback &           playback) override;
+
+  void
+  updateTriangleMeshView(const ui::TriangleMeshView & tmv) override;
+
+  void
+  updateTriangleMeshVertices(const ui::TriangleMeshView & tmv, const ui::PackedVertexUpdate & update) override;
+
+  void
+  updateTriangleMeshScalars(const ui::TriangleMeshView & tmv, const ui::PackedVertexScalars & scalars) override;
+
+  void
+  updateImageView(const ui::ImageView & iv) override;
+
+  void
+  showImagePyramid(ui::ImageView &         _return,
+                   const ui::Group &       g,
+                   const ui::ImageDomain & domain,
+                   std::int32_t            numberOfLevels,
+                   const ui::PackedImage & coarsestLevel,
+                   const std::string &     name) override;
+
+  void
+  createImage(ui::ImageView &         _return,
+              const ui::Group &       g,
+              const ui::ImageDomain & domain,
+              ui::ScalarType::type    pixelType,
+              const std::string &     name) override;
+
+  void
+  updateImageRegion(const ui::ImageView & iv, const ui::PackedImageRegion & region) override;
+
+  void
+  removeGroup(const ui::Group & g) override;
+
+  void
+  removeImage(const ui::ImageView & iv) override;
+
+  void
+  removeTriangleMesh(const ui::TriangleMeshView & tmv) override;
+
+  void
+  removeShapeModelTransformation(const ui::ShapeModelTransformationView & smv) override;
+
+  void
+  removeShapeModel(const ui::ShapeModelView & smv) override;
+
+  // Sent as a single request while connected, the operations are copied to translate their ids.
+  // Journaled operation by operation otherwise. If an operation fails, those before it are recorded and the
+  // SceneBatchError holds their results with client ids.
+  void
+  applySceneBatch(std::vector<ui::SceneOperationResult> & _return,
+                  const std::vector<ui::SceneOperation> & operations) override;
+
+private:
+  struct Operation
+  {
+    enum class Kind
+    {
+      Create,
+      Append,
+      Update,
+      Remove,
+      Register
+    };
+
+    Kind kind;
+    // Object created or modified (its id in the scene), 0 if none
+    int object;
+    // View updated or appended to (the id returned to the application), 0 if none
+    int view{ 0 };
+    // The RPC, updates of an object with the same name supersede each other
+    std::string name;
+    // Set for updates that replace what was appended with the same name, like full vertex updates
+    bool resetsAppends{ false };
+    bool superseded{ false };
+    // Sends the operation, translating ids; throws UnmappedObject if an object it refers to is not shown
+    std::function<void(ui::UIClient &)> send;
+    // Copies the payloads borrowed from the caller, before the operation is kept beyond the call
+    std::function<void()> retain;
+  };
+
+  struct SceneObject
+  {
+    // Group of the object, 0 for groups
+    int                                     group{ 0 };
+    std::shared_ptr<Operation>              creation;
+    std::vector<std::shared_ptr<Operation>> appends;
+    // The latest update of each name, in the order they were made, e.g. a trajectory is played after it is loaded
+    std::vector<std::shared_ptr<Operation>> updates;
+  };
+
+  using OperationPointer = std::shared_ptr<Operation>;
+  using Send = std::function<void(ui::UIClient &)>;
+
+  OperationPointer
+  makeOperation(Operation::Kind kind, int object, const std::string & name, Send send) const;
+
+  // Id in the scene of the object a client id refers to, throws std::invalid_argument for unknown ids
+  int
+  objectOf(int id) const;
+
+  // Id of the service in the current session, throws UnmappedObject if the object is not shown
+  int
+  serverId(int id) const;
+
+  template <typename View>
+  View
+  serverView(View view) const
+  {
+    view.id = serverId(view.id);
+    return view;
+  }
+
+  ui::ShapeModelView
+  serverShapeModelView(ui::ShapeModelView smv) const;
+
+  // Operations of the RPCs that applySceneBatch can batch, the others are built where they are submitted
+  OperationPointer
+  groupCreation(int id, const std::string & name);
+
+  template <typename View, typename Data>
+  OperationPointer
+  viewCreation(const std::string &       rpcName,
+               int                       id,
+               const ui::Group &         g,
+               const Data &              data,
+               const std::string &       name,
+               std::shared_ptr<View>     result,
+               void (ui::UIIf::*rpc)(View &, const ui::Group &, const Data &, const std::string &));
+
+  // Creation of an object that has no view, like a point cloud
+  template <typename Data>
+  OperationPointer
+  anonymousCreation(const std::string & rpcName,
+                    int                 id,
+                    const ui::Group &   g,
+                    const Data &        data,
+                    const std::string & name,
+                    void (ui::UIIf::*rpc)(const ui::Group &, const Data &, const std::string &));
+
+  template <typename View>
+  OperationPointer
+  viewUpdate(const std::string & rpcName, const View & view, void (ui::UIIf::*rpc)(const View &));
+
+  template <typename View, typename Data>
+  OperationPointer
+  dataTransfer(Operation::Kind     kind,
+               const std::string & rpcName,
+               const View &        view,
+               const Data &        data,
+               void (ui::UIIf::*rpc)(const View &, const Data &));
+
+  template <typename View>
+  OperationPointer
+  removal(const std::string & rpcName, const View & view, void (ui::UIIf::*rpc)(const View &));
+
+  // Sends the operation if connected, journals it otherwise, and records it in the scene. Errors of the service are
+  // thrown, nothing is recorded then.
+  void
+  submit(const OperationPointer & operation);
+
+  void
+  addObject(int object, int group, const std::vector<int> & aliases = {});
+
+  // Adds the object to the scene, submits its creation and forgets the object again if that throws
+  void
+  submitCreation(const OperationPointer & operation, int group, const std::vector<int> & aliases = {});
+
+  // Adds the operation to the journal, returns false if it was dropped
+  bool
+  enqueue(const OperationPointer & operation);
+
+  // Counts an operation that did not reach the service and records its view for TakeDropped
+  void
+  drop(const OperationPointer & operation);
+
+  void
+  remember(const OperationPointer & operation);
+
+  // Removes an object from the scene, a group with its objects. The ids of the service are kept for the removals
+  // still journaled.
+  void
+  forget(int id);
+
+  // Closes the connection and wakes up the reconnecting thread
+  void
+  disconnect();
+
+  // Sends the journal until it is empty or the connection breaks, returns whether it is empty
+  bool
+  sendJournal();
+
+  // Rebuilds the journal from the scene, for a service that does not know the scene
+  void
+  startSession();
+
+  // Continues with a new connection, returns whether the journal was sent
+  bool
+  resume(std::unique_ptr<ui::UIClient> client, const std::string & sessionId);
+
+  void
+  reconnectLoop();
+
+  // Records the operations of a batch that the service applied, returns the results with client ids. The objects of
+  // creations that have no result in serverResults are counted as dropped.
+  void
+  rememberBatch(const std::vector<ui::SceneOperation> &       operations,
+                const std::vector<ui::SceneOperationResult> & serverResults,
+                std::vector<ui::SceneOperationResult> &       _return);
+
+  // Applies a batch through the methods above, for a batch that could not be sent as one
+  void
+  applyOneByOne(const std::vector<ui::SceneOperation> & operations, std::vector<ui::SceneOperationResult> & _return);
+
+  Connect          m_connect;
+  ReconnectOptions m_options;
+  std::mutex &     m_connectionMutex;
+
+  // Guarded by m_connectionMutex. m_objects maps the ids returned to the application to the objects of the scene,
+  // m_serverIds to those of the service.
+  using PendingUpdates = std::map<std::pair<int, std::string>, std::weak_ptr<Operation>>;
+  using Models = std::map<std::string, std::shared_ptr<const ui::PackedStatisticalShapeModel>>;
+
+  std::unique_ptr<ui::UIClient>       m_client;
+  std::string                         m_sessionId;
+  int                                 m_nextId{ 1 };
+  std::map<int, SceneObject>          m_scene;
+  std::map<int, int>                  m_objects;
+  std::map<int, int>                  m_serverIds;
+  Models                              m_models;
+  std::map<std::string, std::int32_t> m_modelComponents;
+  std::deque<OperationPointer>        m_journal;
+  PendingUpdates                      m_pendingUpdates;
+  std::size_t                         m_numberOfPending{ 0 };
+  std::uint64_t                       m_reconnects{ 0 };
+  std::uint64_t                       m_droppedOperations{ 0 };
+  std::uint64_t                       m_failedOperations{ 0 };
+  std::set<int>                       m_droppedViews;
+
+  // Wakes up the reconnecting thread
+  bool                    m_reconnect{ false };
+  bool                    m_stopped{ false };
+  std::mutex              m_threadMutex;
+  std::condition_variable m_condition;
+  std::thread             m_thread;
+};
+
+} // namespace StatismoUI
+
+#endif // UI_RESILIENTUI_H
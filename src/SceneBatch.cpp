@@ -0,0 +1,173 @@
+#include "SceneBatch.h"
+#include "ThriftConversions.h"
+
+namespace StatismoUI
+{
+
+struct SceneBatch::Operations
+{
+  std::vector<ui::SceneOperation> operations;
+};
+
+SceneBatch::SceneBatch()
+  : m_operations(std::make_unique<Operations>())
+{}
+
+SceneBatch::~SceneBatch() = default;
+
+SceneBatch::SceneBatch(SceneBatch &&) noexcept = default;
+
+SceneBatch &
+SceneBatch::operator=(SceneBatch &&) noexcept = default;
+
+Group
+SceneBatch::createGroup(const std::string & name)
+{
+  const int placeholderId = -static_cast<int>(m_operations->operations.size()) - 1;
+
+  ui::SceneOperation operation;
+  operation.__set_createGroup(name);
+  m_operations->operations.push_back(std::move(operation));
+  return Group(name, placeholderId);
+}
+
+// The show operations move their payloads into the union, the __set methods would copy them
+
+std::size_t
+SceneBatch::showPointCloud(const Group & group, const std::list<PointType> & points, const std::string & name)
+{
+  ui::ShowPointCloudOperation show;
+  show.g = conversions::groupToThriftGroup(group);
+  show.points = conversions::pointsToThriftPointList(points);
+  show.name = name;
+
+  ui::SceneOperation operation;
+  operation.showPointCloud = std::move(show);
+  operation.__isset.showPointCloud = true;
+  m_operations->operations.push_back(std::move(operation));
+  return m_operations->operations.size() - 1;
+}
+
+std::size_t
+SceneBatch::showTriangleMesh(const Group &       group,
+                             const MeshType *    mesh,
+                             const std::string & name,
+                             ScalarType          vertexType)
+{
+  ui::ShowTriangleMeshOperation show;
+  show.g = conversions::groupToThriftGroup(group);
+  show.mesh = conversions::meshToPackedThriftMesh(mesh, vertexType);
+  show.name = name;
+
+  ui::SceneOperation operation;
+  operation.showTriangleMesh = std::move(show);
+  operation.__isset.showTriangleMesh = true;
+  m_operations->operations.push_back(std::move(operation));
+  return m_operations->operations.size() - 1;
+}
+
+std::size_t
+SceneBatch::showImage(const Group &             group,
+                      const itk::ImageBase<3> * image,
+                      ScalarType                pixelType,
+                      const void *              buffer,
+                      std::size_t               numberOfBytes,
+                      const std::string &       name)
+{
+  ui::ShowImageOperation show;
+  show.g = conversions::groupToThriftGroup(group);
+  show.image = conversions::packedImageToThrift(image, pixelType, buffer, numberOfBytes);
+  show.name = name;
+
+  ui::SceneOperation operation;
+  operation.showImage = std::move(show);
+  operation.__isset.showImage = true;
+  m_operations->operations.push_back(std::move(operation));
+  return m_operations->operations.size() - 1;
+}
+
+std::size_t
+SceneBatch::showLandmark(const Group &              group,
+                         const PointType &          point,
+                         const vnl_matrix<double> & cov,
+                         const std::string &        name)
+{
+  ui::ShowLandmarkOperation show;
+  show.g = conversions::groupToThriftGroup(group);
+  show.landmark = conversions::landmarkToThrift(point, cov, name);
+  show.name = name;
+
+  ui::SceneOperation operation;
+  operation.showLandmark = std::move(show);
+  operation.__isset.showLandmark = true;
+  m_operations->operations.push_back(std::move(operation));
+  return m_operations->operations.size() - 1;
+}
+
+void
+SceneBatch::updateTriangleMeshView(const TriangleMeshView & tmv)
+{
+  ui::SceneOperation operation;
+  operation.__set_updateTriangleMeshView(conversions::thriftMeshViewFromTriangleMeshView(tmv));
+  m_operations->operations.push_back(std::move(operation));
+}
+
+void
+SceneBatch::updateImageView(const ImageView & imv)
+{
+  ui::SceneOperation operation;
+  operation.__set_updateImageView(conversions::imageViewToThriftImageView(imv));
+  m_operations->operations.push_back(std::move(operation));
+}
+
+void
+SceneBatch::updateShapeModelTransformationView(const ShapeModelTransformationView & smv)
+{
+  ui::SceneOperation operation;
+  operation.__set_updateShapeModelTransformation(conversions::shapeModelTransformationViewToThrift(smv));
+  m_operations->operations.push_back(std::move(operation));
+}
+
+void
+SceneBatch::removeGroup(const Group & group)
+{
+  ui::SceneOperation operation;
+  operation.__set_removeGroup(conversions::groupToThriftGroup(group));
+  m_operations->operations.push_back(std::move(operation));
+}
+
+void
+SceneBatch::removeTriangleMesh(const TriangleMeshView & tmv)
+{
+  ui::SceneOperation operation;
+  operation.__set_removeTriangleMesh(conversions::thriftMeshViewFromTriangleMeshView(tmv));
+  m_operations->operations.push_back(std::move(operation));
+}
+
+void
+SceneBatch::removeImage(const ImageView & imv)
+{
+  ui::SceneOperation operation;
+  operation.__set_removeImage(conversions::imageViewToThriftImageView(imv));
+  m_operations->operations.push_back(std::move(operation));
+}
+
+std::size_t
+SceneBatch::GetNumberOfOperations() const
+{
+  return m_operations->operations.size();
+}
+
+const std::vector<ui::SceneOperation> &
+SceneBatch::GetThriftOperations() const
+{
+  return m_operations->operations;
+}
+
+void
+SceneBatch::clear()
+{
+  m_operations->operations.clear();
+}
+
+} // namespace StatismoUI
@@ -0,0 +1,153 @@
+#ifndef UI_SCENEBATCH_H
+#define UI_SCENEBATCH_H
+
+#include "StatismoUI.h"
+
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace ui
+{
+class SceneOperation;
+} // namespace ui
+
+namespace StatismoUI
+{
+// Collects show, update and remove calls, which StatismoUI::applySceneBatch then sends in a single request.
+// Payloads are encoded when a call is added. Calls creating a group or a view return the index of their operation,
+// the created object is looked up with that index in the SceneBatchResult.
+class SceneBatch
+{
+  using MeshType = itk::Mesh<float, 3>;
+  using PointType = MeshType::PointType;
+
+public:
+  SceneBatch();
+  ~SceneBatch();
+
+  SceneBatch(SceneBatch &&) noexcept;
+  SceneBatch &
+  operator=(SceneBatch &&) noexcept;
+
+  // The returned group can be used by the following calls of this batch only. The group created by the service is
+  // in the result, at the index returned by GetNumberOfOperations() before this call.
+  Group
+  createGroup(const std::string & name);
+
+  std::size_t
+  showPointCloud(const Group & group, const std::list<PointType> & points, const std::string & name);
+
+  // Vertices and topology are sent packed, as with StatismoUI::showPackedTriangleMesh
+  std::size_t
+  showTriangleMesh(const Group &       group,
+                   const MeshType *    mesh,
+                   const std::string & name,
+                   ScalarType          vertexType = ScalarType::Float32);
+
+  // The pixel buffer is sent packed, as with StatismoUI::showPackedImage
+  template <typename TPixel>
+  std::size_t
+  showImage(const Group & group, const itk::Image<TPixel, 3> * image, const std::string & name)
+  {
+    return showImage(group,
+                     image,
+                     ScalarTypeTraits<TPixel>::value,
+                     image->GetBufferPointer(),
+                     image->GetPixelContainer()->Size() * sizeof(TPixel),
+                     name);
+  }
+
+  std::size_t
+  showLandmark(const Group & group, const PointType & point, const vnl_matrix<double> & cov, const std::string & name);
+
+  void
+  updateTriangleMeshView(const TriangleMeshView & tmv);
+
+  void
+  updateImageView(const ImageView & imv);
+
+  void
+  updateShapeModelTransformationView(const ShapeModelTransformationView & smv);
+
+  void
+  removeGroup(const Group & group);
+  void
+  removeTriangleMesh(const TriangleMeshView & tmv);
+  void
+  removeImage(const ImageView & imv);
+
+  std::size_t
+  GetNumberOfOperations() const;
+
+  void
+  clear();
+
+private:
+  friend class StatismoUI;
+  struct Operations;
+
+  const std::vector<ui::SceneOperation> &
+  GetThriftOperations() const;
+
+  std::size_t
+  showImage(const Group &             group,
+            const itk::ImageBase<3> * image,
+            ScalarType                pixelType,
+            const void *              buffer,
+            std::size_t               numberOfBytes,
+            const std::string &       name);
+
+  std::unique_ptr<Operations> m_operations;
+};
+
+// Groups and views created by the operations of a scene batch, by operation index
+class SceneBatchResult
+{
+public:
+  using Entry = std::variant<std::monostate, Group, TriangleMeshView, ImageView>;
+
+  explicit SceneBatchResult(std::vector<Entry> && entries)
+    : m_entries(std::move(entries))
+  {}
+
+  // Throw std::invalid_argument if the operation did not create an object of that type
+  Group
+  GetGroup(std::size_t operation) const
+  {
+    return get<Group>(operation);
+  }
+
+  TriangleMeshView
+  GetTriangleMeshView(std::size_t operation) const
+  {
+    return get<TriangleMeshView>(operation);
+  }
+
+  ImageView
+  GetImageView(std::size_t operation) const
+  {
+    return get<ImageView>(operation);
+  }
+
+private:
+  template <typename T>
+  T
+  get(std::size_t operation) const
+  {
+    if (operation >= m_entries.size() || !std::holds_alternative<T>(m_entries[operation]))
+    {
+      throw std::invalid_argument("operation " + std::to_string(operation) + " did not create the requested object");
+    }
+    return std::get<T>(m_entries[operation]);
+  }
+
+  std::vector<Entry> m_entries;
+};
+
+} // namespace StatismoUI
+
+#endif // UI_SCENEBATCH_H
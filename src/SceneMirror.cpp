@@ -0,0 +1,131 @@
+#include "SceneMirror.h"
+
+namespace StatismoUI
+{
+
+namespace
+{
+template <typename View>
+bool
+isCurrent(const std::map<int, View> & views, const View & view)
+{
+  auto known = views.find(view.id);
+  return known != views.end() && known->second == view;
+}
+} // namespace
+
+void
+SceneMirror::addView(int groupId, const ui::TriangleMeshView & view)
+{
+  m_viewGroups[view.id] = groupId;
+  m_meshViews[view.id] = view;
+}
+
+void
+SceneMirror::addView(int groupId, const ui::ImageView & view)
+{
+  m_viewGroups[view.id] = groupId;
+  m_imageViews[view.id] = view;
+}
+
+void
+SceneMirror::addView(int groupId, const ui::ShapeModelView & view)
+{
+  addView(groupId, view.meshView);
+  m_viewGroups[view.shapeModelTransformationView.id] = groupId;
+  m_transformations[view.shapeModelTransformationView.id] = view.shapeModelTransformationView;
+}
+
+bool
+SceneMirror::skip(const ui::TriangleMeshView & view)
+{
+  const bool current = isCurrent(m_meshViews, view);
+  m_skippedUpdates += current;
+  return current;
+}
+
+bool
+SceneMirror::skip(const ui::ImageView & view)
+{
+  const bool current = isCurrent(m_imageViews, view);
+  m_skippedUpdates += current;
+  return current;
+}
+
+bool
+SceneMirror::skip(const ui::ShapeModelTransformationView & view)
+{
+  const bool current = isCurrent(m_transformations, view);
+  m_skippedUpdates += current;
+  return current;
+}
+
+void
+SceneMirror::sent(const ui::TriangleMeshView & view)
+{
+  m_meshViews[view.id] = view;
+}
+
+void
+SceneMirror::sent(const ui::ImageView & view)
+{
+  m_imageViews[view.id] = view;
+}
+
+void
+SceneMirror::sent(const ui::ShapeModelTransformationView & view)
+{
+  m_transformations[view.id] = view;
+}
+
+void
+SceneMirror::invalidate(int viewId)
+{
+  // ids are unique over all kinds of views
+  m_meshViews.erase(viewId);
+  m_imageViews.erase(viewId);
+  m_transformations.erase(viewId);
+}
+
+void
+SceneMirror::removeView(int viewId)
+{
+  invalidate(viewId);
+  m_viewGroups.erase(viewId);
+}
+
+std::vector<int>
+SceneMirror::GetGroupViews(int groupId) const
+{
+  std::vector<int> ids;
+  for (const auto & view : m_viewGroups)
+  {
+    if (view.second == groupId)
+    {
+      ids.push_back(view.first);
+    }
+  }
+  return ids;
+}
+
+std::vector<int>
+SceneMirror::removeGroup(int groupId)
+{
+  std::vector<int> ids;
+  for (auto view = m_viewGroups.begin(); view != m_viewGroups.end();)
+  {
+    if (view->second == groupId)
+    {
+      ids.push_back(view->first);
+      invalidate(view->first);
+      view = m_viewGroups.erase(view);
+    }
+    else
+    {
+      ++view;
+    }
+  }
+  return ids;
+}
+
+} // namespace StatismoUI
@@ -0,0 +1,75 @@
+#ifndef UI_SCENEMIRROR_H
+#define UI_SCENEMIRROR_H
+
+#include "thrift/UI.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace StatismoUI
+{
+// What a client last sent to the service about its scene: the group of each view and the properties of each view,
+// as the thrift struct of its last update or as the service reported it when it was shown. It lets StatismoUI skip
+// updates that would not change anything and forget everything it keeps for the views of a removed group.
+// Views shown by other clients are learnt from their first update, without a group. Not thread-safe.
+class SceneMirror
+{
+public:
+  // A view the service created in a group
+  void
+  addView(int groupId, const ui::TriangleMeshView & view);
+  void
+  addView(int groupId, const ui::ImageView & view);
+  // The mesh view and the transformation view of the model
+  void
+  addView(int groupId, const ui::ShapeModelView & view);
+
+  // Whether the view equals its last known state, the update is counted as skipped then
+  bool
+  skip(const ui::TriangleMeshView & view);
+  bool
+  skip(const ui::ImageView & view);
+  bool
+  skip(const ui::ShapeModelTransformationView & view);
+
+  // Records the view as sent
+  void
+  sent(const ui::TriangleMeshView & view);
+  void
+  sent(const ui::ImageView & view);
+  void
+  sent(const ui::ShapeModelTransformationView & view);
+
+  // Forgets the state of a view that was changed behind the mirror, its next update is sent
+  void
+  invalidate(int viewId);
+
+  void
+  removeView(int viewId);
+
+  // The ids of the views of the group
+  std::vector<int>
+  GetGroupViews(int groupId) const;
+
+  // Removes the group and its views and returns the ids of the views
+  std::vector<int>
+  removeGroup(int groupId);
+
+  std::uint64_t
+  GetNumberOfSkippedUpdates() const
+  {
+    return m_skippedUpdates;
+  }
+
+private:
+  std::map<int, int>                              m_viewGroups;
+  std::map<int, ui::TriangleMeshView>             m_meshViews;
+  std::map<int, ui::ImageView>                    m_imageViews;
+  std::map<int, ui::ShapeModelTransformationView> m_transformations;
+  std::uint64_t                                   m_skippedUpdates{ 0 };
+};
+
+} // namespace StatismoUI
+
+#endif // UI_SCENEMIRROR_H
@@ -0,0 +1,225 @@
+#include "ServerConnection.h"
+#include "ClientMetrics.h"
+#include "CompressedFramedTransport.h"
+#include "RecordingUI.h"
+#include "ResilientUI.h"
+
+#ifdef STATISMO_UI_USE_THRIFTZ
+#  include <thrift/transport/TZlibTransport.h>
+#endif
+
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace StatismoUI
+{
+
+namespace
+{
+std::string
+poolKey(const ConnectionOptions & options)
+{
+  std::ostringstream key;
+  key << options.host << ':' << options.port << '/' << static_cast<int>(options.protocol) << '/'
+      << static_cast<int>(options.transport) << '/' << options.compressionThreshold << '/' << options.compressionLevel
+      << '/' << options.connectTimeoutMs << '/' << options.sendTimeoutMs << '/' << options.receiveTimeoutMs << '/'
+      << options.collectMetrics << '/' << options.reconnect.enabled << '/' << options.reconnect.initialBackoffMs << '/'
+      << options.reconnect.maxBackoffMs << '/' << options.reconnect.maxPendingOperations << '/'
+      << options.reconnect.restoreScene << '/' << options.recordPath;
+  return key.str();
+}
+
+std::shared_ptr<apache::thrift::transport::TSocket>
+makeSocket(const ConnectionOptions & options)
+{
+  auto socket = std::make_shared<apache::thrift::transport::TSocket>(options.host, options.port);
+  socket->setConnTimeout(options.connectTimeoutMs);
+  socket->setSendTimeout(options.sendTimeoutMs);
+  socket->setRecvTimeout(options.receiveTimeoutMs);
+  return socket;
+}
+
+// With metrics, wire bytes are counted right above the socket and message boundaries right below the client
+std::shared_ptr<apache::thrift::transport::TTransport>
+makeClientTransport(const ConnectionOptions &                           options,
+                    std::shared_ptr<apache::thrift::transport::TSocket> socket,
+                    const std::shared_ptr<ClientMetrics> &              metrics)
+{
+  if (!metrics)
+  {
+    return makeTransport(options, socket);
+  }
+  return makeTransport(options,
+                       std::make_shared<CountingTransport>(socket,
+                                                           metrics->GetTransferCounters(),
+                                                           [metrics = metrics.get()] { metrics->messageFlushed(); }));
+}
+
+std::shared_ptr<apache::thrift::protocol::TProtocol>
+makeClientProtocol(const ConnectionOptions &                              options,
+                   std::shared_ptr<apache::thrift::transport::TTransport> transport,
+                   const std::shared_ptr<ClientMetrics> &                 metrics)
+{
+  if (!metrics)
+  {
+    return makeProtocol(options, transport);
+  }
+  return std::make_shared<InstrumentedProtocol>(makeProtocol(options, transport), metrics);
+}
+
+// A new transport stack on a new socket, opened
+std::unique_ptr<ui::UIClient>
+openClient(const ConnectionOptions & options, const std::shared_ptr<ClientMetrics> & metrics)
+{
+  if (metrics)
+  {
+    // the replies of a broken connection will never be read
+    metrics->abandonCalls();
+  }
+  auto transport = makeClientTransport(options, makeSocket(options), metrics);
+  auto client = std::make_unique<ui::UIClient>(makeClientProtocol(options, transport, metrics));
+  transport->open();
+  return client;
+}
+} // namespace
+
+std::shared_ptr<apache::thrift::transport::TTransport>
+makeTransport(const ConnectionOptions & options, std::shared_ptr<apache::thrift::transport::TTransport> socket)
+{
+  using namespace apache::thrift::transport;
+
+  switch (options.transport)
+  {
+    case Transport::Framed:
+      return std::make_shared<TFramedTransport>(socket);
+    case Transport::Zlib:
+#ifdef STATISMO_UI_USE_THRIFTZ
+    {
+      auto zlib = std::make_shared<TZlibTransport>(socket,
+                                                   TZlibTransport::DEFAULT_URBUF_SIZE,
+                                                   TZlibTransport::DEFAULT_CRBUF_SIZE,
+                                                   TZlibTransport::DEFAULT_UWBUF_SIZE,
+                                                   TZlibTransport::DEFAULT_CWBUF_SIZE,
+                                                   static_cast<int16_t>(options.compressionLevel));
+      return std::make_shared<TFramedTransport>(zlib);
+    }
+#else
+      throw std::invalid_argument("statismo-ui was built without TZlibTransport (libthriftz)");
+#endif
+    case Transport::CompressedFrames:
+      return std::make_shared<CompressedFramedTransport>(
+        socket, options.compressionThreshold, options.compressionLevel);
+  }
+  throw std::invalid_argument("unknown transport");
+}
+
+std::shared_ptr<apache::thrift::protocol::TProtocol>
+makeProtocol(const ConnectionOptions & options, std::shared_ptr<apache::thrift::transport::TTransport> transport)
+{
+  if (options.protocol == Protocol::Compact)
+  {
+    return std::make_shared<apache::thrift::protocol::TCompactProtocol>(transport);
+  }
+  return std::make_shared<apache::thrift::protocol::TBinaryProtocol>(transport);
+}
+
+std::shared_ptr<ServerConnection>
+ServerConnection::Acquire(const ConnectionOptions & options)
+{
+  if (!options.shared)
+  {
+    return std::make_shared<ServerConnection>(options);
+  }
+
+  static std::mutex                                              poolMutex;
+  static std::map<std::string, std::weak_ptr<ServerConnection>> pool;
+
+  std::lock_guard<std::mutex> lock(poolMutex);
+  for (auto it = pool.begin(); it != pool.end();)
+  {
+    it = it->second.expired() ? pool.erase(it) : std::next(it);
+  }
+
+  std::weak_ptr<ServerConnection> & entry = pool[poolKey(options)];
+  std::shared_ptr<ServerConnection> connection = entry.lock();
+  if (!connection)
+  {
+    connection = std::make_shared<ServerConnection>(options);
+    entry = connection;
+  }
+  return connection;
+}
+
+ServerConnection::ServerConnection(const ConnectionOptions & options)
+  : m_metrics(options.collectMetrics ? std::make_shared<ClientMetrics>() : nullptr)
+{
+  if (!options.recordPath.empty() && !options.reconnect.enabled)
+  {
+    // replays give the objects the ids chosen by the client
+    throw std::invalid_argument("recording a session needs options.reconnect.enabled");
+  }
+
+  if (options.reconnect.enabled)
+  {
+    m_resilient = std::make_unique<ResilientUI>(
+      [options, metrics = m_metrics] { return openClient(options, metrics); }, options.reconnect, m_mutex);
+    m_ui = m_resilient.get();
+  }
+  else
+  {
+    m_client = openClient(options, m_metrics);
+    m_ui = m_client.get();
+  }
+  if (!options.recordPath.empty())
+  {
+    m_recording = std::make_unique<RecordingUI>(*m_ui, options.recordPath);
+    m_ui = m_recording.get();
+  }
+}
+
+ServerConnection::~ServerConnection()
+{
+  if (!m_client)
+  {
+    return;
+  }
+  try
+  {
+    m_client->getOutputProtocol()->getTransport()->close();
+  }
+  catch (...)
+  {
+    // the service may already be gone
+  }
+}
+
+ServerConnection::Locked<ui::UIClient>
+ServerConnection::GetThriftClient()
+{
+  if (!m_client)
+  {
+    throw std::logic_error("a connection that reconnects has no fixed thrift client");
+  }
+  return Locked<ui::UIClient>(m_mutex, *m_client);
+}
+
+ConnectionStatus
+ServerConnection::GetStatus()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_resilient ? m_resilient->GetStatus() : ConnectionStatus();
+}
+
+bool
+ServerConnection::TakeDropped(int viewId)
+{
+  if (!m_resilient)
+  {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_resilient->TakeDropped(viewId);
+}
+
+} // namespace StatismoUI
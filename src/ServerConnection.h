@@ -0,0 +1,113 @@
+#ifndef UI_SERVERCONNECTION_H
+#define UI_SERVERCONNECTION_H
+
+#include "StatismoUI.h"
+#include "thrift/UI.h"
+
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/protocol/TCompactProtocol.h>
+#include <thrift/transport/TSocket.h>
+#include <thrift/transport/TTransportUtils.h>
+
+#include <memory>
+#include <mutex>
+
+// Connection to ui-service.
+namespace StatismoUI
+{
+class ClientMetrics;
+class RecordingUI;
+class ResilientUI;
+
+// Transport stack selected by the options on top of a socket, shared by the client and the mock service
+std::shared_ptr<apache::thrift::transport::TTransport>
+makeTransport(const ConnectionOptions & options, std::shared_ptr<apache::thrift::transport::TTransport> socket);
+
+std::shared_ptr<apache::thrift::protocol::TProtocol>
+makeProtocol(const ConnectionOptions & options, std::shared_ptr<apache::thrift::transport::TTransport> transport);
+
+class ServerConnection
+{
+public:
+  // Exclusive access to the thrift client for the lifetime of the handle,
+  // i.e. for the duration of a single call like GetThriftUI()->createGroup(...)
+  template <typename UI>
+  class Locked
+  {
+  public:
+    Locked(std::mutex & mutex, UI & ui)
+      : m_lock(mutex)
+      , m_ui(ui)
+    {}
+
+    UI *
+    operator->()
+    {
+      return &m_ui;
+    }
+
+    UI &
+    operator*()
+    {
+      return m_ui;
+    }
+
+  private:
+    std::unique_lock<std::mutex> m_lock;
+    UI &                         m_ui;
+  };
+
+  // Returns an open connection for the given options. Unless options.shared is false, the connection is shared
+  // with every other user of the same endpoint and settings. It is closed when its last user releases it.
+  static std::shared_ptr<ServerConnection>
+  Acquire(const ConnectionOptions & options);
+
+  // Opens the connection
+  explicit ServerConnection(const ConnectionOptions & options);
+  ~ServerConnection();
+
+  ServerConnection(const ServerConnection &) = delete;
+  ServerConnection &
+  operator=(const ServerConnection &) = delete;
+
+  // The service, through a ResilientUI if the connection was opened with options.reconnect.enabled and a RecordingUI
+  // with options.recordPath
+  Locked<ui::UIIf>
+  GetThriftUI()
+  {
+    return Locked<ui::UIIf>(m_mutex, *m_ui);
+  }
+
+  // The thrift client itself, to pipeline calls with send_ and recv_. Throws std::logic_error for connections that
+  // reconnect, which have no fixed client.
+  Locked<ui::UIClient>
+  GetThriftClient();
+
+  ConnectionStatus
+  GetStatus();
+
+  // Whether an operation on the view did not reach the service since the last call for it, see
+  // ResilientUI::TakeDropped. Always false for connections that do not reconnect.
+  bool
+  TakeDropped(int viewId);
+
+  // Null if the connection was opened without options.collectMetrics
+  const std::shared_ptr<ClientMetrics> &
+  GetMetrics() const
+  {
+    return m_metrics;
+  }
+
+private:
+  std::mutex                     m_mutex;
+  std::shared_ptr<ClientMetrics> m_metrics;
+  // One of the first two is set, m_ui points to the last one that is set
+  std::unique_ptr<ui::UIClient>  m_client;
+  std::unique_ptr<ResilientUI>   m_resilient;
+  std::unique_ptr<RecordingUI>   m_recording;
+  ui::UIIf *                     m_ui;
+};
+
+} // namespace StatismoUI
+
+#endif // UI_SERVERCONNECTION_H
@@ -0,0 +1,231 @@
+#include "SessionLog.h"
+
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace StatismoUI
+{
+
+namespace
+{
+const char        magic[8] = { 'S', 'U', 'I', 'R', 'E', 'C', 0, 1 };
+const std::size_t headerSize = sizeof(magic) + sizeof(std::uint64_t);
+const std::size_t recordHeaderSize = sizeof(std::uint64_t) + sizeof(std::uint32_t);
+const std::size_t indexEntrySize = 2 * sizeof(std::uint64_t);
+
+// put and get copy integers in host byte order, and the log format is little-endian. Compilers without __BYTE_ORDER__
+// (MSVC) only target little-endian hosts.
+#if defined(__BYTE_ORDER__)
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "session logs need a little-endian host");
+#endif
+
+template <typename T>
+void
+put(std::vector<char> & buffer, T value)
+{
+  const char * bytes = reinterpret_cast<const char *>(&value);
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+T
+get(const char * data)
+{
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+} // namespace
+
+SessionLogWriter::SessionLogWriter(const std::string & path, std::size_t maxBufferedBytes)
+  : m_path(path)
+  , m_maxBufferedBytes(maxBufferedBytes)
+  , m_start(std::chrono::steady_clock::now())
+  , m_log(path, std::ios::binary | std::ios::trunc)
+  , m_index(path + ".index", std::ios::binary | std::ios::trunc)
+  , m_offset(headerSize)
+{
+  if (!m_log || !m_index)
+  {
+    throw std::runtime_error("cannot create the session log " + path);
+  }
+
+  std::vector<char> header(magic, magic + sizeof(magic));
+  put<std::uint64_t>(header,
+                     std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count());
+  m_log.write(header.data(), header.size());
+  m_log.flush();
+  if (!m_log)
+  {
+    throw std::runtime_error("cannot write the session log " + path);
+  }
+  m_thread = std::thread(&SessionLogWriter::run, this);
+}
+
+SessionLogWriter::~SessionLogWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+  }
+  m_appended.notify_one();
+  m_thread.join();
+}
+
+void
+SessionLogWriter::append(const std::uint8_t * message, std::uint32_t size)
+{
+  const std::uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                      std::chrono::steady_clock::now() - m_start)
+                                      .count();
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  // a message larger than the buffer is accepted once the buffer is empty
+  m_written.wait(lock, [this] { return m_failed || m_records.size() < m_maxBufferedBytes; });
+  if (m_failed)
+  {
+    throw std::runtime_error("cannot write the session log " + m_path);
+  }
+
+  put<std::uint64_t>(m_records, nanoseconds);
+  put<std::uint32_t>(m_records, size);
+  m_records.insert(m_records.end(), message, message + size);
+  put<std::uint64_t>(m_indexEntries, m_offset);
+  put<std::uint64_t>(m_indexEntries, nanoseconds);
+  m_offset += recordHeaderSize + size;
+  lock.unlock();
+  m_appended.notify_one();
+}
+
+void
+SessionLogWriter::run()
+{
+  // swapped with the buffers of the appending side, so that both keep their capacity
+  std::vector<char> records;
+  std::vector<char> indexEntries;
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true)
+  {
+    m_appended.wait(lock, [this] { return m_stopped || !m_records.empty(); });
+    if (m_records.empty())
+    {
+      return;
+    }
+    records.swap(m_records);
+    indexEntries.swap(m_indexEntries);
+    lock.unlock();
+    m_written.notify_all();
+
+    // the index never refers to records that are not in the log yet
+    m_log.write(records.data(), records.size());
+    m_log.flush();
+    m_index.write(indexEntries.data(), indexEntries.size());
+    m_index.flush();
+    const bool failed = !m_log || !m_index;
+    records.clear();
+    indexEntries.clear();
+
+    lock.lock();
+    if (failed)
+    {
+      m_failed = true;
+      m_records.clear();
+      m_indexEntries.clear();
+      m_written.notify_all();
+      return;
+    }
+  }
+}
+
+SessionLogReader::SessionLogReader(const std::string & path)
+  : m_log(path)
+{
+  const char * data = m_log.data();
+  if (m_log.size() < headerSize || std::memcmp(data, magic, sizeof(magic)) != 0)
+  {
+    throw std::runtime_error(path + " is not a session log");
+  }
+  m_startTime = get<std::uint64_t>(data + sizeof(magic));
+
+  // the index, as far as its records are complete in the log
+  std::uint64_t offset = headerSize;
+  try
+  {
+    MappedFile        index(path + ".index");
+    const std::size_t numberOfEntries = index.size() / indexEntrySize;
+    m_offsets.reserve(numberOfEntries);
+    m_times.reserve(numberOfEntries);
+    for (std::size_t i = 0; i < numberOfEntries; ++i)
+    {
+      const std::uint64_t entry = get<std::uint64_t>(index.data() + i * indexEntrySize);
+      if (entry != offset || offset + recordHeaderSize > m_log.size())
+      {
+        break;
+      }
+      const std::uint64_t end = offset + recordHeaderSize + get<std::uint32_t>(data + offset + sizeof(std::uint64_t));
+      if (end > m_log.size())
+      {
+        break;
+      }
+      m_offsets.push_back(offset);
+      m_times.push_back(get<std::uint64_t>(index.data() + i * indexEntrySize + sizeof(std::uint64_t)));
+      offset = end;
+    }
+  }
+  catch (const std::runtime_error &)
+  {
+    // no index, the log is scanned
+  }
+
+  // the records the index misses, a record cut short ends the log
+  while (offset + recordHeaderSize <= m_log.size())
+  {
+    const std::uint64_t end = offset + recordHeaderSize + get<std::uint32_t>(data + offset + sizeof(std::uint64_t));
+    if (end > m_log.size())
+    {
+      break;
+    }
+    m_offsets.push_back(offset);
+    m_times.push_back(get<std::uint64_t>(data + offset));
+    offset = end;
+  }
+}
+
+SessionLogReader::Record
+SessionLogReader::operator[](std::size_t i) const
+{
+  const char * record = m_log.data() + m_offsets.at(i);
+  return Record{ m_times[i],
+                 reinterpret_cast<const std::uint8_t *>(record + recordHeaderSize),
+                 get<std::uint32_t>(record + sizeof(std::uint64_t)) };
+}
+
+std::size_t
+SessionLogReader::seek(std::uint64_t nanoseconds) const
+{
+  return std::lower_bound(m_times.begin(), m_times.end(), nanoseconds) - m_times.begin();
+}
+
+std::string
+SessionLogReader::rpcName(const Record & record)
+{
+  using namespace apache::thrift;
+
+  auto buffer = std::make_shared<transport::TMemoryBuffer>(
+    const_cast<std::uint8_t *>(record.message), record.size, transport::TMemoryBuffer::OBSERVE);
+  protocol::TBinaryProtocol protocol(buffer);
+  std::string               name;
+  protocol::TMessageType    type;
+  std::int32_t              seqid;
+  protocol.readMessageBegin(name, type, seqid);
+  return name;
+}
+
+} // namespace StatismoUI
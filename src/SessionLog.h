@@ -0,0 +1,117 @@
+#ifndef UI_SESSIONLOG_H
+#define UI_SESSIONLOG_H
+
+#include "MappedFile.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Session logs: the requests of a client, recorded to be replayed later.
+//
+// A log starts with a header, followed by one record per request in the order of the requests:
+//   header  "SUIREC" 0 1 (8 bytes), start of the recording in nanoseconds since the epoch (u64)
+//   record  nanoseconds since the start (u64), size (u32), the request as a thrift call message (binary protocol)
+// The index file next to the log (path + ".index") holds the offset and the time (u64 each) of every record. All
+// integers are little-endian. Both files are only appended to, a log cut short by a crash is valid up to its last
+// complete record.
+namespace StatismoUI
+{
+
+// Appends records to a log from a background thread. The requests are copied to a buffer, so that recording costs
+// the calling thread a copy of each request and no I/O.
+class SessionLogWriter
+{
+public:
+  // Creates the log and its index, replacing existing files. Callers of append block while more than
+  // maxBufferedBytes are waiting to be written. Throws std::runtime_error if the files cannot be created.
+  explicit SessionLogWriter(const std::string & path, std::size_t maxBufferedBytes = 64 << 20);
+
+  // Writes what is buffered
+  ~SessionLogWriter();
+
+  SessionLogWriter(const SessionLogWriter &) = delete;
+  SessionLogWriter &
+  operator=(const SessionLogWriter &) = delete;
+
+  // Throws std::runtime_error once the log could not be written
+  void
+  append(const std::uint8_t * message, std::uint32_t size);
+
+private:
+  void
+  run();
+
+  const std::string                           m_path;
+  const std::size_t                           m_maxBufferedBytes;
+  const std::chrono::steady_clock::time_point m_start;
+  std::ofstream                               m_log;
+  std::ofstream                               m_index;
+  // Offset of the next record, only touched by append
+  std::uint64_t m_offset;
+
+  std::mutex              m_mutex;
+  std::condition_variable m_written;
+  std::condition_variable m_appended;
+  std::vector<char>       m_records;
+  std::vector<char>       m_indexEntries;
+  bool                    m_failed{ false };
+  bool                    m_stopped{ false };
+  std::thread             m_thread;
+};
+
+// Memory-mapped log, with the offsets of its records
+class SessionLogReader
+{
+public:
+  struct Record
+  {
+    std::uint64_t        nanoseconds;
+    const std::uint8_t * message;
+    std::uint32_t        size;
+  };
+
+  // Uses the index as far as it agrees with the log, and scans the rest of the log. Throws std::runtime_error if the
+  // log cannot be read or is not a session log.
+  explicit SessionLogReader(const std::string & path);
+
+  // Start of the recording in nanoseconds since the epoch
+  std::uint64_t
+  GetStartTime() const
+  {
+    return m_startTime;
+  }
+
+  std::size_t
+  size() const
+  {
+    return m_offsets.size();
+  }
+
+  Record
+  operator[](std::size_t i) const;
+
+  // Index of the first record at or after the time, size() if there is none
+  std::size_t
+  seek(std::uint64_t nanoseconds) const;
+
+  // Name of the RPC of a record
+  static std::string
+  rpcName(const Record & record);
+
+private:
+  MappedFile                 m_log;
+  std::uint64_t              m_startTime;
+  std::vector<std::uint64_t> m_offsets;
+  std::vector<std::uint64_t> m_times;
+};
+
+} // namespace StatismoUI
+
+#endif // UI_SESSIONLOG_H
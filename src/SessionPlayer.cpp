@@ -0,0 +1,109 @@
+#include "SessionPlayer.h"
+#include "ServerConnection.h"
+
+#include <thrift/TApplicationException.h>
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace StatismoUI
+{
+
+namespace
+{
+ConnectionOptions
+playerOptions(ConnectionOptions options)
+{
+  options.shared = false;
+  options.reconnect.enabled = true;
+  options.recordPath.clear();
+  return options;
+}
+} // namespace
+
+SessionPlayer::SessionPlayer(const std::string & path, ConnectionOptions options)
+  : m_log(path)
+  , m_connection(ServerConnection::Acquire(playerOptions(std::move(options))))
+{
+  // the processor decodes the requests and calls the ResilientUI, with the connection locked by send
+  ui::UIIf * handler = &*m_connection->GetThriftUI();
+  m_processor = std::make_unique<ui::UIProcessor>(std::shared_ptr<ui::UIIf>(handler, [](ui::UIIf *) {}));
+}
+
+SessionPlayer::~SessionPlayer() = default;
+
+ConnectionStatus
+SessionPlayer::GetConnectionStatus() const
+{
+  return m_connection->GetStatus();
+}
+
+void
+SessionPlayer::play(std::uint64_t from, std::uint64_t to, double speed)
+{
+  if (from > to || speed < 0)
+  {
+    throw std::invalid_argument("cannot play from " + std::to_string(from) + " to " + std::to_string(to) +
+                                " ns at speed " + std::to_string(speed));
+  }
+  const std::size_t begin = m_log.seek(from);
+  const std::size_t end = m_log.seek(to);
+  if (m_next > begin)
+  {
+    throw std::invalid_argument("cannot seek back to " + std::to_string(from) + " ns, the requests up to " +
+                                std::to_string(m_log[m_next - 1].nanoseconds) + " ns were played");
+  }
+
+  for (; m_next < begin; ++m_next)
+  {
+    send(m_next);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  for (; m_next < end; ++m_next)
+  {
+    if (speed > 0)
+    {
+      const double delay = (m_log[m_next].nanoseconds - from) / speed;
+      std::this_thread::sleep_until(start + std::chrono::nanoseconds(static_cast<std::int64_t>(delay)));
+    }
+    send(m_next);
+  }
+}
+
+void
+SessionPlayer::send(std::size_t index)
+{
+  using namespace apache::thrift;
+
+  const SessionLogReader::Record record = m_log[index];
+  auto request = std::make_shared<transport::TMemoryBuffer>(
+    const_cast<std::uint8_t *>(record.message), record.size, transport::TMemoryBuffer::OBSERVE);
+  auto reply = std::make_shared<transport::TMemoryBuffer>();
+  auto replyProtocol = std::make_shared<protocol::TBinaryProtocol>(reply);
+  {
+    auto ui = m_connection->GetThriftUI();
+    m_processor->process(std::make_shared<protocol::TBinaryProtocol>(request), replyProtocol, nullptr);
+  }
+
+  // errors that are not declared by the RPC come back as exceptions, oneway requests have no reply
+  if (reply->available_read() == 0)
+  {
+    return;
+  }
+  std::string            name;
+  protocol::TMessageType type;
+  std::int32_t           seqid;
+  replyProtocol->readMessageBegin(name, type, seqid);
+  if (type == protocol::T_EXCEPTION)
+  {
+    TApplicationException error;
+    error.read(replyProtocol.get());
+    m_failures.push_back(std::to_string(index) + " " + name + ": " + error.what());
+  }
+}
+
+} // namespace StatismoUI
@@ -0,0 +1,75 @@
+#ifndef UI_SESSIONPLAYER_H
+#define UI_SESSIONPLAYER_H
+
+#include "SessionLog.h"
+#include "StatismoUI.h"
+#include "thrift/UI.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Replay of session logs, part of the statismo_ui_mock library for the tools.
+namespace StatismoUI
+{
+class ServerConnection;
+
+// Sends the requests of a session log to ui-service. They go through a ResilientUI, like when they were recorded, so
+// that every object gets the id it had then.
+class SessionPlayer
+{
+public:
+  // Opens the log and connects with the options, reconnect enabled and without recording
+  SessionPlayer(const std::string & path, ConnectionOptions options);
+  ~SessionPlayer();
+
+  SessionPlayer(const SessionPlayer &) = delete;
+  SessionPlayer &
+  operator=(const SessionPlayer &) = delete;
+
+  const SessionLogReader &
+  GetLog() const
+  {
+    return m_log;
+  }
+
+  // Plays the requests recorded between from and to (nanoseconds since the start of the recording), spaced as they
+  // were recorded divided by speed, or as fast as possible if speed is 0. The requests before from that were not
+  // played yet are sent first without waiting, so that playing starts from the scene recorded at from. Throws
+  // std::invalid_argument to seek before requests already played.
+  void
+  play(std::uint64_t from = 0, std::uint64_t to = std::numeric_limits<std::uint64_t>::max(), double speed = 1.0);
+
+  // Index of the next request to play
+  std::size_t
+  GetPosition() const
+  {
+    return m_next;
+  }
+
+  // The requests rejected by the service, as "index name: message"
+  const std::vector<std::string> &
+  GetFailures() const
+  {
+    return m_failures;
+  }
+
+  ConnectionStatus
+  GetConnectionStatus() const;
+
+private:
+  void
+  send(std::size_t index);
+
+  SessionLogReader                  m_log;
+  std::shared_ptr<ServerConnection> m_connection;
+  std::unique_ptr<ui::UIProcessor>  m_processor;
+  std::size_t                       m_next{ 0 };
+  std::vector<std::string>          m_failures;
+};
+
+} // namespace StatismoUI
+
+#endif // UI_SESSIONPLAYER_H
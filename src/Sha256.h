@@ -0,0 +1,41 @@
+#ifndef UI_SHA256_H
+#define UI_SHA256_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace StatismoUI
+{
+// Incremental SHA-256 (FIPS 180-4), used to identify model contents.
+class Sha256
+{
+public:
+  Sha256();
+
+  void
+  update(const void * data, std::size_t size);
+
+  template <typename T>
+  void
+  updateValue(const T & value)
+  {
+    update(&value, sizeof(T));
+  }
+
+  // Finalizes the hash. The object must not be updated afterwards.
+  std::string
+  hexDigest();
+
+private:
+  void
+  processBlock(const std::uint8_t * block);
+
+  std::uint32_t m_state[8];
+  std::uint8_t  m_buffer[64];
+  std::size_t   m_bufferSize{ 0 };
+  std::uint64_t m_length{ 0 };
+};
+} // namespace StatismoUI
+
+#endif // UI_SHA256_H
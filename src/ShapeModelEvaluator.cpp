@@ -0,0 +1,361 @@
+#include "ShapeModelEvaluator.h"
+
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace StatismoUI
+{
+
+namespace
+{
+using MeshType = itk::Mesh<float, 3>;
+
+// Floats of the basis per block, so that a block stays in the L2 cache while it is applied to a batch
+constexpr std::size_t basisBlockFloats = 32 * 1024;
+// Instances a block is applied to at once, each float of the basis loaded is used that many times
+constexpr std::size_t samplesPerPass = 4;
+// Fewer multiply-adds are not worth a thread
+constexpr std::size_t minMultiplyAddsPerThread = 1 << 20;
+
+// Rows of the blocks for a basis of that many columns: whole points, and a multiple of 16 floats for the vector loops
+std::size_t
+rowsPerBlock(std::size_t numberOfColumns)
+{
+  const std::size_t rows = std::min<std::size_t>(4096, basisBlockFloats / std::max<std::size_t>(1, numberOfColumns));
+  return std::max<std::size_t>(48, rows / 48 * 48);
+}
+
+// U * diag(sqrt(variances)), column by column
+std::vector<float>
+scaledBasis(const vnl_matrix<float> & basis, const vnl_vector<float> & variances)
+{
+  const std::size_t  rows = basis.rows();
+  std::vector<float> scaled(rows * basis.cols());
+  for (std::size_t j = 0; j < basis.cols(); ++j)
+  {
+    const float sigma = std::sqrt(std::max(0.0f, variances[j]));
+    for (std::size_t r = 0; r < rows; ++r)
+    {
+      scaled[j * rows + r] = basis(r, j) * sigma;
+    }
+  }
+  return scaled;
+}
+
+// A mesh without points that owns copies of the cells of the reference
+MeshType::Pointer
+copyTopology(const MeshType * reference)
+{
+  auto topology = MeshType::New();
+  for (MeshType::CellIdentifier i = 0; i < reference->GetNumberOfCells(); ++i)
+  {
+    MeshType::CellAutoPointer cell;
+    reference->GetCells()->GetElement(i)->MakeCopy(cell);
+    topology->SetCell(i, cell);
+  }
+  return topology;
+}
+
+// The 3 x 3 matrix, row by row, and the offset of the pose of a view
+std::array<float, 12>
+poseMatrix(const PoseTransformation & pose)
+{
+  using TransformType = itk::Euler3DTransform<float>;
+
+  auto transform = TransformType::New();
+  transform->SetCenter(pose.GetCenter());
+  transform->SetRotation(pose.GetAngleX(), pose.GetAngleY(), pose.GetAngleZ());
+  const vnl_vector<float>         t = pose.GetTranslation();
+  TransformType::OutputVectorType translation;
+  for (unsigned i = 0; i < 3; ++i)
+  {
+    translation[i] = t[i];
+  }
+  transform->SetTranslation(translation);
+
+  std::array<float, 12> matrix;
+  for (unsigned i = 0; i < 3; ++i)
+  {
+    for (unsigned j = 0; j < 3; ++j)
+    {
+      matrix[3 * i + j] = transform->GetMatrix()(i, j);
+    }
+    matrix[9 + i] = transform->GetOffset()[i];
+  }
+  return matrix;
+}
+
+// y[s][r] += alpha[s][j] * basis[j * stride + r] for the S instances s, the rows r and the columns j. The columns are
+// the outer loop, so that each instance is updated with a vectorized multiply-add over the rows.
+template <std::size_t S>
+void
+accumulate(const float *         basis,
+           std::size_t           stride,
+           std::size_t           rows,
+           std::size_t           numberOfColumns,
+           const float * const * alpha,
+           float * const *       y)
+{
+  float * out[S];
+  std::copy(y, y + S, out);
+  for (std::size_t j = 0; j < numberOfColumns; ++j)
+  {
+    const float * column = basis + j * stride;
+    float         a[S];
+    for (std::size_t s = 0; s < S; ++s)
+    {
+      a[s] = alpha[s][j];
+    }
+    for (std::size_t r = 0; r < rows; ++r)
+    {
+      const float w = column[r];
+      for (std::size_t s = 0; s < S; ++s)
+      {
+        out[s][r] += a[s] * w;
+      }
+    }
+  }
+}
+
+void
+applyPose(const float * pose, std::size_t rows, float * y)
+{
+  for (std::size_t i = 0; i + 2 < rows; i += 3)
+  {
+    const float x0 = y[i];
+    const float x1 = y[i + 1];
+    const float x2 = y[i + 2];
+    y[i] = pose[0] * x0 + pose[1] * x1 + pose[2] * x2 + pose[9];
+    y[i + 1] = pose[3] * x0 + pose[4] * x1 + pose[5] * x2 + pose[10];
+    y[i + 2] = pose[6] * x0 + pose[7] * x1 + pose[8] * x2 + pose[11];
+  }
+}
+} // namespace
+
+ShapeModelEvaluator::ShapeModelEvaluator(const StatisticalModelType * ssm)
+{
+  // statismo stores the mean as point positions (i.e. ref + df), which is what instances start from
+  const vnl_vector<float> mean = ssm->GetMeanVector();
+  const vnl_matrix<float> basis = ssm->GetOrthonormalPCABasisMatrix();
+  m_numberOfComponents = basis.cols();
+  m_noiseVariance = ssm->GetNoiseVariance();
+  m_mean.assign(mean.begin(), mean.begin() + basis.rows());
+  m_basis = scaledBasis(basis, ssm->GetPCAVarianceVector());
+  m_topology = copyTopology(ssm->GetRepresenter()->GetReference());
+}
+
+ShapeModelEvaluator::ShapeModelEvaluator(const MeshType *          reference,
+                                         const vnl_vector<float> & meanDeformation,
+                                         const vnl_matrix<float> & orthonormalBasis,
+                                         const vnl_vector<float> & variances,
+                                         float                     noiseVariance)
+  : m_noiseVariance(noiseVariance)
+{
+  const std::size_t numberOfRows = 3 * std::size_t(reference->GetNumberOfPoints());
+  if (meanDeformation.size() != numberOfRows || orthonormalBasis.rows() != numberOfRows ||
+      variances.size() != orthonormalBasis.cols())
+  {
+    throw std::invalid_argument("the mean, the basis and the variances do not match the reference");
+  }
+
+  m_numberOfComponents = orthonormalBasis.cols();
+  m_mean.resize(numberOfRows);
+  for (std::size_t i = 0; i < reference->GetNumberOfPoints(); ++i)
+  {
+    const MeshType::PointType point = reference->GetPoint(i);
+    for (unsigned d = 0; d < 3; ++d)
+    {
+      m_mean[3 * i + d] = point[d] + meanDeformation[3 * i + d];
+    }
+  }
+  m_basis = scaledBasis(orthonormalBasis, variances);
+  m_topology = copyTopology(reference);
+}
+
+void
+ShapeModelEvaluator::evaluate(const vnl_vector<float> & coefficients, float * points) const
+{
+  evaluate(coefficients.data_block(), 1, coefficients.size(), nullptr, points);
+}
+
+void
+ShapeModelEvaluator::evaluate(const ShapeModelTransformationView & smtv, float * points) const
+{
+  const vnl_vector<float>     coefficients = smtv.GetShapeTransformation().GetCoefficients();
+  const std::array<float, 12> pose = poseMatrix(smtv.GetPoseTransformation());
+  evaluate(coefficients.data_block(), 1, coefficients.size(), pose.data(), points);
+}
+
+std::vector<float>
+ShapeModelEvaluator::evaluate(const ShapeModelTransformationView & smtv) const
+{
+  std::vector<float> points(m_mean.size());
+  evaluate(smtv, points.data());
+  return points;
+}
+
+ShapeModelEvaluator::MeshType::Pointer
+ShapeModelEvaluator::instance(const ShapeModelTransformationView & smtv) const
+{
+  const std::vector<float> points = evaluate(smtv);
+
+  auto mesh = MeshType::New();
+  auto container = MeshType::PointsContainer::New();
+  container->Reserve(GetNumberOfPoints());
+  for (std::size_t i = 0; i < GetNumberOfPoints(); ++i)
+  {
+    MeshType::PointType & point = container->ElementAt(i);
+    point[0] = points[3 * i];
+    point[1] = points[3 * i + 1];
+    point[2] = points[3 * i + 2];
+  }
+  mesh->SetPoints(container);
+  // the cells are released by the last mesh that holds the container
+  mesh->SetCells(m_topology->GetCells());
+  return mesh;
+}
+
+void
+ShapeModelEvaluator::evaluate(const vnl_matrix<float> & coefficients, float * points) const
+{
+  evaluate(coefficients.data_block(), coefficients.rows(), coefficients.cols(), nullptr, points);
+}
+
+void
+ShapeModelEvaluator::evaluate(const float * coefficients,
+                              std::size_t   numberOfSamples,
+                              std::size_t   numberOfCoefficients,
+                              const float * pose,
+                              float *       points) const
+{
+  if (numberOfCoefficients > m_numberOfComponents)
+  {
+    throw std::invalid_argument("the model has only " + std::to_string(m_numberOfComponents) + " components");
+  }
+  const std::size_t numberOfRows = m_mean.size();
+  if (numberOfSamples == 0 || numberOfRows == 0)
+  {
+    return;
+  }
+
+  // Tasks are blocks of rows of a slice of the batch. The batch is only sliced when there are fewer blocks than
+  // threads, each slice loads the basis once more.
+  const std::size_t blockRows = rowsPerBlock(numberOfCoefficients);
+  const std::size_t numberOfBlocks = (numberOfRows + blockRows - 1) / blockRows;
+  const std::size_t numberOfSlices =
+    std::min(numberOfSamples, (getNumberOfWorkerThreads() + numberOfBlocks - 1) / numberOfBlocks);
+  const std::size_t samplesPerSlice = (numberOfSamples + numberOfSlices - 1) / numberOfSlices;
+  const std::size_t multiplyAddsPerTask = blockRows * std::max<std::size_t>(1, numberOfCoefficients) * samplesPerSlice;
+
+  auto task = [&](std::size_t t) {
+    const std::size_t firstRow = (t / numberOfSlices) * blockRows;
+    const std::size_t rows = std::min(blockRows, numberOfRows - firstRow);
+    const std::size_t firstSample = (t % numberOfSlices) * samplesPerSlice;
+    const std::size_t endSample = std::min(numberOfSamples, firstSample + samplesPerSlice);
+    const float *     basis = m_basis.data() + firstRow;
+
+    for (std::size_t s = firstSample; s < endSample; s += samplesPerPass)
+    {
+      const std::size_t n = std::min(samplesPerPass, endSample - s);
+      const float *     alpha[samplesPerPass];
+      float *           y[samplesPerPass];
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        alpha[i] = coefficients + (s + i) * numberOfCoefficients;
+        y[i] = points + (s + i) * numberOfRows + firstRow;
+        std::copy(m_mean.begin() + firstRow, m_mean.begin() + firstRow + rows, y[i]);
+      }
+      switch (n)
+      {
+        case 4:
+          accumulate<4>(basis, numberOfRows, rows, numberOfCoefficients, alpha, y);
+          break;
+        case 3:
+          accumulate<3>(basis, numberOfRows, rows, numberOfCoefficients, alpha, y);
+          break;
+        case 2:
+          accumulate<2>(basis, numberOfRows, rows, numberOfCoefficients, alpha, y);
+          break;
+        default:
+          accumulate<1>(basis, numberOfRows, rows, numberOfCoefficients, alpha, y);
+          break;
+      }
+      for (std::size_t i = 0; pose && i < n; ++i)
+      {
+        applyPose(pose, rows, y[i]);
+      }
+    }
+  };
+
+  parallelFor(numberOfBlocks * numberOfSlices,
+              std::max<std::size_t>(1, minMultiplyAddsPerThread / multiplyAddsPerTask),
+              [&task](std::size_t begin, std::size_t end) {
+                for (std::size_t t = begin; t < end; ++t)
+                {
+                  task(t);
+                }
+              });
+}
+
+void
+ShapeModelEvaluator::computeMarginalVariances(float * variances) const
+{
+  const std::size_t numberOfRows = m_mean.size();
+  if (numberOfRows == 0)
+  {
+    return;
+  }
+
+  // Each task sums the squares of the columns over a block of rows, then the 3 sums of each point. The columns are the
+  // outer loop, as in accumulate, so that the basis is read in order and the inner loop is vectorized.
+  const std::size_t blockRows = rowsPerBlock(m_numberOfComponents);
+  const std::size_t numberOfBlocks = (numberOfRows + blockRows - 1) / blockRows;
+  const std::size_t multiplyAddsPerTask = blockRows * std::max<std::size_t>(1, m_numberOfComponents);
+
+  // the sums of the rows, allocated before the loop so that the threads do not allocate
+  std::vector<float> rowSums(numberOfRows);
+
+  auto task = [&](std::size_t t) {
+    const std::size_t firstRow = t * blockRows;
+    const std::size_t rows = std::min(blockRows, numberOfRows - firstRow);
+    float *           sums = rowSums.data() + firstRow;
+    std::fill(sums, sums + rows, m_noiseVariance);
+    for (std::size_t j = 0; j < m_numberOfComponents; ++j)
+    {
+      const float * column = m_basis.data() + j * numberOfRows + firstRow;
+      for (std::size_t r = 0; r < rows; ++r)
+      {
+        sums[r] += column[r] * column[r];
+      }
+    }
+    // blocks hold whole points
+    for (std::size_t r = 0; r + 2 < rows; r += 3)
+    {
+      variances[(firstRow + r) / 3] = sums[r] + sums[r + 1] + sums[r + 2];
+    }
+  };
+
+  parallelFor(numberOfBlocks,
+              std::max<std::size_t>(1, minMultiplyAddsPerThread / multiplyAddsPerTask),
+              [&task](std::size_t begin, std::size_t end) {
+                for (std::size_t t = begin; t < end; ++t)
+                {
+                  task(t);
+                }
+              });
+}
+
+std::vector<float>
+ShapeModelEvaluator::computeMarginalVariances() const
+{
+  std::vector<float> variances(GetNumberOfPoints());
+  computeMarginalVariances(variances.data());
+  return variances;
+}
+
+} // namespace StatismoUI
@@ -0,0 +1,97 @@
+#ifndef UI_SHAPEMODELEVALUATOR_H
+#define UI_SHAPEMODELEVALUATOR_H
+
+#include "StatismoUI.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace StatismoUI
+{
+
+// Computes instances of a shape model on the client, from the data showStatisticalShapeModel sends: the points of
+// an instance are mean + U * diag(sqrt(variances)) * coefficients, with U the orthonormal PCA basis. The scaled basis
+// is kept column-major and multiplied in blocks of rows that stay in cache, with loops the compiler vectorizes.
+// Missing coefficients are 0, as in the viewer. Points are stored x0 y0 z0 x1 y1 z1 ..., 3 * GetNumberOfPoints()
+// floats per instance.
+class ShapeModelEvaluator
+{
+  using MeshType = itk::Mesh<float, 3>;
+  using StatisticalModelType = itk::StatisticalModel<MeshType>;
+
+public:
+  explicit ShapeModelEvaluator(const StatisticalModelType * ssm);
+
+  // A model given by its parts: meanDeformation and orthonormalBasis have 3 rows per point of the reference, the
+  // basis one column per variance. Throws std::invalid_argument if the sizes do not match.
+  ShapeModelEvaluator(const MeshType *          reference,
+                      const vnl_vector<float> & meanDeformation,
+                      const vnl_matrix<float> & orthonormalBasis,
+                      const vnl_vector<float> & variances,
+                      float                     noiseVariance = 0);
+
+  std::size_t
+  GetNumberOfPoints() const
+  {
+    return m_mean.size() / 3;
+  }
+
+  unsigned
+  GetNumberOfComponents() const
+  {
+    return m_numberOfComponents;
+  }
+
+  // The instance for the coefficients. Throws std::invalid_argument if there are more coefficients than components.
+  void
+  evaluate(const vnl_vector<float> & coefficients, float * points) const;
+
+  // The instance a view shows: the instance for its coefficients, rotated by its Euler angles about its center and
+  // translated
+  void
+  evaluate(const ShapeModelTransformationView & smtv, float * points) const;
+
+  std::vector<float>
+  evaluate(const ShapeModelTransformationView & smtv) const;
+
+  // Same as a mesh with the topology of the reference, which the meshes of all instances share
+  MeshType::Pointer
+  instance(const ShapeModelTransformationView & smtv) const;
+
+  // The instances for the rows of coefficients, one after the other, computed as a single matrix product. Each
+  // block of the basis is loaded once for all of them, so that a batch costs little more than writing the points.
+  void
+  evaluate(const vnl_matrix<float> & coefficients, float * points) const;
+
+  // The variance of each point of the model, the trace of its 3 x 3 marginal covariance
+  // U_i * diag(variances) * U_i^T + noise variance * I, with U_i the 3 rows of the basis of the point: the expected
+  // squared distance of the point of an instance from the mean. The squared norms of the rows of the scaled basis
+  // are summed in blocks of points, in parallel, without forming a covariance: O(points * components).
+  // variances holds GetNumberOfPoints() floats. See StatismoUI::updateTriangleMeshScalars to show them.
+  void
+  computeMarginalVariances(float * variances) const;
+
+  std::vector<float>
+  computeMarginalVariances() const;
+
+private:
+  // pose is the 3 x 3 matrix, row by row, and the offset of a rigid transform, or null
+  void
+  evaluate(const float * coefficients,
+           std::size_t   numberOfSamples,
+           std::size_t   numberOfCoefficients,
+           const float * pose,
+           float *       points) const;
+
+  unsigned           m_numberOfComponents;
+  // of each coordinate, only used for the marginal variances
+  float              m_noiseVariance;
+  std::vector<float> m_mean;
+  // U * diag(sqrt(variances)), column by column
+  std::vector<float> m_basis;
+  MeshType::Pointer  m_topology;
+};
+
+} // namespace StatismoUI
+
+#endif // UI_SHAPEMODELEVALUATOR_H
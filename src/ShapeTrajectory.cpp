@@ -0,0 +1,91 @@
+#include "ShapeTrajectory.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace StatismoUI
+{
+
+ShapeTrajectory::ShapeTrajectory(ScalarType scalarType)
+  : m_scalarType(scalarType)
+{
+  if (scalarType != ScalarType::Float32 && scalarType != ScalarType::Float64 && scalarType != ScalarType::Float16)
+  {
+    throw std::invalid_argument("coefficients can only be sent as Float32, Float64 or Float16");
+  }
+}
+
+void
+ShapeTrajectory::addKeyframe(double time, const vnl_vector<float> & coefficients)
+{
+  addCoefficients(time, coefficients, false);
+}
+
+void
+ShapeTrajectory::addKeyframe(double time, const vnl_vector<float> & coefficients, const PoseTransformation & pose)
+{
+  addCoefficients(time, coefficients, true);
+
+  const vnl_vector<float> translation = pose.GetTranslation();
+  const auto              center = pose.GetCenter();
+  m_poses.insert(m_poses.end(),
+                 { center[0],
+                   center[1],
+                   center[2],
+                   pose.GetAngleX(),
+                   pose.GetAngleY(),
+                   pose.GetAngleZ(),
+                   translation[0],
+                   translation[1],
+                   translation[2] });
+}
+
+void
+ShapeTrajectory::addKeyframe(double time, const ShapeModelTransformationView & smtv)
+{
+  addKeyframe(time, smtv.GetShapeTransformation().GetCoefficients(), smtv.GetPoseTransformation());
+}
+
+void
+ShapeTrajectory::reserve(std::size_t numberOfKeyframes)
+{
+  m_times.reserve(numberOfKeyframes);
+  m_coefficients.reserve(numberOfKeyframes * m_numberOfCoefficients);
+}
+
+void
+ShapeTrajectory::clear()
+{
+  m_numberOfCoefficients = 0;
+  m_times.clear();
+  m_coefficients.clear();
+  m_poses.clear();
+}
+
+void
+ShapeTrajectory::addCoefficients(double time, const vnl_vector<float> & coefficients, bool withPose)
+{
+  if (m_times.empty())
+  {
+    m_numberOfCoefficients = coefficients.size();
+  }
+  else if (coefficients.size() != m_numberOfCoefficients)
+  {
+    throw std::invalid_argument("keyframe " + std::to_string(m_times.size()) + " has " +
+                                std::to_string(coefficients.size()) + " coefficients instead of " +
+                                std::to_string(m_numberOfCoefficients));
+  }
+  else if (withPose != HasPoses())
+  {
+    throw std::invalid_argument("either all keyframes or none have a pose");
+  }
+  if (!(time >= 0) || (!m_times.empty() && !(time > m_times.back())))
+  {
+    throw std::invalid_argument("keyframe times must be increasing, from 0 on");
+  }
+
+  m_times.push_back(time);
+  m_coefficients.insert(m_coefficients.end(), coefficients.begin(), coefficients.end());
+}
+
+} // namespace StatismoUI
@@ -0,0 +1,103 @@
+#ifndef UI_SHAPETRAJECTORY_H
+#define UI_SHAPETRAJECTORY_H
+
+#include "StatismoUI.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace StatismoUI
+{
+// Keyframes of the coefficients and the pose of a shape model, e.g. the iterations of a fitting, which
+// StatismoUI::loadShapeTrajectory sends with a single request and the service plays by itself (see
+// TrajectoryPlayback). The service moves the view linearly from one keyframe to the next.
+class ShapeTrajectory
+{
+public:
+  // The coefficients are sent as scalarType: Float32, Float64 or Float16 (half the size, about 3 significant
+  // digits). Throws std::invalid_argument for other types.
+  explicit ShapeTrajectory(ScalarType scalarType = ScalarType::Float32);
+
+  // Appends a keyframe at time seconds from the start. Keyframes come in the order of their times and all have as
+  // many coefficients as the first one, and all or none of them a pose. Throws std::invalid_argument otherwise.
+  void
+  addKeyframe(double time, const vnl_vector<float> & coefficients);
+
+  void
+  addKeyframe(double time, const vnl_vector<float> & coefficients, const PoseTransformation & pose);
+
+  // The coefficients and the pose of the view
+  void
+  addKeyframe(double time, const ShapeModelTransformationView & smtv);
+
+  void
+  reserve(std::size_t numberOfKeyframes);
+
+  void
+  clear();
+
+  std::size_t
+  GetNumberOfKeyframes() const
+  {
+    return m_times.size();
+  }
+
+  std::size_t
+  GetNumberOfCoefficients() const
+  {
+    return m_numberOfCoefficients;
+  }
+
+  bool
+  HasPoses() const
+  {
+    return !m_poses.empty();
+  }
+
+  ScalarType
+  GetScalarType() const
+  {
+    return m_scalarType;
+  }
+
+  // Time of the last keyframe, 0 without keyframes
+  double
+  GetDuration() const
+  {
+    return m_times.empty() ? 0 : m_times.back();
+  }
+
+  const std::vector<double> &
+  GetTimes() const
+  {
+    return m_times;
+  }
+
+  // GetNumberOfCoefficients() per keyframe, keyframe after keyframe
+  const std::vector<float> &
+  GetCoefficients() const
+  {
+    return m_coefficients;
+  }
+
+  // 9 per keyframe if HasPoses(): the center, the Euler angles and the translation of the pose
+  const std::vector<double> &
+  GetPoses() const
+  {
+    return m_poses;
+  }
+
+private:
+  void
+  addCoefficients(double time, const vnl_vector<float> & coefficients, bool withPose);
+
+  ScalarType          m_scalarType;
+  std::size_t         m_numberOfCoefficients{ 0 };
+  std::vector<double> m_times;
+  std::vector<float>  m_coefficients;
+  std::vector<double> m_poses;
+};
+
+} // namespace StatismoUI
+
+#endif // UI_SHAPETRAJECTORY_H
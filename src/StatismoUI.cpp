@@ -1,463 +1,1210 @@
 #include "StatismoUI.h"
-#include "thrift/UI.h"
-
-#include <thrift/protocol/TBinaryProtocol.h>
-#include <thrift/protocol/TCompactProtocol.h>
-#include <thrift/transport/TSocket.h>
-#include <thrift/transport/TTransportUtils.h>
-
+#include "ClientMetrics.h"
+#include "FileSources.h"
+#include "ImagePyramid.h"
+#include "MappedFile.h"
+#include "SceneBatch.h"
+#include "SceneMirror.h"
+#include "ServerConnection.h"
+#include "ShapeTrajectory.h"
+#include "ThriftConversions.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 namespace StatismoUI
 {
 
-class ServerConnection
+// Sends the queued transformation updates from a background thread. Only the latest
+// update per view id is kept, and batches are sent at most maxUpdatesPerSecond times per second.
+class ShapeModelTransformationStream
 {
 public:
+  ShapeModelTransformationStream(std::shared_ptr<ServerConnection> connection, double maxUpdatesPerSecond)
+    : m_connection(std::move(connection))
+    , m_interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / maxUpdatesPerSecond)))
+    , m_thread(&ShapeModelTransformationStream::run, this)
+  {}
+
+  ~ShapeModelTransformationStream() { stop(); }
+
   void
-  open()
+  push(const ShapeModelTransformationView & smv)
   {
-    m_transport->open();
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_pending.insert_or_assign(smv.GetId(), smv);
+    }
+    m_condition.notify_one();
   }
+
+  // Sends what is still pending and terminates the sending thread
   void
-  close()
+  stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopped = true;
+    }
+    m_condition.notify_one();
+    if (m_thread.joinable())
+    {
+      m_thread.join();
+    }
+  }
+
+  // Last error encountered by the sending thread, if any
+  std::exception_ptr
+  takeError()
   {
-    m_transport->close();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::exception_ptr          error = m_error;
+    m_error = nullptr;
+    return error;
   }
 
-  ui::UIClient &
-  GetThriftUI()
+private:
+  void
+  run()
   {
-    return m_ui;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+      m_condition.wait(lock, [this] { return m_stopped || !m_pending.empty(); });
+      if (m_pending.empty())
+      {
+        return;
+      }
+
+      std::map<int, ShapeModelTransformationView> batch;
+      batch.swap(m_pending);
+      lock.unlock();
+
+      auto nextSend = std::chrono::steady_clock::now() + m_interval;
+      send(batch);
+
+      lock.lock();
+      m_condition.wait_until(lock, nextSend, [this] { return m_stopped; });
+    }
   }
 
-  ServerConnection()
-    : m_socket(std::make_shared<apache::thrift::transport::TSocket>("localhost", 8000))
-    , m_transport(std::make_shared<apache::thrift::transport::TFramedTransport>(m_socket))
-    , m_protocol(std::make_shared<apache::thrift::protocol::TBinaryProtocol>(m_transport))
-    , m_ui(m_protocol)
+  void
+  send(const std::map<int, ShapeModelTransformationView> & batch)
+  {
+    std::vector<ui::ShapeModelTransformationView> smtvs;
+    smtvs.reserve(batch.size());
+    for (const auto & entry : batch)
+    {
+      smtvs.push_back(conversions::shapeModelTransformationViewToThrift(entry.second));
+    }
+
+    try
+    {
+      m_connection->GetThriftUI()->updateShapeModelTransformations(smtvs);
+    }
+    catch (...)
+    {
+      // the fitting thread must not be disturbed by the viewer: the batch is dropped
+      // and the error is reported when the stream is stopped
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_error = std::current_exception();
+    }
+  }
+
+  std::shared_ptr<ServerConnection>           m_connection;
+  std::chrono::steady_clock::duration         m_interval;
+  std::map<int, ShapeModelTransformationView> m_pending;
+  bool                                        m_stopped{ false };
+  std::exception_ptr                          m_error;
+  std::mutex                                  m_mutex;
+  std::condition_variable                     m_condition;
+  std::thread                                 m_thread;
+};
+
+// Appends the principal components of a progressively shown model from a background thread,
+// componentsPerChunk components per request. Owns a copy of the basis, the model may be gone meanwhile.
+// Once cancelled, e.g. because the model was removed, no further chunk is sent.
+class ShapeModelComponentUpload
+{
+public:
+  ShapeModelComponentUpload(std::shared_ptr<ServerConnection> connection,
+                            const ui::ShapeModelView &        view,
+                            vnl_matrix<float> &&              pcaBasisMatrix,
+                            vnl_vector<float> &&              variances,
+                            unsigned                          firstComponent,
+                            unsigned                          componentsPerChunk,
+                            ScalarType                        scalarType)
+    : m_connection(std::move(connection))
+    , m_view(view)
+    , m_pcaBasisMatrix(std::move(pcaBasisMatrix))
+    , m_variances(std::move(variances))
+    , m_firstComponent(firstComponent)
+    , m_componentsPerChunk(std::max(1u, componentsPerChunk))
+    , m_scalarType(scalarType)
+    , m_thread(&ShapeModelComponentUpload::run, this)
   {}
 
+  ~ShapeModelComponentUpload() { wait(); }
+
+  void
+  cancel()
+  {
+    m_cancelled = true;
+  }
+
+  int
+  GetMeshViewId() const
+  {
+    return m_view.meshView.id;
+  }
+
+  void
+  wait()
+  {
+    if (m_thread.joinable())
+    {
+      m_thread.join();
+    }
+  }
+
+  bool
+  done() const
+  {
+    return m_done;
+  }
+
+  // Error encountered by the uploading thread, only valid once done
+  std::exception_ptr
+  error() const
+  {
+    return m_error;
+  }
+
 private:
-  static ServerConnection * theinstance;
+  void
+  run()
+  {
+    try
+    {
+      const unsigned rows = m_pcaBasisMatrix.rows();
+      for (unsigned first = m_firstComponent; first < m_pcaBasisMatrix.cols() && !m_cancelled;
+           first += m_componentsPerChunk)
+      {
+        const unsigned    count = std::min(m_componentsPerChunk, m_pcaBasisMatrix.cols() - first);
+        ui::PackedKLBasis components = conversions::klBasisToPackedThrift(
+          m_pcaBasisMatrix.extract(rows, count, 0, first), m_variances.extract(count, first), m_scalarType);
+        m_connection->GetThriftUI()->appendShapeModelComponents(m_view, components);
+      }
+    }
+    catch (...)
+    {
+      // the rest of the model is not sent, the error is reported by waitForShapeModelUploads
+      m_error = std::current_exception();
+    }
+    m_done = true;
+  }
 
-  std::shared_ptr<apache::thrift::transport::TSocket>    m_socket;
-  std::shared_ptr<apache::thrift::transport::TTransport> m_transport;
-  std::shared_ptr<apache::thrift::protocol::TProtocol>   m_protocol;
-  ui::UIClient                                           m_ui;
+  std::shared_ptr<ServerConnection> m_connection;
+  ui::ShapeModelView                m_view;
+  vnl_matrix<float>                 m_pcaBasisMatrix;
+  vnl_vector<float>                 m_variances;
+  unsigned                          m_firstComponent;
+  unsigned                          m_componentsPerChunk;
+  ScalarType                        m_scalarType;
+  std::exception_ptr                m_error;
+  std::atomic<bool>                 m_cancelled{ false };
+  std::atomic<bool>                 m_done{ false };
+  std::thread                       m_thread;
 };
 
-ServerConnection &
-ServerConnectionInstance()
+namespace
+{
+// Number of leading components sent before showProgressiveStatisticalShapeModel returns
+unsigned
+numberOfInitialComponents(const vnl_vector<float> & variances, const ProgressiveUploadOptions & options)
 {
-  static ServerConnection con{};
-  return con;
+  if (options.explainedVariance <= 0)
+  {
+    return std::min<unsigned>(std::max(1u, options.numberOfInitialComponents), variances.size());
+  }
+
+  const double total = variances.sum();
+  double       explained = 0;
+  unsigned     count = 0;
+  while (count < variances.size() && explained < options.explainedVariance * total)
+  {
+    explained += variances[count++];
+  }
+  return std::max(1u, count);
 }
 
+// Regions of an image pyramid larger than this are sent in several requests
+constexpr std::size_t maxImageRegionBytesPerRequest = std::size_t(64) << 20;
 
-StatismoUI::StatismoUI()
+// Images and meshes read from files are sent in requests of at most that many bytes, which bounds the memory the
+// client needs beyond the mapping
+constexpr std::size_t maxFileBytesPerRequest = std::size_t(16) << 20;
+
+// Brings the mirror up to date with the first numberOfOperations operations of a batch the service applied, results
+// are those of the whole batch or empty. Returns the ids of the views removed.
+std::vector<int>
+mirrorSceneBatch(SceneMirror &                                 scene,
+                 const std::vector<ui::SceneOperation> &       operations,
+                 const std::vector<ui::SceneOperationResult> & results,
+                 std::size_t                                   numberOfOperations)
 {
-  ServerConnectionInstance().open();
+  // groups created by the batch are referred to by -(index + 1)
+  auto groupId = [&results](const ui::Group & g) {
+    const std::size_t index = -(g.id + 1);
+    return g.id < 0 && index < results.size() ? results[index].group.id : g.id;
+  };
+
+  std::vector<int> removed;
+  for (std::size_t i = 0; i < numberOfOperations && i < operations.size(); ++i)
+  {
+    const ui::SceneOperation & operation = operations[i];
+    if (operation.__isset.showTriangleMesh && i < results.size())
+    {
+      const TriangleMeshView tmv = conversions::triangleMeshViewFromThriftMeshView(results[i].meshView);
+      scene.addView(groupId(operation.showTriangleMesh.g), conversions::thriftMeshViewFromTriangleMeshView(tmv));
+    }
+    else if (operation.__isset.showImage && i < results.size())
+    {
+      const ImageView imageView = conversions::imageViewFromThriftImageView(results[i].imageView);
+      scene.addView(groupId(operation.showImage.g), conversions::imageViewToThriftImageView(imageView));
+    }
+    else if (operation.__isset.updateTriangleMeshView)
+    {
+      scene.sent(operation.updateTriangleMeshView);
+    }
+    else if (operation.__isset.updateImageView)
+    {
+      scene.sent(operation.updateImageView);
+    }
+    else if (operation.__isset.updateShapeModelTransformation)
+    {
+      scene.sent(operation.updateShapeModelTransformation);
+    }
+    else if (operation.__isset.removeGroup)
+    {
+      const std::vector<int> ids = scene.removeGroup(groupId(operation.removeGroup));
+      removed.insert(removed.end(), ids.begin(), ids.end());
+    }
+    else if (operation.__isset.removeTriangleMesh)
+    {
+      removed.push_back(operation.removeTriangleMesh.id);
+    }
+    else if (operation.__isset.removeImage)
+    {
+      removed.push_back(operation.removeImage.id);
+    }
+  }
+  return removed;
 }
+} // namespace
+
+
+StatismoUI::StatismoUI(const ConnectionOptions & options)
+  : m_connection(ServerConnection::Acquire(options))
+  , m_scene(std::make_unique<SceneMirror>())
+  , m_skipUnchangedUpdates(options.skipUnchangedUpdates)
+{}
 
 StatismoUI::~StatismoUI()
 {
-  ServerConnectionInstance().close();
+  m_metricsDump.reset();
+  m_transformationStream.reset();
+  // waitForShapeModelUploads finishes the uploads, the others stop after the chunk they are sending
+  for (auto & upload : m_componentUploads)
+  {
+    upload->cancel();
+  }
+  m_componentUploads.clear();
 }
 
 Group
 StatismoUI::createGroup(const std::string & name)
 {
   ui::Group g;
-  ServerConnectionInstance().GetThriftUI().createGroup(g, name);
+  m_connection->GetThriftUI()->createGroup(g, name);
   return Group(g.name, g.id);
 }
 
 TriangleMeshView
 StatismoUI::showTriangleMesh(const Group & group, const MeshType * mesh, const std::string & name)
 {
-  ui::TriangleMesh thriftMesh = meshToThriftMesh(mesh);
+  ui::TriangleMesh thriftMesh = timedEncode([&] { return conversions::meshToThriftMesh(mesh); });
 
   ui::TriangleMeshView tmvThrift;
-  ServerConnectionInstance().GetThriftUI().showTriangleMesh(tmvThrift, groupToThriftGroup(group), thriftMesh, name);
+  m_connection->GetThriftUI()->showTriangleMesh(
+    tmvThrift, conversions::groupToThriftGroup(group), thriftMesh, name);
 
-  TriangleMeshView tmv = triangleMeshViewFromThriftMeshView(tmvThrift);
-  return tmv;
+  return addToScene(group, tmvThrift);
 }
 
-void
-StatismoUI::showPointCloud(const Group & group, const std::list<PointType> points, const std::string & name)
+TriangleMeshView
+StatismoUI::showTriangleMesh(const Group & group, const std::string & path, const std::string & name)
 {
-  ui::PointList pts;
+  const MappedFile     file(path);
+  const MeshFileHeader header = readMeshFileHeader(file, path);
+  // before anything is created on the service
+  checkMeshFileTriangles(file, header, path);
 
-  for (const auto & pt : points)
+  ui::TriangleMeshView tmvThrift;
+  m_connection->GetThriftUI()->createTriangleMesh(tmvThrift,
+                                                  conversions::groupToThriftGroup(group),
+                                                  static_cast<std::int32_t>(header.numberOfVertices),
+                                                  static_cast<std::int32_t>(header.numberOfTriangles),
+                                                  name);
+
+  // vertices first, then the topology, both copied straight from the mapping
+  constexpr std::size_t vertexBytes = 3 * sizeof(float);
+  constexpr std::size_t verticesPerRequest = maxFileBytesPerRequest / vertexBytes;
+  constexpr std::size_t triangleBytes = 3 * sizeof(std::int32_t);
+  constexpr std::size_t trianglesPerRequest = maxFileBytesPerRequest / triangleBytes;
+  ui::PackedMeshChunk   chunk;
+  for (std::size_t first = 0; first < header.numberOfVertices; first += verticesPerRequest)
+  {
+    const std::size_t offset = header.verticesOffset + first * vertexBytes;
+    const std::size_t bytes = std::min(verticesPerRequest, header.numberOfVertices - first) * vertexBytes;
+    chunk.firstVertex = static_cast<std::int32_t>(first);
+    chunk.vertices.assign(file.data() + offset, bytes);
+    chunk.firstTriangle = 0;
+    chunk.topology.clear();
+    m_connection->GetThriftUI()->writeTriangleMeshChunk(tmvThrift, chunk);
+    file.release(offset, bytes);
+  }
+  for (std::size_t first = 0; first < header.numberOfTriangles; first += trianglesPerRequest)
   {
-    ui::Point3D         p;
-    p.x = pt.GetElement(0);
-    p.y = pt.GetElement(1);
-    p.z = pt.GetElement(2);
-    pts.push_back(p);
+    const std::size_t offset = header.topologyOffset + first * triangleBytes;
+    const std::size_t bytes = std::min(trianglesPerRequest, header.numberOfTriangles - first) * triangleBytes;
+    chunk.firstVertex = 0;
+    chunk.vertices.clear();
+    chunk.firstTriangle = static_cast<std::int32_t>(first);
+    chunk.topology.assign(file.data() + offset, bytes);
+    m_connection->GetThriftUI()->writeTriangleMeshChunk(tmvThrift, chunk);
+    file.release(offset, bytes);
   }
-  ServerConnectionInstance().GetThriftUI().showPointCloud(groupToThriftGroup(group), pts, name);
+
+  return addToScene(group, tmvThrift);
 }
 
-ShapeModelView
-StatismoUI::showStatisticalShapeModel(const Group & group, const StatisticalModelType * ssm, const std::string & name)
+TriangleMeshView
+StatismoUI::showPackedTriangleMesh(const Group &       group,
+                                   const MeshType *    mesh,
+                                   const std::string & name,
+                                   ScalarType          vertexType)
+{
+  ui::PackedTriangleMesh packedMesh =
+    timedEncode([&] { return conversions::meshToPackedThriftMesh(mesh, vertexType); });
+
+  ui::TriangleMeshView tmvThrift;
+  m_connection->GetThriftUI()->showPackedTriangleMesh(
+    tmvThrift, conversions::groupToThriftGroup(group), packedMesh, name);
+
+  return addToScene(group, tmvThrift);
+}
+
+TriangleMeshView
+StatismoUI::showPackedTriangleMesh(const Group & group, const MeshBuffers & mesh, const std::string & name)
+{
+  ui::PackedTriangleMesh packedMesh = timedEncode([&] { return conversions::meshBuffersToPackedThrift(mesh); });
+
+  ui::TriangleMeshView tmvThrift;
+  m_connection->GetThriftUI()->showPackedTriangleMesh(
+    tmvThrift, conversions::groupToThriftGroup(group), packedMesh, name);
+
+  return addToScene(group, tmvThrift);
+}
+
+void
+StatismoUI::showPointCloud(const Group & group, const std::list<PointType> & points, const std::string & name)
 {
-  ui::StatisticalShapeModel model;
-  model.reference = meshToThriftMesh(ssm->GetRepresenter()->GetReference());
+  ui::PointList pts = timedEncode([&] { return conversions::pointsToThriftPointList(points); });
+  m_connection->GetThriftUI()->showPointCloud(conversions::groupToThriftGroup(group), pts, name);
+}
 
-  ui::KLBasis             klBasis;
-  ui::ListOfDoubleVectors eigenVectors;
-  ui::DoubleVector        eigenValues;
-  ui::DoubleVector        meanVector;
+PointCloudView
+StatismoUI::streamPointCloud(const Group &              group,
+                             const PointCloudProducer & producer,
+                             const std::string &        name,
+                             std::size_t                expectedNumberOfPoints,
+                             std::size_t                pointsPerChunk)
+{
+  if (pointsPerChunk == 0)
+  {
+    throw std::invalid_argument("pointsPerChunk must be positive");
+  }
 
-  vnl_matrix<float>    pcaBasisMatrix = ssm->GetOrthonormalPCABasisMatrix();
-  vnl_vector<float>    meanVecStatismo = ssm->GetMeanVector();
-  statismo::VectorType refVec = ssm->GetRepresenter()->SampleToSampleVector(ssm->GetRepresenter()->GetReference());
+  ui::PointCloudView pcvThrift;
+  m_connection->GetThriftUI()->createPointCloud(
+    pcvThrift, conversions::groupToThriftGroup(group), name, expectedNumberOfPoints);
 
-  for (unsigned i = 0; i < pcaBasisMatrix.cols(); ++i)
+  // the chunk and its encoding are reused, their size does not depend on the size of the cloud
+  std::vector<PointType> points(pointsPerChunk);
+  ui::PackedPointChunk   chunk;
+  while (std::size_t numberOfPoints = producer(points.data(), pointsPerChunk))
   {
-    ui::DoubleVector v;
-    for (unsigned j = 0; j < pcaBasisMatrix.rows(); ++j)
+    if (numberOfPoints > pointsPerChunk)
+    {
+      throw std::invalid_argument("the producer wrote more points than requested");
+    }
     {
-      v.push_back(pcaBasisMatrix(j, i));
+      ScopedEncodeTimer timer;
+      conversions::pointsToPackedThrift(points.data(), numberOfPoints, chunk);
     }
-    eigenVectors.push_back(v);
-    eigenValues.push_back(ssm->GetPCAVarianceVector()[i]);
+    m_connection->GetThriftUI()->appendPointCloudPoints(pcvThrift, chunk);
+  }
+  return PointCloudView(pcvThrift.id);
+}
+
+PointCloudView
+StatismoUI::streamPointCloud(const Group &       group,
+                             ScalarType          coordinateType,
+                             const void *        coordinates,
+                             std::size_t         numberOfPoints,
+                             const std::string & name,
+                             std::size_t         pointsPerChunk)
+{
+  if (pointsPerChunk == 0)
+  {
+    throw std::invalid_argument("pointsPerChunk must be positive");
   }
 
+  ui::PointCloudView pcvThrift;
+  m_connection->GetThriftUI()->createPointCloud(
+    pcvThrift, conversions::groupToThriftGroup(group), name, numberOfPoints);
 
-  for (unsigned j = 0; j < pcaBasisMatrix.rows(); j++)
+  // each chunk is copied straight from the caller's array
+  const std::size_t    pointBytes = 3 * conversions::scalarTypeSize(coordinateType);
+  const char *         data = static_cast<const char *>(coordinates);
+  ui::PackedPointChunk chunk;
+  chunk.pointType = conversions::scalarTypeToThrift(coordinateType);
+  for (std::size_t first = 0; first < numberOfPoints; first += pointsPerChunk)
   {
-    // statismo stores the mean not as a vector, but as point positions (i.e. ref + df)
-    // we need to subtract the reference to get df alone
-    meanVector.push_back(meanVecStatismo[j] - refVec[j]);
+    const std::size_t count = std::min(pointsPerChunk, numberOfPoints - first);
+    {
+      ScopedEncodeTimer timer;
+      chunk.numberOfPoints = static_cast<std::int32_t>(count);
+      chunk.points.assign(data + first * pointBytes, count * pointBytes);
+    }
+    m_connection->GetThriftUI()->appendPointCloudPoints(pcvThrift, chunk);
   }
+  return PointCloudView(pcvThrift.id);
+}
 
+ShapeModelView
+StatismoUI::showStatisticalShapeModel(const Group & group, const StatisticalModelType * ssm, const std::string & name)
+{
+  ui::StatisticalShapeModel model = timedEncode([&] { return conversions::statisticalModelToThrift(ssm); });
 
-  klBasis.eigenvalues = eigenValues;
-  klBasis.eigenvectors = eigenVectors;
-  model.klbasis = klBasis;
-  model.mean = meanVector;
-  // ui::ShapeModelTransformationView tv;
   ui::ShapeModelView thriftSSMView;
-  ServerConnectionInstance().GetThriftUI().showStatisticalShapeModel(
-    thriftSSMView, groupToThriftGroup(group), model, name);
+  m_connection->GetThriftUI()->showStatisticalShapeModel(
+    thriftSSMView, conversions::groupToThriftGroup(group), model, name);
 
-  return shapeModelViewFromThrift(thriftSSMView);
+  return addToScene(group, thriftSSMView);
 }
 
-void
-StatismoUI::showLandmark(const Group &            group,
-                         const PointType &        point,
-                         const vnl_matrix<double> cov,
-                         const std::string &      name)
+ShapeModelView
+StatismoUI::showPackedStatisticalShapeModel(const Group &                group,
+                                            const StatisticalModelType * ssm,
+                                            const std::string &          name,
+                                            ScalarType                   scalarType)
 {
-  if (cov.cols() != 3 || cov.rows() != 3)
-  {
-    throw std::invalid_argument(" cov matrix must be 3 x 3");
-  }
-  ui::Landmark landmark;
-  landmark.name = name;
+  ui::PackedStatisticalShapeModel model =
+    timedEncode([&] { return conversions::statisticalModelToPackedThrift(ssm, scalarType); });
 
-  ui::Point3D tpoint;
-  tpoint.x = point.GetElement(0);
-  tpoint.y = point.GetElement(1);
-  tpoint.z = point.GetElement(2);
-
-  landmark.point = tpoint;
+  ui::ShapeModelView thriftSSMView;
+  m_connection->GetThriftUI()->showPackedStatisticalShapeModel(
+    thriftSSMView, conversions::groupToThriftGroup(group), model, name);
 
-  vnl_svd<double>           svd(cov);
-  ui::UncertaintyCovariance tcov;
-  ui::Vector3D              varianceVec;
-  varianceVec.x = svd.W(0);
-  varianceVec.y = svd.W(1);
-  varianceVec.z = svd.W(2);
+  return addToScene(group, thriftSSMView);
+}
 
-  ui::Vector3D pc1;
-  ui::Vector3D pc2;
-  ui::Vector3D pc3;
-  pc1.x = svd.U(0, 0);
-  pc1.y = svd.U(0, 1);
-  pc1.z = svd.U(0, 2);
-  pc2.x = svd.U(1, 0);
-  pc2.y = svd.U(1, 1);
-  pc2.z = svd.U(1, 2);
-  pc3.x = svd.U(2, 0);
-  pc3.y = svd.U(2, 1);
-  pc3.z = svd.U(2, 2);
+ShapeModelView
+StatismoUI::showPackedStatisticalShapeModel(const Group &             group,
+                                            const MeshBuffers &       reference,
+                                            const vnl_vector<float> & meanDeformation,
+                                            const vnl_matrix<float> & orthonormalBasis,
+                                            const vnl_vector<float> & variances,
+                                            const std::string &       name,
+                                            ScalarType                scalarType)
+{
+  ui::PackedStatisticalShapeModel model = timedEncode([&] {
+    return conversions::statisticalModelToPackedThrift(
+      reference, meanDeformation, orthonormalBasis, variances, scalarType);
+  });
 
-  tcov.variances = varianceVec;
-  tcov.principalAxis1 = pc1;
-  tcov.principalAxis2 = pc2;
-  tcov.principalAxis3 = pc3;
+  ui::ShapeModelView thriftSSMView;
+  m_connection->GetThriftUI()->showPackedStatisticalShapeModel(
+    thriftSSMView, conversions::groupToThriftGroup(group), model, name);
 
-  landmark.uncertainty = tcov;
-  ServerConnectionInstance().GetThriftUI().showLandmark(groupToThriftGroup(group), landmark, name);
+  return addToScene(group, thriftSSMView);
 }
 
-ImageView
-StatismoUI::showImage(const Group & group, const ImageType * image, const std::string & name)
+ShapeModelView
+StatismoUI::showRegisteredStatisticalShapeModel(const Group &                group,
+                                                const StatisticalModelType * ssm,
+                                                const std::string &          name,
+                                                ScalarType                   scalarType)
 {
-  ui::Point3D origin;
-  origin.x = image->GetOrigin().GetElement(0);
-  origin.y = image->GetOrigin().GetElement(1);
-  origin.z = image->GetOrigin().GetElement(2);
+  const std::string modelHash = conversions::statisticalModelHash(ssm, scalarType);
+  const ui::Group   thriftGroup = conversions::groupToThriftGroup(group);
 
-  ui::IntVector3D size;
-  size.i = image->GetLargestPossibleRegion().GetSize().GetElement(0);
-  size.j = image->GetLargestPossibleRegion().GetSize().GetElement(1);
-  size.k = image->GetLargestPossibleRegion().GetSize().GetElement(2);
+  ui::ShapeModelView thriftSSMView;
+  try
+  {
+    m_connection->GetThriftUI()->showRegisteredStatisticalShapeModel(thriftSSMView, thriftGroup, modelHash, name);
+  }
+  catch (const ui::UnknownModel &)
+  {
+    ui::PackedStatisticalShapeModel model =
+      timedEncode([&] { return conversions::statisticalModelToPackedThrift(ssm, scalarType); });
+    m_connection->GetThriftUI()->registerStatisticalShapeModel(modelHash, model);
+    m_connection->GetThriftUI()->showRegisteredStatisticalShapeModel(thriftSSMView, thriftGroup, modelHash, name);
+  }
 
-  ui::Vector3D spacing;
-  spacing.x = image->GetSpacing().GetElement(0);
-  spacing.y = image->GetSpacing().GetElement(1);
-  spacing.z = image->GetSpacing().GetElement(2);
+  return addToScene(group, thriftSSMView);
+}
 
-  ui::ImageDomain domain;
-  domain.origin = origin;
-  domain.spacing = spacing;
-  domain.size = size;
+ShapeModelView
+StatismoUI::showProgressiveStatisticalShapeModel(const Group &                    group,
+                                                 const StatisticalModelType *     ssm,
+                                                 const std::string &              name,
+                                                 const ProgressiveUploadOptions & options)
+{
+  vnl_matrix<float> pcaBasisMatrix = ssm->GetOrthonormalPCABasisMatrix();
+  vnl_vector<float> variances = ssm->GetPCAVarianceVector();
+  const unsigned    initialComponents = numberOfInitialComponents(variances, options);
+
+  ui::PackedStatisticalShapeModel model = timedEncode([&] {
+    return conversions::statisticalModelToPackedThrift(ssm, pcaBasisMatrix, initialComponents, options.scalarType);
+  });
+
+  ui::ShapeModelView thriftSSMView;
+  m_connection->GetThriftUI()->showPackedStatisticalShapeModel(
+    thriftSSMView, conversions::groupToThriftGroup(group), model, name);
 
-  ui::ImageData                         data;
-  ImageType::PixelContainerConstPointer pixelContainer = image->GetPixelContainer();
-  for (unsigned i = 0; i < pixelContainer->Size(); ++i)
+  if (initialComponents < pcaBasisMatrix.cols())
   {
-    data.push_back((*pixelContainer)[i]);
+    // finished uploads are kept only to report their error, each one holds a copy of a basis
+    m_componentUploads.erase(std::remove_if(m_componentUploads.begin(),
+                                            m_componentUploads.end(),
+                                            [](const std::unique_ptr<ShapeModelComponentUpload> & upload) {
+                                              return upload->done() && !upload->error();
+                                            }),
+                             m_componentUploads.end());
+    m_componentUploads.push_back(std::make_unique<ShapeModelComponentUpload>(m_connection,
+                                                                             thriftSSMView,
+                                                                             std::move(pcaBasisMatrix),
+                                                                             std::move(variances),
+                                                                             initialComponents,
+                                                                             options.componentsPerChunk,
+                                                                             options.scalarType));
   }
 
-  ui::Image thriftImage;
-  thriftImage.data = data;
-  thriftImage.domain = domain;
+  return addToScene(group, thriftSSMView);
+}
 
-  ui::ImageView thriftImageView;
-  ServerConnectionInstance().GetThriftUI().showImage(thriftImageView, groupToThriftGroup(group), thriftImage, name);
+void
+StatismoUI::waitForShapeModelUploads()
+{
+  std::vector<std::unique_ptr<ShapeModelComponentUpload>> uploads;
+  uploads.swap(m_componentUploads);
 
-  ImageView iv(thriftImageView.id, thriftImageView.window, thriftImageView.level, thriftImageView.opacity);
-  return iv;
+  std::exception_ptr error;
+  for (auto & upload : uploads)
+  {
+    upload->wait();
+    if (!error)
+    {
+      error = upload->error();
+    }
+  }
+  if (error)
+  {
+    std::rethrow_exception(error);
+  }
 }
 
 void
-StatismoUI::updateShapeModelTransformationView(const ShapeModelTransformationView & smv)
+StatismoUI::showLandmark(const Group &            group,
+                         const PointType &        point,
+                         const vnl_matrix<double> cov,
+                         const std::string &      name)
 {
-  ServerConnectionInstance().GetThriftUI().updateShapeModelTransformation(shapeModelTransformationViewToThrift(smv));
+  ui::Landmark landmark = timedEncode([&] { return conversions::landmarkToThrift(point, cov, name); });
+  m_connection->GetThriftUI()->showLandmark(conversions::groupToThriftGroup(group), landmark, name);
 }
 
 void
-StatismoUI::updateTriangleMeshView(const TriangleMeshView & tmv)
+StatismoUI::showLandmarks(const Group &                           group,
+                          const std::vector<PointType> &          points,
+                          const std::vector<vnl_matrix<double>> & covariances,
+                          const std::vector<std::string> &        names)
 {
-  ui::TriangleMeshView thriftTmv = thriftMeshViewFromTriangleMeshView(tmv);
-  ServerConnectionInstance().GetThriftUI().updateTriangleMeshView(thriftTmv);
+  std::vector<ui::Landmark> landmarks =
+    timedEncode([&] { return conversions::landmarksToThrift(points, covariances, names); });
+  m_connection->GetThriftUI()->showLandmarks(conversions::groupToThriftGroup(group), landmarks);
 }
 
-ui::Group
-StatismoUI::groupToThriftGroup(const Group & group)
+ImageView
+StatismoUI::showImage(const Group & group, const ImageType * image, const std::string & name)
 {
-  ui::Group thriftGroup;
-  thriftGroup.id = group.GetId();
-  thriftGroup.name = group.GetName().c_str();
-  return thriftGroup;
+  ui::Image thriftImage = timedEncode([&] { return conversions::imageToThrift(image); });
+
+  ui::ImageView thriftImageView;
+  m_connection->GetThriftUI()->showImage(
+    thriftImageView, conversions::groupToThriftGroup(group), thriftImage, name);
+
+  return addToScene(group, thriftImageView);
 }
 
-void
-StatismoUI::updateImageView(const ImageView & imageView)
+ImageView
+StatismoUI::showImage(const Group & group, const std::string & path, const std::string & name)
 {
-  ui::ImageView thriftImageView = imageViewToThriftImageView(imageView);
+  const ImageFileHeader header = readImageFileHeader(path);
+  const MappedFile      file(header.dataPath);
+
+  const std::size_t sliceBytes = header.size[0] * header.size[1] * conversions::scalarTypeSize(header.pixelType);
+  if (file.size() < header.dataOffset + sliceBytes * header.size[2])
+  {
+    throw std::runtime_error(header.dataPath + " is truncated");
+  }
 
+  ui::ImageView thriftImageView;
+  m_connection->GetThriftUI()->createImage(thriftImageView,
+                                           conversions::groupToThriftGroup(group),
+                                           conversions::imageDomainToThrift(header.size, header.origin, header.spacing),
+                                           conversions::scalarTypeToThrift(header.pixelType),
+                                           name);
+
+  const char *      data = file.data() + header.dataOffset;
+  const std::size_t slicesPerRequest =
+    std::max(std::size_t(1), maxFileBytesPerRequest / std::max(std::size_t(1), sliceBytes));
+  for (std::size_t z = 0; z < header.size[2]; z += slicesPerRequest)
+  {
+    const std::size_t numberOfSlices = std::min(slicesPerRequest, header.size[2] - z);
+    ui::PackedImageRegion slab = timedEncode(
+      [&] { return conversions::imageSlicesToThrift(header.size, header.pixelType, data, z, numberOfSlices); });
+    m_connection->GetThriftUI()->updateImageRegion(thriftImageView, slab);
+    file.release(header.dataOffset + z * sliceBytes, numberOfSlices * sliceBytes);
+  }
 
-  ServerConnectionInstance().GetThriftUI().updateImageView(thriftImageView);
+  return addToScene(group, thriftImageView);
 }
 
-TriangleMeshView
-StatismoUI::triangleMeshViewFromThriftMeshView(ui::TriangleMeshView tmvThrift)
+ImageView
+StatismoUI::showPackedImage(const Group &             group,
+                            const itk::ImageBase<3> * image,
+                            ScalarType                pixelType,
+                            const void *              buffer,
+                            std::size_t               numberOfBytes,
+                            const std::string &       name)
 {
-  Color color(tmvThrift.color.r, tmvThrift.color.g, tmvThrift.color.b);
+  ui::PackedImage packedImage =
+    timedEncode([&] { return conversions::packedImageToThrift(image, pixelType, buffer, numberOfBytes); });
 
-  TriangleMeshView tmv(tmvThrift.id, color, tmvThrift.opacity, tmvThrift.lineWidth);
-  return tmv;
+  ui::ImageView thriftImageView;
+  m_connection->GetThriftUI()->showPackedImage(
+    thriftImageView, conversions::groupToThriftGroup(group), packedImage, name);
+
+  return addToScene(group, thriftImageView);
 }
 
-ui::TriangleMeshView
-StatismoUI::thriftMeshViewFromTriangleMeshView(const TriangleMeshView & tmv)
+ImageView
+StatismoUI::showPackedImage(const Group &                      group,
+                            const std::array<std::size_t, 3> & size,
+                            const std::array<double, 3> &      origin,
+                            const std::array<double, 3> &      spacing,
+                            ScalarType                         pixelType,
+                            const void *                       voxels,
+                            const std::string &                name)
 {
-  ui::TriangleMeshView thriftTmv;
-  Color                color = tmv.GetColor();
-  thriftTmv.id = tmv.GetId();
-  thriftTmv.color.r = color.red;
-  thriftTmv.color.g = color.green;
-  thriftTmv.color.b = color.blue;
-  thriftTmv.opacity = tmv.GetOpacity();
-  thriftTmv.lineWidth = tmv.GetLineWidth();
-  return thriftTmv;
+  const std::size_t numberOfBytes = size[0] * size[1] * size[2] * conversions::scalarTypeSize(pixelType);
+  ui::PackedImage   packedImage = timedEncode([&] {
+    return conversions::packedImageToThrift(
+      conversions::imageDomainToThrift(size, origin, spacing), pixelType, voxels, numberOfBytes);
+  });
+
+  ui::ImageView thriftImageView;
+  m_connection->GetThriftUI()->showPackedImage(
+    thriftImageView, conversions::groupToThriftGroup(group), packedImage, name);
+
+  return addToScene(group, thriftImageView);
 }
 
-ShapeModelTransformationView
-StatismoUI::shapeModelTransformationViewFromThrift(const ui::ShapeModelTransformationView & tvthrift)
+ImageView
+StatismoUI::showImagePyramid(const Group &               group,
+                             const itk::ImageBase<3> *   image,
+                             ScalarType                  pixelType,
+                             const void *                buffer,
+                             const std::string &         name,
+                             const ImagePyramidOptions & options)
 {
-  vnl_vector<float> coeffs(tvthrift.shapeTransformation.coefficients.size());
-  for (unsigned i = 0; i < coeffs.size(); ++i)
-  {
-    coeffs[i] = tvthrift.shapeTransformation.coefficients[i];
-  }
+  auto pyramid = timedEncode([&] {
+    return std::make_unique<ImagePyramid>(image, pixelType, buffer, options.coarsestEdge, options.maxNumberOfLevels);
+  });
+  const unsigned  numberOfLevels = pyramid->GetNumberOfLevels();
+  ui::PackedImage coarsestLevel =
+    timedEncode([&] { return conversions::imagePyramidLevelToThrift(*pyramid, numberOfLevels - 1); });
 
-  itk::Euler3DTransform<float>::Pointer        eulerTransform = itk::Euler3DTransform<float>::New();
-  itk::Euler3DTransform<float>::InputPointType center;
-  center.SetElement(0, tvthrift.poseTransformation.rotation.center.x);
-  center.SetElement(1, tvthrift.poseTransformation.rotation.center.y);
-  center.SetElement(2, tvthrift.poseTransformation.rotation.center.z);
+  ui::ImageView thriftImageView;
+  m_connection->GetThriftUI()->showImagePyramid(thriftImageView,
+                                                conversions::groupToThriftGroup(group),
+                                                conversions::imageDomainToThrift(image),
+                                                numberOfLevels,
+                                                coarsestLevel,
+                                                name);
+
+  m_imagePyramids[thriftImageView.id] = std::move(pyramid);
+  return addToScene(group, thriftImageView);
+}
 
-  eulerTransform->SetCenter(center);
-  eulerTransform->SetRotation(tvthrift.poseTransformation.rotation.angleX,
-                              tvthrift.poseTransformation.rotation.angleY,
-                              tvthrift.poseTransformation.rotation.angleZ);
-  itk::Vector<float> v(3);
-  v.SetElement(0, tvthrift.poseTransformation.translation.x);
-  v.SetElement(1, tvthrift.poseTransformation.translation.y);
-  v.SetElement(2, tvthrift.poseTransformation.translation.z);
-  eulerTransform->SetTranslation(v);
+const ImagePyramid &
+StatismoUI::findImagePyramid(const ImageView & imv) const
+{
+  auto pyramid = m_imagePyramids.find(imv.GetId());
+  if (pyramid == m_imagePyramids.end())
+  {
+    throw std::invalid_argument("image " + std::to_string(imv.GetId()) + " was not shown with showImagePyramid");
+  }
+  return *pyramid->second;
+}
 
-  PoseTransformation pose(*eulerTransform);
-  return ShapeModelTransformationView(tvthrift.id, pose, ShapeTransformation(std::move(coeffs)));
+unsigned
+StatismoUI::getNumberOfImagePyramidLevels(const ImageView & imv) const
+{
+  return findImagePyramid(imv).GetNumberOfLevels();
 }
 
-ShapeModelView
-StatismoUI::shapeModelViewFromThrift(const ui::ShapeModelView & smvThrift)
+void
+StatismoUI::showImageLevel(const ImageView & imv, unsigned level)
 {
-  TriangleMeshView             tmv = triangleMeshViewFromThriftMeshView(smvThrift.meshView);
-  ShapeModelTransformationView smv = shapeModelTransformationViewFromThrift(smvThrift.shapeModelTransformationView);
-  ShapeModelView               ssmView(tmv, smv);
-  return ssmView;
+  const ImagePyramid::Level & l = findImagePyramid(imv).GetLevel(level);
+
+  itk::ImageRegion<3> region;
+  for (unsigned i = 0; i < 3; ++i)
+  {
+    region.SetSize(i, l.size[i]);
+  }
+  showImageRegion(imv, level, region);
 }
 
-ui::ShapeModelTransformationView
-StatismoUI::shapeModelTransformationViewToThrift(const ShapeModelTransformationView & tv)
+void
+StatismoUI::showImageRegion(const ImageView & imv, unsigned level, const itk::ImageRegion<3> & region)
 {
-  ui::ShapeModelTransformationView tvthrift;
-  ui::RigidTransformation          rtThrift;
-  ui::EulerTransform               eulerThrift;
+  const ImagePyramid & pyramid = findImagePyramid(imv);
+  ui::ImageView        thriftImageView = conversions::imageViewToThriftImageView(imv);
+  pyramid.checkRegion(level, region);
+
+  const std::size_t sliceBytes = region.GetSize(0) * region.GetSize(1) * pyramid.GetPixelSize();
+  const std::size_t slicesPerRequest =
+    std::max<std::size_t>(1, maxImageRegionBytesPerRequest / std::max<std::size_t>(1, sliceBytes));
+  for (std::size_t z = 0; z < region.GetSize(2); z += slicesPerRequest)
+  {
+    itk::ImageRegion<3> slab = region;
+    slab.SetIndex(2, region.GetIndex(2) + z);
+    slab.SetSize(2, std::min(slicesPerRequest, region.GetSize(2) - z));
 
-  eulerThrift.angleX = tv.GetPoseTransformation().GetAngleX();
-  eulerThrift.angleY = tv.GetPoseTransformation().GetAngleY();
-  eulerThrift.angleZ = tv.GetPoseTransformation().GetAngleZ();
-  ui::Point3D center;
+    ui::PackedImageRegion packedRegion =
+      timedEncode([&] { return conversions::imagePyramidRegionToThrift(pyramid, level, slab); });
+    m_connection->GetThriftUI()->updateImageRegion(thriftImageView, packedRegion);
+  }
+}
 
-  center.x = tv.GetPoseTransformation().GetCenter()[0];
-  center.y = tv.GetPoseTransformation().GetCenter()[1];
-  center.z = tv.GetPoseTransformation().GetCenter()[2];
+void
+StatismoUI::updateShapeModelTransformationView(const ShapeModelTransformationView & smv)
+{
+  ui::ShapeModelTransformationView smvThrift = conversions::shapeModelTransformationViewToThrift(smv);
+  if (m_skipUnchangedUpdates && m_scene->skip(smvThrift))
+  {
+    return;
+  }
+  try
+  {
+    m_connection->GetThriftUI()->updateShapeModelTransformation(smvThrift);
+  }
+  catch (...)
+  {
+    // the service may or may not have applied it
+    m_scene->invalidate(smv.GetId());
+    throw;
+  }
+  if (!forgetIfDropped(smv.GetId()))
+  {
+    m_scene->sent(smvThrift);
+  }
+}
 
-  eulerThrift.center = center;
-  rtThrift.rotation = eulerThrift;
+void
+StatismoUI::startShapeModelTransformationStream(double maxUpdatesPerSecond)
+{
+  if (maxUpdatesPerSecond <= 0)
+  {
+    throw std::invalid_argument("maxUpdatesPerSecond must be positive");
+  }
+  stopShapeModelTransformationStream();
+  m_transformationStream = std::make_unique<ShapeModelTransformationStream>(m_connection, maxUpdatesPerSecond);
+}
 
-  ui::TranslationTransform translationThrift;
-  translationThrift.x = tv.GetPoseTransformation().GetTranslation()[0];
-  translationThrift.y = tv.GetPoseTransformation().GetTranslation()[1];
-  translationThrift.z = tv.GetPoseTransformation().GetTranslation()[2];
-  rtThrift.translation = translationThrift;
+void
+StatismoUI::streamShapeModelTransformationView(const ShapeModelTransformationView & smv)
+{
+  if (!m_transformationStream)
+  {
+    startShapeModelTransformationStream();
+  }
+  // the mirror does not know when the update is sent, the next updateShapeModelTransformationView is always sent
+  m_scene->invalidate(smv.GetId());
+  m_transformationStream->push(smv);
+}
 
-  ui::ShapeTransformation stThrift;
-  ui::DoubleVector        coeffsThrift;
+void
+StatismoUI::stopShapeModelTransformationStream()
+{
+  if (m_transformationStream)
+  {
+    std::unique_ptr<ShapeModelTransformationStream> stream = std::move(m_transformationStream);
+    stream->stop();
+    if (std::exception_ptr error = stream->takeError())
+    {
+      std::rethrow_exception(error);
+    }
+  }
+}
 
-  vnl_vector<float> coeffs = tv.GetShapeTransformation().GetCoefficients();
-  for (unsigned i = 0; i < coeffs.size(); ++i)
+void
+StatismoUI::loadShapeTrajectory(const ShapeModelTransformationView & smv, const ShapeTrajectory & trajectory)
+{
+  if (trajectory.GetNumberOfKeyframes() == 0)
   {
-    coeffsThrift.push_back(coeffs[i]);
+    throw std::invalid_argument("the trajectory has no keyframes");
   }
+  ui::PackedShapeTrajectory packed =
+    timedEncode([&] { return conversions::shapeTrajectoryToPackedThrift(trajectory); });
 
-  stThrift.coefficients = coeffsThrift;
-  tvthrift.shapeTransformation = stThrift;
-  tvthrift.poseTransformation = rtThrift;
-  tvthrift.id = tv.GetId();
-  return tvthrift;
+  // the service moves the view from now on, the next update of the view is always sent
+  m_scene->invalidate(smv.GetId());
+  m_connection->GetThriftUI()->loadShapeTrajectory(conversions::shapeModelTransformationViewToThrift(smv), packed);
 }
 
-ui::TriangleMesh
-StatismoUI::meshToThriftMesh(const MeshType * mesh)
+void
+StatismoUI::playShapeTrajectory(const ShapeModelTransformationView & smv, const TrajectoryPlayback & playback)
 {
-  ui::PointList pts;
+  if (!(playback.speed > 0) || !(playback.time >= 0))
+  {
+    throw std::invalid_argument("the playback needs a positive speed and a time from 0 on");
+  }
+  m_scene->invalidate(smv.GetId());
+  m_connection->GetThriftUI()->playShapeTrajectory(conversions::shapeModelTransformationViewToThrift(smv),
+                                                   conversions::trajectoryPlaybackToThrift(playback));
+}
 
-  for (unsigned i = 0; i < mesh->GetNumberOfPoints(); i++)
+void
+StatismoUI::updateTriangleMeshView(const TriangleMeshView & tmv)
+{
+  ui::TriangleMeshView thriftTmv = conversions::thriftMeshViewFromTriangleMeshView(tmv);
+  if (m_skipUnchangedUpdates && m_scene->skip(thriftTmv))
+  {
+    return;
+  }
+  try
+  {
+    m_connection->GetThriftUI()->updateTriangleMeshView(thriftTmv);
+  }
+  catch (...)
   {
-    ui::Point3D         p;
-    MeshType::PointType pt = mesh->GetPoint(i);
-    p.x = pt.GetElement(0);
-    p.y = pt.GetElement(1);
-    p.z = pt.GetElement(2);
-    pts.push_back(p);
+    m_scene->invalidate(tmv.GetId());
+    throw;
   }
+  if (!forgetIfDropped(tmv.GetId()))
+  {
+    m_scene->sent(thriftTmv);
+  }
+}
 
-  ui::TriangleCellList cells;
-  for (unsigned i = 0; i < mesh->GetNumberOfCells(); i++)
+void
+StatismoUI::updateTriangleMeshVertices(const TriangleMeshView & tmv, const MeshType * mesh, VertexUpdateMode mode)
+{
+  // a delta journaled earlier may have failed when the journal was sent
+  forgetIfDropped(tmv.GetId());
+  ui::PackedVertexUpdate update;
+  if (mode == VertexUpdateMode::Delta)
+  {
+    update = timedEncode([&] { return conversions::meshVertexDeltaToPackedThrift(mesh, m_sentVertices[tmv.GetId()]); });
+  }
+  else
   {
-    ui::TriangleCell     c;
-    MeshType::CellType * cell = mesh->GetCells()->GetElement(i);
-    c.id1 = cell->GetPointIdsContainer().GetElement(0);
-    c.id2 = cell->GetPointIdsContainer().GetElement(1);
-    c.id3 = cell->GetPointIdsContainer().GetElement(2);
-    cells.push_back(c);
+    m_sentVertices.erase(tmv.GetId());
+    update = timedEncode([&] { return conversions::meshVerticesToPackedThrift(mesh); });
   }
 
-  ui::TriangleMesh thriftMesh;
-  thriftMesh.vertices = pts;
-  thriftMesh.topology = cells;
+  try
+  {
+    m_connection->GetThriftUI()->updateTriangleMeshVertices(conversions::thriftMeshViewFromTriangleMeshView(tmv),
+                                                            update);
+  }
+  catch (...)
+  {
+    // the service may not have the positions the delta refers to, the next update sends all vertices
+    m_sentVertices.erase(tmv.GetId());
+    throw;
+  }
+  // neither sent nor journaled: likewise
+  forgetIfDropped(tmv.GetId());
+}
 
-  return thriftMesh;
+void
+StatismoUI::updateTriangleMeshScalars(const TriangleMeshView & tmv,
+                                      const float *            values,
+                                      std::size_t              numberOfValues,
+                                      const std::string &      name)
+{
+  ui::PackedVertexScalars scalars =
+    timedEncode([&] { return conversions::vertexScalarsToPackedThrift(values, numberOfValues, name); });
+  m_connection->GetThriftUI()->updateTriangleMeshScalars(conversions::thriftMeshViewFromTriangleMeshView(tmv),
+                                                         scalars);
 }
 
-ui::ImageView
-StatismoUI::imageViewToThriftImageView(const ImageView & imageView)
+void
+StatismoUI::updateImageView(const ImageView & imageView)
 {
-  ui::ImageView thriftImageView;
-  thriftImageView.id = imageView.GetId();
-  thriftImageView.opacity = imageView.GetOpacity();
-  thriftImageView.level = imageView.GetLevel();
-  thriftImageView.window = imageView.GetWindow();
-  return thriftImageView;
+  ui::ImageView thriftImageView = conversions::imageViewToThriftImageView(imageView);
+  if (m_skipUnchangedUpdates && m_scene->skip(thriftImageView))
+  {
+    return;
+  }
+  try
+  {
+    m_connection->GetThriftUI()->updateImageView(thriftImageView);
+  }
+  catch (...)
+  {
+    m_scene->invalidate(imageView.GetId());
+    throw;
+  }
+  if (!forgetIfDropped(imageView.GetId()))
+  {
+    m_scene->sent(thriftImageView);
+  }
 }
 
-ui::ShapeModelView
-StatismoUI::shapeModelViewToThriftShapeModelView(const ShapeModelView & smv)
+SceneBatchResult
+StatismoUI::applySceneBatch(const SceneBatch & batch)
 {
-  ui::ShapeModelView               thriftSmv;
-  ui::ShapeModelTransformationView tssmView =
-    shapeModelTransformationViewToThrift(smv.GetShapeModelTransformationView());
-  ui::TriangleMeshView tMeshView = thriftMeshViewFromTriangleMeshView(smv.GetTriangleMeshView());
-  thriftSmv.shapeModelTransformationView = tssmView;
-  thriftSmv.meshView = tMeshView;
-  return thriftSmv;
+  const std::vector<ui::SceneOperation> & operations = batch.GetThriftOperations();
+  std::vector<ui::SceneOperationResult>   results;
+  try
+  {
+    m_connection->GetThriftUI()->applySceneBatch(results, operations);
+  }
+  catch (const ui::SceneBatchError & e)
+  {
+    // the views the applied operations created are known if the service reported them
+    forgetViews(mirrorSceneBatch(*m_scene, operations, e.results, e.operationIndex));
+    throw std::runtime_error("operation " + std::to_string(e.operationIndex) + " of the scene batch failed: " +
+                             e.message);
+  }
+
+  forgetViews(mirrorSceneBatch(*m_scene, operations, results, operations.size()));
+  // a connection that reconnects journals the operations one by one while the service is down, and may drop some
+  for (const ui::SceneOperation & operation : operations)
+  {
+    if (operation.__isset.updateTriangleMeshView)
+    {
+      forgetIfDropped(operation.updateTriangleMeshView.id);
+    }
+    else if (operation.__isset.updateImageView)
+    {
+      forgetIfDropped(operation.updateImageView.id);
+    }
+    else if (operation.__isset.updateShapeModelTransformation)
+    {
+      forgetIfDropped(operation.updateShapeModelTransformation.id);
+    }
+  }
+
+  std::vector<SceneBatchResult::Entry> entries(results.size());
+  for (std::size_t i = 0; i < results.size(); ++i)
+  {
+    if (results[i].__isset.group)
+    {
+      entries[i] = Group(results[i].group.name, results[i].group.id);
+    }
+    else if (results[i].__isset.meshView)
+    {
+      entries[i] = conversions::triangleMeshViewFromThriftMeshView(results[i].meshView);
+    }
+    else if (results[i].__isset.imageView)
+    {
+      entries[i] = conversions::imageViewFromThriftImageView(results[i].imageView);
+    }
+  }
+  return SceneBatchResult(std::move(entries));
 }
 
 void
 StatismoUI::removeGroup(const Group & group)
 {
-  ServerConnectionInstance().GetThriftUI().removeGroup(groupToThriftGroup(group));
+  // no chunk of a model of the group may reach the service after the group is removed
+  stopUploads(m_scene->GetGroupViews(group.GetId()));
+  m_connection->GetThriftUI()->removeGroup(conversions::groupToThriftGroup(group));
+  forgetViews(m_scene->removeGroup(group.GetId()));
 }
 
 void
 StatismoUI::removeTriangleMesh(const TriangleMeshView & tmv)
 {
-  ui::TriangleMeshView thriftTmv = thriftMeshViewFromTriangleMeshView(tmv);
-  ServerConnectionInstance().GetThriftUI().removeTriangleMesh(thriftTmv);
+  ui::TriangleMeshView thriftTmv = conversions::thriftMeshViewFromTriangleMeshView(tmv);
+  stopUploads({ tmv.GetId() });
+  m_connection->GetThriftUI()->removeTriangleMesh(thriftTmv);
+  forgetViews({ tmv.GetId() });
 }
 
 void
 StatismoUI::removeImage(const ImageView & imv)
 {
-  ui::ImageView thriftImageView = imageViewToThriftImageView(imv);
-  ServerConnectionInstance().GetThriftUI().removeImage(thriftImageView);
+  ui::ImageView thriftImageView = conversions::imageViewToThriftImageView(imv);
+  m_connection->GetThriftUI()->removeImage(thriftImageView);
+  forgetViews({ imv.GetId() });
 }
 
 void
 StatismoUI::removeShapeModelTransformation(const ShapeModelTransformationView & ssmtview)
 {
-  ui::ShapeModelTransformationView tssmView = shapeModelTransformationViewToThrift(ssmtview);
-  ServerConnectionInstance().GetThriftUI().removeShapeModelTransformation(tssmView);
+  ui::ShapeModelTransformationView tssmView = conversions::shapeModelTransformationViewToThrift(ssmtview);
+  m_connection->GetThriftUI()->removeShapeModelTransformation(tssmView);
+  forgetViews({ ssmtview.GetId() });
 }
+
 void
 StatismoUI::removeShapeModel(const ShapeModelView & ssmview)
 {
-  ui::ShapeModelView smvThrift = shapeModelViewToThriftShapeModelView(ssmview);
-  ServerConnectionInstance().GetThriftUI().removeShapeModel(smvThrift);
+  ui::ShapeModelView smvThrift = conversions::shapeModelViewToThriftShapeModelView(ssmview);
+  stopUploads({ smvThrift.meshView.id });
+  m_connection->GetThriftUI()->removeShapeModel(smvThrift);
+  forgetViews({ smvThrift.meshView.id, smvThrift.shapeModelTransformationView.id });
+}
+
+TriangleMeshView
+StatismoUI::addToScene(const Group & group, const ui::TriangleMeshView & tmvThrift)
+{
+  TriangleMeshView tmv = conversions::triangleMeshViewFromThriftMeshView(tmvThrift);
+  // what an update of the unchanged view sends, which may differ from the doubles the service reported
+  m_scene->addView(group.GetId(), conversions::thriftMeshViewFromTriangleMeshView(tmv));
+  return tmv;
+}
+
+ImageView
+StatismoUI::addToScene(const Group & group, const ui::ImageView & imageViewThrift)
+{
+  ImageView imageView = conversions::imageViewFromThriftImageView(imageViewThrift);
+  m_scene->addView(group.GetId(), conversions::imageViewToThriftImageView(imageView));
+  return imageView;
+}
+
+ShapeModelView
+StatismoUI::addToScene(const Group & group, const ui::ShapeModelView & smvThrift)
+{
+  ShapeModelView ssmView = conversions::shapeModelViewFromThrift(smvThrift);
+  m_scene->addView(group.GetId(), conversions::shapeModelViewToThriftShapeModelView(ssmView));
+  return ssmView;
+}
+
+void
+StatismoUI::forgetViews(const std::vector<int> & ids)
+{
+  for (int id : ids)
+  {
+    m_scene->removeView(id);
+    m_sentVertices.erase(id);
+    m_imagePyramids.erase(id);
+  }
+  // views removed by a scene batch
+  stopUploads(ids);
+}
+
+void
+StatismoUI::stopUploads(const std::vector<int> & meshViewIds)
+{
+  // an error of the chunk an upload is sending does not matter, the model is removed
+  auto stopped = [&meshViewIds](const std::unique_ptr<ShapeModelComponentUpload> & upload) {
+    return std::find(meshViewIds.begin(), meshViewIds.end(), upload->GetMeshViewId()) != meshViewIds.end();
+  };
+  for (auto & upload : m_componentUploads)
+  {
+    if (stopped(upload))
+    {
+      upload->cancel();
+    }
+  }
+  // destroying an upload waits for its thread
+  m_componentUploads.erase(std::remove_if(m_componentUploads.begin(), m_componentUploads.end(), stopped),
+                           m_componentUploads.end());
+}
+
+bool
+StatismoUI::forgetIfDropped(int viewId)
+{
+  if (!m_connection->TakeDropped(viewId))
+  {
+    return false;
+  }
+  m_scene->invalidate(viewId);
+  m_sentVertices.erase(viewId);
+  return true;
+}
+
+std::vector<RpcMetrics>
+StatismoUI::getMetrics() const
+{
+  const auto & metrics = m_connection->GetMetrics();
+  return metrics ? metrics->snapshot() : std::vector<RpcMetrics>();
+}
+
+void
+StatismoUI::resetMetrics()
+{
+  if (const auto & metrics = m_connection->GetMetrics())
+  {
+    metrics->reset();
+  }
+}
+
+void
+StatismoUI::startMetricsDump(const std::string & path, std::chrono::milliseconds period)
+{
+  m_metricsDump.reset();
+  if (const auto & metrics = m_connection->GetMetrics())
+  {
+    m_metricsDump = std::make_unique<MetricsDump>(metrics, path, period);
+  }
+}
+
+void
+StatismoUI::stopMetricsDump()
+{
+  m_metricsDump.reset();
+}
+
+ConnectionStatus
+StatismoUI::getConnectionStatus() const
+{
+  return m_connection->GetStatus();
+}
+
+std::uint64_t
+StatismoUI::getNumberOfSkippedUpdates() const
+{
+  return m_scene->GetNumberOfSkippedUpdates();
 }
 
-} // namespace StatismoUI
\ No newline at end of file
+} // namespace StatismoUI
@@ -13,6 +13,18 @@
 #include <itkImageFileReader.h>
 #include <vnl/algo/vnl_svd.h>
 
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
 
 // foreward declarations for
 namespace ui
@@ -27,6 +39,316 @@ class ImageView;
 
 namespace StatismoUI
 {
+// Scalar type used to encode packed (binary) payloads.
+// Float16 (IEEE half) has no C++ counterpart, it is only used to shrink shape model bases.
+enum class ScalarType
+{
+  Float32,
+  Float64,
+  Int8,
+  UInt8,
+  Int16,
+  UInt16,
+  Int32,
+  UInt32,
+  Float16
+};
+
+// Maps a C++ type to the ScalarType used to send it
+template <typename T>
+struct ScalarTypeTraits;
+
+template <>
+struct ScalarTypeTraits<float>
+{
+  static constexpr ScalarType value = ScalarType::Float32;
+};
+
+template <>
+struct ScalarTypeTraits<double>
+{
+  static constexpr ScalarType value = ScalarType::Float64;
+};
+
+template <>
+struct ScalarTypeTraits<std::int8_t>
+{
+  static constexpr ScalarType value = ScalarType::Int8;
+};
+
+template <>
+struct ScalarTypeTraits<std::uint8_t>
+{
+  static constexpr ScalarType value = ScalarType::UInt8;
+};
+
+template <>
+struct ScalarTypeTraits<std::int16_t>
+{
+  static constexpr ScalarType value = ScalarType::Int16;
+};
+
+template <>
+struct ScalarTypeTraits<std::uint16_t>
+{
+  static constexpr ScalarType value = ScalarType::UInt16;
+};
+
+template <>
+struct ScalarTypeTraits<std::int32_t>
+{
+  static constexpr ScalarType value = ScalarType::Int32;
+};
+
+template <>
+struct ScalarTypeTraits<std::uint32_t>
+{
+  static constexpr ScalarType value = ScalarType::UInt32;
+};
+
+// A triangle mesh as raw arrays: numberOfVertices x y z triples of vertexType (Float32 or Float64) and
+// numberOfTriangles triples of point ids. The arrays are sent as they are, they must outlive the call.
+struct MeshBuffers
+{
+  MeshBuffers() = default;
+
+  template <typename TCoordinate>
+  MeshBuffers(const TCoordinate *  vertices,
+              std::size_t          numberOfVertices,
+              const std::int32_t * triangles,
+              std::size_t          numberOfTriangles)
+    : vertexType(ScalarTypeTraits<TCoordinate>::value)
+    , vertices(vertices)
+    , numberOfVertices(numberOfVertices)
+    , triangles(triangles)
+    , numberOfTriangles(numberOfTriangles)
+  {
+    static_assert(std::is_floating_point_v<TCoordinate>, "vertices must be float or double");
+  }
+
+  ScalarType           vertexType{ ScalarType::Float32 };
+  const void *         vertices{ nullptr };
+  std::size_t          numberOfVertices{ 0 };
+  const std::int32_t * triangles{ nullptr };
+  std::size_t          numberOfTriangles{ 0 };
+};
+
+// Adapters from ITK and statismo types to raw arrays, used by the templates of StatismoUI
+namespace detail
+{
+// The coordinates x0 y0 z0 x1 ... of the points of a 3D itk::PointSet or itk::Mesh, straight from its points container
+template <typename TPointSet>
+const typename TPointSet::CoordRepType *
+pointCoordinates(const TPointSet * pointSet)
+{
+  using PointType = typename TPointSet::PointType;
+  static_assert(TPointSet::PointDimension == 3, "only 3D meshes and point sets can be shown");
+  static_assert(sizeof(PointType) == 3 * sizeof(typename TPointSet::CoordRepType), "points must not be padded");
+  static_assert(std::is_same_v<typename TPointSet::PointsContainer::STLContainerType, std::vector<PointType>>,
+                "points must be stored in an itk::VectorContainer");
+
+  if (pointSet->GetNumberOfPoints() == 0)
+  {
+    return nullptr;
+  }
+  return pointSet->GetPoints()->CastToSTLConstContainer().front().GetDataPointer();
+}
+
+// The vertices of a mesh as they are stored, and its point ids gathered into triangles. Throws std::invalid_argument
+// if a cell is not a triangle.
+template <typename TMesh>
+MeshBuffers
+meshBuffers(const TMesh * mesh, std::vector<std::int32_t> & triangles)
+{
+  triangles.clear();
+  triangles.reserve(3 * mesh->GetNumberOfCells());
+  if (mesh->GetNumberOfCells() > 0)
+  {
+    for (auto cell = mesh->GetCells()->Begin(); cell != mesh->GetCells()->End(); ++cell)
+    {
+      if (cell.Value()->GetNumberOfPoints() != 3)
+      {
+        throw std::invalid_argument("only meshes of triangles can be shown");
+      }
+      auto pointIds = cell.Value()->PointIdsBegin();
+      triangles.insert(triangles.end(), { static_cast<std::int32_t>(pointIds[0]),
+                                          static_cast<std::int32_t>(pointIds[1]),
+                                          static_cast<std::int32_t>(pointIds[2]) });
+    }
+  }
+  return MeshBuffers(pointCoordinates(mesh), mesh->GetNumberOfPoints(), triangles.data(), triangles.size() / 3);
+}
+
+// statismo stores the mean as point positions (i.e. ref + df), the viewer expects the deformation alone
+template <typename TModel>
+vnl_vector<float>
+meanDeformation(const TModel * ssm)
+{
+  vnl_vector<float> mean = ssm->GetMeanVector();
+  const auto        reference = ssm->GetRepresenter()->SampleToSampleVector(ssm->GetRepresenter()->GetReference());
+  for (unsigned j = 0; j < mean.size(); ++j)
+  {
+    mean[j] -= reference[j];
+  }
+  return mean;
+}
+} // namespace detail
+
+// Wire protocol, must match the protocol ui-service is configured with
+enum class Protocol
+{
+  Binary,
+  Compact
+};
+
+// Transport stack below the protocol, must match the transport ui-service is configured with.
+// Zlib compresses the whole stream (TZlibTransport). CompressedFrames compresses each message on its own, and
+// only messages of at least compressionThreshold bytes.
+enum class Transport
+{
+  Framed,
+  Zlib,
+  CompressedFrames
+};
+
+// Reconnection to ui-service, for long jobs that must survive a restart of the viewer. Once the connection breaks,
+// calls no longer reach the service: they are journaled (at most maxPendingOperations, further ones are dropped) and
+// return views with ids chosen by the client. A background thread reconnects, waiting from initialBackoffMs up to
+// maxBackoffMs between attempts, and then sends the journal, keeping only the latest update of each view. After an
+// operation on a view was dropped or failed, the next update of the view is sent even if it changes nothing, and the
+// next vertex update of a mesh sends all vertices. If the service was restarted, the whole scene is shown again
+// instead, from copies of the payloads that the client keeps for that if restoreScene is set. The ids of the views
+// returned to the application never change, the client maps them to those of the service. Transport errors are never
+// thrown, errors reported by the service still are.
+struct ReconnectOptions
+{
+  bool        enabled{ false };
+  int         initialBackoffMs{ 100 };
+  int         maxBackoffMs{ 5000 };
+  std::size_t maxPendingOperations{ 10000 };
+  bool        restoreScene{ true };
+};
+
+// State of a connection with reconnect enabled. Operations are dropped when the journal is full, and fail when the
+// service rejects them while the journal is sent.
+struct ConnectionStatus
+{
+  bool          connected{ true };
+  std::uint64_t reconnects{ 0 };
+  std::size_t   pendingOperations{ 0 };
+  std::uint64_t droppedOperations{ 0 };
+  std::uint64_t failedOperations{ 0 };
+};
+
+// Where and how to connect to ui-service. Timeouts are in milliseconds, 0 means no timeout.
+// StatismoUI instances created with equal options share one connection unless shared is false.
+struct ConnectionOptions
+{
+  std::string      host{ "localhost" };
+  int              port{ 8000 };
+  Protocol         protocol{ Protocol::Binary };
+  Transport        transport{ Transport::Framed };
+  std::size_t      compressionThreshold{ 64 * 1024 };
+  int              compressionLevel{ 1 };
+  int              connectTimeoutMs{ 0 };
+  int              sendTimeoutMs{ 0 };
+  int              receiveTimeoutMs{ 0 };
+  bool             shared{ true };
+  // Record the metrics of every RPC (see StatismoUI::getMetrics)
+  bool             collectMetrics{ true };
+  ReconnectOptions reconnect;
+  // Appends every request to a session log at this path, to be replayed later with the ui-replay tool. Needs
+  // reconnect.enabled, so that the service may also be absent (set reconnect.maxPendingOperations to 0 and
+  // reconnect.restoreScene to false to keep nothing in memory then).
+  std::string      recordPath;
+  // Updates of a view that equal what this client last sent for it, or the state it was shown with, are not sent
+  // (see StatismoUI::getNumberOfSkippedUpdates). Only for a client that is the sole writer of its views: a change
+  // made in the viewer or by another client, even one sharing the connection, is not seen and re-sending the
+  // previous value would be skipped. Does not affect which clients share a connection.
+  bool             skipUnchangedUpdates{ false };
+};
+
+// Distribution of a quantity measured by the client instrumentation. Bucket 0 counts the zeros, bucket b > 0 the
+// values in [2^(b-1), 2^b).
+struct Histogram
+{
+  std::uint64_t                 count{ 0 };
+  std::uint64_t                 sum{ 0 };
+  std::uint64_t                 max{ 0 };
+  std::array<std::uint64_t, 65> buckets{};
+
+  double
+  mean() const;
+
+  // Upper bound of the bucket holding the q-th percentile (0 < q <= 100), 0 without values
+  std::uint64_t
+  percentile(double q) const;
+};
+
+// What the client measured for the calls of one RPC. Encode time is spent converting ITK and statismo objects to
+// thrift structs, serialize time writing them with the protocol, round trip time from the start of the request to
+// the end of its reply (to the flush of the request for oneway RPCs). Bytes are counted on the socket, after
+// compression; with Transport::Zlib they are approximate.
+struct RpcMetrics
+{
+  std::string   name;
+  std::uint64_t calls{ 0 };
+  Histogram     encodeNanoseconds;
+  Histogram     serializeNanoseconds;
+  Histogram     roundTripNanoseconds;
+  Histogram     bytesWritten;
+  Histogram     bytesRead;
+};
+
+// How updateTriangleMeshVertices sends the vertices. Delta sends only the vertices that moved since the last update
+// of the view, the client keeps a copy of the positions it sent for that.
+enum class VertexUpdateMode
+{
+  Full,
+  Delta
+};
+
+// How showProgressiveStatisticalShapeModel splits the upload of a model. The call returns once the first
+// numberOfInitialComponents principal components are shown; if explainedVariance is positive, as many as needed to
+// explain that fraction of the total variance are sent first instead. The remaining components follow in the
+// background, componentsPerChunk at a time. The basis is sent with scalarType (see showPackedStatisticalShapeModel).
+struct ProgressiveUploadOptions
+{
+  unsigned   numberOfInitialComponents{ 10 };
+  double     explainedVariance{ 0 };
+  unsigned   componentsPerChunk{ 10 };
+  ScalarType scalarType{ ScalarType::Float32 };
+};
+
+// How showImagePyramid builds the pyramid of an image: levels of half the size of the previous one are added until
+// the largest edge of the coarsest level is at most coarsestEdge voxels, or until there are maxNumberOfLevels levels
+// (if not 0).
+struct ImagePyramidOptions
+{
+  unsigned coarsestEdge{ 64 };
+  unsigned maxNumberOfLevels{ 0 };
+};
+
+// What the service does at the end of a shape trajectory: stop on the last keyframe, start over, or play it
+// backwards to the start and so on
+enum class PlaybackMode
+{
+  Once,
+  Loop,
+  Bounce
+};
+
+// How the service plays the trajectory of a view (see StatismoUI::loadShapeTrajectory). Playing, the trajectory
+// advances from time (in seconds) at speed times the pace of its keyframes. Paused, the view shows the trajectory at
+// time, which scrubs it.
+struct TrajectoryPlayback
+{
+  bool         playing{ true };
+  double       time{ 0 };
+  double       speed{ 1 };
+  PlaybackMode mode{ PlaybackMode::Once };
+};
+
 class Group
 {
 public:
@@ -359,6 +681,34 @@ private:
   double m_opacity;
 };
 
+class PointCloudView
+{
+public:
+  explicit PointCloudView(int id)
+    : m_id(id)
+  {}
+
+  int
+  GetId() const
+  {
+    return m_id;
+  }
+
+private:
+  int m_id;
+};
+
+
+
+class ImagePyramid;
+class MetricsDump;
+class SceneBatch;
+class SceneBatchResult;
+class SceneMirror;
+class ServerConnection;
+class ShapeModelTransformationStream;
+class ShapeModelComponentUpload;
+class ShapeTrajectory;
 
 class StatismoUI
 {
@@ -368,36 +718,324 @@ class StatismoUI
   using StatisticalModelType = itk::StatisticalModel<MeshType>;
 
 public:
-  StatismoUI();
+  explicit StatismoUI(const ConnectionOptions & options = ConnectionOptions());
   ~StatismoUI();
 
+  StatismoUI(const StatismoUI &) = delete;
+  StatismoUI &
+  operator=(const StatismoUI &) = delete;
+
   Group
   createGroup(const std::string & name);
 
   TriangleMeshView
   showTriangleMesh(const Group & group, const MeshType * mesh, const std::string & name);
 
+  // Shows a mesh straight from a packed mesh file (see writePackedMeshFile), memory-mapped and sent in chunks. Throws
+  // std::runtime_error, before anything is sent, for a file with more than 2^31 - 1 vertices or triangles or with a
+  // triangle that refers to a missing vertex.
+  TriangleMeshView
+  showTriangleMesh(const Group & group, const std::string & path, const std::string & name);
+
+  // Same as showTriangleMesh, but vertices and topology are sent as packed binary arrays
+  TriangleMeshView
+  showPackedTriangleMesh(const Group &       group,
+                         const MeshType *    mesh,
+                         const std::string & name,
+                         ScalarType          vertexType = ScalarType::Float32);
+
+  // Same, for any 3D itk::Mesh of triangles with its points in a VectorContainer, e.g. itk::Mesh<double, 3>. The
+  // vertices are sent with their coordinate type straight from the points container, only the point ids are gathered.
+  template <typename TMesh>
+  TriangleMeshView
+  showPackedTriangleMesh(const Group & group, const TMesh * mesh, const std::string & name)
+  {
+    std::vector<std::int32_t> triangles;
+    return showPackedTriangleMesh(group, detail::meshBuffers(mesh, triangles), name);
+  }
+
+  // Same, for a mesh given as raw arrays
+  TriangleMeshView
+  showPackedTriangleMesh(const Group & group, const MeshBuffers & mesh, const std::string & name);
+
   void
-  showPointCloud(const Group & group, const std::list<PointType> points, const std::string & name);
+  showPointCloud(const Group & group, const std::list<PointType> & points, const std::string & name);
+
+  // Writes at most capacity points and returns how many it wrote, 0 ends the point cloud
+  using PointCloudProducer = std::function<std::size_t(PointType * points, std::size_t capacity)>;
+
+  // Sends a point cloud of any size in packed chunks of pointsPerChunk points. The cloud is shown empty first and
+  // grows as the chunks arrive; if expectedNumberOfPoints is not 0 the viewer shows the progress of the upload.
+  // Only one chunk is held in memory at a time.
+  PointCloudView
+  streamPointCloud(const Group &              group,
+                   const PointCloudProducer & producer,
+                   const std::string &        name,
+                   std::size_t                expectedNumberOfPoints = 0,
+                   std::size_t                pointsPerChunk = 65536);
+
+  // Same, for the points in [first, last) of any container or array
+  template <typename Iterator>
+  PointCloudView
+  streamPointCloud(const Group &       group,
+                   Iterator            first,
+                   Iterator            last,
+                   const std::string & name,
+                   std::size_t         pointsPerChunk = 65536)
+  {
+    using Category = typename std::iterator_traits<Iterator>::iterator_category;
+
+    std::size_t expectedNumberOfPoints = 0;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>)
+    {
+      expectedNumberOfPoints = std::distance(first, last);
+    }
+    auto producer = [&first, &last](PointType * points, std::size_t capacity) {
+      std::size_t n = 0;
+      for (; n < capacity && first != last; ++n, ++first)
+      {
+        points[n] = *first;
+      }
+      return n;
+    };
+    return streamPointCloud(group, producer, name, expectedNumberOfPoints, pointsPerChunk);
+  }
+
+  // Same, for the points of any 3D itk::PointSet or itk::Mesh with its points in a VectorContainer. The chunks are
+  // copied straight from the points container, float and double coordinates are sent as they are.
+  template <typename TPointSet>
+  PointCloudView
+  streamPointCloud(const Group &       group,
+                   const TPointSet *   pointSet,
+                   const std::string & name,
+                   std::size_t         pointsPerChunk = 65536)
+  {
+    return streamPointCloud(
+      group, detail::pointCoordinates(pointSet), pointSet->GetNumberOfPoints(), name, pointsPerChunk);
+  }
+
+  // Same, for numberOfPoints x y z triples of float or double
+  template <typename TCoordinate>
+  PointCloudView
+  streamPointCloud(const Group &       group,
+                   const TCoordinate * coordinates,
+                   std::size_t         numberOfPoints,
+                   const std::string & name,
+                   std::size_t         pointsPerChunk = 65536)
+  {
+    static_assert(std::is_floating_point_v<TCoordinate>, "coordinates must be float or double");
+    return streamPointCloud(
+      group, ScalarTypeTraits<TCoordinate>::value, coordinates, numberOfPoints, name, pointsPerChunk);
+  }
 
   ShapeModelView
   showStatisticalShapeModel(const Group & group, const StatisticalModelType * ssm, const std::string & name);
 
+  // Same as showStatisticalShapeModel, but reference, mean and basis are sent as packed binary arrays.
+  // Float32 and Float64 apply to everything. Float16 and Int16 (quantized per column) apply to the basis only,
+  // reference and mean are then sent as Float32.
+  ShapeModelView
+  showPackedStatisticalShapeModel(const Group &                group,
+                                  const StatisticalModelType * ssm,
+                                  const std::string &          name,
+                                  ScalarType                   scalarType = ScalarType::Float32);
+
+  // Same, for a model of any 3D itk::Mesh of triangles (see showPackedTriangleMesh). The reference is sent with its
+  // coordinate type, the mean as described above.
+  template <typename TMesh>
+  ShapeModelView
+  showPackedStatisticalShapeModel(const Group &                          group,
+                                  const itk::StatisticalModel<TMesh> * ssm,
+                                  const std::string &                    name,
+                                  ScalarType                             scalarType = ScalarType::Float32)
+  {
+    const TMesh *             reference = ssm->GetRepresenter()->GetReference();
+    std::vector<std::int32_t> triangles;
+    return showPackedStatisticalShapeModel(group,
+                                           detail::meshBuffers(reference, triangles),
+                                           detail::meanDeformation(ssm),
+                                           ssm->GetOrthonormalPCABasisMatrix(),
+                                           ssm->GetPCAVarianceVector(),
+                                           name,
+                                           scalarType);
+  }
+
+  // Same, for a model given by its parts: meanDeformation and orthonormalBasis have 3 rows per vertex of the
+  // reference, the basis one column per variance
+  ShapeModelView
+  showPackedStatisticalShapeModel(const Group &             group,
+                                  const MeshBuffers &       reference,
+                                  const vnl_vector<float> & meanDeformation,
+                                  const vnl_matrix<float> & orthonormalBasis,
+                                  const vnl_vector<float> & variances,
+                                  const std::string &       name,
+                                  ScalarType                scalarType = ScalarType::Float32);
+
+  // Shows a model through the service's model registry. The model is identified by a hash of its contents and
+  // only uploaded if the service does not know it yet; showing a known model costs a single small request.
+  ShapeModelView
+  showRegisteredStatisticalShapeModel(const Group &                group,
+                                      const StatisticalModelType * ssm,
+                                      const std::string &          name,
+                                      ScalarType                   scalarType = ScalarType::Float32);
+
+  // Shows the model with its first principal components only and returns right away; the remaining components
+  // are appended by a background thread (see ProgressiveUploadOptions). The returned view has as many coefficients
+  // as components were sent first, missing coefficients are 0. Removing the model or its group, or destroying the
+  // client, stops the upload after the chunk it is sending; waitForShapeModelUploads finishes it.
+  ShapeModelView
+  showProgressiveStatisticalShapeModel(const Group &                    group,
+                                       const StatisticalModelType *     ssm,
+                                       const std::string &              name,
+                                       const ProgressiveUploadOptions & options = ProgressiveUploadOptions());
+
+  // Waits until every progressive upload is complete and rethrows the first error that occurred while uploading
+  void
+  waitForShapeModelUploads();
+
   void
   showLandmark(const Group & group, const PointType & point, const vnl_matrix<double> cov, const std::string & name);
 
+  // Shows many landmarks with a single request. The principal axes of all covariances are computed together,
+  // which is much faster than decomposing them one by one. The vectors must have the same size.
+  void
+  showLandmarks(const Group &                           group,
+                const std::vector<PointType> &          points,
+                const std::vector<vnl_matrix<double>> & covariances,
+                const std::vector<std::string> &        names);
+
   ImageView
   showImage(const Group & group, const ImageType * image, const std::string & name);
 
+  // Images of other pixel types are sent with showPackedImage, the voxels keep their type
+  template <typename TPixel>
+  ImageView
+  showImage(const Group & group, const itk::Image<TPixel, 3> * image, const std::string & name)
+  {
+    return showPackedImage(group, image, name);
+  }
+
+  // Shows an image straight from a file: a 3D NRRD with raw encoding (.nrrd, or .nhdr and its data file) or an
+  // uncompressed NIfTI-1 (.nii). The voxels are memory-mapped and sent in slabs of whole slices with their pixel
+  // type, the image is never loaded. Throws std::runtime_error for other files.
+  ImageView
+  showImage(const Group & group, const std::string & path, const std::string & name);
+
+  // Sends the pixel buffer as a single binary array with its pixel type, without per-pixel conversion
+  template <typename TPixel>
+  ImageView
+  showPackedImage(const Group & group, const itk::Image<TPixel, 3> * image, const std::string & name)
+  {
+    return showPackedImage(group,
+                           image,
+                           ScalarTypeTraits<TPixel>::value,
+                           image->GetBufferPointer(),
+                           image->GetPixelContainer()->Size() * sizeof(TPixel),
+                           name);
+  }
+
+  // Same, for voxels given as a raw array (x fastest, then y, then z)
+  template <typename TPixel>
+  ImageView
+  showPackedImage(const Group &                      group,
+                  const TPixel *                     voxels,
+                  const std::array<std::size_t, 3> & size,
+                  const std::array<double, 3> &      origin,
+                  const std::array<double, 3> &      spacing,
+                  const std::string &                name)
+  {
+    return showPackedImage(group, size, origin, spacing, ScalarTypeTraits<TPixel>::value, voxels, name);
+  }
+
+  // Shows the coarsest level of a pyramid of the image built on the client (see ImagePyramidOptions), so that the
+  // time to the first view depends on the size of that level only. Finer levels or regions of them are sent on
+  // demand with showImageLevel and showImageRegion. The client keeps the image and its pyramid until the view is
+  // removed.
+  template <typename TPixel>
+  ImageView
+  showImagePyramid(const Group &                 group,
+                   const itk::Image<TPixel, 3> * image,
+                   const std::string &           name,
+                   const ImagePyramidOptions &   options = ImagePyramidOptions())
+  {
+    return showImagePyramid(group, image, ScalarTypeTraits<TPixel>::value, image->GetBufferPointer(), name, options);
+  }
+
+  // Level 0 is the full resolution
+  unsigned
+  getNumberOfImagePyramidLevels(const ImageView & imv) const;
+
+  void
+  showImageLevel(const ImageView & imv, unsigned level);
+
+  // The region is given in voxels of the level. Large regions are sent in slabs of whole slices.
+  void
+  showImageRegion(const ImageView & imv, unsigned level, const itk::ImageRegion<3> & region);
+
   void
   updateShapeModelTransformationView(const ShapeModelTransformationView & smv);
 
+  // Streaming mode for fitting loops: the update is queued and sent by a background thread, so the caller never
+  // waits for the viewer. Only the latest update per view is sent, superseded ones are dropped.
+  // The stream is started with the default rate on first use.
+  void
+  streamShapeModelTransformationView(const ShapeModelTransformationView & smv);
+
+  void
+  startShapeModelTransformationStream(double maxUpdatesPerSecond = 30.0);
+
+  // Sends the pending updates and rethrows the last error that occurred while streaming
+  void
+  stopShapeModelTransformationStream();
+
+  // Sends the keyframes (see ShapeTrajectory.h) with a single request. They replace the trajectory of the view, which
+  // shows the first keyframe until playShapeTrajectory. The service then moves the view by itself, without a request
+  // per frame. Throws std::invalid_argument for a trajectory without keyframes.
+  void
+  loadShapeTrajectory(const ShapeModelTransformationView & smv, const ShapeTrajectory & trajectory);
+
+  // Plays, pauses, scrubs or loops the trajectory of the view. While it plays, an update of the view is shown until
+  // the next frame.
+  void
+  playShapeTrajectory(const ShapeModelTransformationView & smv,
+                      const TrajectoryPlayback &           playback = TrajectoryPlayback());
+
   void
   updateTriangleMeshView(const TriangleMeshView & tmv);
 
+  // Moves the vertices of a mesh shown with showTriangleMesh or showPackedTriangleMesh to the positions of the
+  // vertices of mesh, which must have the same topology. The view keeps its id, colour and opacity.
+  // With VertexUpdateMode::Delta the first update of a view sends all vertices.
+  void
+  updateTriangleMeshVertices(const TriangleMeshView & tmv,
+                             const MeshType *         mesh,
+                             VertexUpdateMode         mode = VertexUpdateMode::Delta);
+
+  // Colours the mesh of the view by numberOfValues values, one per vertex, e.g. the marginal variances of a shape
+  // model (see ShapeModelEvaluator::computeMarginalVariances) on the mesh of its ShapeModelView. name labels the colour
+  // map. The values replace the previous ones of the mesh, the view keeps its properties.
+  void
+  updateTriangleMeshScalars(const TriangleMeshView & tmv,
+                            const float *            values,
+                            std::size_t              numberOfValues,
+                            const std::string &      name);
+
+  void
+  updateTriangleMeshScalars(const TriangleMeshView & tmv, const std::vector<float> & values, const std::string & name)
+  {
+    updateTriangleMeshScalars(tmv, values.data(), values.size(), name);
+  }
+
   void
   updateImageView(const ImageView & imv);
 
+  // Applies the operations of the batch (see SceneBatch.h) in order, with a single request. If an operation fails,
+  // the operations before it remain applied and a std::runtime_error names the failed operation.
+  SceneBatchResult
+  applySceneBatch(const SceneBatch & batch);
+
+  // Removes the group with everything in it with a single request, and releases what the client keeps for its views
+  // (see updateTriangleMeshVertices, showImagePyramid and showProgressiveStatisticalShapeModel)
   void
   removeGroup(const Group & group);
   void
@@ -409,35 +1047,105 @@ public:
   void
   removeShapeModel(const ShapeModelView & ssmview);
 
-private:
-  ui::Group
-  groupToThriftGroup(const Group & group);
+  // Metrics of every RPC sent over the connection of this client since it was opened or reset, one entry per RPC
+  // name. Clients sharing a connection share its metrics. Empty if options.collectMetrics was false.
+  std::vector<RpcMetrics>
+  getMetrics() const;
 
-  ShapeModelView
-  shapeModelViewFromThrift(const ui::ShapeModelView & smvThrift);
+  void
+  resetMetrics();
 
-  ui::ShapeModelView
-  shapeModelViewToThriftShapeModelView(const ShapeModelView & tv);
+  // Appends the metrics to a file every period from a background thread, one JSON object per RPC and line, until
+  // stopMetricsDump is called or the client is destroyed. Does nothing if options.collectMetrics was false.
+  void
+  startMetricsDump(const std::string & path, std::chrono::milliseconds period = std::chrono::seconds(10));
 
-  ShapeModelTransformationView
-  shapeModelTransformationViewFromThrift(const ui::ShapeModelTransformationView & tvthrift);
+  // Writes the metrics a last time and stops the dump
+  void
+  stopMetricsDump();
 
-  ui::ShapeModelTransformationView
-  shapeModelTransformationViewToThrift(const ShapeModelTransformationView & tv);
+  // Whether the service is reachable and what is journaled, see ReconnectOptions. Always connected without reconnect.
+  ConnectionStatus
+  getConnectionStatus() const;
 
-  ui::ImageView
-  imageViewToThriftImageView(const ImageView & iv);
+  // Updates of views that were not sent because they would not have changed anything, see
+  // ConnectionOptions::skipUnchangedUpdates
+  std::uint64_t
+  getNumberOfSkippedUpdates() const;
 
+private:
+  // Record a view the service created in the group and convert it
   TriangleMeshView
-  triangleMeshViewFromThriftMeshView(ui::TriangleMeshView tmvThrift);
+  addToScene(const Group & group, const ui::TriangleMeshView & tmvThrift);
+  ImageView
+  addToScene(const Group & group, const ui::ImageView & imageViewThrift);
+  ShapeModelView
+  addToScene(const Group & group, const ui::ShapeModelView & smvThrift);
+
+  // Releases what the client keeps for views that were removed
+  void
+  forgetViews(const std::vector<int> & ids);
+
+  // Cancels the uploads of the models with these mesh views and waits for the chunks they are sending
+  void
+  stopUploads(const std::vector<int> & meshViewIds);
 
-  ui::TriangleMeshView
-  thriftMeshViewFromTriangleMeshView(const TriangleMeshView & tmv);
+  // Forgets what was last sent for the view if an operation on it did not reach the service, i.e. was dropped by a
+  // connection that reconnects. Returns whether it did.
+  bool
+  forgetIfDropped(int viewId);
 
-  ui::TriangleMesh
-  meshToThriftMesh(const MeshType * mesh);
+  ImageView
+  showPackedImage(const Group &             group,
+                  const itk::ImageBase<3> * image,
+                  ScalarType                pixelType,
+                  const void *              buffer,
+                  std::size_t               numberOfBytes,
+                  const std::string &       name);
+
+  ImageView
+  showPackedImage(const Group &                      group,
+                  const std::array<std::size_t, 3> & size,
+                  const std::array<double, 3> &      origin,
+                  const std::array<double, 3> &      spacing,
+                  ScalarType                         pixelType,
+                  const void *                       voxels,
+                  const std::string &                name);
+
+  PointCloudView
+  streamPointCloud(const Group &       group,
+                   ScalarType          coordinateType,
+                   const void *        coordinates,
+                   std::size_t         numberOfPoints,
+                   const std::string & name,
+                   std::size_t         pointsPerChunk);
+
+  ImageView
+  showImagePyramid(const Group &               group,
+                   const itk::ImageBase<3> *   image,
+                   ScalarType                  pixelType,
+                   const void *                buffer,
+                   const std::string &         name,
+                   const ImagePyramidOptions & options);
+
+  const ImagePyramid &
+  findImagePyramid(const ImageView & imv) const;
+
+  std::shared_ptr<ServerConnection>                       m_connection;
+  std::unique_ptr<ShapeModelTransformationStream>         m_transformationStream;
+  std::unique_ptr<MetricsDump>                            m_metricsDump;
+  std::vector<std::unique_ptr<ShapeModelComponentUpload>> m_componentUploads;
+  std::map<int, std::vector<float>>                       m_sentVertices;
+  std::map<int, std::unique_ptr<ImagePyramid>>            m_imagePyramids;
+  std::unique_ptr<SceneMirror>                            m_scene;
+  bool                                                    m_skipUnchangedUpdates;
 };
 
+// Writes the mesh, which must consist of triangles, as a packed mesh file for StatismoUI::showTriangleMesh:
+// vertices as float32 and triangles as int32 point ids, after a 16 byte header.
+void
+writePackedMeshFile(const std::string & path, const itk::Mesh<float, 3> * mesh);
+
 } // namespace StatismoUI
 
 #endif // UI_STATISMOUI_H
@@ -0,0 +1,421 @@
+#include "StatismoUIAsync.h"
+#include "ServerConnection.h"
+#include "ThriftConversions.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace StatismoUI
+{
+
+// Queue of calls processed by the I/O thread. Each call is split into the part writing the
+// request and the part reading the reply, so that a batch of requests can be written before
+// the first reply is read. Replies arrive in request order on the single connection.
+class AsyncCallQueue
+{
+public:
+  struct Call
+  {
+    std::function<void(ui::UIClient &)>     send;
+    std::function<void(ui::UIClient &)>     receive;
+    std::function<void(std::exception_ptr)> fail;
+  };
+
+  AsyncCallQueue(std::shared_ptr<ServerConnection> connection, unsigned maxRequestsInFlight, unsigned maxQueuedCalls)
+    : m_connection(std::move(connection))
+    , m_maxRequestsInFlight(std::max(1u, maxRequestsInFlight))
+    , m_maxQueuedCalls(std::max(1u, maxQueuedCalls))
+    , m_thread(&AsyncCallQueue::run, this)
+  {}
+
+  // Processes the remaining calls before returning
+  ~AsyncCallQueue()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopped = true;
+    }
+    m_condition.notify_one();
+    m_thread.join();
+  }
+
+  template <typename T, typename SendFunction, typename ReceiveFunction>
+  std::future<T>
+  enqueue(SendFunction && send, ReceiveFunction && receive)
+  {
+    auto           promise = std::make_shared<std::promise<T>>();
+    std::future<T> future = promise->get_future();
+
+    Call call;
+    call.send = std::forward<SendFunction>(send);
+    call.receive = [promise, receive](ui::UIClient & client) {
+      if constexpr (std::is_void<T>::value)
+      {
+        receive(client);
+        promise->set_value();
+      }
+      else
+      {
+        promise->set_value(receive(client));
+      }
+    };
+    call.fail = [promise](std::exception_ptr error) { promise->set_exception(error); };
+
+    {
+      // the calls hold their payloads, wait for room rather than growing the queue
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_taken.wait(lock, [this] { return m_calls.size() < m_maxQueuedCalls; });
+      m_calls.push_back(std::move(call));
+    }
+    m_condition.notify_one();
+    return future;
+  }
+
+private:
+  void
+  run()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+      m_condition.wait(lock, [this] { return m_stopped || !m_calls.empty(); });
+      if (m_calls.empty())
+      {
+        return;
+      }
+
+      std::vector<Call> batch;
+      while (!m_calls.empty() && batch.size() < m_maxRequestsInFlight)
+      {
+        batch.push_back(std::move(m_calls.front()));
+        m_calls.pop_front();
+      }
+      m_taken.notify_all();
+
+      lock.unlock();
+      process(batch);
+      lock.lock();
+    }
+  }
+
+  void
+  process(std::vector<Call> & batch)
+  {
+    auto ui = m_connection->GetThriftClient();
+
+    try
+    {
+      for (auto & call : batch)
+      {
+        call.send(*ui);
+        // the payload is not needed anymore
+        call.send = nullptr;
+      }
+    }
+    catch (...)
+    {
+      // the connection is in an undefined state, none of the replies can be read reliably
+      failFrom(batch, 0, std::current_exception());
+      return;
+    }
+
+    for (std::size_t i = 0; i < batch.size(); ++i)
+    {
+      try
+      {
+        batch[i].receive(*ui);
+      }
+      catch (const apache::thrift::TApplicationException &)
+      {
+        // the service reported an error, its reply has been read completely
+        batch[i].fail(std::current_exception());
+      }
+      catch (...)
+      {
+        failFrom(batch, i, std::current_exception());
+        return;
+      }
+    }
+  }
+
+  static void
+  failFrom(std::vector<Call> & batch, std::size_t first, std::exception_ptr error)
+  {
+    for (std::size_t i = first; i < batch.size(); ++i)
+    {
+      batch[i].fail(error);
+    }
+  }
+
+  std::shared_ptr<ServerConnection> m_connection;
+  std::size_t                       m_maxRequestsInFlight;
+  std::size_t                       m_maxQueuedCalls;
+  std::deque<Call>                  m_calls;
+  bool                              m_stopped{ false };
+  std::mutex                        m_mutex;
+  std::condition_variable           m_condition;
+  // notified when the I/O thread takes calls from the queue
+  std::condition_variable           m_taken;
+  std::thread                       m_thread;
+};
+
+namespace
+{
+// Pipelining needs a fixed thrift client, there is no journal to fall back to. The connection is never shared: the
+// I/O thread keeps it locked for a whole batch of round trips, which would stall the other users of a shared one.
+std::shared_ptr<ServerConnection>
+acquireConnection(ConnectionOptions options)
+{
+  if (options.reconnect.enabled)
+  {
+    throw std::invalid_argument("StatismoUIAsync does not reconnect, use StatismoUI with options.reconnect");
+  }
+  options.shared = false;
+  return ServerConnection::Acquire(options);
+}
+} // namespace
+
+StatismoUIAsync::StatismoUIAsync(const ConnectionOptions & options,
+                                 unsigned                  maxRequestsInFlight,
+                                 unsigned                  maxQueuedRequests)
+  : m_queue(std::make_unique<AsyncCallQueue>(acquireConnection(options), maxRequestsInFlight, maxQueuedRequests))
+{}
+
+StatismoUIAsync::~StatismoUIAsync() = default;
+
+std::future<Group>
+StatismoUIAsync::createGroup(const std::string & name)
+{
+  return m_queue->enqueue<Group>([name](ui::UIClient & client) { client.send_createGroup(name); },
+                                 [](ui::UIClient & client) {
+                                   ui::Group g;
+                                   client.recv_createGroup(g);
+                                   return Group(g.name, g.id);
+                                 });
+}
+
+std::future<TriangleMeshView>
+StatismoUIAsync::showTriangleMesh(const Group & group, const MeshType * mesh, const std::string & name)
+{
+  auto      thriftMesh = std::make_shared<ui::TriangleMesh>(conversions::meshToThriftMesh(mesh));
+  ui::Group thriftGroup = conversions::groupToThriftGroup(group);
+
+  return m_queue->enqueue<TriangleMeshView>(
+    [thriftGroup, thriftMesh, name](ui::UIClient & client) {
+      client.send_showTriangleMesh(thriftGroup, *thriftMesh, name);
+    },
+    [](ui::UIClient & client) {
+      ui::TriangleMeshView tmvThrift;
+      client.recv_showTriangleMesh(tmvThrift);
+      return conversions::triangleMeshViewFromThriftMeshView(tmvThrift);
+    });
+}
+
+std::future<TriangleMeshView>
+StatismoUIAsync::showPackedTriangleMesh(const Group &       group,
+                                        const MeshType *    mesh,
+                                        const std::string & name,
+                                        ScalarType          vertexType)
+{
+  auto packedMesh = std::make_shared<ui::PackedTriangleMesh>(conversions::meshToPackedThriftMesh(mesh, vertexType));
+  ui::Group thriftGroup = conversions::groupToThriftGroup(group);
+
+  return m_queue->enqueue<TriangleMeshView>(
+    [thriftGroup, packedMesh, name](ui::UIClient & client) {
+      client.send_showPackedTriangleMesh(thriftGroup, *packedMesh, name);
+    },
+    [](ui::UIClient & client) {
+      ui::TriangleMeshView tmvThrift;
+      client.recv_showPackedTriangleMesh(tmvThrift);
+      return conversions::triangleMeshViewFromThriftMeshView(tmvThrift);
+    });
+}
+
+std::future<void>
+StatismoUIAsync::showPointCloud(const Group & group, const std::list<PointType> & points, const std::string & name)
+{
+  auto      pts = std::make_shared<ui::PointList>(conversions::pointsToThriftPointList(points));
+  ui::Group thriftGroup = conversions::groupToThriftGroup(group);
+
+  return m_queue->enqueue<void>(
+    [thriftGroup, pts, name](ui::UIClient & client) { client.send_showPointCloud(thriftGroup, *pts, name); },
+    [](ui::UIClient & client) { client.recv_showPointCloud(); });
+}
+
+std::future<ShapeModelView>
+StatismoUIAsync::showStatisticalShapeModel(const Group &                group,
+                                           const StatisticalModelType * ssm,
+                                           const std::string &          name)
+{
+  auto      model = std::make_shared<ui::StatisticalShapeModel>(conversions::statisticalModelToThrift(ssm));
+  ui::Group thriftGroup = conversions::groupToThriftGroup(group);
+
+  return m_queue->enqueue<ShapeModelView>(
+    [thriftGroup, model, name](ui::UIClient & client) {
+      client.send_showStatisticalShapeModel(thriftGroup, *model, name);
+    },
+    [](ui::UIClient & client) {
+      ui::ShapeModelView thriftSSMView;
+      client.recv_showStatisticalShapeModel(thriftSSMView);
+      return conversions::shapeModelViewFromThrift(thriftSSMView);
+    });
+}
+
+std::future<ShapeModelView>
+StatismoUIAsync::showPackedStatisticalShapeModel(const Group &                group,
+                                                 const StatisticalModelType * ssm,
+                                                 const std::string &          name,
+                                                 ScalarType                   scalarType)
+{
+  auto model =
+    std::make_shared<ui::PackedStatisticalShapeModel>(conversions::statisticalModelToPackedThrift(ssm, scalarType));
+  ui::Group thriftGroup = conversions::groupToThriftGroup(group);
+
+  return m_queue->enqueue<ShapeModelView>(
+    [thriftGroup, model, name](ui::UIClient & client) {
+      client.send_showPackedStatisticalShapeModel(thriftGroup, *model, name);
+    },
+    [](ui::UIClient & client) {
+      ui::ShapeModelView thriftSSMView;
+      client.recv_showPackedStatisticalShapeModel(thriftSSMView);
+      return conversions::shapeModelViewFromThrift(thriftSSMView);
+    });
+}
+
+std::future<void>
+StatismoUIAsync::showLandmark(const Group &              group,
+                              const PointType &          point,
+                              const vnl_matrix<double> & cov,
+                              const std::string &        name)
+{
+  ui::Landmark landmark = conversions::landmarkToThrift(point, cov, name);
+  ui::Group    thriftGroup = conversions::groupToThriftGroup(group);
+
+  return m_queue->enqueue<void>(
+    [thriftGroup, landmark, name](ui::UIClient & client) { client.send_showLandmark(thriftGroup, landmark, name); },
+    [](ui::UIClient & client) { client.recv_showLandmark(); });
+}
+
+std::future<ImageView>
+StatismoUIAsync::showImage(const Group & group, const ImageType * image, const std::string & name)
+{
+  auto      thriftImage = std::make_shared<ui::Image>(conversions::imageToThrift(image));
+  ui::Group thriftGroup = conversions::groupToThriftGroup(group);
+
+  return m_queue->enqueue<ImageView>(
+    [thriftGroup, thriftImage, name](ui::UIClient & client) {
+      client.send_showImage(thriftGroup, *thriftImage, name);
+    },
+    [](ui::UIClient & client) {
+      ui::ImageView thriftImageView;
+      client.recv_showImage(thriftImageView);
+      return conversions::imageViewFromThriftImageView(thriftImageView);
+    });
+}
+
+std::future<ImageView>
+StatismoUIAsync::showPackedImage(const Group &             group,
+                                 const itk::ImageBase<3> * image,
+                                 ScalarType                pixelType,
+                                 const void *              buffer,
+                                 std::size_t               numberOfBytes,
+                                 const std::string &       name)
+{
+  auto packedImage =
+    std::make_shared<ui::PackedImage>(conversions::packedImageToThrift(image, pixelType, buffer, numberOfBytes));
+  ui::Group thriftGroup = conversions::groupToThriftGroup(group);
+
+  return m_queue->enqueue<ImageView>(
+    [thriftGroup, packedImage, name](ui::UIClient & client) {
+      client.send_showPackedImage(thriftGroup, *packedImage, name);
+    },
+    [](ui::UIClient & client) {
+      ui::ImageView thriftImageView;
+      client.recv_showPackedImage(thriftImageView);
+      return conversions::imageViewFromThriftImageView(thriftImageView);
+    });
+}
+
+std::future<void>
+StatismoUIAsync::updateShapeModelTransformationView(const ShapeModelTransformationView & smv)
+{
+  ui::ShapeModelTransformationView smvThrift = conversions::shapeModelTransformationViewToThrift(smv);
+
+  return m_queue->enqueue<void>(
+    [smvThrift](ui::UIClient & client) { client.send_updateShapeModelTransformation(smvThrift); },
+    [](ui::UIClient & client) { client.recv_updateShapeModelTransformation(); });
+}
+
+std::future<void>
+StatismoUIAsync::updateTriangleMeshView(const TriangleMeshView & tmv)
+{
+  ui::TriangleMeshView thriftTmv = conversions::thriftMeshViewFromTriangleMeshView(tmv);
+
+  return m_queue->enqueue<void>([thriftTmv](ui::UIClient & client) { client.send_updateTriangleMeshView(thriftTmv); },
+                                [](ui::UIClient & client) { client.recv_updateTriangleMeshView(); });
+}
+
+std::future<void>
+StatismoUIAsync::updateImageView(const ImageView & imageView)
+{
+  ui::ImageView thriftImageView = conversions::imageViewToThriftImageView(imageView);
+
+  return m_queue->enqueue<void>(
+    [thriftImageView](ui::UIClient & client) { client.send_updateImageView(thriftImageView); },
+    [](ui::UIClient & client) { client.recv_updateImageView(); });
+}
+
+std::future<void>
+StatismoUIAsync::removeGroup(const Group & group)
+{
+  ui::Group thriftGroup = conversions::groupToThriftGroup(group);
+
+  return m_queue->enqueue<void>([thriftGroup](ui::UIClient & client) { client.send_removeGroup(thriftGroup); },
+                                [](ui::UIClient & client) { client.recv_removeGroup(); });
+}
+
+std::future<void>
+StatismoUIAsync::removeTriangleMesh(const TriangleMeshView & tmv)
+{
+  ui::TriangleMeshView thriftTmv = conversions::thriftMeshViewFromTriangleMeshView(tmv);
+
+  return m_queue->enqueue<void>([thriftTmv](ui::UIClient & client) { client.send_removeTriangleMesh(thriftTmv); },
+                                [](ui::UIClient & client) { client.recv_removeTriangleMesh(); });
+}
+
+std::future<void>
+StatismoUIAsync::removeImage(const ImageView & imv)
+{
+  ui::ImageView thriftImageView = conversions::imageViewToThriftImageView(imv);
+
+  return m_queue->enqueue<void>([thriftImageView](ui::UIClient & client) { client.send_removeImage(thriftImageView); },
+                                [](ui::UIClient & client) { client.recv_removeImage(); });
+}
+
+std::future<void>
+StatismoUIAsync::removeShapeModelTransformation(const ShapeModelTransformationView & ssmtview)
+{
+  ui::ShapeModelTransformationView tssmView = conversions::shapeModelTransformationViewToThrift(ssmtview);
+
+  return m_queue->enqueue<void>(
+    [tssmView](ui::UIClient & client) { client.send_removeShapeModelTransformation(tssmView); },
+    [](ui::UIClient & client) { client.recv_removeShapeModelTransformation(); });
+}
+
+std::future<void>
+StatismoUIAsync::removeShapeModel(const ShapeModelView & ssmview)
+{
+  ui::ShapeModelView smvThrift = conversions::shapeModelViewToThriftShapeModelView(ssmview);
+
+  return m_queue->enqueue<void>([smvThrift](ui::UIClient & client) { client.send_removeShapeModel(smvThrift); },
+                                [](ui::UIClient & client) { client.recv_removeShapeModel(); });
+}
+
+} // namespace StatismoUI
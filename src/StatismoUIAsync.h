@@ -0,0 +1,116 @@
+#ifndef UI_STATISMOUIASYNC_H
+#define UI_STATISMOUIASYNC_H
+
+#include "StatismoUI.h"
+
+#include <future>
+#include <memory>
+
+namespace StatismoUI
+{
+class AsyncCallQueue;
+
+// Non-blocking variant of StatismoUI. Every call encodes its payload in the calling thread, queues the request and
+// returns immediately. A dedicated I/O thread pipelines the queued requests over the connection (up to
+// maxRequestsInFlight requests are written before their replies are read) and resolves the returned futures
+// when the replies arrive. Requests are executed in the order they were issued. options.reconnect is not supported,
+// and options.shared is ignored: the client always opens a connection of its own.
+// A queued request holds its encoded payload: once maxQueuedRequests wait to be sent, a call blocks until the I/O
+// thread takes one, so that a thread issuing calls faster than the network drains them does not grow the memory
+// without limit.
+class StatismoUIAsync
+{
+  using MeshType = itk::Mesh<float, 3>;
+  using PointType = MeshType::PointType;
+  using ImageType = itk::Image<short, 3>;
+  using StatisticalModelType = itk::StatisticalModel<MeshType>;
+
+public:
+  explicit StatismoUIAsync(const ConnectionOptions & options = ConnectionOptions(),
+                           unsigned                  maxRequestsInFlight = 16,
+                           unsigned                  maxQueuedRequests = 64);
+
+  // Waits until all queued requests are sent and answered
+  ~StatismoUIAsync();
+
+  StatismoUIAsync(const StatismoUIAsync &) = delete;
+  StatismoUIAsync &
+  operator=(const StatismoUIAsync &) = delete;
+
+  std::future<Group>
+  createGroup(const std::string & name);
+
+  std::future<TriangleMeshView>
+  showTriangleMesh(const Group & group, const MeshType * mesh, const std::string & name);
+
+  std::future<TriangleMeshView>
+  showPackedTriangleMesh(const Group &       group,
+                         const MeshType *    mesh,
+                         const std::string & name,
+                         ScalarType          vertexType = ScalarType::Float32);
+
+  std::future<void>
+  showPointCloud(const Group & group, const std::list<PointType> & points, const std::string & name);
+
+  std::future<ShapeModelView>
+  showStatisticalShapeModel(const Group & group, const StatisticalModelType * ssm, const std::string & name);
+
+  std::future<ShapeModelView>
+  showPackedStatisticalShapeModel(const Group &                group,
+                                  const StatisticalModelType * ssm,
+                                  const std::string &          name,
+                                  ScalarType                   scalarType = ScalarType::Float32);
+
+  std::future<void>
+  showLandmark(const Group & group, const PointType & point, const vnl_matrix<double> & cov, const std::string & name);
+
+  std::future<ImageView>
+  showImage(const Group & group, const ImageType * image, const std::string & name);
+
+  template <typename TPixel>
+  std::future<ImageView>
+  showPackedImage(const Group & group, const itk::Image<TPixel, 3> * image, const std::string & name)
+  {
+    return showPackedImage(group,
+                           image,
+                           ScalarTypeTraits<TPixel>::value,
+                           image->GetBufferPointer(),
+                           image->GetPixelContainer()->Size() * sizeof(TPixel),
+                           name);
+  }
+
+  std::future<void>
+  updateShapeModelTransformationView(const ShapeModelTransformationView & smv);
+
+  std::future<void>
+  updateTriangleMeshView(const TriangleMeshView & tmv);
+
+  std::future<void>
+  updateImageView(const ImageView & imv);
+
+  std::future<void>
+  removeGroup(const Group & group);
+  std::future<void>
+  removeTriangleMesh(const TriangleMeshView & tmv);
+  std::future<void>
+  removeImage(const ImageView & imv);
+  std::future<void>
+  removeShapeModelTransformation(const ShapeModelTransformationView & ssmtview);
+  std::future<void>
+  removeShapeModel(const ShapeModelView & ssmview);
+
+private:
+  std::future<ImageView>
+  showPackedImage(const Group &             group,
+                  const itk::ImageBase<3> * image,
+                  ScalarType                pixelType,
+                  const void *              buffer,
+                  std::size_t               numberOfBytes,
+                  const std::string &       name);
+
+  std::unique_ptr<AsyncCallQueue> m_queue;
+};
+
+} // namespace StatismoUI
+
+#endif // UI_STATISMOUIASYNC_H
@@ -0,0 +1,157 @@
+#ifndef UI_SYMMETRICEIGEN3_H
+#define UI_SYMMETRICEIGEN3_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+// Eigendecomposition of symmetric 3 x 3 matrices, such as landmark covariances.
+namespace StatismoUI
+{
+namespace detail
+{
+constexpr std::size_t symmetricEigen3BlockSize = 8;
+
+// A block of symmetric 3 x 3 matrices stored entry by entry, so that the loops over the matrices of the block are
+// vectorized by the compiler. a[i][j][m] is entry (i, j) of matrix m.
+struct SymmetricEigen3Block
+{
+  alignas(64) double a[3][3][symmetricEigen3BlockSize];
+  alignas(64) double v[3][3][symmetricEigen3BlockSize];
+
+  // Symmetrizes the input, the entries must be stored row by row
+  void
+  setMatrix(std::size_t m, const double * entries)
+  {
+    for (unsigned i = 0; i < 3; ++i)
+    {
+      for (unsigned j = 0; j < 3; ++j)
+      {
+        a[i][j][m] = 0.5 * (entries[3 * i + j] + entries[3 * j + i]);
+      }
+    }
+  }
+
+  void
+  setIdentity(std::size_t m)
+  {
+    for (unsigned i = 0; i < 3; ++i)
+    {
+      for (unsigned j = 0; j < 3; ++j)
+      {
+        a[i][j][m] = i == j ? 1.0 : 0.0;
+      }
+    }
+  }
+
+  // Valid after symmetricEigen3, in decreasing order
+  double
+  eigenvalue(std::size_t m, unsigned i) const
+  {
+    return a[i][i][m];
+  }
+
+  // Component k of the unit eigenvector i: the eigenvectors are the columns of v, as the columns of U in the SVD
+  double
+  eigenvector(std::size_t m, unsigned i, unsigned k) const
+  {
+    return v[k][i][m];
+  }
+};
+
+// Jacobi rotation in the (p, q) plane that zeroes a[p][q], r is the remaining index
+template <unsigned p, unsigned q, unsigned r>
+inline void
+jacobiRotation(SymmetricEigen3Block & block)
+{
+  auto & a = block.a;
+  auto & v = block.v;
+  for (std::size_t m = 0; m < symmetricEigen3BlockSize; ++m)
+  {
+    // t = tan of the rotation angle, the smaller root of t^2 + 2 t (a_qq - a_pp) / (2 a_pq) - 1 = 0. The
+    // denominator vanishes only if a_pq is 0, t is then 0 without a branch.
+    const double apq = a[p][q][m];
+    const double d = a[q][q][m] - a[p][p][m];
+    const double o = 2 * apq;
+    const double denominator = std::abs(d) + std::sqrt(d * d + o * o);
+    const double t = std::copysign(1.0, d) * o / std::max(denominator, std::numeric_limits<double>::min());
+    const double c = 1 / std::sqrt(t * t + 1);
+    const double s = t * c;
+
+    a[p][p][m] -= t * apq;
+    a[q][q][m] += t * apq;
+    a[p][q][m] = 0;
+    a[q][p][m] = 0;
+
+    const double arp = a[r][p][m];
+    const double arq = a[r][q][m];
+    a[r][p][m] = a[p][r][m] = c * arp - s * arq;
+    a[r][q][m] = a[q][r][m] = s * arp + c * arq;
+
+    for (unsigned k = 0; k < 3; ++k)
+    {
+      const double vkp = v[k][p][m];
+      const double vkq = v[k][q][m];
+      v[k][p][m] = c * vkp - s * vkq;
+      v[k][q][m] = s * vkp + c * vkq;
+    }
+  }
+}
+
+// Swaps eigenpairs i and j of the matrices where eigenvalue i is the smaller one
+template <unsigned i, unsigned j>
+inline void
+sortEigenpairs(SymmetricEigen3Block & block)
+{
+  auto & a = block.a;
+  auto & v = block.v;
+  for (std::size_t m = 0; m < symmetricEigen3BlockSize; ++m)
+  {
+    const bool   swap = a[i][i][m] < a[j][j][m];
+    const double ai = a[i][i][m];
+    const double aj = a[j][j][m];
+    a[i][i][m] = swap ? aj : ai;
+    a[j][j][m] = swap ? ai : aj;
+    for (unsigned k = 0; k < 3; ++k)
+    {
+      const double vki = v[k][i][m];
+      const double vkj = v[k][j][m];
+      v[k][i][m] = swap ? vkj : vki;
+      v[k][j][m] = swap ? vki : vkj;
+    }
+  }
+}
+
+// Diagonalizes the matrices of the block in place with a fixed number of cyclic Jacobi sweeps, which is enough for
+// convergence to double precision as Jacobi converges quadratically. Afterwards the diagonal of a holds the
+// eigenvalues in decreasing order and the columns of v the corresponding eigenvectors. No memory is allocated.
+inline void
+symmetricEigen3(SymmetricEigen3Block & block)
+{
+  constexpr unsigned numberOfSweeps = 6;
+
+  for (unsigned i = 0; i < 3; ++i)
+  {
+    for (unsigned j = 0; j < 3; ++j)
+    {
+      std::fill_n(block.v[i][j], symmetricEigen3BlockSize, i == j ? 1.0 : 0.0);
+    }
+  }
+
+  for (unsigned sweep = 0; sweep < numberOfSweeps; ++sweep)
+  {
+    jacobiRotation<0, 1, 2>(block);
+    jacobiRotation<0, 2, 1>(block);
+    jacobiRotation<1, 2, 0>(block);
+  }
+
+  sortEigenpairs<0, 1>(block);
+  sortEigenpairs<1, 2>(block);
+  sortEigenpairs<0, 1>(block);
+}
+
+} // namespace detail
+} // namespace StatismoUI
+
+#endif // UI_SYMMETRICEIGEN3_H
@@ -0,0 +1,1170 @@
+#include "ThriftConversions.h"
+#include "ParallelFor.h"
+#include "Sha256.h"
+#include "SymmetricEigen3.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace StatismoUI
+{
+namespace conversions
+{
+
+namespace
+{
+// Packed arrays are copied in host byte order, and ui.thrift defines them as little-endian. Compilers without
+// __BYTE_ORDER__ (MSVC) only target little-endian hosts.
+#if defined(__BYTE_ORDER__)
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "packed arrays need a little-endian host");
+#endif
+
+template <typename T>
+void
+writeScalar(char * dst, std::size_t index, T value)
+{
+  std::memcpy(dst + index * sizeof(T), &value, sizeof(T));
+}
+
+// Smallest amount of work (points, cells or matrix entries) worth a thread of its own
+constexpr std::size_t minElementsPerChunk = 32768;
+
+// Edge of the tiles in which matrices are transposed, a tile of floats fits in L1 with room to spare
+constexpr std::size_t transposeBlockSize = 64;
+
+// Calls f(i, point) for all points, in parallel. Reads the point container directly instead of copying
+// each point through GetPoint.
+template <typename F>
+void
+forEachPoint(const MeshType * mesh, F && f)
+{
+  if (mesh->GetNumberOfPoints() == 0)
+  {
+    return;
+  }
+  const auto & points = mesh->GetPoints()->CastToSTLConstContainer();
+  parallelFor(points.size(), minElementsPerChunk, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i)
+    {
+      f(i, points[i]);
+    }
+  });
+}
+
+// Calls f(i, pointIds) for all cells, in parallel. pointIds points to the first of the three point ids of a
+// triangle; unlike GetPointIdsContainer, PointIdsBegin does not copy the ids.
+template <typename F>
+void
+forEachTriangle(const MeshType * mesh, F && f)
+{
+  if (mesh->GetNumberOfCells() == 0)
+  {
+    return;
+  }
+  const auto & cells = mesh->GetCells()->CastToSTLConstContainer();
+  parallelFor(cells.size(), minElementsPerChunk, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i)
+    {
+      f(i, cells[i]->PointIdsBegin());
+    }
+  });
+}
+
+// Calls f(row, column, value) for all entries of the row-major matrix m, in the order of a cache blocked
+// transposition: tile by tile, column by column within a tile. Row ranges are processed in parallel.
+template <typename F>
+void
+forEachEntryColumnMajor(const vnl_matrix<float> & m, F && f)
+{
+  const std::size_t rows = m.rows();
+  const std::size_t cols = m.cols();
+  const float *     data = m.data_block();
+  if (cols == 0)
+  {
+    return;
+  }
+
+  const std::size_t minRowsPerChunk = std::max(transposeBlockSize, minElementsPerChunk / cols);
+  parallelFor(rows, minRowsPerChunk, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t rowBlock = begin; rowBlock < end; rowBlock += transposeBlockSize)
+    {
+      const std::size_t rowEnd = std::min(rowBlock + transposeBlockSize, end);
+      for (std::size_t colBlock = 0; colBlock < cols; colBlock += transposeBlockSize)
+      {
+        const std::size_t colEnd = std::min(colBlock + transposeBlockSize, cols);
+        for (std::size_t c = colBlock; c < colEnd; ++c)
+        {
+          for (std::size_t r = rowBlock; r < rowEnd; ++r)
+          {
+            f(r, c, data[r * cols + c]);
+          }
+        }
+      }
+    }
+  });
+}
+
+template <typename T>
+void
+packVertices(const MeshType * mesh, std::string & vertices)
+{
+  if constexpr (std::is_same_v<T, MeshType::CoordRepType>)
+  {
+    // the points container already holds x0 y0 z0 x1 ... of that type
+    const MeshType::CoordRepType * coordinates = detail::pointCoordinates(mesh);
+    vertices.assign(reinterpret_cast<const char *>(coordinates), 3 * mesh->GetNumberOfPoints() * sizeof(T));
+    return;
+  }
+
+  vertices.resize(3 * mesh->GetNumberOfPoints() * sizeof(T));
+
+  char * dst = &vertices[0];
+  forEachPoint(mesh, [dst](std::size_t i, const MeshType::PointType & pt) {
+    writeScalar<T>(dst, 3 * i, pt[0]);
+    writeScalar<T>(dst, 3 * i + 1, pt[1]);
+    writeScalar<T>(dst, 3 * i + 2, pt[2]);
+  });
+}
+
+template <typename T, typename VectorType>
+void
+packVector(const VectorType & v, std::size_t size, std::string & out)
+{
+  out.resize(size * sizeof(T));
+
+  char * dst = &out[0];
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    writeScalar<T>(dst, i, v[i]);
+  }
+}
+
+template <typename T>
+void
+packColumnMajor(const vnl_matrix<float> & m, std::string & out)
+{
+  out.resize(m.rows() * m.cols() * sizeof(T));
+
+  char *            dst = &out[0];
+  const std::size_t rows = m.rows();
+  forEachEntryColumnMajor(
+    m, [dst, rows](std::size_t r, std::size_t c, float value) { writeScalar<T>(dst, c * rows + r, value); });
+}
+
+// Copy of m in column-major order
+std::vector<float>
+toColumnMajor(const vnl_matrix<float> & m)
+{
+  std::vector<float> columns(std::size_t(m.rows()) * m.cols());
+  const std::size_t  rows = m.rows();
+  forEachEntryColumnMajor(
+    m, [&columns, rows](std::size_t r, std::size_t c, float value) { columns[c * rows + r] = value; });
+  return columns;
+}
+
+template <typename T>
+T
+readScalar(const char * src, std::size_t index)
+{
+  T value;
+  std::memcpy(&value, src + index * sizeof(T), sizeof(T));
+  return value;
+}
+
+// IEEE 754 binary32 to binary16, rounding to nearest even
+std::uint16_t
+floatToHalf(float value)
+{
+  std::uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+
+  const std::uint16_t sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000);
+  const std::uint32_t absBits = bits & 0x7fffffff;
+  if (absBits >= 0x7f800000)
+  {
+    return sign | 0x7c00 | (absBits > 0x7f800000 ? 0x200 : 0); // inf, nan
+  }
+  if (absBits >= 0x477ff000)
+  {
+    return sign | 0x7c00; // rounds to a value above the largest half
+  }
+  if (absBits < 0x38800000)
+  {
+    // subnormal half: value = m * 2^-24
+    if (absBits < 0x33000000)
+    {
+      return sign;
+    }
+    const std::uint32_t mantissa = (absBits & 0x7fffff) | 0x800000;
+    const unsigned      shift = 126 - (absBits >> 23);
+    std::uint32_t       half = mantissa >> shift;
+    const std::uint32_t remainder = mantissa & ((1u << shift) - 1);
+    const std::uint32_t halfway = 1u << (shift - 1);
+    if (remainder > halfway || (remainder == halfway && (half & 1)))
+    {
+      ++half;
+    }
+    return sign | static_cast<std::uint16_t>(half);
+  }
+
+  // rebias the exponent from 127 to 15, a carry out of the mantissa correctly increments the exponent
+  std::uint32_t       half = (absBits - 0x38000000) >> 13;
+  const std::uint32_t remainder = absBits & 0x1fff;
+  if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+  {
+    ++half;
+  }
+  return sign | static_cast<std::uint16_t>(half);
+}
+
+float
+halfToFloat(std::uint16_t half)
+{
+  const std::uint32_t sign = std::uint32_t(half & 0x8000) << 16;
+  const std::uint32_t exponent = (half >> 10) & 0x1f;
+  const std::uint32_t mantissa = half & 0x3ff;
+  if (exponent == 0)
+  {
+    float value = std::ldexp(static_cast<float>(mantissa), -24);
+    return sign ? -value : value;
+  }
+
+  std::uint32_t bits = sign | (mantissa << 13);
+  bits |= (exponent == 0x1f) ? 0x7f800000 : (exponent + 112) << 23;
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+ui::Point3D
+point3D(const PointType & point)
+{
+  ui::Point3D p;
+  p.x = point.GetElement(0);
+  p.y = point.GetElement(1);
+  p.z = point.GetElement(2);
+  return p;
+}
+
+ui::Vector3D
+vector3D(double x, double y, double z)
+{
+  ui::Vector3D v;
+  v.x = x;
+  v.y = y;
+  v.z = z;
+  return v;
+}
+
+// The variances are the eigenvalues of the covariance, clamped at 0 against rounding. principalAxis<i + 1> holds
+// row i of the eigenvector matrix, as it held row i of U when the covariance was decomposed with vnl_svd.
+void
+setUncertainty(ui::UncertaintyCovariance & uncertainty, const detail::SymmetricEigen3Block & block, std::size_t m)
+{
+  uncertainty.variances = vector3D(std::max(0.0, block.eigenvalue(m, 0)),
+                                   std::max(0.0, block.eigenvalue(m, 1)),
+                                   std::max(0.0, block.eigenvalue(m, 2)));
+  ui::Vector3D * axes[] = { &uncertainty.principalAxis1, &uncertainty.principalAxis2, &uncertainty.principalAxis3 };
+  for (unsigned i = 0; i < 3; ++i)
+  {
+    *axes[i] = vector3D(block.eigenvector(m, 0, i), block.eigenvector(m, 1, i), block.eigenvector(m, 2, i));
+  }
+}
+
+// A model of the packed reference, the mean deformation and the first numberOfComponents columns of the basis. The
+// mean is stored as Float64 if scalarType is, as Float32 otherwise.
+ui::PackedStatisticalShapeModel
+packedModel(ui::PackedTriangleMesh && reference,
+            const vnl_vector<float> & meanDf,
+            const vnl_matrix<float> & pcaBasisMatrix,
+            const vnl_vector<float> & variances,
+            unsigned                  numberOfComponents,
+            ScalarType                scalarType)
+{
+  if (numberOfComponents > pcaBasisMatrix.cols())
+  {
+    throw std::invalid_argument("the model has only " + std::to_string(pcaBasisMatrix.cols()) + " components");
+  }
+
+  ui::PackedStatisticalShapeModel model;
+  model.reference = std::move(reference);
+
+  if (scalarType == ScalarType::Float64)
+  {
+    model.meanType = ui::ScalarType::FLOAT64;
+    packVector<double>(meanDf, pcaBasisMatrix.rows(), model.mean);
+  }
+  else
+  {
+    model.meanType = ui::ScalarType::FLOAT32;
+    packVector<float>(meanDf, pcaBasisMatrix.rows(), model.mean);
+  }
+
+  if (numberOfComponents == pcaBasisMatrix.cols())
+  {
+    model.klbasis = klBasisToPackedThrift(pcaBasisMatrix, variances, scalarType);
+  }
+  else
+  {
+    model.klbasis = klBasisToPackedThrift(pcaBasisMatrix.extract(pcaBasisMatrix.rows(), numberOfComponents),
+                                          variances.extract(numberOfComponents),
+                                          scalarType);
+  }
+  return model;
+}
+} // namespace
+
+ui::ScalarType::type
+scalarTypeToThrift(ScalarType scalarType)
+{
+  switch (scalarType)
+  {
+    case ScalarType::Float32:
+      return ui::ScalarType::FLOAT32;
+    case ScalarType::Float64:
+      return ui::ScalarType::FLOAT64;
+    case ScalarType::Int8:
+      return ui::ScalarType::INT8;
+    case ScalarType::UInt8:
+      return ui::ScalarType::UINT8;
+    case ScalarType::Int16:
+      return ui::ScalarType::INT16;
+    case ScalarType::UInt16:
+      return ui::ScalarType::UINT16;
+    case ScalarType::Int32:
+      return ui::ScalarType::INT32;
+    case ScalarType::UInt32:
+      return ui::ScalarType::UINT32;
+    case ScalarType::Float16:
+      return ui::ScalarType::FLOAT16;
+  }
+  throw std::invalid_argument("unsupported scalar type");
+}
+
+std::size_t
+scalarTypeSize(ScalarType scalarType)
+{
+  switch (scalarType)
+  {
+    case ScalarType::Float64:
+      return 8;
+    case ScalarType::Float32:
+    case ScalarType::Int32:
+    case ScalarType::UInt32:
+      return 4;
+    case ScalarType::Int16:
+    case ScalarType::UInt16:
+    case ScalarType::Float16:
+      return 2;
+    case ScalarType::Int8:
+    case ScalarType::UInt8:
+      return 1;
+  }
+  throw std::invalid_argument("unsupported scalar type");
+}
+
+ui::Group
+groupToThriftGroup(const Group & group)
+{
+  ui::Group thriftGroup;
+  thriftGroup.id = group.GetId();
+  thriftGroup.name = group.GetName().c_str();
+  return thriftGroup;
+}
+
+TriangleMeshView
+triangleMeshViewFromThriftMeshView(const ui::TriangleMeshView & tmvThrift)
+{
+  Color color(tmvThrift.color.r, tmvThrift.color.g, tmvThrift.color.b);
+
+  TriangleMeshView tmv(tmvThrift.id, color, tmvThrift.opacity, tmvThrift.lineWidth);
+  return tmv;
+}
+
+ui::TriangleMeshView
+thriftMeshViewFromTriangleMeshView(const TriangleMeshView & tmv)
+{
+  ui::TriangleMeshView thriftTmv;
+  Color                color = tmv.GetColor();
+  thriftTmv.id = tmv.GetId();
+  thriftTmv.color.r = color.red;
+  thriftTmv.color.g = color.green;
+  thriftTmv.color.b = color.blue;
+  thriftTmv.opacity = tmv.GetOpacity();
+  thriftTmv.lineWidth = tmv.GetLineWidth();
+  return thriftTmv;
+}
+
+ShapeModelTransformationView
+shapeModelTransformationViewFromThrift(const ui::ShapeModelTransformationView & tvthrift)
+{
+  vnl_vector<float> coeffs(tvthrift.shapeTransformation.coefficients.size());
+  for (unsigned i = 0; i < coeffs.size(); ++i)
+  {
+    coeffs[i] = tvthrift.shapeTransformation.coefficients[i];
+  }
+
+  itk::Euler3DTransform<float>::Pointer        eulerTransform = itk::Euler3DTransform<float>::New();
+  itk::Euler3DTransform<float>::InputPointType center;
+  center.SetElement(0, tvthrift.poseTransformation.rotation.center.x);
+  center.SetElement(1, tvthrift.poseTransformation.rotation.center.y);
+  center.SetElement(2, tvthrift.poseTransformation.rotation.center.z);
+
+  eulerTransform->SetCenter(center);
+  eulerTransform->SetRotation(tvthrift.poseTransformation.rotation.angleX,
+                              tvthrift.poseTransformation.rotation.angleY,
+                              tvthrift.poseTransformation.rotation.angleZ);
+  itk::Vector<float> v(3);
+  v.SetElement(0, tvthrift.poseTransformation.translation.x);
+  v.SetElement(1, tvthrift.poseTransformation.translation.y);
+  v.SetElement(2, tvthrift.poseTransformation.translation.z);
+  eulerTransform->SetTranslation(v);
+
+  PoseTransformation pose(*eulerTransform);
+  return ShapeModelTransformationView(tvthrift.id, pose, ShapeTransformation(std::move(coeffs)));
+}
+
+ShapeModelView
+shapeModelViewFromThrift(const ui::ShapeModelView & smvThrift)
+{
+  TriangleMeshView             tmv = triangleMeshViewFromThriftMeshView(smvThrift.meshView);
+  ShapeModelTransformationView smv = shapeModelTransformationViewFromThrift(smvThrift.shapeModelTransformationView);
+  ShapeModelView               ssmView(tmv, smv);
+  return ssmView;
+}
+
+ui::ShapeModelTransformationView
+shapeModelTransformationViewToThrift(const ShapeModelTransformationView & tv)
+{
+  ui::ShapeModelTransformationView tvthrift;
+  ui::RigidTransformation          rtThrift;
+  ui::EulerTransform               eulerThrift;
+
+  eulerThrift.angleX = tv.GetPoseTransformation().GetAngleX();
+  eulerThrift.angleY = tv.GetPoseTransformation().GetAngleY();
+  eulerThrift.angleZ = tv.GetPoseTransformation().GetAngleZ();
+  ui::Point3D center;
+
+  center.x = tv.GetPoseTransformation().GetCenter()[0];
+  center.y = tv.GetPoseTransformation().GetCenter()[1];
+  center.z = tv.GetPoseTransformation().GetCenter()[2];
+
+  eulerThrift.center = center;
+  rtThrift.rotation = eulerThrift;
+
+  ui::TranslationTransform translationThrift;
+  translationThrift.x = tv.GetPoseTransformation().GetTranslation()[0];
+  translationThrift.y = tv.GetPoseTransformation().GetTranslation()[1];
+  translationThrift.z = tv.GetPoseTransformation().GetTranslation()[2];
+  rtThrift.translation = translationThrift;
+
+  ui::ShapeTransformation stThrift;
+  ui::DoubleVector        coeffsThrift;
+
+  vnl_vector<float> coeffs = tv.GetShapeTransformation().GetCoefficients();
+  for (unsigned i = 0; i < coeffs.size(); ++i)
+  {
+    coeffsThrift.push_back(coeffs[i]);
+  }
+
+  stThrift.coefficients = coeffsThrift;
+  tvthrift.shapeTransformation = stThrift;
+  tvthrift.poseTransformation = rtThrift;
+  tvthrift.id = tv.GetId();
+  return tvthrift;
+}
+
+ui::PointList
+pointsToThriftPointList(const std::list<PointType> & points)
+{
+  ui::PointList pts;
+  pts.reserve(points.size());
+
+  for (const auto & pt : points)
+  {
+    ui::Point3D p;
+    p.x = pt.GetElement(0);
+    p.y = pt.GetElement(1);
+    p.z = pt.GetElement(2);
+    pts.push_back(p);
+  }
+  return pts;
+}
+
+void
+pointsToPackedThrift(const PointType * points, std::size_t numberOfPoints, ui::PackedPointChunk & chunk)
+{
+  chunk.numberOfPoints = static_cast<std::int32_t>(numberOfPoints);
+  chunk.pointType = ui::ScalarType::FLOAT32;
+  chunk.points.resize(3 * numberOfPoints * sizeof(float));
+
+  // a chunk of a stream: packed on the calling thread, starting threads for every chunk would cost more
+  char * dst = &chunk.points[0];
+  for (std::size_t i = 0; i < numberOfPoints; ++i)
+  {
+    writeScalar<float>(dst, 3 * i, points[i][0]);
+    writeScalar<float>(dst, 3 * i + 1, points[i][1]);
+    writeScalar<float>(dst, 3 * i + 2, points[i][2]);
+  }
+}
+
+ui::Landmark
+landmarkToThrift(const PointType & point, const vnl_matrix<double> & cov, const std::string & name)
+{
+  return landmarksToThrift({ point }, { cov }, { name }).front();
+}
+
+std::vector<ui::Landmark>
+landmarksToThrift(const std::vector<PointType> &          points,
+                  const std::vector<vnl_matrix<double>> & covariances,
+                  const std::vector<std::string> &        names)
+{
+  if (covariances.size() != points.size() || names.size() != points.size())
+  {
+    throw std::invalid_argument("points, covariances and names must have the same size");
+  }
+  for (const auto & cov : covariances)
+  {
+    if (cov.cols() != 3 || cov.rows() != 3)
+    {
+      throw std::invalid_argument(" cov matrix must be 3 x 3");
+    }
+  }
+
+  // a thread gets at least 512 landmarks, the last block is padded with identity matrices
+  constexpr std::size_t     blockSize = detail::symmetricEigen3BlockSize;
+  constexpr std::size_t     minBlocksPerChunk = 512 / blockSize;
+  const std::size_t         numberOfLandmarks = points.size();
+  const std::size_t         numberOfBlocks = (numberOfLandmarks + blockSize - 1) / blockSize;
+  std::vector<ui::Landmark> landmarks(numberOfLandmarks);
+  parallelFor(numberOfBlocks, minBlocksPerChunk, [&](std::size_t begin, std::size_t end) {
+    detail::SymmetricEigen3Block block;
+    for (std::size_t b = begin; b < end; ++b)
+    {
+      const std::size_t first = b * blockSize;
+      const std::size_t count = std::min(blockSize, numberOfLandmarks - first);
+      for (std::size_t m = 0; m < blockSize; ++m)
+      {
+        if (m < count)
+        {
+          block.setMatrix(m, covariances[first + m].data_block());
+        }
+        else
+        {
+          block.setIdentity(m);
+        }
+      }
+      detail::symmetricEigen3(block);
+
+      for (std::size_t m = 0; m < count; ++m)
+      {
+        ui::Landmark & landmark = landmarks[first + m];
+        landmark.point = point3D(points[first + m]);
+        setUncertainty(landmark.uncertainty, block, m);
+      }
+    }
+  });
+  // copying a name allocates, which is left to the calling thread
+  for (std::size_t i = 0; i < numberOfLandmarks; ++i)
+  {
+    landmarks[i].name = names[i];
+  }
+  return landmarks;
+}
+
+ui::TriangleMesh
+meshToThriftMesh(const MeshType * mesh)
+{
+  ui::TriangleMesh thriftMesh;
+
+  ui::PointList & pts = thriftMesh.vertices;
+  pts.resize(mesh->GetNumberOfPoints());
+  forEachPoint(mesh, [&pts](std::size_t i, const MeshType::PointType & pt) {
+    pts[i].x = pt[0];
+    pts[i].y = pt[1];
+    pts[i].z = pt[2];
+  });
+
+  ui::TriangleCellList & cells = thriftMesh.topology;
+  cells.resize(mesh->GetNumberOfCells());
+  forEachTriangle(mesh, [&cells](std::size_t i, MeshType::CellType::PointIdConstIterator pointIds) {
+    cells[i].id1 = pointIds[0];
+    cells[i].id2 = pointIds[1];
+    cells[i].id3 = pointIds[2];
+  });
+
+  return thriftMesh;
+}
+
+ui::PackedTriangleMesh
+meshToPackedThriftMesh(const MeshType * mesh, ScalarType vertexType)
+{
+  if (vertexType != ScalarType::Float32 && vertexType != ScalarType::Float64)
+  {
+    throw std::invalid_argument("mesh vertices can only be sent as Float32 or Float64");
+  }
+
+  ui::PackedTriangleMesh packedMesh;
+  packedMesh.numberOfVertices = mesh->GetNumberOfPoints();
+  packedMesh.numberOfTriangles = mesh->GetNumberOfCells();
+  packedMesh.vertexType = scalarTypeToThrift(vertexType);
+
+  if (vertexType == ScalarType::Float32)
+  {
+    packVertices<float>(mesh, packedMesh.vertices);
+  }
+  else
+  {
+    packVertices<double>(mesh, packedMesh.vertices);
+  }
+
+  packedMesh.topology.resize(3 * mesh->GetNumberOfCells() * sizeof(int32_t));
+
+  char * dst = &packedMesh.topology[0];
+  forEachTriangle(mesh, [dst](std::size_t i, MeshType::CellType::PointIdConstIterator pointIds) {
+    writeScalar<int32_t>(dst, 3 * i, pointIds[0]);
+    writeScalar<int32_t>(dst, 3 * i + 1, pointIds[1]);
+    writeScalar<int32_t>(dst, 3 * i + 2, pointIds[2]);
+  });
+
+  return packedMesh;
+}
+
+ui::PackedTriangleMesh
+meshBuffersToPackedThrift(const MeshBuffers & mesh)
+{
+  if (mesh.vertexType != ScalarType::Float32 && mesh.vertexType != ScalarType::Float64)
+  {
+    throw std::invalid_argument("mesh vertices can only be sent as Float32 or Float64");
+  }
+
+  ui::PackedTriangleMesh packedMesh;
+  packedMesh.numberOfVertices = static_cast<std::int32_t>(mesh.numberOfVertices);
+  packedMesh.numberOfTriangles = static_cast<std::int32_t>(mesh.numberOfTriangles);
+  packedMesh.vertexType = scalarTypeToThrift(mesh.vertexType);
+  if (mesh.numberOfVertices > 0)
+  {
+    packedMesh.vertices.assign(static_cast<const char *>(mesh.vertices),
+                               3 * mesh.numberOfVertices * scalarTypeSize(mesh.vertexType));
+  }
+  if (mesh.numberOfTriangles > 0)
+  {
+    packedMesh.topology.assign(reinterpret_cast<const char *>(mesh.triangles),
+                               3 * mesh.numberOfTriangles * sizeof(std::int32_t));
+  }
+  return packedMesh;
+}
+
+ui::PackedVertexUpdate
+meshVerticesToPackedThrift(const MeshType * mesh)
+{
+  ui::PackedVertexUpdate update;
+  update.numberOfVertices = mesh->GetNumberOfPoints();
+  update.vertexType = ui::ScalarType::FLOAT32;
+  packVertices<float>(mesh, update.vertices);
+  return update;
+}
+
+ui::PackedVertexUpdate
+meshVertexDeltaToPackedThrift(const MeshType * mesh, std::vector<float> & sentVertices)
+{
+  const std::size_t numberOfPoints = mesh->GetNumberOfPoints();
+  if (numberOfPoints == 0 || sentVertices.size() != 3 * numberOfPoints)
+  {
+    sentVertices.resize(3 * numberOfPoints);
+    forEachPoint(mesh, [&sentVertices](std::size_t i, const MeshType::PointType & pt) {
+      std::copy(pt.Begin(), pt.End(), &sentVertices[3 * i]);
+    });
+    return meshVerticesToPackedThrift(mesh);
+  }
+
+  std::vector<int32_t> ids;
+  std::vector<float>   positions;
+  const auto &         points = mesh->GetPoints()->CastToSTLConstContainer();
+  for (std::size_t i = 0; i < numberOfPoints; ++i)
+  {
+    const MeshType::PointType & pt = points[i];
+    float *                     sent = &sentVertices[3 * i];
+    if (sent[0] != pt[0] || sent[1] != pt[1] || sent[2] != pt[2])
+    {
+      std::copy(pt.Begin(), pt.End(), sent);
+      ids.push_back(static_cast<int32_t>(i));
+      positions.insert(positions.end(), pt.Begin(), pt.End());
+    }
+  }
+
+  // an id costs a third of a vertex: the delta only pays off if less than 3/4 of the vertices moved
+  if (4 * ids.size() >= 3 * numberOfPoints)
+  {
+    return meshVerticesToPackedThrift(mesh);
+  }
+
+  ui::PackedVertexUpdate update;
+  update.numberOfVertices = ids.size();
+  update.vertexType = ui::ScalarType::FLOAT32;
+  update.vertices.assign(reinterpret_cast<const char *>(positions.data()), positions.size() * sizeof(float));
+  update.__set_indices(std::string(reinterpret_cast<const char *>(ids.data()), ids.size() * sizeof(int32_t)));
+  return update;
+}
+
+ui::PackedVertexScalars
+vertexScalarsToPackedThrift(const float * values, std::size_t numberOfValues, const std::string & name)
+{
+  ui::PackedVertexScalars scalars;
+  scalars.numberOfVertices = numberOfValues;
+  scalars.scalarType = ui::ScalarType::FLOAT32;
+  scalars.values.assign(reinterpret_cast<const char *>(values), numberOfValues * sizeof(float));
+  scalars.name = name;
+  return scalars;
+}
+
+ui::StatisticalShapeModel
+statisticalModelToThrift(const StatisticalModelType * ssm)
+{
+  ui::StatisticalShapeModel model;
+  model.reference = meshToThriftMesh(ssm->GetRepresenter()->GetReference());
+
+  vnl_matrix<float> pcaBasisMatrix = ssm->GetOrthonormalPCABasisMatrix();
+  vnl_vector<float> variances = ssm->GetPCAVarianceVector();
+  vnl_vector<float> meanDf = detail::meanDeformation(ssm);
+
+  ui::ListOfDoubleVectors & eigenVectors = model.klbasis.eigenvectors;
+  eigenVectors.resize(pcaBasisMatrix.cols());
+  for (auto & v : eigenVectors)
+  {
+    v.resize(pcaBasisMatrix.rows());
+  }
+  forEachEntryColumnMajor(pcaBasisMatrix, [&eigenVectors](std::size_t r, std::size_t c, float value) {
+    eigenVectors[c][r] = value;
+  });
+
+  model.klbasis.eigenvalues.assign(variances.begin(), variances.begin() + pcaBasisMatrix.cols());
+  model.mean.assign(meanDf.begin(), meanDf.begin() + pcaBasisMatrix.rows());
+  return model;
+}
+
+ui::PackedKLBasis
+klBasisToPackedThrift(const vnl_matrix<float> & basis, const vnl_vector<float> & variances, ScalarType scalarType)
+{
+  ui::PackedKLBasis klBasis;
+  klBasis.numberOfComponents = basis.cols();
+  klBasis.scalarType = scalarTypeToThrift(scalarType);
+  klBasis.eigenvalues.assign(variances.begin(), variances.end());
+  klBasis.__set_columnErrors(std::vector<double>(basis.cols(), 0.0));
+
+  const std::size_t rows = basis.rows();
+  const std::size_t minColumnsPerChunk = std::max<std::size_t>(1, minElementsPerChunk / std::max<std::size_t>(1, rows));
+  switch (scalarType)
+  {
+    case ScalarType::Float32:
+      packColumnMajor<float>(basis, klBasis.eigenvectors);
+      break;
+    case ScalarType::Float64:
+      packColumnMajor<double>(basis, klBasis.eigenvectors);
+      break;
+    case ScalarType::Float16:
+    {
+      klBasis.eigenvectors.resize(rows * basis.cols() * sizeof(std::uint16_t));
+      char *                   dst = &klBasis.eigenvectors[0];
+      const std::vector<float> columns = toColumnMajor(basis);
+      parallelFor(basis.cols(), minColumnsPerChunk, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+          const float * column = &columns[i * rows];
+          double        error = 0;
+          for (std::size_t j = 0; j < rows; ++j)
+          {
+            const std::uint16_t half = floatToHalf(column[j]);
+            writeScalar<std::uint16_t>(dst, i * rows + j, half);
+            error = std::max(error, std::abs(double(halfToFloat(half)) - column[j]));
+          }
+          klBasis.columnErrors[i] = error;
+        }
+      });
+      break;
+    }
+    case ScalarType::Int16:
+    {
+      klBasis.eigenvectors.resize(rows * basis.cols() * sizeof(std::int16_t));
+      klBasis.__set_columnScales(std::vector<double>(basis.cols(), 0.0));
+      klBasis.__set_columnOffsets(std::vector<double>(basis.cols(), 0.0));
+      char *                   dst = &klBasis.eigenvectors[0];
+      const std::vector<float> columns = toColumnMajor(basis);
+      parallelFor(basis.cols(), minColumnsPerChunk, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+          const float * column = &columns[i * rows];
+          const auto    range = std::minmax_element(column, column + rows);
+          const double  minValue = rows > 0 ? *range.first : 0.0;
+          const double  maxValue = rows > 0 ? *range.second : 0.0;
+          const double  offset = 0.5 * (minValue + maxValue);
+          const double  scale = (maxValue - minValue) / 65534;
+
+          double error = 0;
+          for (std::size_t j = 0; j < rows; ++j)
+          {
+            const double       q = scale > 0 ? std::round((column[j] - offset) / scale) : 0;
+            const std::int16_t stored = static_cast<std::int16_t>(std::max(-32767.0, std::min(32767.0, q)));
+            writeScalar<std::int16_t>(dst, i * rows + j, stored);
+            error = std::max(error, std::abs(offset + scale * stored - column[j]));
+          }
+          klBasis.columnScales[i] = scale;
+          klBasis.columnOffsets[i] = offset;
+          klBasis.columnErrors[i] = error;
+        }
+      });
+      break;
+    }
+    default:
+      throw std::invalid_argument("the basis can only be sent as Float64, Float32, Float16 or Int16");
+  }
+  return klBasis;
+}
+
+vnl_matrix<double>
+klBasisFromPackedThrift(const ui::PackedKLBasis & klBasis, unsigned numberOfRows)
+{
+  vnl_matrix<double> basis(numberOfRows, klBasis.numberOfComponents);
+  const char *       src = klBasis.eigenvectors.data();
+  for (int i = 0; i < klBasis.numberOfComponents; ++i)
+  {
+    for (unsigned j = 0; j < numberOfRows; ++j)
+    {
+      const std::size_t index = std::size_t(i) * numberOfRows + j;
+      switch (klBasis.scalarType)
+      {
+        case ui::ScalarType::FLOAT32:
+          basis(j, i) = readScalar<float>(src, index);
+          break;
+        case ui::ScalarType::FLOAT64:
+          basis(j, i) = readScalar<double>(src, index);
+          break;
+        case ui::ScalarType::FLOAT16:
+          basis(j, i) = halfToFloat(readScalar<std::uint16_t>(src, index));
+          break;
+        case ui::ScalarType::INT16:
+          basis(j, i) = klBasis.columnOffsets[i] + klBasis.columnScales[i] * readScalar<std::int16_t>(src, index);
+          break;
+        default:
+          throw std::invalid_argument("unsupported basis scalar type");
+      }
+    }
+  }
+  return basis;
+}
+
+ui::PackedStatisticalShapeModel
+statisticalModelToPackedThrift(const StatisticalModelType * ssm, ScalarType scalarType)
+{
+  vnl_matrix<float> pcaBasisMatrix = ssm->GetOrthonormalPCABasisMatrix();
+  return statisticalModelToPackedThrift(ssm, pcaBasisMatrix, pcaBasisMatrix.cols(), scalarType);
+}
+
+ui::PackedStatisticalShapeModel
+statisticalModelToPackedThrift(const StatisticalModelType * ssm,
+                               const vnl_matrix<float> &    pcaBasisMatrix,
+                               unsigned                     numberOfComponents,
+                               ScalarType                   scalarType)
+{
+  // Reduced precision only pays off for the basis; vertices and mean in mm need at least float
+  const ScalarType meshType = (scalarType == ScalarType::Float64) ? ScalarType::Float64 : ScalarType::Float32;
+  return packedModel(meshToPackedThriftMesh(ssm->GetRepresenter()->GetReference(), meshType),
+                     detail::meanDeformation(ssm),
+                     pcaBasisMatrix,
+                     ssm->GetPCAVarianceVector(),
+                     numberOfComponents,
+                     scalarType);
+}
+
+ui::PackedStatisticalShapeModel
+statisticalModelToPackedThrift(const MeshBuffers &       reference,
+                               const vnl_vector<float> & meanDeformation,
+                               const vnl_matrix<float> & orthonormalBasis,
+                               const vnl_vector<float> & variances,
+                               ScalarType                scalarType)
+{
+  if (meanDeformation.size() != 3 * reference.numberOfVertices ||
+      orthonormalBasis.rows() != 3 * reference.numberOfVertices || variances.size() != orthonormalBasis.cols())
+  {
+    throw std::invalid_argument("the mean, the basis and the variances do not match the reference");
+  }
+  return packedModel(meshBuffersToPackedThrift(reference),
+                     meanDeformation,
+                     orthonormalBasis,
+                     variances,
+                     orthonormalBasis.cols(),
+                     scalarType);
+}
+
+std::string
+statisticalModelHash(const StatisticalModelType * ssm, ScalarType scalarType)
+{
+  Sha256 sha;
+  sha.updateValue(static_cast<int32_t>(scalarType));
+
+  const MeshType * reference = ssm->GetRepresenter()->GetReference();
+  sha.updateValue(static_cast<uint64_t>(reference->GetNumberOfPoints()));
+  for (unsigned i = 0; i < reference->GetNumberOfPoints(); ++i)
+  {
+    MeshType::PointType pt = reference->GetPoint(i);
+    float               xyz[3] = { pt.GetElement(0), pt.GetElement(1), pt.GetElement(2) };
+    sha.update(xyz, sizeof(xyz));
+  }
+
+  sha.updateValue(static_cast<uint64_t>(reference->GetNumberOfCells()));
+  for (unsigned i = 0; i < reference->GetNumberOfCells(); ++i)
+  {
+    MeshType::CellType::PointIdConstIterator pointIds = reference->GetCells()->GetElement(i)->PointIdsBegin();
+    for (unsigned j = 0; j < 3; ++j)
+    {
+      sha.updateValue(static_cast<int32_t>(pointIds[j]));
+    }
+  }
+
+  vnl_vector<float> mean = ssm->GetMeanVector();
+  vnl_vector<float> variances = ssm->GetPCAVarianceVector();
+  vnl_matrix<float> pcaBasisMatrix = ssm->GetOrthonormalPCABasisMatrix();
+  sha.updateValue(static_cast<uint64_t>(mean.size()));
+  sha.update(mean.data_block(), mean.size() * sizeof(float));
+  sha.updateValue(static_cast<uint64_t>(variances.size()));
+  sha.update(variances.data_block(), variances.size() * sizeof(float));
+  sha.updateValue(static_cast<uint64_t>(pcaBasisMatrix.rows()));
+  sha.updateValue(static_cast<uint64_t>(pcaBasisMatrix.cols()));
+  sha.update(pcaBasisMatrix.data_block(), pcaBasisMatrix.size() * sizeof(float));
+
+  return sha.hexDigest();
+}
+
+ui::ImageView
+imageViewToThriftImageView(const ImageView & imageView)
+{
+  ui::ImageView thriftImageView;
+  thriftImageView.id = imageView.GetId();
+  thriftImageView.opacity = imageView.GetOpacity();
+  thriftImageView.level = imageView.GetLevel();
+  thriftImageView.window = imageView.GetWindow();
+  return thriftImageView;
+}
+
+ImageView
+imageViewFromThriftImageView(const ui::ImageView & ivThrift)
+{
+  return ImageView(ivThrift.id, ivThrift.window, ivThrift.level, ivThrift.opacity);
+}
+
+ui::ImageDomain
+imageDomainToThrift(const itk::ImageBase<3> * image)
+{
+  ui::Point3D origin;
+  origin.x = image->GetOrigin().GetElement(0);
+  origin.y = image->GetOrigin().GetElement(1);
+  origin.z = image->GetOrigin().GetElement(2);
+
+  ui::IntVector3D size;
+  size.i = image->GetLargestPossibleRegion().GetSize().GetElement(0);
+  size.j = image->GetLargestPossibleRegion().GetSize().GetElement(1);
+  size.k = image->GetLargestPossibleRegion().GetSize().GetElement(2);
+
+  ui::Vector3D spacing;
+  spacing.x = image->GetSpacing().GetElement(0);
+  spacing.y = image->GetSpacing().GetElement(1);
+  spacing.z = image->GetSpacing().GetElement(2);
+
+  ui::ImageDomain domain;
+  domain.origin = origin;
+  domain.spacing = spacing;
+  domain.size = size;
+  return domain;
+}
+
+ui::ImageDomain
+imageDomainToThrift(const std::array<std::size_t, 3> & size,
+                    const std::array<double, 3> &      origin,
+                    const std::array<double, 3> &      spacing)
+{
+  ui::ImageDomain domain;
+  domain.origin.x = origin[0];
+  domain.origin.y = origin[1];
+  domain.origin.z = origin[2];
+  domain.size.i = static_cast<std::int32_t>(size[0]);
+  domain.size.j = static_cast<std::int32_t>(size[1]);
+  domain.size.k = static_cast<std::int32_t>(size[2]);
+  domain.spacing.x = spacing[0];
+  domain.spacing.y = spacing[1];
+  domain.spacing.z = spacing[2];
+  return domain;
+}
+
+ui::Image
+imageToThrift(const ImageType * image)
+{
+  ui::ImageData                         data;
+  ImageType::PixelContainerConstPointer pixelContainer = image->GetPixelContainer();
+  data.reserve(pixelContainer->Size());
+  for (unsigned i = 0; i < pixelContainer->Size(); ++i)
+  {
+    data.push_back((*pixelContainer)[i]);
+  }
+
+  ui::Image thriftImage;
+  thriftImage.data = std::move(data);
+  thriftImage.domain = imageDomainToThrift(image);
+  return thriftImage;
+}
+
+ui::PackedImage
+packedImageToThrift(const itk::ImageBase<3> * image,
+                    ScalarType                pixelType,
+                    const void *              buffer,
+                    std::size_t               numberOfBytes)
+{
+  if (image->GetBufferedRegion() != image->GetLargestPossibleRegion())
+  {
+    throw std::invalid_argument("image must be buffered over its largest possible region");
+  }
+
+  return packedImageToThrift(imageDomainToThrift(image), pixelType, buffer, numberOfBytes);
+}
+
+ui::PackedImage
+packedImageToThrift(const ui::ImageDomain & domain,
+                    ScalarType              pixelType,
+                    const void *            buffer,
+                    std::size_t             numberOfBytes)
+{
+  ui::PackedImage packedImage;
+  packedImage.domain = domain;
+  packedImage.pixelType = scalarTypeToThrift(pixelType);
+  packedImage.data.assign(static_cast<const char *>(buffer), numberOfBytes);
+  return packedImage;
+}
+
+ui::PackedImageRegion
+imageSlicesToThrift(const std::array<std::size_t, 3> & size,
+                    ScalarType                         pixelType,
+                    const char *                       data,
+                    std::size_t                        firstSlice,
+                    std::size_t                        numberOfSlices)
+{
+  const std::size_t sliceBytes = size[0] * size[1] * scalarTypeSize(pixelType);
+
+  ui::PackedImageRegion packedRegion;
+  packedRegion.region.level = 0;
+  packedRegion.region.index.i = 0;
+  packedRegion.region.index.j = 0;
+  packedRegion.region.index.k = static_cast<std::int32_t>(firstSlice);
+  packedRegion.region.size.i = static_cast<std::int32_t>(size[0]);
+  packedRegion.region.size.j = static_cast<std::int32_t>(size[1]);
+  packedRegion.region.size.k = static_cast<std::int32_t>(numberOfSlices);
+  packedRegion.pixelType = scalarTypeToThrift(pixelType);
+  packedRegion.data.assign(data + firstSlice * sliceBytes, numberOfSlices * sliceBytes);
+  return packedRegion;
+}
+
+ui::PackedImage
+imagePyramidLevelToThrift(const ImagePyramid & pyramid, unsigned level)
+{
+  const ImagePyramid::Level & l = pyramid.GetLevel(level);
+
+  ui::PackedImage packedImage;
+  packedImage.domain = imageDomainToThrift(l.size, l.origin, l.spacing);
+  packedImage.pixelType = scalarTypeToThrift(pyramid.GetPixelType());
+  packedImage.data.assign(l.data, l.size[0] * l.size[1] * l.size[2] * pyramid.GetPixelSize());
+  return packedImage;
+}
+
+ui::PackedImageRegion
+imagePyramidRegionToThrift(const ImagePyramid & pyramid, unsigned level, const itk::ImageRegion<3> & region)
+{
+  ui::PackedImageRegion packedRegion;
+  packedRegion.region.level = static_cast<std::int32_t>(level);
+  packedRegion.region.index.i = static_cast<std::int32_t>(region.GetIndex(0));
+  packedRegion.region.index.j = static_cast<std::int32_t>(region.GetIndex(1));
+  packedRegion.region.index.k = static_cast<std::int32_t>(region.GetIndex(2));
+  packedRegion.region.size.i = static_cast<std::int32_t>(region.GetSize(0));
+  packedRegion.region.size.j = static_cast<std::int32_t>(region.GetSize(1));
+  packedRegion.region.size.k = static_cast<std::int32_t>(region.GetSize(2));
+  packedRegion.pixelType = scalarTypeToThrift(pyramid.GetPixelType());
+  packedRegion.data.resize(region.GetNumberOfPixels() * pyramid.GetPixelSize());
+  pyramid.copyRegion(level, region, &packedRegion.data[0]);
+  return packedRegion;
+}
+
+ui::ShapeModelView
+shapeModelViewToThriftShapeModelView(const ShapeModelView & smv)
+{
+  ui::ShapeModelView               thriftSmv;
+  ui::ShapeModelTransformationView tssmView =
+    shapeModelTransformationViewToThrift(smv.GetShapeModelTransformationView());
+  ui::TriangleMeshView tMeshView = thriftMeshViewFromTriangleMeshView(smv.GetTriangleMeshView());
+  thriftSmv.shapeModelTransformationView = tssmView;
+  thriftSmv.meshView = tMeshView;
+  return thriftSmv;
+}
+
+ui::PackedShapeTrajectory
+shapeTrajectoryToPackedThrift(const ShapeTrajectory & trajectory)
+{
+  const std::vector<float> & coefficients = trajectory.GetCoefficients();
+
+  ui::PackedShapeTrajectory packed;
+  packed.numberOfFrames = static_cast<std::int32_t>(trajectory.GetNumberOfKeyframes());
+  packed.numberOfCoefficients = static_cast<std::int32_t>(trajectory.GetNumberOfCoefficients());
+  packed.scalarType = scalarTypeToThrift(trajectory.GetScalarType());
+  packVector<double>(trajectory.GetTimes(), trajectory.GetNumberOfKeyframes(), packed.times);
+  switch (trajectory.GetScalarType())
+  {
+    case ScalarType::Float32:
+      packed.coefficients.assign(reinterpret_cast<const char *>(coefficients.data()),
+                                 coefficients.size() * sizeof(float));
+      break;
+    case ScalarType::Float64:
+      packVector<double>(coefficients, coefficients.size(), packed.coefficients);
+      break;
+    case ScalarType::Float16:
+    {
+      packed.coefficients.resize(coefficients.size() * sizeof(std::uint16_t));
+      char * dst = &packed.coefficients[0];
+      for (std::size_t i = 0; i < coefficients.size(); ++i)
+      {
+        writeScalar<std::uint16_t>(dst, i, floatToHalf(coefficients[i]));
+      }
+      break;
+    }
+    default:
+      throw std::invalid_argument("coefficients can only be sent as Float32, Float64 or Float16");
+  }
+  if (trajectory.HasPoses())
+  {
+    packed.__isset.poses = true;
+    packVector<double>(trajectory.GetPoses(), trajectory.GetPoses().size(), packed.poses);
+  }
+  return packed;
+}
+
+ui::TrajectoryPlayback
+trajectoryPlaybackToThrift(const TrajectoryPlayback & playback)
+{
+  ui::TrajectoryPlayback thriftPlayback;
+  thriftPlayback.playing = playback.playing;
+  thriftPlayback.time = playback.time;
+  thriftPlayback.speed = playback.speed;
+  switch (playback.mode)
+  {
+    case PlaybackMode::Once:
+      thriftPlayback.mode = ui::PlaybackMode::ONCE;
+      break;
+    case PlaybackMode::Loop:
+      thriftPlayback.mode = ui::PlaybackMode::LOOP;
+      break;
+    case PlaybackMode::Bounce:
+      thriftPlayback.mode = ui::PlaybackMode::BOUNCE;
+      break;
+  }
+  return thriftPlayback;
+}
+
+} // namespace conversions
+} // namespace StatismoUI
@@ -0,0 +1,182 @@
+#ifndef UI_THRIFTCONVERSIONS_H
+#define UI_THRIFTCONVERSIONS_H
+
+#include "ImagePyramid.h"
+#include "ShapeTrajectory.h"
+#include "StatismoUI.h"
+#include "thrift/ui_types.h"
+
+// Conversions between the statismo-ui client types and the types generated from ui.thrift.
+namespace StatismoUI
+{
+namespace conversions
+{
+using MeshType = itk::Mesh<float, 3>;
+using PointType = MeshType::PointType;
+using ImageType = itk::Image<short, 3>;
+using StatisticalModelType = itk::StatisticalModel<MeshType>;
+
+ui::ScalarType::type
+scalarTypeToThrift(ScalarType scalarType);
+
+std::size_t
+scalarTypeSize(ScalarType scalarType);
+
+ui::Group
+groupToThriftGroup(const Group & group);
+
+ShapeModelView
+shapeModelViewFromThrift(const ui::ShapeModelView & smvThrift);
+
+ui::ShapeModelView
+shapeModelViewToThriftShapeModelView(const ShapeModelView & tv);
+
+ShapeModelTransformationView
+shapeModelTransformationViewFromThrift(const ui::ShapeModelTransformationView & tvthrift);
+
+ui::ShapeModelTransformationView
+shapeModelTransformationViewToThrift(const ShapeModelTransformationView & tv);
+
+ui::ImageView
+imageViewToThriftImageView(const ImageView & iv);
+
+ImageView
+imageViewFromThriftImageView(const ui::ImageView & ivThrift);
+
+ui::ImageDomain
+imageDomainToThrift(const itk::ImageBase<3> * image);
+
+ui::ImageDomain
+imageDomainToThrift(const std::array<std::size_t, 3> & size,
+                    const std::array<double, 3> &      origin,
+                    const std::array<double, 3> &      spacing);
+
+ui::Image
+imageToThrift(const ImageType * image);
+
+// Copies the buffer into the binary field with a single memcpy
+ui::PackedImage
+packedImageToThrift(const itk::ImageBase<3> * image,
+                    ScalarType                pixelType,
+                    const void *              buffer,
+                    std::size_t               numberOfBytes);
+
+// Same, for a buffer holding the whole domain
+ui::PackedImage
+packedImageToThrift(const ui::ImageDomain & domain,
+                    ScalarType              pixelType,
+                    const void *            buffer,
+                    std::size_t             numberOfBytes);
+
+// The slices [firstSlice, firstSlice + numberOfSlices) of a level 0 image whose voxels are at data
+ui::PackedImageRegion
+imageSlicesToThrift(const std::array<std::size_t, 3> & size,
+                    ScalarType                         pixelType,
+                    const char *                       data,
+                    std::size_t                        firstSlice,
+                    std::size_t                        numberOfSlices);
+
+// A whole level of the pyramid as a packed image
+ui::PackedImage
+imagePyramidLevelToThrift(const ImagePyramid & pyramid, unsigned level);
+
+// region is given in voxels of the level
+ui::PackedImageRegion
+imagePyramidRegionToThrift(const ImagePyramid & pyramid, unsigned level, const itk::ImageRegion<3> & region);
+
+TriangleMeshView
+triangleMeshViewFromThriftMeshView(const ui::TriangleMeshView & tmvThrift);
+
+ui::TriangleMeshView
+thriftMeshViewFromTriangleMeshView(const TriangleMeshView & tmv);
+
+ui::PointList
+pointsToThriftPointList(const std::list<PointType> & points);
+
+// Packs the points as float32 into chunk, reusing its buffer, on the calling thread
+void
+pointsToPackedThrift(const PointType * points, std::size_t numberOfPoints, ui::PackedPointChunk & chunk);
+
+ui::Landmark
+landmarkToThrift(const PointType & point, const vnl_matrix<double> & cov, const std::string & name);
+
+// Decomposes the covariances in blocks with a fixed-size 3 x 3 symmetric eigensolver, in parallel
+std::vector<ui::Landmark>
+landmarksToThrift(const std::vector<PointType> &          points,
+                  const std::vector<vnl_matrix<double>> & covariances,
+                  const std::vector<std::string> &        names);
+
+ui::TriangleMesh
+meshToThriftMesh(const MeshType * mesh);
+
+// Vertices are packed as x0 y0 z0 x1 y1 z1 ... of the requested type, the topology as int32 point ids.
+ui::PackedTriangleMesh
+meshToPackedThriftMesh(const MeshType * mesh, ScalarType vertexType);
+
+// Copies the arrays into the binary fields as they are
+ui::PackedTriangleMesh
+meshBuffersToPackedThrift(const MeshBuffers & mesh);
+
+// All vertices of the mesh, as float32
+ui::PackedVertexUpdate
+meshVerticesToPackedThrift(const MeshType * mesh);
+
+// The vertices whose position differs from sentVertices (x0 y0 z0 x1 ... as last sent), with their ids.
+// All vertices are sent if sentVertices does not match the mesh or if that is not larger than the delta.
+// sentVertices is updated to the current positions.
+ui::PackedVertexUpdate
+meshVertexDeltaToPackedThrift(const MeshType * mesh, std::vector<float> & sentVertices);
+
+// numberOfValues float32 values, one per vertex
+ui::PackedVertexScalars
+vertexScalarsToPackedThrift(const float * values, std::size_t numberOfValues, const std::string & name);
+
+ui::StatisticalShapeModel
+statisticalModelToThrift(const StatisticalModelType * ssm);
+
+// Packs the basis column-major. Float16 stores IEEE half floats, Int16 quantizes each column linearly to
+// [-32767, 32767] with a scale and an offset. columnErrors holds the largest absolute error of each decoded column.
+ui::PackedKLBasis
+klBasisToPackedThrift(const vnl_matrix<float> & basis, const vnl_vector<float> & variances, ScalarType scalarType);
+
+// Decodes the eigenvectors of a packed basis, the inverse of klBasisToPackedThrift
+vnl_matrix<double>
+klBasisFromPackedThrift(const ui::PackedKLBasis & klBasis, unsigned numberOfRows);
+
+// Reference and mean are stored as Float64 if requested and as Float32 otherwise, the basis with the given
+// scalar type (see klBasisToPackedThrift).
+ui::PackedStatisticalShapeModel
+statisticalModelToPackedThrift(const StatisticalModelType * ssm, ScalarType scalarType);
+
+// Same, but only the first numberOfComponents columns of pcaBasisMatrix (the model's orthonormal basis, computed
+// by the caller) are stored
+ui::PackedStatisticalShapeModel
+statisticalModelToPackedThrift(const StatisticalModelType * ssm,
+                               const vnl_matrix<float> &    pcaBasisMatrix,
+                               unsigned                     numberOfComponents,
+                               ScalarType                   scalarType);
+
+// A model given by its parts, the reference copied as it is (see meshBuffersToPackedThrift)
+ui::PackedStatisticalShapeModel
+statisticalModelToPackedThrift(const MeshBuffers &       reference,
+                               const vnl_vector<float> & meanDeformation,
+                               const vnl_matrix<float> & orthonormalBasis,
+                               const vnl_vector<float> & variances,
+                               ScalarType                scalarType);
+
+// SHA-256 over the model contents and the scalar type they are sent with. The model is identified without
+// encoding it, so that the packed encoding is only built when the service does not know the model yet.
+std::string
+statisticalModelHash(const StatisticalModelType * ssm, ScalarType scalarType);
+
+// Times and poses are stored as float64, the coefficients with the scalar type of the trajectory
+ui::PackedShapeTrajectory
+shapeTrajectoryToPackedThrift(const ShapeTrajectory & trajectory);
+
+ui::TrajectoryPlayback
+trajectoryPlaybackToThrift(const TrajectoryPlayback & playback);
+
+} // namespace conversions
+} // namespace StatismoUI
+
+#endif // UI_THRIFTCONVERSIONS_H
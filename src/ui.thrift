@@ -142,21 +142,274 @@ struct ShapeModelView {
 }
 
 
+// Packed representations: bulk data is sent as a single binary blob instead of
+// a list of structs. All packed arrays are little-endian.
+
+enum ScalarType {
+    FLOAT32 = 1,
+    FLOAT64 = 2,
+    INT8 = 3,
+    UINT8 = 4,
+    INT16 = 5,
+    UINT16 = 6,
+    INT32 = 7,
+    UINT32 = 8,
+    FLOAT16 = 9,
+}
+
+// vertices: x0 y0 z0 x1 y1 z1 ... stored as vertexType
+// topology: the three point ids of each triangle, stored as int32
+struct PackedTriangleMesh {
+    1: required i32 numberOfVertices;
+    2: required i32 numberOfTriangles;
+    3: required ScalarType vertexType;
+    4: required binary vertices;
+    5: required binary topology;
+}
+
+// data: the pixel buffer (x fastest, then y, then z), stored as pixelType
+struct PackedImage {
+    1: required ImageDomain domain;
+    2: required ScalarType pixelType;
+    3: required binary data;
+}
+
+// eigenvectors: column-major matrix of 3 * numberOfVertices rows and
+// numberOfComponents columns, stored as scalarType (FLOAT16: IEEE 754 half)
+// With scalarType INT16 each column c is quantized:
+//   entry = columnOffsets[c] + columnScales[c] * stored value
+// columnErrors[c] bounds the absolute error of every decoded entry of column c.
+// A shape mean + sum_c coefficient[c] * sqrt(eigenvalues[c]) * column c is then
+// off by at most sum_c |coefficient[c]| * sqrt(eigenvalues[c]) * columnErrors[c]
+// per coordinate.
+struct PackedKLBasis {
+    1: required i32 numberOfComponents;
+    2: required ScalarType scalarType;
+    3: required DoubleVector eigenvalues;
+    4: required binary eigenvectors;
+    5: optional DoubleVector columnScales;
+    6: optional DoubleVector columnOffsets;
+    7: optional DoubleVector columnErrors;
+}
+
+// New vertex positions of a shown triangle mesh, the topology is unchanged.
+// vertices: x y z of numberOfVertices vertices, stored as vertexType
+// indices: if set, the int32 ids of the vertices in vertices; all other vertices keep
+// their position. If not set, vertices holds every vertex of the mesh.
+struct PackedVertexUpdate {
+    1: required i32 numberOfVertices;
+    2: required ScalarType vertexType;
+    3: required binary vertices;
+    4: optional binary indices;
+}
+
+// A value per vertex of a shown triangle mesh, which the viewer shows as a colour map on the mesh,
+// e.g. the variance of a shape model at each point. It replaces the previous values of the mesh.
+// values: numberOfVertices values, stored as scalarType (FLOAT32 or FLOAT64)
+// name: what the values are, for the legend of the colour map
+struct PackedVertexScalars {
+    1: required i32 numberOfVertices;
+    2: required ScalarType scalarType;
+    3: required binary values;
+    4: required string name;
+}
+
+// Image pyramids: level 0 is the full resolution image, each further level averages blocks of
+// 2 x 2 x 2 voxels of the previous one (sizes are halved, rounded up).
+// region: first voxel and size, in voxels of the level
+struct ImageRegion {
+    1: required i32 level;
+    2: required IntVector3D index;
+    3: required IntVector3D size;
+}
+
+// data: the voxels of the region, x fastest, stored as pixelType
+struct PackedImageRegion {
+    1: required ImageRegion region;
+    2: required ScalarType pixelType;
+    3: required binary data;
+}
+
+// A block of a mesh created with createTriangleMesh: the float32 x y z of the vertices from
+// firstVertex on and the int32 point ids of the triangles from firstTriangle on. Either may be empty.
+struct PackedMeshChunk {
+    1: required i32 firstVertex;
+    2: required binary vertices;
+    3: required i32 firstTriangle;
+    4: required binary topology;
+}
+
+struct PointCloudView {
+    1: required i32 id;
+}
+
+// points: x y z of numberOfPoints points, stored as pointType
+struct PackedPointChunk {
+    1: required i32 numberOfPoints;
+    2: required ScalarType pointType;
+    3: required binary points;
+}
+
+// mean: the mean deformation of the reference vertices, stored as meanType
+struct PackedStatisticalShapeModel {
+    1: required PackedTriangleMesh reference;
+    2: required ScalarType meanType;
+    3: required binary mean;
+    4: required PackedKLBasis klbasis;
+}
+
+
+// Keyframes of a shape model transformation view, played by the service: the view shows each
+// keyframe at its time and moves linearly from one keyframe to the next (the coefficients, the
+// Euler angles and the translation are interpolated).
+// times: numberOfFrames increasing float64, in seconds from the start of the trajectory
+// coefficients: numberOfCoefficients per keyframe, keyframe after keyframe, stored as scalarType
+// (FLOAT32, FLOAT64 or FLOAT16)
+// poses: if set, 9 float64 per keyframe: the center, the Euler angles and the translation of the
+// rigid transformation; otherwise the view keeps its pose
+struct PackedShapeTrajectory {
+    1: required i32 numberOfFrames;
+    2: required i32 numberOfCoefficients;
+    3: required ScalarType scalarType;
+    4: required binary times;
+    5: required binary coefficients;
+    6: optional binary poses;
+}
+
+// What happens at the end of a trajectory: stop on the last keyframe, start over, or play it
+// backwards to the start and so on
+enum PlaybackMode {
+    ONCE = 1,
+    LOOP = 2,
+    BOUNCE = 3,
+}
+
+// Playing, the trajectory advances from time (seconds) at speed times the pace of its keyframes.
+// Paused, the view shows the trajectory at time.
+struct TrajectoryPlayback {
+    1: required bool playing;
+    2: required double time;
+    3: required double speed;
+    4: required PlaybackMode mode;
+}
+
+// Scene batches: show, update and remove operations applied in order with a single request.
+// The group created by the operation at index k of a batch is referred to as the Group
+// with id -(k + 1) by the following operations of the same batch.
+
+struct ShowPointCloudOperation {
+    1: required Group g;
+    2: required PointList points;
+    3: required string name;
+}
+
+struct ShowTriangleMeshOperation {
+    1: required Group g;
+    2: required PackedTriangleMesh mesh;
+    3: required string name;
+}
+
+struct ShowImageOperation {
+    1: required Group g;
+    2: required PackedImage image;
+    3: required string name;
+}
+
+struct ShowLandmarkOperation {
+    1: required Group g;
+    2: required Landmark landmark;
+    3: required string name;
+}
+
+union SceneOperation {
+    1: string createGroup;
+    2: ShowPointCloudOperation showPointCloud;
+    3: ShowTriangleMeshOperation showTriangleMesh;
+    4: ShowImageOperation showImage;
+    5: ShowLandmarkOperation showLandmark;
+    6: TriangleMeshView updateTriangleMeshView;
+    7: ImageView updateImageView;
+    8: ShapeModelTransformationView updateShapeModelTransformation;
+    9: Group removeGroup;
+    10: TriangleMeshView removeTriangleMesh;
+    11: ImageView removeImage;
+}
+
+// What an operation created; nothing is set for the other operations
+struct SceneOperationResult {
+    1: optional Group group;
+    2: optional TriangleMeshView meshView;
+    3: optional ImageView imageView;
+}
+
+// Raised when an operation of a batch fails, the operations before it have been applied and results holds what they
+// created, one result per operation
+exception SceneBatchError {
+    1: required i32 operationIndex;
+    2: required string message;
+    3: optional list<SceneOperationResult> results;
+}
+
+// Raised when a model hash is not known to the service
+exception UnknownModel {
+    1: required string modelHash;
+}
+
+
 service UI {
+  // Changes whenever ui-service starts, a client that reconnects with the same id finds its scene unchanged
+  string getSessionId();
   Group createGroup(1:string name);
+  // Meshes sent in chunks: the mesh is shown once all its vertices and triangles are written
+  TriangleMeshView createTriangleMesh(1: Group g, 2: i32 numberOfVertices, 3: i32 numberOfTriangles, 4: string name);
+  void writeTriangleMeshChunk(1: TriangleMeshView tmv, 2: PackedMeshChunk chunk);
   void showPointCloud(1: Group g, 2:PointList p, 3:string name);
+  // Streamed point clouds: the cloud is created empty and grows as chunks of points are appended.
+  // expectedNumberOfPoints (0 if unknown) lets the viewer show the progress of the upload.
+  PointCloudView createPointCloud(1: Group g, 2: string name, 3: i64 expectedNumberOfPoints);
+  void appendPointCloudPoints(1: PointCloudView pcv, 2: PackedPointChunk chunk);
   TriangleMeshView showTriangleMesh(1: Group g, 2:TriangleMesh m, 3:string name);
+  TriangleMeshView showPackedTriangleMesh(1: Group g, 2:PackedTriangleMesh m, 3:string name);
   ImageView showImage(1: Group g, 2:Image img, 3:string name);
+  ImageView showPackedImage(1: Group g, 2:PackedImage img, 3:string name);
   void showLandmark(1 : Group g, 2 : Landmark landmark, 3 : string name);
+  // Shows each landmark under its own name
+  void showLandmarks(1 : Group g, 2 : list<Landmark> landmarks);
   ShapeModelView showStatisticalShapeModel(1 : Group g, 2:StatisticalShapeModel ssm, 3:string name);
+  ShapeModelView showPackedStatisticalShapeModel(1 : Group g, 2:PackedStatisticalShapeModel ssm, 3:string name);
+  // Content-addressed model registry: a model is uploaded once and then shown by its hash
+  void registerStatisticalShapeModel(1 : string modelHash, 2:PackedStatisticalShapeModel ssm);
+  ShapeModelView showRegisteredStatisticalShapeModel(1 : Group g, 2:string modelHash, 3:string name) throws (1: UnknownModel e);
+  // Appends principal components to the basis of a shown model, for models uploaded progressively.
+  // Coefficient vectors shorter than the basis leave the remaining components at 0.
+  void appendShapeModelComponents(1: ShapeModelView smv, 2: PackedKLBasis components);
   void updateShapeModelTransformation(1: ShapeModelTransformationView smtv);
+  // Replaces the trajectory of the view, which then shows its first keyframe, paused
+  void loadShapeTrajectory(1: ShapeModelTransformationView smtv, 2: PackedShapeTrajectory trajectory);
+  // Plays, pauses or scrubs the trajectory of the view. While it plays, an update of the view is
+  // shown until the next frame.
+  void playShapeTrajectory(1: ShapeModelTransformationView smtv, 2: TrajectoryPlayback playback);
+  oneway void updateShapeModelTransformations(1: list<ShapeModelTransformationView> smtvs);
   void updateTriangleMeshView(1: TriangleMeshView tvm);
+  // Moves the vertices of a mesh shown with showTriangleMesh or showPackedTriangleMesh, the view keeps its properties
+  void updateTriangleMeshVertices(1: TriangleMeshView tmv, 2: PackedVertexUpdate update);
+  // Colours a mesh, also the one of a shape model, by a value per vertex
+  void updateTriangleMeshScalars(1: TriangleMeshView tmv, 2: PackedVertexScalars scalars);
   void updateImageView(1 : ImageView iv);
+  // Shows the coarsest level of an image pyramid, domain is the one of level 0. The finer levels
+  // are then sent region by region with updateImageRegion, as the client decides.
+  ImageView showImagePyramid(1: Group g, 2: ImageDomain domain, 3: i32 numberOfLevels, 4: PackedImage coarsestLevel, 5: string name);
+  // Shows an image whose voxels (0 until then) are sent with updateImageRegion at level 0
+  ImageView createImage(1: Group g, 2: ImageDomain domain, 3: ScalarType pixelType, 4: string name);
+  // Replaces the voxels of a region of an image shown with showImagePyramid or createImage
+  void updateImageRegion(1: ImageView iv, 2: PackedImageRegion region);
   void removeGroup(1: Group g);
   void removeImage(1: ImageView iv);
   void removeTriangleMesh(1: TriangleMeshView tmv);
   void removeShapeModelTransformation(1: ShapeModelTransformationView smv);
   void removeShapeModel(1: ShapeModelView smv);
+  // One result per operation, in the order of the operations
+  list<SceneOperationResult> applySceneBatch(1: list<SceneOperation> operations) throws (1: SceneBatchError e);
 }
 
 
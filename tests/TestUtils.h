@@ -0,0 +1,34 @@
+#ifndef UI_TESTUTILS_H
+#define UI_TESTUTILS_H
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+// Helpers shared by the test executables
+namespace test
+{
+// Whether actual is what was expected, prints the difference if not
+inline bool
+check(const std::string & what, std::size_t actual, std::size_t expected)
+{
+  if (actual != expected)
+  {
+    std::cerr << what << ": " << actual << ", expected " << expected << std::endl;
+  }
+  return actual == expected;
+}
+
+// Whether value is at most tolerance, prints both if not
+inline bool
+checkError(const std::string & what, double value, double tolerance)
+{
+  if (!(value <= tolerance))
+  {
+    std::cerr << what << ": " << value << ", tolerance " << tolerance << std::endl;
+  }
+  return value <= tolerance;
+}
+} // namespace test
+
+#endif // UI_TESTUTILS_H
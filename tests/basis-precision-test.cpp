@@ -0,0 +1,94 @@
+// Reconstructs shapes mean + basis * diag(sqrt(eigenvalues)) * coefficients from each encoding of the PCA basis
+// (Float64, Float32, Float16, quantized Int16) and fails if an error exceeds the bound announced in
+// PackedKLBasis.columnErrors.
+
+#include "BenchmarkUtils.h"
+#include "TestUtils.h"
+#include "ThriftConversions.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// Largest error of the reconstructed shapes, in excess of the bound announced for their coefficients
+double
+maxExcess(const vnl_matrix<float> &   basis,
+          const vnl_vector<float> &   variances,
+          const ui::PackedKLBasis &   packed,
+          const std::vector<double> & coefficients)
+{
+  vnl_matrix<double> decoded = StatismoUI::conversions::klBasisFromPackedThrift(packed, basis.rows());
+
+  double excess = 0;
+  for (std::size_t s = 0; s < coefficients.size() / basis.cols(); ++s)
+  {
+    const double * alpha = &coefficients[s * basis.cols()];
+
+    double bound = 0;
+    for (unsigned i = 0; i < basis.cols(); ++i)
+    {
+      bound += std::abs(alpha[i]) * std::sqrt(variances[i]) * packed.columnErrors[i];
+    }
+
+    // the mean is sent identically for all encodings, its contribution cancels out
+    double error = 0;
+    for (unsigned j = 0; j < basis.rows(); ++j)
+    {
+      double exact = 0;
+      double approximate = 0;
+      for (unsigned i = 0; i < basis.cols(); ++i)
+      {
+        exact += double(basis(j, i)) * std::sqrt(variances[i]) * alpha[i];
+        approximate += decoded(j, i) * std::sqrt(variances[i]) * alpha[i];
+      }
+      error = std::max(error, std::abs(exact - approximate));
+    }
+    // allow for the rounding of the double precision sums
+    excess = std::max(excess, error - bound * (1 + 1e-9));
+  }
+  return excess;
+}
+} // namespace
+
+int
+main()
+{
+  using namespace StatismoUI;
+
+  const unsigned          numberOfComponents = 20;
+  const vnl_matrix<float> basis = benchmark::makeOrthonormalBasis(3 * 2000, numberOfComponents);
+  vnl_vector<float>       variances(numberOfComponents);
+  for (unsigned i = 0; i < numberOfComponents; ++i)
+  {
+    variances[i] = 1000.0f / (i + 1);
+  }
+
+  // coefficients are standard normal under the model, the largest ones are the interesting cases
+  std::mt19937                     generator(42);
+  std::normal_distribution<double> normal;
+  std::vector<double>              coefficients(5 * numberOfComponents);
+  for (double & c : coefficients)
+  {
+    c = 3 * normal(generator);
+  }
+
+  const std::pair<ScalarType, const char *> encodings[] = {
+    { ScalarType::Float64, "float64" }, { ScalarType::Float32, "float32" },
+    { ScalarType::Float16, "float16" }, { ScalarType::Int16, "int16" }
+  };
+  bool ok = true;
+  for (const auto & encoding : encodings)
+  {
+    const ui::PackedKLBasis packed = conversions::klBasisToPackedThrift(basis, variances, encoding.first);
+    ok = test::checkError(std::string(encoding.second) + " error beyond the announced bound",
+                          maxExcess(basis, variances, packed, coefficients),
+                          1e-9) &&
+         ok;
+  }
+  return ok ? 0 : 1;
+}
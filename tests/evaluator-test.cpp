@@ -0,0 +1,140 @@
+// Computes shape model instances with ShapeModelEvaluator: one instance, one posed instance, a batch and the batch
+// one instance at a time, on one and on all threads. Fails if an instance differs from the double precision
+// reference computation.
+
+#include "BenchmarkUtils.h"
+#include "ParallelFor.h"
+#include "ShapeModelEvaluator.h"
+#include "TestUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+using MeshType = itk::Mesh<float, 3>;
+
+// Largest distance of points from mean + basis * diag(sqrt(variances)) * alpha, computed in double precision
+double
+maxError(const vnl_vector<float> & mean,
+         const vnl_matrix<float> & basis,
+         const vnl_vector<float> & variances,
+         const float *             alpha,
+         const float *             points)
+{
+  double error = 0;
+  for (unsigned r = 0; r < basis.rows(); ++r)
+  {
+    double exact = mean[r];
+    for (unsigned j = 0; j < basis.cols(); ++j)
+    {
+      exact += double(basis(r, j)) * std::sqrt(double(variances[j])) * alpha[j];
+    }
+    error = std::max(error, std::abs(exact - points[r]));
+  }
+  return error;
+}
+} // namespace
+
+int
+main()
+{
+  using namespace StatismoUI;
+
+  const unsigned          numberOfComponents = 20;
+  const unsigned          numberOfSamples = 20;
+  auto                    reference = benchmark::makeTorusMesh(1000);
+  const std::size_t       numberOfRows = 3 * std::size_t(reference->GetNumberOfPoints());
+  const vnl_matrix<float> basis = benchmark::makeBasis(numberOfRows, numberOfComponents);
+  vnl_vector<float>       variances(numberOfComponents);
+  vnl_vector<float>       meanDeformation(numberOfRows);
+  vnl_vector<float>       mean(numberOfRows);
+  for (unsigned i = 0; i < numberOfComponents; ++i)
+  {
+    variances[i] = 1000.0f / (i + 1);
+  }
+  for (std::size_t r = 0; r < numberOfRows; ++r)
+  {
+    meanDeformation[r] = std::sin(0.01 * r);
+    mean[r] = reference->GetPoint(r / 3)[r % 3] + meanDeformation[r];
+  }
+
+  ShapeModelEvaluator evaluator(reference, meanDeformation, basis, variances);
+  bool                ok = test::check("vertices", evaluator.GetNumberOfPoints(), reference->GetNumberOfPoints());
+  ok = test::check("components", evaluator.GetNumberOfComponents(), numberOfComponents) && ok;
+
+  // coefficients are standard normal under the model
+  std::mt19937                    generator(42);
+  std::normal_distribution<float> normal;
+  vnl_matrix<float>               coefficients(numberOfSamples, numberOfComponents);
+  for (unsigned s = 0; s < numberOfSamples; ++s)
+  {
+    for (unsigned j = 0; j < numberOfComponents; ++j)
+    {
+      coefficients(s, j) = normal(generator);
+    }
+  }
+  const vnl_vector<float> alpha = coefficients.get_row(0);
+
+  // the posed instance is the instance moved by the rigid transform the view describes
+  auto rigid = itk::Euler3DTransform<float>::New();
+  rigid->SetRotation(0.1, -0.2, 0.3);
+  MeshType::PointType center;
+  center.Fill(5);
+  rigid->SetCenter(center);
+  itk::Euler3DTransform<float>::OutputVectorType translation;
+  translation.Fill(20);
+  rigid->SetTranslation(translation);
+  ShapeModelTransformationView smtv(0, PoseTransformation(*rigid), ShapeTransformation(vnl_vector<float>(alpha)));
+
+  for (unsigned threads : { 1u, 0u })
+  {
+    setNumberOfWorkerThreads(threads);
+    const std::string label = std::to_string(getNumberOfWorkerThreads()) + " threads, ";
+
+    std::vector<float> points(numberOfRows);
+    evaluator.evaluate(alpha, points.data());
+    // float sums of about 20 terms of a few tens of mm
+    const double error = maxError(mean, basis, variances, alpha.data_block(), points.data());
+    ok = test::checkError(label + "instance error", error, 1e-2) && ok;
+
+    std::vector<float> posed(numberOfRows);
+    evaluator.evaluate(smtv, posed.data());
+    double poseError = 0;
+    for (std::size_t i = 0; i < evaluator.GetNumberOfPoints(); ++i)
+    {
+      MeshType::PointType p;
+      for (unsigned d = 0; d < 3; ++d)
+      {
+        p[d] = points[3 * i + d];
+      }
+      p = rigid->TransformPoint(p);
+      for (unsigned d = 0; d < 3; ++d)
+      {
+        poseError = std::max(poseError, std::abs(double(p[d]) - posed[3 * i + d]));
+      }
+    }
+    ok = test::checkError(label + "posed instance error", poseError, 1e-2) && ok;
+
+    std::vector<float> batch(std::size_t(numberOfSamples) * numberOfRows);
+    std::vector<float> loop(batch.size());
+    evaluator.evaluate(coefficients, batch.data());
+    for (unsigned s = 0; s < numberOfSamples; ++s)
+    {
+      evaluator.evaluate(coefficients.get_row(s), &loop[s * numberOfRows]);
+    }
+    double batchError = 0;
+    double loopError = 0;
+    for (unsigned s = 0; s < numberOfSamples; ++s)
+    {
+      batchError = std::max(batchError, maxError(mean, basis, variances, coefficients[s], &batch[s * numberOfRows]));
+      loopError = std::max(loopError, maxError(mean, basis, variances, coefficients[s], &loop[s * numberOfRows]));
+    }
+    ok = test::checkError(label + "batch error", batchError, 1e-2) && ok;
+    ok = test::checkError(label + "one instance at a time error", loopError, 1e-2) && ok;
+  }
+  return ok ? 0 : 1;
+}
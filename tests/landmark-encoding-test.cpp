@@ -0,0 +1,88 @@
+// Checks the batched landmark encoding against vnl_svd, on one and on all threads. Fails if a variance or a
+// covariance rebuilt from the principal axes differs from vnl_svd by more than 1e-9 (relative to the largest
+// variance).
+
+#include "BenchmarkUtils.h"
+#include "ParallelFor.h"
+#include "TestUtils.h"
+#include "ThriftConversions.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace
+{
+using PointType = itk::Mesh<float, 3>::PointType;
+
+// Largest difference to vnl_svd, relative to the largest variance: variances and the covariance rebuilt from the
+// principal axes. The axes hold the rows of the eigenvector matrix.
+double
+maxError(const vnl_matrix<double> & cov, const ui::UncertaintyCovariance & uncertainty)
+{
+  vnl_svd<double> svd(cov);
+  const double    scale = std::max(svd.W(0), 1e-300);
+
+  const double       variances[] = { uncertainty.variances.x, uncertainty.variances.y, uncertainty.variances.z };
+  const ui::Vector3D axes[] = { uncertainty.principalAxis1, uncertainty.principalAxis2, uncertainty.principalAxis3 };
+  vnl_matrix<double> eigenvectors(3, 3);
+  for (unsigned k = 0; k < 3; ++k)
+  {
+    eigenvectors(k, 0) = axes[k].x;
+    eigenvectors(k, 1) = axes[k].y;
+    eigenvectors(k, 2) = axes[k].z;
+  }
+
+  double error = 0;
+  for (unsigned i = 0; i < 3; ++i)
+  {
+    error = std::max(error, std::abs(variances[i] - svd.W(i)) / scale);
+  }
+  for (unsigned r = 0; r < 3; ++r)
+  {
+    for (unsigned c = 0; c < 3; ++c)
+    {
+      double rebuilt = 0;
+      for (unsigned i = 0; i < 3; ++i)
+      {
+        rebuilt += eigenvectors(r, i) * variances[i] * eigenvectors(c, i);
+      }
+      error = std::max(error, std::abs(rebuilt - cov(r, c)) / scale);
+    }
+  }
+  return error;
+}
+} // namespace
+
+int
+main()
+{
+  using namespace StatismoUI;
+
+  const std::size_t               numberOfLandmarks = 1000;
+  std::vector<PointType>          points(numberOfLandmarks);
+  std::vector<std::string>        names(numberOfLandmarks);
+  std::vector<vnl_matrix<double>> covariances = benchmark::makeCovariances(numberOfLandmarks);
+  for (std::size_t l = 0; l < numberOfLandmarks; ++l)
+  {
+    points[l].Fill(static_cast<float>(l));
+    names[l] = "landmark-" + std::to_string(l);
+  }
+
+  bool ok = true;
+  for (unsigned threads : { 1u, 0u })
+  {
+    setNumberOfWorkerThreads(threads);
+    std::vector<ui::Landmark> landmarks = conversions::landmarksToThrift(points, covariances, names);
+    double                    error = 0;
+    for (std::size_t l = 0; l < numberOfLandmarks; ++l)
+    {
+      error = std::max(error, maxError(covariances[l], landmarks[l].uncertainty));
+      ok = test::check("name of landmark " + std::to_string(l), landmarks[l].name == names[l], true) && ok;
+    }
+    const std::string label = std::to_string(getNumberOfWorkerThreads()) + " threads, relative error to vnl_svd";
+    ok = test::checkError(label, error, 1e-9) && ok;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+// Makes a few calls to an in-process mock service with each protocol and transport, and fails if the bytes the client
+// metrics count differ from those the service counts on its side of the socket.
+
+#include "BenchmarkUtils.h"
+#include "MockUIService.h"
+#include "TestUtils.h"
+
+#include <cstdint>
+#include <string>
+
+namespace
+{
+bool
+run(StatismoUI::ConnectionOptions options, const std::string & label)
+{
+  StatismoUI::MockUIServer server(options);
+  options.port = server.GetPort();
+  StatismoUI::StatismoUI ui(options);
+
+  StatismoUI::Group            group = ui.createGroup("metrics-test");
+  auto                         mesh = benchmark::makeTorusMesh(1000);
+  StatismoUI::TriangleMeshView view = ui.showPackedTriangleMesh(group, mesh.GetPointer(), "mesh");
+  view.SetColor(StatismoUI::Color(255, 0, 0));
+  ui.updateTriangleMeshView(view);
+  ui.showPackedImage(group, benchmark::makeImage(16).GetPointer(), "image");
+  ui.removeGroup(group);
+
+  std::uint64_t bytesWritten = 0;
+  std::uint64_t bytesRead = 0;
+  for (const auto & rpc : ui.getMetrics())
+  {
+    bytesWritten += rpc.bytesWritten.sum;
+    bytesRead += rpc.bytesRead.sum;
+  }
+  bool ok = test::check(label + "bytes written", bytesWritten, server.GetBytesReceived());
+  ok = test::check(label + "bytes read", bytesRead, server.GetBytesSent()) && ok;
+  return ok;
+}
+} // namespace
+
+int
+main()
+{
+  using namespace StatismoUI;
+
+  ConnectionOptions options;
+  options.port = 0;
+  options.shared = false;
+
+  bool ok = run(options, "binary, framed: ");
+  options.protocol = Protocol::Compact;
+  ok = run(options, "compact, framed: ") && ok;
+  options.transport = Transport::Zlib;
+  ok = run(options, "compact, zlib: ") && ok;
+  options.transport = Transport::CompressedFrames;
+  options.compressionThreshold = 1024;
+  ok = run(options, "compact, compressed frames: ") && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+// Restarts an in-process mock service under a client with reconnect enabled: shows a scene, stops the service, keeps
+// calling while it is down, starts a new service on the same port and checks that the client restored the scene
+// there. A second client journals nothing: its calls while the service is down are dropped, and its next vertex
+// update must send all vertices, its next view update must not be skipped.
+
+#include "BenchmarkUtils.h"
+#include "MockUIService.h"
+#include "TestUtils.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+int
+main()
+{
+  using namespace StatismoUI;
+
+  ConnectionOptions options;
+  options.port = 0;
+  options.shared = false;
+  options.connectTimeoutMs = 1000;
+  options.reconnect.enabled = true;
+  options.reconnect.initialBackoffMs = 50;
+  options.reconnect.maxBackoffMs = 500;
+  auto server = std::make_unique<MockUIServer>(options);
+  options.port = server->GetPort();
+
+  StatismoUI::StatismoUI ui(options);
+  auto                   mesh = benchmark::makeTorusMesh(1000);
+
+  Group                         kept = ui.createGroup("kept");
+  Group                         removed = ui.createGroup("removed");
+  std::vector<TriangleMeshView> views;
+  views.push_back(ui.showPackedTriangleMesh(kept, mesh.GetPointer(), "mesh 1"));
+  views.push_back(ui.showPackedTriangleMesh(kept, mesh.GetPointer(), "mesh 2"));
+  ui.showPackedTriangleMesh(removed, mesh.GetPointer(), "mesh 3");
+
+  // a client that journals nothing, it moves every vertex of its mesh and recolours it while the service is down
+  ConnectionOptions tightOptions = options;
+  tightOptions.reconnect.maxPendingOperations = 0;
+  tightOptions.skipUnchangedUpdates = true;
+  StatismoUI::StatismoUI tight(tightOptions);
+  Group                  tightGroup = tight.createGroup("tight");
+  TriangleMeshView       tightView = tight.showPackedTriangleMesh(tightGroup, mesh.GetPointer(), "tight mesh");
+  tight.updateTriangleMeshVertices(tightView, mesh.GetPointer());
+  auto moved = benchmark::makeTorusMesh(1000);
+  for (unsigned i = 0; i < moved->GetNumberOfPoints(); ++i)
+  {
+    benchmark::MeshType::PointType pt = moved->GetPoint(i);
+    pt[2] += 0.1f;
+    moved->SetPoint(i, pt);
+  }
+
+  auto recolor = [&](unsigned i) {
+    TriangleMeshView & view = views[i % views.size()];
+    view.SetColor(Color(i % 256, 128, 255 - i % 256));
+    ui.updateTriangleMeshView(view);
+  };
+  for (unsigned i = 0; i < 10; ++i)
+  {
+    recolor(i);
+  }
+
+  server->stop();
+  server.reset();
+
+  for (unsigned i = 0; i < 10; ++i)
+  {
+    recolor(i);
+  }
+  views.push_back(ui.showPackedTriangleMesh(kept, mesh.GetPointer(), "mesh 4"));
+  ui.removeGroup(removed);
+  tight.updateTriangleMeshVertices(tightView, moved.GetPointer());
+  tightView.SetColor(Color(255, 0, 0));
+  tight.updateTriangleMeshView(tightView);
+  bool ok = test::check("connected while the service is down", ui.getConnectionStatus().connected, false);
+
+  auto start = std::chrono::steady_clock::now();
+  server = std::make_unique<MockUIServer>(options);
+  while ((!ui.getConnectionStatus().connected || !tight.getConnectionStatus().connected) &&
+         std::chrono::steady_clock::now() - start < std::chrono::seconds(30))
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // the views returned before the restart still work
+  for (unsigned i = 0; i < 10; ++i)
+  {
+    recolor(i);
+  }
+
+  // the dropped delta was the last one the client computed, the service still has the vertices shown first
+  const std::uint64_t bytes = server->GetBytesReceived();
+  tight.updateTriangleMeshVertices(tightView, moved.GetPointer());
+  ok = test::check("dropped operations", tight.getConnectionStatus().droppedOperations, 2) && ok;
+  ok = test::check("vertices sent after a dropped delta",
+                   server->GetBytesReceived() - bytes >= 3 * sizeof(float) * moved->GetNumberOfPoints(),
+                   true) &&
+       ok;
+  // the service still has the colour shown first
+  const std::uint64_t skipped = tight.getNumberOfSkippedUpdates();
+  tight.updateTriangleMeshView(tightView);
+  ok = test::check("skipped updates after a dropped one", tight.getNumberOfSkippedUpdates() - skipped, 0) && ok;
+
+  const MockUIService::Statistics stats = server->GetService().GetStatistics();
+  ok = test::check("connected", ui.getConnectionStatus().connected, true) && ok;
+  ok = test::check("failed operations", ui.getConnectionStatus().failedOperations, 0) && ok;
+  ok = test::check("groups", stats.numberOfGroups, 2) && ok;
+  ok = test::check("meshes", stats.numberOfTriangleMeshes, views.size() + 1) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,62 @@
+// Records a session against an in-process mock service with ConnectionOptions::recordPath, replays the log into a
+// second mock service and fails if a request could not be replayed or if the scene there differs from the recorded
+// one.
+
+#include "BenchmarkUtils.h"
+#include "MockUIService.h"
+#include "SessionPlayer.h"
+#include "TestUtils.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <string>
+
+int
+main()
+{
+  using namespace StatismoUI;
+
+  ConnectionOptions options;
+  options.port = 0;
+  options.shared = false;
+  options.reconnect.enabled = true;
+  const std::string path = "record-replay-test.log";
+
+  MockUIService::Statistics recorded;
+  {
+    ConnectionOptions recordOptions = options;
+    MockUIServer      server(recordOptions);
+    recordOptions.port = server.GetPort();
+    recordOptions.recordPath = path;
+
+    StatismoUI::StatismoUI ui(recordOptions);
+    auto                   mesh = benchmark::makeTorusMesh(1000);
+    Group                  group = ui.createGroup("record-replay-test");
+    TriangleMeshView       view = ui.showPackedTriangleMesh(group, mesh.GetPointer(), "mesh");
+    for (unsigned i = 0; i < 10; ++i)
+    {
+      view.SetColor(Color(i % 256, 128, 255 - i % 256));
+      ui.updateTriangleMeshView(view);
+      ui.showPackedTriangleMesh(group, mesh.GetPointer(), "mesh " + std::to_string(i));
+    }
+    ui.removeTriangleMesh(view);
+    ui.showPackedImage(ui.createGroup("images"), benchmark::makeImage(16).GetPointer(), "image");
+    recorded = server.GetService().GetStatistics();
+  }
+
+  MockUIServer replayServer(options);
+  options.port = replayServer.GetPort();
+  SessionPlayer player(path, options);
+  player.play(0, std::numeric_limits<std::uint64_t>::max(), 0);
+  const MockUIService::Statistics replayed = replayServer.GetService().GetStatistics();
+
+  bool ok = test::check("requests that failed to replay", player.GetFailures().size(), 0);
+  ok = test::check("groups", replayed.numberOfGroups, recorded.numberOfGroups) && ok;
+  ok = test::check("meshes", replayed.numberOfTriangleMeshes, recorded.numberOfTriangleMeshes) && ok;
+  ok = test::check("images", replayed.numberOfImages, recorded.numberOfImages) && ok;
+  ok = test::check("shape models", replayed.numberOfShapeModels, recorded.numberOfShapeModels) && ok;
+  std::remove(path.c_str());
+  std::remove((path + ".index").c_str());
+  return ok ? 0 : 1;
+}
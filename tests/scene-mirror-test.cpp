@@ -0,0 +1,100 @@
+// Updates the views of a scene on an in-process mock service every frame, with only one of them changed, without and
+// with ConnectionOptions::skipUnchangedUpdates, then removes the group. Fails if an update that changed something
+// was not sent, if an unchanged one was sent while skipping, or if the views of the removed group are still known to
+// the client.
+
+#include "BenchmarkUtils.h"
+#include "MockUIService.h"
+#include "TestUtils.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+using StatismoUI::MockUIService;
+
+bool
+run(StatismoUI::ConnectionOptions options, unsigned meshes, unsigned images, unsigned frames)
+{
+  StatismoUI::MockUIServer server(options);
+  options.port = server.GetPort();
+  StatismoUI::StatismoUI ui(options);
+  StatismoUI::Group      group = ui.createGroup("scene-mirror-test");
+
+  auto                                      mesh = benchmark::makeTorusMesh(100);
+  auto                                      image = benchmark::makeImage(8);
+  std::vector<StatismoUI::TriangleMeshView> meshViews;
+  std::vector<StatismoUI::ImageView>        imageViews;
+  for (unsigned i = 0; i < meshes; ++i)
+  {
+    meshViews.push_back(ui.showPackedTriangleMesh(group, mesh.GetPointer(), "mesh " + std::to_string(i)));
+  }
+  for (unsigned i = 0; i < images; ++i)
+  {
+    imageViews.push_back(ui.showPackedImage(group, image.GetPointer(), "image " + std::to_string(i)));
+  }
+
+  const std::size_t callsBefore = server.GetService().GetStatistics().numberOfCalls;
+  for (unsigned frame = 0; frame < frames; ++frame)
+  {
+    // one view changes per frame, alternately a mesh and an image
+    if (frame % 2 == 0)
+    {
+      StatismoUI::TriangleMeshView & view = meshViews[frame / 2 % meshViews.size()];
+      view.SetOpacity(view.GetOpacity() == 1.0 ? 0.5 : 1.0);
+    }
+    else
+    {
+      StatismoUI::ImageView & view = imageViews[frame / 2 % imageViews.size()];
+      view.SetWindow(view.GetWindow() + 1);
+    }
+    for (const auto & view : meshViews)
+    {
+      ui.updateTriangleMeshView(view);
+    }
+    for (const auto & view : imageViews)
+    {
+      ui.updateImageView(view);
+    }
+  }
+  const std::size_t   calls = server.GetService().GetStatistics().numberOfCalls - callsBefore;
+  const std::uint64_t skipped = ui.getNumberOfSkippedUpdates();
+
+  // every frame changes one view, which must have been sent
+  const std::string label = options.skipUnchangedUpdates ? "skipping unchanged updates, " : "sending all updates, ";
+  const std::size_t updates = std::size_t(frames) * (meshes + images);
+  bool ok = test::check(label + "requests", calls, options.skipUnchangedUpdates ? frames : updates);
+  ok = test::check(label + "requests and skipped updates", calls + skipped, updates) && ok;
+
+  // the group goes with a single request, and the client forgets its views: updating one is sent again and fails
+  ui.removeGroup(group);
+  const MockUIService::Statistics statistics = server.GetService().GetStatistics();
+  ok = test::check(label + "meshes after removing the group", statistics.numberOfTriangleMeshes, 0) && ok;
+  ok = test::check(label + "images after removing the group", statistics.numberOfImages, 0) && ok;
+  try
+  {
+    ui.updateTriangleMeshView(meshViews.front());
+    ok = test::check(label + "update of a removed view accepted", true, false) && ok;
+  }
+  catch (const std::exception &)
+  {}
+  return ok;
+}
+} // namespace
+
+int
+main()
+{
+  StatismoUI::ConnectionOptions options;
+  options.port = 0;
+  options.shared = false;
+
+  options.skipUnchangedUpdates = false;
+  bool ok = run(options, 5, 3, 20);
+  options.skipUnchangedUpdates = true;
+  ok = run(options, 5, 3, 20) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+// Loads a ShapeTrajectory on an in-process mock service, then scrubs, loops, bounces and plays it. Fails if the
+// service does not hold every keyframe, is not at the expected keyframe or needs requests to move on while playing.
+
+#include "BenchmarkUtils.h"
+#include "MockUIService.h"
+#include "ShapeTrajectory.h"
+#include "TestUtils.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+int
+main()
+{
+  using namespace StatismoUI;
+
+  ConnectionOptions options;
+  options.port = 0;
+  options.shared = false;
+  MockUIServer server(options);
+  options.port = server.GetPort();
+
+  StatismoUI::StatismoUI ui(options);
+  Group                  group = ui.createGroup("trajectory-test");
+
+  // a model of constant modes: the service only checks the sizes
+  const unsigned            numberOfComponents = 10;
+  const unsigned            numberOfFrames = 100;
+  const double              fps = 100;
+  auto                      mesh = benchmark::makeTorusMesh(100);
+  std::vector<std::int32_t> triangles;
+  const std::size_t         numberOfRows = 3 * std::size_t(mesh->GetNumberOfPoints());
+  vnl_matrix<float>         basis(numberOfRows, numberOfComponents);
+  vnl_vector<float>         variances(numberOfComponents, 1.0f);
+  basis.fill(0.01f);
+  ShapeModelView model = ui.showPackedStatisticalShapeModel(group,
+                                                            detail::meshBuffers(mesh.GetPointer(), triangles),
+                                                            vnl_vector<float>(numberOfRows, 0.0f),
+                                                            basis,
+                                                            variances,
+                                                            "model");
+  const ShapeModelTransformationView & view = model.GetShapeModelTransformationView();
+
+  ShapeTrajectory trajectory;
+  for (unsigned f = 0; f < numberOfFrames; ++f)
+  {
+    vnl_vector<float> coefficients(numberOfComponents);
+    for (unsigned j = 0; j < numberOfComponents; ++j)
+    {
+      coefficients[j] = std::sin(1.0 + j + 0.01 * f);
+    }
+    auto rigid = itk::Euler3DTransform<float>::New();
+    rigid->SetRotation(0.001 * f, 0, 0);
+    trajectory.addKeyframe(f / fps, coefficients, PoseTransformation(*rigid));
+  }
+  ui.loadShapeTrajectory(view, trajectory);
+
+  MockUIService &                 service = server.GetService();
+  const MockUIService::Statistics statistics = service.GetStatistics();
+  bool                            ok = test::check("trajectories", statistics.numberOfTrajectories, 1);
+  ok = test::check("keyframes", statistics.numberOfTrajectoryKeyframes, numberOfFrames) && ok;
+  ok = test::check("keyframe after loading", service.GetTrajectoryKeyframe(view.GetId()), 0) && ok;
+
+  // scrubbing shows the keyframe at the time, between keyframes the one before
+  TrajectoryPlayback scrub;
+  scrub.playing = false;
+  const unsigned middle = numberOfFrames / 2;
+  scrub.time = (middle + 0.5) / fps;
+  ui.playShapeTrajectory(view, scrub);
+  ok = test::check("keyframe when scrubbed", service.GetTrajectoryKeyframe(view.GetId()), middle) && ok;
+
+  // looping past the end starts over, bouncing comes back
+  scrub.mode = PlaybackMode::Loop;
+  scrub.time = trajectory.GetDuration() + (middle + 0.5) / fps;
+  ui.playShapeTrajectory(view, scrub);
+  ok = test::check("keyframe when looped", service.GetTrajectoryKeyframe(view.GetId()), middle) && ok;
+  scrub.mode = PlaybackMode::Bounce;
+  scrub.time = 2 * trajectory.GetDuration() - (middle + 0.5) / fps;
+  ui.playShapeTrajectory(view, scrub);
+  ok = test::check("keyframe when bounced", service.GetTrajectoryKeyframe(view.GetId()), middle) && ok;
+
+  // playing moves on without requests
+  ui.playShapeTrajectory(view);
+  const std::size_t callsBefore = service.GetStatistics().numberOfCalls;
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  ok = test::check("requests while playing", service.GetStatistics().numberOfCalls - callsBefore, 0) && ok;
+  ok = test::check("keyframe advanced while playing", service.GetTrajectoryKeyframe(view.GetId()) > 0, true) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+// Computes the marginal variance of each point of a shape model with ShapeModelEvaluator, on one and on all threads,
+// against a 3 x 3 covariance per point formed with vnl, then colours the mesh of the model with them on an in-process
+// mock service. Fails if a variance differs from the double precision reference, if the service does not hold the
+// values sent or if a field of the wrong size is accepted.
+
+#include "BenchmarkUtils.h"
+#include "MockUIService.h"
+#include "ParallelFor.h"
+#include "ShapeModelEvaluator.h"
+#include "TestUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+// The covariance of each point, U_i * diag(variances) * U_i^T, and its trace
+std::vector<double>
+covarianceTraces(const vnl_matrix<float> & basis, const vnl_vector<float> & variances, float noiseVariance)
+{
+  std::vector<double> traces(basis.rows() / 3);
+  for (std::size_t i = 0; i < traces.size(); ++i)
+  {
+    vnl_matrix<double> rows(3, basis.cols());
+    vnl_matrix<double> scaledRows(3, basis.cols());
+    for (unsigned d = 0; d < 3; ++d)
+    {
+      for (unsigned j = 0; j < basis.cols(); ++j)
+      {
+        rows(d, j) = basis(3 * i + d, j);
+        scaledRows(d, j) = rows(d, j) * variances[j];
+      }
+    }
+    const vnl_matrix<double> covariance = scaledRows * rows.transpose();
+    traces[i] = covariance(0, 0) + covariance(1, 1) + covariance(2, 2) + 3.0 * noiseVariance;
+  }
+  return traces;
+}
+
+double
+maxRelativeError(const std::vector<double> & exact, const std::vector<float> & values)
+{
+  double error = 0;
+  for (std::size_t i = 0; i < exact.size(); ++i)
+  {
+    error = std::max(error, std::abs(exact[i] - values[i]) / std::max(1e-12, exact[i]));
+  }
+  return error;
+}
+} // namespace
+
+int
+main()
+{
+  using namespace StatismoUI;
+
+  const unsigned          numberOfComponents = 20;
+  auto                    reference = benchmark::makeTorusMesh(2000);
+  const std::size_t       numberOfRows = 3 * std::size_t(reference->GetNumberOfPoints());
+  const vnl_matrix<float> basis = benchmark::makeBasis(numberOfRows, numberOfComponents);
+  const float             noiseVariance = 0.1f;
+  vnl_vector<float>       variances(numberOfComponents);
+  for (unsigned i = 0; i < numberOfComponents; ++i)
+  {
+    variances[i] = 1000.0f / (i + 1);
+  }
+  const vnl_vector<float> meanDeformation(numberOfRows, 0.0f);
+
+  ShapeModelEvaluator       evaluator(reference, meanDeformation, basis, variances, noiseVariance);
+  const std::vector<double> exact = covarianceTraces(basis, variances, noiseVariance);
+  std::vector<float>        marginalVariances(evaluator.GetNumberOfPoints());
+  bool                      ok = true;
+  for (unsigned threads : { 1u, 0u })
+  {
+    setNumberOfWorkerThreads(threads);
+    evaluator.computeMarginalVariances(marginalVariances.data());
+    // float sums of positive terms
+    ok = test::checkError(std::to_string(getNumberOfWorkerThreads()) + " threads, relative error",
+                          maxRelativeError(exact, marginalVariances),
+                          1e-4) &&
+         ok;
+  }
+
+  // the variances colour the mesh of the model
+  ConnectionOptions options;
+  options.port = 0;
+  options.shared = false;
+  MockUIServer server(options);
+  options.port = server.GetPort();
+
+  StatismoUI::StatismoUI    ui(options);
+  Group                     group = ui.createGroup("variance-test");
+  std::vector<std::int32_t> triangles;
+  ShapeModelView            model = ui.showPackedStatisticalShapeModel(
+    group, detail::meshBuffers(reference.GetPointer(), triangles), meanDeformation, basis, variances, "model");
+  ui.updateTriangleMeshScalars(model.GetTriangleMeshView(), marginalVariances, "variance");
+
+  MockUIService & service = server.GetService();
+  const auto      shown = service.GetTriangleMeshScalars(model.GetTriangleMeshView().GetId());
+  ok = test::check("values held by the service", shown.first == marginalVariances, true) && ok;
+  ok = test::check("name held by the service", shown.second == "variance", true) && ok;
+  ok = test::check("scalar fields", service.GetStatistics().numberOfVertexScalarFields, 1) && ok;
+
+  // a value per vertex, no more, no less
+  try
+  {
+    ui.updateTriangleMeshScalars(model.GetTriangleMeshView(), marginalVariances.data(), 1, "variance");
+    ok = test::check("a field of one value accepted", true, false) && ok;
+  }
+  catch (const std::exception &)
+  {}
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,71 @@
+// Stand-in for ui-service: accepts every client call, keeps track of the scene and checks the payloads, but does
+// not render anything. Useful to run clients and benchmarks on machines without a display.
+
+#include "MockUIService.h"
+
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace
+{
+volatile std::sig_atomic_t stopRequested = 0;
+
+void
+onSignal(int)
+{
+  stopRequested = 1;
+}
+} // namespace
+
+int
+main(int argc, char ** argv)
+{
+  StatismoUI::ConnectionOptions options;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--compact")
+    {
+      options.protocol = StatismoUI::Protocol::Compact;
+    }
+    else if (arg == "--port" && i + 1 < argc)
+    {
+      options.port = std::stoi(argv[++i]);
+    }
+    else if (arg == "--zlib")
+    {
+      options.transport = StatismoUI::Transport::Zlib;
+    }
+    else if (arg == "--compressed-frames")
+    {
+      options.transport = StatismoUI::Transport::CompressedFrames;
+    }
+    else
+    {
+      std::cerr << "usage: " << argv[0] << " [--port port] [--compact] [--zlib | --compressed-frames]" << std::endl;
+      return 1;
+    }
+  }
+
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+
+  StatismoUI::MockUIServer server(options);
+  std::cout << "mock ui-service listening on port " << options.port << std::endl;
+
+  while (!stopRequested)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  server.stop();
+
+  auto stats = server.GetService().GetStatistics();
+  std::cout << stats.numberOfCalls << " calls, " << stats.numberOfGroups << " groups, "
+            << stats.numberOfTriangleMeshes << " meshes, " << stats.numberOfImages << " images, "
+            << stats.numberOfShapeModels << " shape models, " << stats.numberOfRegisteredModels
+            << " registered models" << std::endl;
+  return 0;
+}
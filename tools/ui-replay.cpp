@@ -0,0 +1,122 @@
+// Replays a session log recorded with ConnectionOptions::recordPath into ui-service, at the recorded pace, faster, or
+// as fast as possible. --from seeks: the requests before it are sent at once, so that playing starts from the scene
+// recorded at that time. --list prints the requests instead.
+
+#include "SessionPlayer.h"
+
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+
+namespace
+{
+std::uint64_t
+nanoseconds(const std::string & seconds)
+{
+  return static_cast<std::uint64_t>(std::stod(seconds) * 1e9);
+}
+} // namespace
+
+int
+main(int argc, char ** argv)
+{
+  StatismoUI::ConnectionOptions options;
+  std::string                   path;
+  std::uint64_t                 from = 0;
+  std::uint64_t                 to = std::numeric_limits<std::uint64_t>::max();
+  double                        speed = 1.0;
+  bool                          list = false;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--host" && i + 1 < argc)
+    {
+      options.host = argv[++i];
+    }
+    else if (arg == "--port" && i + 1 < argc)
+    {
+      options.port = std::stoi(argv[++i]);
+    }
+    else if (arg == "--compact")
+    {
+      options.protocol = StatismoUI::Protocol::Compact;
+    }
+    else if (arg == "--speed" && i + 1 < argc)
+    {
+      speed = std::stod(argv[++i]);
+    }
+    else if (arg == "--fast")
+    {
+      speed = 0;
+    }
+    else if (arg == "--from" && i + 1 < argc)
+    {
+      from = nanoseconds(argv[++i]);
+    }
+    else if (arg == "--to" && i + 1 < argc)
+    {
+      to = nanoseconds(argv[++i]);
+    }
+    else if (arg == "--list")
+    {
+      list = true;
+    }
+    else if (path.empty() && arg[0] != '-')
+    {
+      path = arg;
+    }
+    else
+    {
+      path.clear();
+      break;
+    }
+  }
+  if (path.empty())
+  {
+    std::cerr << "usage: " << argv[0]
+              << " log [--host host] [--port port] [--compact] [--speed factor | --fast] [--from s] [--to s]"
+              << std::endl
+              << "       " << argv[0] << " log --list [--from s] [--to s]" << std::endl;
+    return 1;
+  }
+
+  try
+  {
+    if (list)
+    {
+      StatismoUI::SessionLogReader log(path);
+      for (std::size_t i = log.seek(from); i < log.seek(to); ++i)
+      {
+        const auto record = log[i];
+        std::cout << std::fixed << std::setprecision(6) << std::setw(14) << record.nanoseconds / 1e9 << " s "
+                  << std::setw(12) << record.size << " bytes  " << StatismoUI::SessionLogReader::rpcName(record)
+                  << std::endl;
+      }
+      return 0;
+    }
+
+    StatismoUI::SessionPlayer player(path, options);
+    player.play(from, to, speed);
+
+    for (const auto & failure : player.GetFailures())
+    {
+      std::cerr << "rejected request " << failure << std::endl;
+    }
+    const auto status = player.GetConnectionStatus();
+    std::cout << "played " << player.GetPosition() << " of " << player.GetLog().size() << " requests, "
+              << player.GetFailures().size() << " rejected";
+    if (!status.connected)
+    {
+      std::cout << ", ui-service unreachable with " << status.pendingOperations << " requests pending";
+    }
+    std::cout << std::endl;
+    return player.GetFailures().empty() && status.connected ? 0 : 1;
+  }
+  catch (const std::exception & e)
+  {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+}